@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_MUSL_PATCHES_PTHREAD_H
+#define _OE_MUSL_PATCHES_PTHREAD_H
+
+#include "__pthread.h"
+
+/* The kinds of readers-writer locks, a glibc extension that musl does not
+ * declare (see oe_pthread_rwlockattr_setkind_np()) */
+#if defined(_GNU_SOURCE) && !defined(PTHREAD_RWLOCK_PREFER_READER_NP)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PTHREAD_RWLOCK_PREFER_READER_NP 0
+#define PTHREAD_RWLOCK_PREFER_WRITER_NP 1
+#define PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP 2
+
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t*, int);
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t*, int*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(_GNU_SOURCE) && !defined(PTHREAD_RWLOCK_PREFER_READER_NP) */
+
+#endif /* _OE_MUSL_PATCHES_PTHREAD_H */
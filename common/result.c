@@ -105,6 +105,8 @@ const char* oe_result_str(oe_result_t result)
             return "OE_VERIFY_REVOKED";
         case OE_CRYPTO_ERROR:
             return "OE_CRYPTO_ERROR";
+        case OE_TIMEOUT:
+            return "OE_TIMEOUT";
         case __OE_RESULT_MAX:
             break;
     }
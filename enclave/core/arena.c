@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "arena.h"
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/raise.h>
+#include "runtimealloc.h"
+
+/*
+**==============================================================================
+**
+** Arena allocator:
+**
+**     An arena hands out its block in order and only remembers how much of
+**     it is used, so allocating is a bounds check and an addition, and
+**     releasing all the allocations resets that count. Allocations are never
+**     freed one by one.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_arena_create(oe_arena_t* arena, size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    void* base;
+
+    if (!arena || !size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(base = oe_memalign(OE_ARENA_ALIGNMENT, size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    arena->base = (uint8_t*)base;
+    arena->size = size;
+    arena->used = 0;
+    arena->owned = 1;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_arena_create_from_buffer(
+    oe_arena_t* arena,
+    void* buffer,
+    size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!arena || !buffer || !size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    arena->base = (uint8_t*)buffer;
+    arena->size = size;
+    arena->used = 0;
+    arena->owned = 0;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void* oe_arena_memalign(oe_arena_t* arena, size_t alignment, size_t size)
+{
+    uintptr_t next;
+    uintptr_t start;
+    uintptr_t end;
+
+    if (!arena || !alignment || (alignment & (alignment - 1)))
+        return NULL;
+
+    /* Align the address rather than the offset: a buffer given by the
+     * caller may not be aligned */
+    next = (uintptr_t)arena->base + arena->used;
+    start = (next + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+    if (start < next || size > arena->size ||
+        start - (uintptr_t)arena->base > arena->size - size)
+        return NULL;
+
+    end = start + size;
+    arena->used = end - (uintptr_t)arena->base;
+
+    return (void*)start;
+}
+
+void* oe_arena_alloc(oe_arena_t* arena, size_t size)
+{
+    return oe_arena_memalign(arena, OE_ARENA_ALIGNMENT, size);
+}
+
+void oe_arena_reset(oe_arena_t* arena)
+{
+    if (arena)
+        arena->used = 0;
+}
+
+void oe_arena_destroy(oe_arena_t* arena)
+{
+    if (!arena)
+        return;
+
+    if (arena->owned)
+        oe_free(arena->base);
+
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+    arena->owned = 0;
+}
+
+/* The block of a thread arena follows its structure, which keeps it
+ * aligned */
+OE_STATIC_ASSERT(sizeof(oe_arena_t) % OE_ARENA_ALIGNMENT == 0);
+
+oe_arena_t* oe_get_thread_arena(void)
+{
+    void** slot = oe_get_thread_arena_slot();
+    oe_arena_t* arena;
+
+    if (!slot)
+        return NULL;
+
+    if ((arena = (oe_arena_t*)*slot))
+        return arena;
+
+    /* The arena lives as long as the enclave */
+    arena = (oe_arena_t*)oe_runtime_memalign(
+        OE_ARENA_ALIGNMENT, sizeof(oe_arena_t) + OE_THREAD_ARENA_SIZE);
+
+    if (!arena)
+        return NULL;
+
+    oe_arena_create_from_buffer(arena, arena + 1, OE_THREAD_ARENA_SIZE);
+
+    *slot = arena;
+    return arena;
+}
@@ -0,0 +1,13 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_ARENA_H
+#define _OE_ARENA_H
+
+#include <openenclave/bits/arena.h>
+
+/* Returns the address of the arena pointer of the calling thread, or null
+ * if the thread has no arena slot. Implemented by each platform */
+void** oe_get_thread_arena_slot(void);
+
+#endif /* _OE_ARENA_H */
@@ -0,0 +1,465 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "heapprofile.h"
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/backtrace.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include "runtimealloc.h"
+
+/*
+**==============================================================================
+**
+** Sampling heap profiler:
+**
+**     The debug allocator records the call stack of every block, which is
+**     too slow for production. Once enabled by the host, this profiler
+**     records the call stack of about one allocation per interval bytes
+**     instead, so that its cost does not depend on the allocation rate:
+**
+**         (1) Each thread counts down the bytes it allocates from a distance
+**             drawn from an exponential distribution whose mean is the
+**             interval. The allocation that reaches zero is sampled and a
+**             new distance is drawn. Each allocation of N bytes is thus
+**             sampled with a probability of 1 - exp(-N / interval), which
+**             lets the host scale the samples back up (Poisson sampling).
+**         (2) Samples are aggregated by call stack in a fixed-size table.
+**         (3) Sampled blocks that are still allocated are kept in a second
+**             table, so that freeing them updates the bytes in use of their
+**             stack. A counting filter tells most frees that their block was
+**             not sampled without taking the lock of the profiler.
+**
+**     The profile is returned by oe_get_heap_profile_ecall() and written in
+**     the pprof heap format by the host, which symbolizes the stacks.
+**     Allocations that do not fit in the tables are counted as dropped.
+**
+**==============================================================================
+*/
+
+/* Most sampled blocks tracked at once, at most three quarters full */
+#define MAX_LIVE_SAMPLES 4096
+#define MAX_LIVE_LOAD (MAX_LIVE_SAMPLES / 4 * 3)
+
+#define FILTER_SIZE 16384
+
+/* The sampling state of a thread holds the epoch of the profile it counts
+ * for in its upper bits and the bytes left before its next sample in the
+ * lower ones, which can hold any distance drawn for the largest interval */
+#define EPOCH_SHIFT 48
+#define EPOCH_MASK 0xffff
+#define COUNTDOWN_MASK ((1ULL << EPOCH_SHIFT) - 1)
+
+/* Fixed-point constants (16 fractional bits) */
+#define FIXED_ONE 65536
+#define FIXED_LN2 45426
+
+typedef struct _stack_entry
+{
+    /* Hash of the frames, or zero while the entry is free */
+    uint64_t hash;
+    oe_heap_profile_stack_t stack;
+} StackEntry;
+
+typedef struct _live_sample
+{
+    /* Address of the block, or zero while the entry is free */
+    uint64_t ptr;
+    uint64_t size;
+    uint64_t stack;
+} LiveSample;
+
+typedef struct _profile
+{
+    StackEntry stacks[OE_HEAP_PROFILE_MAX_STACKS];
+    LiveSample live[MAX_LIVE_SAMPLES];
+    uint16_t filter[FILTER_SIZE];
+} Profile;
+
+/* Allocated when the profiler is first enabled and kept from then on */
+static Profile* _profile;
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/* The sample interval, or zero while the profiler is disabled */
+static volatile uint64_t _interval;
+
+/* The interval of the current profile, kept once it is disabled */
+static uint64_t _profile_interval;
+
+/* Bumped by each new profile so that threads draw a new distance */
+static volatile uint64_t _epoch;
+
+static uint64_t _num_live;
+static uint64_t _dropped;
+static uint64_t _seed;
+
+/* splitmix64 */
+static uint64_t _random(void)
+{
+    uint64_t z = __atomic_add_fetch(
+        &_seed, 0x9e3779b97f4a7c15ULL, __ATOMIC_RELAXED);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Returns a distance drawn from an exponential distribution of the given
+ * mean, which is -ln(u) * mean for u uniform in (0, 1] */
+static uint64_t _next_distance(uint64_t mean)
+{
+    /* u = r / 2^32 with r in [1, 2^32] */
+    const uint64_t r = (_random() >> 32) + 1;
+    const uint64_t e = 63 - (uint64_t)__builtin_clzll(r);
+    const uint64_t f = ((r << (32 - e)) >> 16) & (FIXED_ONE - 1);
+    uint64_t log2_r;
+    uint64_t neg_ln_u;
+
+    /* log2(1 + f) ~= f * (1.3465 - 0.3465 * f) for f in [0, 1) */
+    log2_r = (e << 16) + ((f * (88244 - ((22708 * f) >> 16))) >> 16);
+
+    if (log2_r > (32 << 16))
+        log2_r = 32 << 16;
+
+    /* -ln(u) = ln(2) * (32 - log2(r)) */
+    neg_ln_u = (((32 << 16) - log2_r) * FIXED_LN2) >> 16;
+
+    return ((mean * neg_ln_u) >> 16) + 1;
+}
+
+OE_INLINE size_t _filter_index(uint64_t ptr)
+{
+    /* Blocks are at least 16-byte aligned: hash the upper bits */
+    return (size_t)((ptr * 0x9e3779b97f4a7c15ULL) >> 50) % FILTER_SIZE;
+}
+
+OE_INLINE size_t _live_index(uint64_t ptr)
+{
+    return (size_t)((ptr * 0xc2b2ae3d27d4eb4fULL) >> 52) % MAX_LIVE_SAMPLES;
+}
+
+static uint64_t _hash_frames(void* const* frames, int num_frames)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < num_frames; i++)
+        hash = (hash ^ (uint64_t)frames[i]) * 0x100000001b3ULL;
+
+    /* Zero marks free entries */
+    return hash | 1;
+}
+
+/* Find or add the entry of the stack, or return null if the table is full.
+ * Called with the lock held */
+static StackEntry* _get_stack(
+    Profile* profile,
+    void* const* frames,
+    int num_frames)
+{
+    const uint64_t hash = _hash_frames(frames, num_frames);
+    const size_t index = (size_t)(hash >> 32) % OE_HEAP_PROFILE_MAX_STACKS;
+
+    for (size_t i = 0; i < OE_HEAP_PROFILE_MAX_STACKS; i++)
+    {
+        StackEntry* entry =
+            &profile->stacks[(index + i) % OE_HEAP_PROFILE_MAX_STACKS];
+        oe_heap_profile_stack_t* stack = &entry->stack;
+
+        if (entry->hash == 0)
+        {
+            entry->hash = hash;
+            stack->num_frames = (uint64_t)num_frames;
+
+            for (int j = 0; j < num_frames; j++)
+                stack->frames[j] = (uint64_t)frames[j];
+
+            return entry;
+        }
+
+        if (entry->hash == hash && stack->num_frames == (uint64_t)num_frames)
+        {
+            int j = 0;
+
+            while (j < num_frames && stack->frames[j] == (uint64_t)frames[j])
+                j++;
+
+            if (j == num_frames)
+                return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* Called with the lock held */
+static bool _add_live(Profile* profile, uint64_t ptr, size_t size, size_t i)
+{
+    size_t index = _live_index(ptr);
+
+    if (_num_live >= MAX_LIVE_LOAD)
+        return false;
+
+    while (profile->live[index].ptr)
+        index = (index + 1) % MAX_LIVE_SAMPLES;
+
+    profile->live[index].ptr = ptr;
+    profile->live[index].size = size;
+    profile->live[index].stack = i;
+    __atomic_add_fetch(
+        &profile->filter[_filter_index(ptr)], 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&_num_live, _num_live + 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+/* Remove the sample of the given entry, moving back the entries that follow
+ * it so that lookups need no tombstones. Called with the lock held */
+static void _remove_live(Profile* profile, size_t i)
+{
+    size_t j = i;
+
+    __atomic_sub_fetch(
+        &profile->filter[_filter_index(profile->live[i].ptr)],
+        1,
+        __ATOMIC_RELAXED);
+    __atomic_store_n(&_num_live, _num_live - 1, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        size_t k;
+
+        j = (j + 1) % MAX_LIVE_SAMPLES;
+
+        if (!profile->live[j].ptr)
+            break;
+
+        /* The entry stays if its home lies cyclically in (i, j] */
+        k = _live_index(profile->live[j].ptr);
+
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        profile->live[i] = profile->live[j];
+        i = j;
+    }
+
+    profile->live[i].ptr = 0;
+}
+
+static void _record(void* ptr, size_t size, void* const* frames, int n)
+{
+    Profile* profile;
+    StackEntry* entry;
+
+    oe_spin_lock(&_lock);
+
+    /* Disabled meanwhile */
+    if (!_interval)
+        goto done;
+
+    profile = _profile;
+
+    if (!(entry = _get_stack(profile, frames, n)))
+    {
+        _dropped++;
+        goto done;
+    }
+
+    entry->stack.alloc_count++;
+    entry->stack.alloc_bytes += size;
+
+    /* The block is counted as allocated but its release cannot be */
+    if (!_add_live(
+            profile, (uint64_t)ptr, size, (size_t)(entry - profile->stacks)))
+    {
+        _dropped++;
+        goto done;
+    }
+
+    entry->stack.in_use_count++;
+    entry->stack.in_use_bytes += size;
+
+done:
+    oe_spin_unlock(&_lock);
+}
+
+void oe_heap_profile_allocation(void* ptr, size_t size)
+{
+    const uint64_t interval = _interval;
+    uint64_t* slot;
+    uint64_t epoch;
+    uint64_t state;
+    void* frames[OE_HEAP_PROFILE_MAX_FRAMES + 1];
+    int n;
+
+    if (!interval || !ptr || !(slot = oe_get_heap_profile_slot()))
+        return;
+
+    epoch = _epoch & EPOCH_MASK;
+    state = *slot;
+
+    /* First allocation of the thread in this profile */
+    if ((state >> EPOCH_SHIFT) != epoch)
+        state = (epoch << EPOCH_SHIFT) | _next_distance(interval);
+
+    if (size < (state & COUNTDOWN_MASK))
+    {
+        *slot = state - size;
+        return;
+    }
+
+    *slot = (epoch << EPOCH_SHIFT) | _next_distance(interval);
+
+    /* Drop the frame of this function */
+    n = oe_backtrace(frames, OE_COUNTOF(frames));
+    n = n > 0 ? n - 1 : 0;
+
+    _record(ptr, size, frames + 1, n);
+}
+
+void oe_heap_profile_free(void* ptr)
+{
+    Profile* profile = _profile;
+    const uint64_t p = (uint64_t)ptr;
+
+    if (!p || !profile || !__atomic_load_n(&_num_live, __ATOMIC_RELAXED))
+        return;
+
+    /* The block was sampled, if at all, before the caller obtained it */
+    if (!__atomic_load_n(&profile->filter[_filter_index(p)], __ATOMIC_RELAXED))
+        return;
+
+    oe_spin_lock(&_lock);
+
+    for (size_t i = _live_index(p); profile->live[i].ptr;
+         i = (i + 1) % MAX_LIVE_SAMPLES)
+    {
+        LiveSample* sample = &profile->live[i];
+
+        if (sample->ptr == p)
+        {
+            oe_heap_profile_stack_t* stack =
+                &profile->stacks[sample->stack].stack;
+
+            stack->in_use_count--;
+            stack->in_use_bytes -= sample->size;
+            _remove_live(profile, i);
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_lock);
+}
+
+oe_result_t oe_enable_heap_profiler(uint64_t interval)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (interval > OE_HEAP_PROFILE_MAX_INTERVAL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!interval)
+    {
+        /* Stop sampling but keep tracking the frees of sampled blocks */
+        _interval = 0;
+        result = OE_OK;
+        goto done;
+    }
+
+    /* The profile lives as long as the enclave */
+    if (!_profile)
+    {
+        Profile* profile;
+
+        if (!(profile = (Profile*)oe_runtime_calloc(1, sizeof(Profile))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        oe_spin_lock(&_lock);
+
+        if (_profile)
+            oe_runtime_free(profile);
+        else
+            _profile = profile;
+
+        oe_spin_unlock(&_lock);
+    }
+
+    /* Start a new profile */
+    oe_spin_lock(&_lock);
+    memset(_profile, 0, sizeof(Profile));
+    __atomic_store_n(&_num_live, 0, __ATOMIC_RELAXED);
+    _dropped = 0;
+    _profile_interval = interval;
+
+    /* Epoch zero is the state of the threads that never allocated */
+    if (!(_epoch = (_epoch + 1) & EPOCH_MASK))
+        _epoch = 1;
+
+    _interval = interval;
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+bool oe_heap_profiler_enabled(void)
+{
+    return _interval != 0;
+}
+
+oe_result_t oe_get_heap_profile(
+    oe_heap_profile_stack_t* stacks,
+    size_t max_stacks,
+    size_t* num_stacks,
+    uint64_t* interval,
+    uint64_t* dropped)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const uint64_t base = (uint64_t)__oe_get_enclave_base();
+    Profile* profile = _profile;
+    size_t n = 0;
+
+    if ((!stacks && max_stacks) || !num_stacks || !interval || !dropped)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_spin_lock(&_lock);
+
+    for (size_t i = 0; profile && i < OE_HEAP_PROFILE_MAX_STACKS; i++)
+    {
+        const StackEntry* entry = &profile->stacks[i];
+
+        if (entry->hash == 0)
+            continue;
+
+        if (n < max_stacks)
+        {
+            oe_heap_profile_stack_t* stack = &stacks[n];
+
+            *stack = entry->stack;
+
+            for (uint64_t j = 0; j < stack->num_frames; j++)
+                stack->frames[j] -= base;
+        }
+
+        n++;
+    }
+
+    *num_stacks = n;
+    *interval = _profile_interval;
+    *dropped = _dropped;
+
+    oe_spin_unlock(&_lock);
+
+    if (n > max_stacks)
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HEAP_PROFILE_H
+#define _OE_HEAP_PROFILE_H
+
+#include <openenclave/bits/result.h>
+#include <openenclave/internal/heapprofile.h>
+
+/* Sampling heap profiler (see heapprofile.c) */
+
+/* Record the allocation of size bytes at ptr if it is sampled */
+void oe_heap_profile_allocation(void* ptr, size_t size);
+
+/* Account for the release of ptr if it was sampled. Must be called before
+ * the block is freed, since another thread may allocate it again */
+void oe_heap_profile_free(void* ptr);
+
+/* Start a new profile that samples one allocation per interval bytes on
+ * average, or stop sampling if interval is zero */
+oe_result_t oe_enable_heap_profiler(uint64_t interval);
+
+/* Whether the profiler is sampling allocations */
+bool oe_heap_profiler_enabled(void);
+
+/* Copy up to max_stacks call stacks of the profile. Returns the number of
+ * stacks recorded, the interval they were sampled with and the number of
+ * samples dropped because the table of stacks was full */
+oe_result_t oe_get_heap_profile(
+    oe_heap_profile_stack_t* stacks,
+    size_t max_stacks,
+    size_t* num_stacks,
+    uint64_t* interval,
+    uint64_t* dropped);
+
+/* Returns the address of the sampling state of the calling thread, or null
+ * if the thread cannot sample yet. Implemented by each platform */
+uint64_t* oe_get_heap_profile_slot(void);
+
+#endif /* _OE_HEAP_PROFILE_H */
@@ -10,11 +10,17 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/stack_alloc.h>
+#include "hostpool.h"
 
 void* oe_host_malloc(size_t size)
 {
     uint64_t arg_in = size;
     uint64_t arg_out = 0;
+    void* ptr;
+
+    /* Allocate from the untrusted memory pool when the enclave uses one */
+    if ((ptr = oe_host_pool_alloc(size)))
+        return ptr;
 
     if (oe_ocall(OE_OCALL_MALLOC, arg_in, &arg_out) != OE_OK)
     {
@@ -41,10 +47,42 @@ void* oe_host_calloc(size_t nmemb, size_t size)
     return ptr;
 }
 
+/* Resize a block of the untrusted memory pool of the given size */
+static void* _host_pool_realloc(void* ptr, size_t block_size, size_t size)
+{
+    void* new_ptr;
+
+    /* Like realloc(), release the block when the new size is zero */
+    if (size == 0)
+    {
+        oe_host_free(ptr);
+        return NULL;
+    }
+
+    if (size <= block_size)
+        return ptr;
+
+    if (!(new_ptr = oe_host_malloc(size)))
+        return NULL;
+
+    if (oe_memcpy_s(new_ptr, size, ptr, block_size) != OE_OK)
+    {
+        oe_host_free(new_ptr);
+        return NULL;
+    }
+
+    oe_host_free(ptr);
+    return new_ptr;
+}
+
 void* oe_host_realloc(void* ptr, size_t size)
 {
     oe_realloc_args_t* arg_in = NULL;
     uint64_t arg_out = 0;
+    size_t block_size;
+
+    if (ptr && (block_size = oe_host_pool_block_size(ptr)))
+        return _host_pool_realloc(ptr, block_size, size);
 
     if (!(arg_in =
               (oe_realloc_args_t*)oe_host_calloc(1, sizeof(oe_realloc_args_t))))
@@ -69,7 +107,13 @@ done:
 
 void oe_host_free(void* ptr)
 {
-    oe_ocall(OE_OCALL_FREE, (uint64_t)ptr, NULL);
+    if (!ptr || oe_host_pool_free(ptr))
+        return;
+
+    /* Nothing is returned: let the host free ptr when the thread next exits
+     * the enclave unless the call cannot be deferred */
+    if (oe_defer_ocall(OE_OCALL_FREE, (uint64_t)ptr) != OE_OK)
+        oe_ocall(OE_OCALL_FREE, (uint64_t)ptr, NULL);
 }
 
 char* oe_host_strndup(const char* str, size_t n)
@@ -196,15 +240,3 @@ int oe_host_fprintf(int device, const char* fmt, ...)
 
     return n;
 }
-
-// Function used by oeedger8r for allocating ocall buffers.
-void* oe_allocate_ocall_buffer(size_t size)
-{
-    return oe_host_malloc(size);
-}
-
-// Function used by oeedger8r for freeing ocall buffers.
-void oe_free_ocall_buffer(void* buffer)
-{
-    oe_host_free(buffer);
-}
@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_POOL_H
+#define _OE_HOST_POOL_H
+
+#include <openenclave/bits/types.h>
+
+/* Pool of host memory managed by the enclave, which serves oe_host_malloc()
+ * and friends when OE_ENABLE_HOST_MEMORY_POOL() is used. Implemented by each
+ * platform */
+
+/* Returns a block of at least size bytes of host memory, or null if the pool
+ * is disabled, cannot serve blocks of that size or cannot grow */
+void* oe_host_pool_alloc(size_t size);
+
+/* Releases ptr and returns true if it was allocated from the pool */
+bool oe_host_pool_free(void* ptr);
+
+/* Returns the size of the block ptr or zero if ptr is not from the pool */
+size_t oe_host_pool_block_size(const void* ptr);
+
+#endif /* _OE_HOST_POOL_H */
@@ -11,6 +11,9 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/thread.h>
 #include "debugmalloc.h"
+#include "heapprofile.h"
+#include "malloccache.h"
+#include "runtimealloc.h"
 
 /* The use of dlmalloc/malloc.c below requires stdc names from these headers */
 #define OE_NEED_STDC_NAMES
@@ -43,8 +46,45 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic pop
 
+/*
+**==============================================================================
+**
+** Runtime allocations:
+**
+**     The runtime keeps some of its state for as long as the enclave lives
+**     (thread caches and arenas, profiles, slabs of caches that are never
+**     destroyed) and never frees it. This memory is taken from dlmalloc
+**     directly rather than through malloc(): the debug allocator would
+**     report it as leaked when the enclave is terminated, and the heap
+**     profiler and statistics would count the runtime's allocations as the
+**     application's.
+**
+**==============================================================================
+*/
+
+void* oe_runtime_malloc(size_t size)
+{
+    return dlmalloc(size);
+}
+
+void* oe_runtime_calloc(size_t nmemb, size_t size)
+{
+    return dlcalloc(nmemb, size);
+}
+
+void* oe_runtime_memalign(size_t alignment, size_t size)
+{
+    return dlmemalign(alignment, size);
+}
+
+void oe_runtime_free(void* ptr)
+{
+    dlfree(ptr);
+}
+
 /* Choose release mode or debug mode allocation functions */
 #if defined(OE_USE_DEBUG_MALLOC)
+#define THREAD_CACHE false
 #define MALLOC oe_debug_malloc
 #define CALLOC oe_debug_calloc
 #define REALLOC oe_debug_realloc
@@ -52,16 +92,116 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 #define POSIX_MEMALIGN oe_debug_posix_memalign
 #define FREE oe_debug_free
 #else
-#define MALLOC dlmalloc
-#define CALLOC dlcalloc
-#define REALLOC dlrealloc
+#define THREAD_CACHE oe_malloc_thread_cache
+#define MALLOC _malloc
+#define CALLOC _calloc
+#define REALLOC _realloc
 #define MEMALIGN dlmemalign
 #define POSIX_MEMALIGN dlposix_memalign
-#define FREE dlfree
+#define FREE _free
+
+/* Small blocks are served by the thread-caching allocator when the enclave
+ * enables it with OE_ENABLE_MALLOC_THREAD_CACHE() (see malloccache.c) */
+
+static void* _malloc(size_t size)
+{
+    if (THREAD_CACHE)
+        return oe_malloc_cache_alloc(size);
+
+    return dlmalloc(size);
+}
+
+static void* _calloc(size_t nmemb, size_t size)
+{
+    if (THREAD_CACHE)
+        return oe_malloc_cache_calloc(nmemb, size);
+
+    return dlcalloc(nmemb, size);
+}
+
+static void* _realloc(void* ptr, size_t size)
+{
+    if (THREAD_CACHE)
+        return oe_malloc_cache_realloc(ptr, size);
+
+    return dlrealloc(ptr, size);
+}
+
+static void _free(void* ptr)
+{
+    if (THREAD_CACHE)
+        oe_malloc_cache_free(ptr);
+    else
+        dlfree(ptr);
+}
 #endif
 
 static oe_allocation_failure_callback_t _failure_callback;
 
+/*
+**==============================================================================
+**
+** Allocation counters:
+**
+**     The allocations and frees are counted for oe_get_heap_stats(). Threads
+**     with a malloc cache count them in their cache, which keeps the counts
+**     off the shared cache lines that the thread cache avoids. Other threads
+**     update the global counters atomically.
+**
+**==============================================================================
+*/
+
+static oe_heap_counters_t _counters;
+static uint64_t _failures;
+
+static size_t _size_class(size_t size)
+{
+    size_t c;
+
+    if (size <= 16)
+        return 0;
+
+    /* Element c counts the sizes of (8 << c) + 1 up to 16 << c bytes */
+    c = (size_t)(64 - __builtin_clzll((uint64_t)size - 1)) - 4;
+
+    if (c >= OE_HEAP_STATS_NUM_SIZE_CLASSES)
+        c = OE_HEAP_STATS_NUM_SIZE_CLASSES - 1;
+
+    return c;
+}
+
+static void _count_allocation(size_t size)
+{
+    oe_heap_counters_t* counters;
+    const size_t c = _size_class(size);
+
+    if (THREAD_CACHE && (counters = oe_malloc_cache_counters()))
+    {
+        counters->allocations++;
+        counters->size_classes[c]++;
+    }
+    else
+    {
+        __atomic_add_fetch(&_counters.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&_counters.size_classes[c], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void _count_free(void)
+{
+    oe_heap_counters_t* counters;
+
+    if (THREAD_CACHE && (counters = oe_malloc_cache_counters()))
+        counters->frees++;
+    else
+        __atomic_add_fetch(&_counters.frees, 1, __ATOMIC_RELAXED);
+}
+
+static void _count_failure(void)
+{
+    __atomic_add_fetch(&_failures, 1, __ATOMIC_RELAXED);
+}
+
 void oe_set_allocation_failure_callback(
     oe_allocation_failure_callback_t function)
 {
@@ -72,8 +212,14 @@ void* oe_malloc(size_t size)
 {
     void* p = MALLOC(size);
 
-    if (!p && size)
+    if (p)
     {
+        _count_allocation(size);
+        oe_heap_profile_allocation(p, size);
+    }
+    else if (size)
+    {
+        _count_failure();
         errno = ENOMEM;
 
         if (_failure_callback)
@@ -85,6 +231,14 @@ void* oe_malloc(size_t size)
 
 void oe_free(void* ptr)
 {
+    if (ptr)
+    {
+        _count_free();
+
+        /* Before the block can be allocated again */
+        oe_heap_profile_free(ptr);
+    }
+
     FREE(ptr);
 }
 
@@ -92,8 +246,14 @@ void* oe_calloc(size_t nmemb, size_t size)
 {
     void* p = CALLOC(nmemb, size);
 
-    if (!p && nmemb && size)
+    if (p)
     {
+        _count_allocation(nmemb * size);
+        oe_heap_profile_allocation(p, nmemb * size);
+    }
+    else if (nmemb && size)
+    {
+        _count_failure();
         errno = ENOMEM;
 
         if (_failure_callback)
@@ -105,10 +265,23 @@ void* oe_calloc(size_t nmemb, size_t size)
 
 void* oe_realloc(void* ptr, size_t size)
 {
-    void* p = REALLOC(ptr, size);
+    void* p;
+
+    /* A failed call keeps the block but its sample is lost, which only
+     * makes the profile miss it */
+    oe_heap_profile_free(ptr);
+
+    if ((p = REALLOC(ptr, size)))
+    {
+        if (ptr)
+            _count_free();
 
-    if (!p && size)
+        _count_allocation(size);
+        oe_heap_profile_allocation(p, size);
+    }
+    else if (size)
     {
+        _count_failure();
         errno = ENOMEM;
 
         if (_failure_callback)
@@ -122,8 +295,14 @@ int oe_posix_memalign(void** memptr, size_t alignment, size_t size)
 {
     int rc = POSIX_MEMALIGN(memptr, alignment, size);
 
-    if (rc != 0 && size)
+    if (rc == 0)
+    {
+        _count_allocation(size);
+        oe_heap_profile_allocation(*memptr, size);
+    }
+    else if (size)
     {
+        _count_failure();
         errno = ENOMEM;
 
         if (_failure_callback)
@@ -137,8 +316,14 @@ void* oe_memalign(size_t alignment, size_t size)
 {
     void* p = MEMALIGN(alignment, size);
 
-    if (!p && size)
+    if (p)
     {
+        _count_allocation(size);
+        oe_heap_profile_allocation(p, size);
+    }
+    else if (size)
+    {
+        _count_failure();
         errno = ENOMEM;
 
         if (_failure_callback)
@@ -236,3 +421,66 @@ done:
     oe_mutex_unlock(&_mutex);
     return result;
 }
+
+/*
+**==============================================================================
+**
+** oe_get_heap_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_heap_stats(oe_heap_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_heap_counters_t counters;
+    struct mallinfo info;
+
+    if (!stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memset(stats, 0, sizeof(oe_heap_stats_t));
+
+    stats->heap_size = __oe_get_heap_size();
+    oe_get_sbrk_stats(&stats->sbrk_bytes, &stats->peak_sbrk_bytes);
+
+    /* The free bytes include the top chunk (at the end of the heap), which
+     * mallinfo counts among the free blocks */
+    info = dlmallinfo();
+    stats->in_use_bytes = info.uordblks;
+    stats->free_bytes = info.fordblks;
+    stats->top_free_bytes = info.keepcost;
+    stats->free_blocks = info.ordblks;
+
+    if (stats->free_bytes)
+    {
+        stats->fragmentation = (stats->free_bytes - stats->top_free_bytes) *
+                               100 / stats->free_bytes;
+    }
+
+    counters.allocations =
+        __atomic_load_n(&_counters.allocations, __ATOMIC_RELAXED);
+    counters.frees = __atomic_load_n(&_counters.frees, __ATOMIC_RELAXED);
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+    {
+        counters.size_classes[i] =
+            __atomic_load_n(&_counters.size_classes[i], __ATOMIC_RELAXED);
+    }
+
+    if (THREAD_CACHE)
+        oe_malloc_cache_sum_counters(&counters);
+
+    stats->allocations = counters.allocations;
+    stats->frees = counters.frees;
+    stats->failures = __atomic_load_n(&_failures, __ATOMIC_RELAXED);
+    memcpy(
+        stats->size_classes,
+        counters.size_classes,
+        sizeof(stats->size_classes));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
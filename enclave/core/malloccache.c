@@ -0,0 +1,398 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#define USE_DL_PREFIX
+#include "malloccache.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/malloc.h>
+#include <openenclave/internal/thread.h>
+#include "../3rdparty/dlmalloc/dlmalloc/malloc.h"
+#include "runtimealloc.h"
+
+/*
+**==============================================================================
+**
+** Thread-caching allocator:
+**
+**     dlmalloc serializes every allocation on one global lock, which becomes
+**     the bottleneck of enclaves that allocate from many threads. This module
+**     puts a cache in front of dlmalloc that serves small blocks without
+**     taking that lock:
+**
+**         (1) Each TCS has a bin of free blocks per size class, which only
+**             the thread running on that TCS touches.
+**         (2) An empty bin takes a batch of blocks from the central list of
+**             its size class, or failing that, allocates a batch from
+**             dlmalloc with a single call.
+**         (3) A full bin moves a batch to the central list, which releases
+**             the batches it cannot hold to dlmalloc with a single call.
+**
+**     Blocks remain ordinary dlmalloc blocks throughout, so they carry no
+**     extra header: the size class of a freed block is derived from its
+**     usable size, and oe_realloc() and oe_get_malloc_stats() work as before
+**     (cached blocks count as in use). dlmalloc still obtains the heap from
+**     oe_sbrk().
+**
+**     dlmalloc allocates chunks of 16-byte granules with an 8-byte header,
+**     so a chunk of N granules has N * 16 - 8 usable bytes. The size classes
+**     follow that layout so that caching wastes no memory.
+**
+**     The cache is enabled with OE_ENABLE_MALLOC_THREAD_CACHE().
+**
+**==============================================================================
+*/
+
+#define GRANULE 16
+#define NUM_CLASSES 64
+#define MAX_BATCH 32
+#define BATCH_BYTES 2048
+#define MAX_CACHE_BYTES (64 * 1024)
+#define MAX_CENTRAL_BATCHES 64
+#define CACHE_LINE_SIZE 64
+
+/* Overridden by OE_ENABLE_MALLOC_THREAD_CACHE() */
+__attribute__((weak)) const bool oe_malloc_thread_cache = false;
+
+/* A free block links to the next block of its batch. The first block of a
+ * batch on a central list also holds the next batch and its block count */
+typedef struct _block
+{
+    struct _block* next;
+    struct _block* next_batch;
+    size_t count;
+} Block;
+
+typedef struct _bin
+{
+    Block* head;
+    uint32_t count;
+    uint32_t batch;
+} Bin;
+
+typedef struct _cache
+{
+    Bin bins[NUM_CLASSES];
+    size_t bytes;
+
+    /* Allocations made by the thread, read by oe_get_heap_stats() */
+    oe_heap_counters_t counters;
+
+    /* Next cache created: caches are never freed */
+    struct _cache* next;
+} Cache;
+
+typedef struct _central
+{
+    oe_spinlock_t lock;
+    size_t num_batches;
+    Block* batches;
+} OE_ALIGNED(CACHE_LINE_SIZE) Central;
+
+static Central _central[NUM_CLASSES];
+static Cache* _caches;
+
+static size_t _class_size(size_t c)
+{
+    return (c + 2) * GRANULE - sizeof(size_t);
+}
+
+/* Smallest class whose blocks can hold size bytes */
+static size_t _size_class(size_t size)
+{
+    if (size <= _class_size(0))
+        return 0;
+
+    return (size + sizeof(size_t) + GRANULE - 1) / GRANULE - 2;
+}
+
+/* Largest class whose size a block of usable bytes can serve */
+static size_t _usable_class(size_t usable)
+{
+    return (usable + sizeof(size_t)) / GRANULE - 2;
+}
+
+static Cache* _get_cache(bool create)
+{
+    void** slot = oe_get_malloc_cache_slot();
+    Cache* cache;
+
+    if (!slot)
+        return NULL;
+
+    if ((cache = (Cache*)*slot) || !create)
+        return cache;
+
+    if (!(cache = (Cache*)oe_runtime_calloc(1, sizeof(Cache))))
+        return NULL;
+
+    for (size_t c = 0; c < NUM_CLASSES; c++)
+    {
+        size_t batch = BATCH_BYTES / _class_size(c);
+
+        if (batch < 2)
+            batch = 2;
+        else if (batch > MAX_BATCH)
+            batch = MAX_BATCH;
+
+        cache->bins[c].batch = (uint32_t)batch;
+    }
+
+    cache->next = __atomic_load_n(&_caches, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(
+        &_caches,
+        &cache->next,
+        cache,
+        true,
+        __ATOMIC_RELEASE,
+        __ATOMIC_RELAXED))
+        ;
+
+    *slot = cache;
+    return cache;
+}
+
+/* Detach the first count blocks of a bin as a batch */
+static Block* _take_batch(Cache* cache, size_t c, size_t count)
+{
+    Bin* bin = &cache->bins[c];
+    Block* batch = bin->head;
+    Block* tail = batch;
+
+    for (size_t i = 1; i < count; i++)
+        tail = tail->next;
+
+    bin->head = tail->next;
+    bin->count -= (uint32_t)count;
+    cache->bytes -= count * _class_size(c);
+
+    tail->next = NULL;
+    batch->count = count;
+    return batch;
+}
+
+static void _free_batch(Block* batch)
+{
+    void* blocks[MAX_BATCH];
+    size_t count = 0;
+
+    while (batch)
+    {
+        blocks[count++] = batch;
+        batch = batch->next;
+    }
+
+    dlbulk_free(blocks, count);
+}
+
+static void _release_batch(size_t c, Block* batch)
+{
+    Central* central = &_central[c];
+
+    oe_spin_lock(&central->lock);
+
+    if (central->num_batches < MAX_CENTRAL_BATCHES)
+    {
+        batch->next_batch = central->batches;
+        central->batches = batch;
+        central->num_batches++;
+        batch = NULL;
+    }
+
+    oe_spin_unlock(&central->lock);
+
+    if (batch)
+        _free_batch(batch);
+}
+
+static Block* _acquire_batch(size_t c)
+{
+    Central* central = &_central[c];
+    Block* batch;
+
+    /* Skip the lock when the list looks empty */
+    if (!__atomic_load_n(&central->batches, __ATOMIC_RELAXED))
+        return NULL;
+
+    oe_spin_lock(&central->lock);
+
+    if ((batch = central->batches))
+    {
+        central->batches = batch->next_batch;
+        central->num_batches--;
+    }
+
+    oe_spin_unlock(&central->lock);
+
+    return batch;
+}
+
+static Block* _allocate_batch(size_t c, size_t count)
+{
+    size_t sizes[MAX_BATCH];
+    void* blocks[MAX_BATCH];
+
+    for (size_t i = 0; i < count; i++)
+        sizes[i] = _class_size(c);
+
+    /* Carve all the blocks out of one chunk under one dlmalloc lock */
+    if (!dlindependent_comalloc(count, sizes, blocks))
+        return NULL;
+
+    for (size_t i = 0; i + 1 < count; i++)
+        ((Block*)blocks[i])->next = (Block*)blocks[i + 1];
+
+    ((Block*)blocks[count - 1])->next = NULL;
+    ((Block*)blocks[0])->count = count;
+
+    return (Block*)blocks[0];
+}
+
+/* Give the blocks of this thread and of the central lists back to dlmalloc */
+static void _flush(Cache* cache)
+{
+    for (size_t c = 0; c < NUM_CLASSES; c++)
+    {
+        Bin* bin = &cache->bins[c];
+        Block* batches;
+
+        while (bin->count)
+        {
+            size_t count = bin->count < MAX_BATCH ? bin->count : MAX_BATCH;
+            _free_batch(_take_batch(cache, c, count));
+        }
+
+        oe_spin_lock(&_central[c].lock);
+        batches = _central[c].batches;
+        _central[c].batches = NULL;
+        _central[c].num_batches = 0;
+        oe_spin_unlock(&_central[c].lock);
+
+        while (batches)
+        {
+            Block* next = batches->next_batch;
+            _free_batch(batches);
+            batches = next;
+        }
+    }
+}
+
+void* oe_malloc_cache_alloc(size_t size)
+{
+    Cache* cache;
+    Bin* bin;
+    Block* batch;
+    Block* block;
+    size_t c;
+
+    if (size > _class_size(NUM_CLASSES - 1) || !(cache = _get_cache(true)))
+        return dlmalloc(size);
+
+    c = _size_class(size);
+    bin = &cache->bins[c];
+
+    if ((block = bin->head))
+    {
+        bin->head = block->next;
+        bin->count--;
+        cache->bytes -= _class_size(c);
+        return block;
+    }
+
+    if ((batch = _acquire_batch(c)) || (batch = _allocate_batch(c, bin->batch)))
+    {
+        bin->head = batch->next;
+        bin->count = (uint32_t)(batch->count - 1);
+        cache->bytes += bin->count * _class_size(c);
+        return batch;
+    }
+
+    /* The heap is exhausted: release the cached blocks and try again */
+    _flush(cache);
+    return dlmalloc(size);
+}
+
+void oe_malloc_cache_free(void* ptr)
+{
+    Cache* cache;
+    Block* block = (Block*)ptr;
+    Bin* bin;
+    size_t usable;
+    size_t c;
+
+    if (!ptr)
+        return;
+
+    usable = dlmalloc_usable_size(ptr);
+
+    if (usable < _class_size(0) || (c = _usable_class(usable)) >= NUM_CLASSES ||
+        !(cache = _get_cache(false)) ||
+        cache->bytes + _class_size(c) > MAX_CACHE_BYTES)
+    {
+        dlfree(ptr);
+        return;
+    }
+
+    bin = &cache->bins[c];
+    block->next = bin->head;
+    bin->head = block;
+    bin->count++;
+    cache->bytes += _class_size(c);
+
+    if (bin->count >= 2 * bin->batch)
+        _release_batch(c, _take_batch(cache, c, bin->batch));
+}
+
+void* oe_malloc_cache_calloc(size_t nmemb, size_t size)
+{
+    size_t total;
+    void* p;
+
+    if (oe_safe_mul_sizet(nmemb, size, &total) != OE_OK ||
+        total > _class_size(NUM_CLASSES - 1))
+    {
+        return dlcalloc(nmemb, size);
+    }
+
+    if ((p = oe_malloc_cache_alloc(total)))
+        memset(p, 0, total);
+
+    return p;
+}
+
+void* oe_malloc_cache_realloc(void* ptr, size_t size)
+{
+    /* A cached block is an allocated dlmalloc block, so dlrealloc() can
+     * resize any block handed out by this module */
+    if (!ptr)
+        return oe_malloc_cache_alloc(size);
+
+    return dlrealloc(ptr, size);
+}
+
+oe_heap_counters_t* oe_malloc_cache_counters(void)
+{
+    Cache* cache = _get_cache(false);
+
+    return cache ? &cache->counters : NULL;
+}
+
+void oe_malloc_cache_sum_counters(oe_heap_counters_t* sum)
+{
+    Cache* cache = __atomic_load_n(&_caches, __ATOMIC_ACQUIRE);
+
+    /* The counters of other threads may be read while they are updated,
+     * which at worst misses their latest allocations */
+    for (; cache; cache = cache->next)
+    {
+        const oe_heap_counters_t* counters = &cache->counters;
+
+        sum->allocations += counters->allocations;
+        sum->frees += counters->frees;
+
+        for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+            sum->size_classes[i] += counters->size_classes[i];
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_MALLOC_CACHE_H
+#define _OE_MALLOC_CACHE_H
+
+#include <openenclave/bits/heapstats.h>
+#include <openenclave/bits/types.h>
+
+/* Allocation counts reported by oe_get_heap_stats() */
+typedef struct _oe_heap_counters
+{
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t size_classes[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+} oe_heap_counters_t;
+
+/* Thread-caching front end of dlmalloc (see malloccache.c) */
+void* oe_malloc_cache_alloc(size_t size);
+void oe_malloc_cache_free(void* ptr);
+void* oe_malloc_cache_calloc(size_t nmemb, size_t size);
+void* oe_malloc_cache_realloc(void* ptr, size_t size);
+
+/* Returns the counters of the cache of the calling thread, which only that
+ * thread updates, or null if the thread has no cache */
+oe_heap_counters_t* oe_malloc_cache_counters(void);
+
+/* Adds the counters of the caches of all the threads to sum */
+void oe_malloc_cache_sum_counters(oe_heap_counters_t* sum);
+
+/* Returns the address of the malloc cache pointer of the calling thread, or
+ * null if the thread cannot cache yet. Implemented by each platform */
+void** oe_get_malloc_cache_slot(void);
+
+#endif /* _OE_MALLOC_CACHE_H */
@@ -9,6 +9,9 @@
 #define FUNC_BEING_INVOKED 1
 #define FUNC_INVOKED 2
 
+/* The function is being invoked and other threads wait on the futex */
+#define FUNC_BEING_INVOKED_WAITED 3
+
 oe_result_t oe_once(oe_once_t* once, void (*func)(void))
 {
     if (!once)
@@ -62,19 +65,40 @@ oe_result_t oe_once(oe_once_t* once, void (*func)(void))
                 func();
 
             // Inform other threads that func has completed by setting it to
-            // FUNC_INVOKED. Use a release barrier.
-            __atomic_store_n(once, FUNC_INVOKED, __ATOMIC_RELEASE);
+            // FUNC_INVOKED. Use a release barrier. Wake the threads that wait
+            // on the futex, if any.
+            if (__atomic_exchange_n(once, FUNC_INVOKED, __ATOMIC_RELEASE) ==
+                FUNC_BEING_INVOKED_WAITED)
+                oe_futex_wake(once, OE_SIZE_MAX, NULL);
         }
         else
         {
             /*
               Another thread is invoking the function. Wait for that thread to
-              finish the invocation.
+              finish the invocation: mark the once as waited on, so that the
+              invoking thread wakes this thread, and sleep on the futex
+              (which spins first) for as long as the mark stays.
             */
-            while (__atomic_load_n(once, __ATOMIC_ACQUIRE) != FUNC_INVOKED)
+            while ((expected = __atomic_load_n(once, __ATOMIC_ACQUIRE)) !=
+                   FUNC_INVOKED)
             {
-                // Relinquish CPU
-                OE_CPU_RELAX();
+                if (expected == FUNC_BEING_INVOKED &&
+                    !__atomic_compare_exchange_n(
+                        once,
+                        &expected,
+                        FUNC_BEING_INVOKED_WAITED,
+                        false,
+                        __ATOMIC_ACQUIRE,
+                        __ATOMIC_ACQUIRE))
+                    continue;
+
+                /* Spin where the futex cannot block (e.g. OE_UNSUPPORTED) */
+                if (oe_futex_wait(
+                        once, FUNC_BEING_INVOKED_WAITED, OE_UINT64_MAX) !=
+                        OE_OK &&
+                    __atomic_load_n(once, __ATOMIC_ACQUIRE) ==
+                        FUNC_BEING_INVOKED_WAITED)
+                    OE_CPU_RELAX();
             }
         }
     }
@@ -3,6 +3,9 @@
 
 #include <openenclave/bits/defs.h>
 #include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include "../hostpool.h"
 
 oe_result_t oe_ocall(uint16_t func, uint64_t arg_in, uint64_t* arg_out)
 {
@@ -29,6 +32,117 @@ oe_result_t oe_call_host_function(
     return OE_UNSUPPORTED;
 }
 
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_host_function(
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+// Function used by oeedger8r for allocating ocall buffers.
+void* oe_allocate_ocall_buffer(size_t size)
+{
+    return oe_host_malloc(size);
+}
+
+// Function used by oeedger8r for freeing ocall buffers.
+void oe_free_ocall_buffer(void* buffer)
+{
+    oe_host_free(buffer);
+}
+
+// The untrusted memory pool is not supported: oe_host_malloc() and
+// oe_host_free() always call the host.
+void* oe_host_pool_alloc(size_t size)
+{
+    OE_UNUSED(size);
+    return NULL;
+}
+
+bool oe_host_pool_free(void* ptr)
+{
+    OE_UNUSED(ptr);
+    return false;
+}
+
+size_t oe_host_pool_block_size(const void* ptr)
+{
+    OE_UNUSED(ptr);
+    return 0;
+}
+
+void* oe_allocate_switchless_ocall_buffer(size_t size)
+{
+    return oe_allocate_ocall_buffer(size);
+}
+
+void oe_free_switchless_ocall_buffer(void* buffer)
+{
+    oe_free_ocall_buffer(buffer);
+}
+
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_host_function(
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+void* oe_allocate_deferred_ocall_buffer(size_t size)
+{
+    return oe_allocate_ocall_buffer(size);
+}
+
+void oe_free_deferred_ocall_buffer(void* buffer)
+{
+    oe_free_ocall_buffer(buffer);
+}
+
+// OCALLs are never deferred: callers make them with oe_ocall() instead.
+oe_result_t oe_defer_ocall(uint16_t func, uint64_t arg_in)
+{
+    OE_UNUSED(func);
+    OE_UNUSED(arg_in);
+    return OE_UNSUPPORTED;
+}
+
+void* oe_allocate_deferred_ocall(uint16_t func, size_t size)
+{
+    OE_UNUSED(func);
+    OE_UNUSED(size);
+    return NULL;
+}
+
+void oe_post_deferred_ocall(void* args)
+{
+    OE_UNUSED(args);
+}
+
+void oe_cancel_deferred_ocall(void* args)
+{
+    OE_UNUSED(args);
+}
+
 void oe_abort(void)
 {
     // TODO: Determine the appropriate call to make into OP-TEE on TA abort.
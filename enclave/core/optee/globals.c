@@ -50,3 +50,11 @@ const void* __oe_get_heap_end()
 {
     return (const uint8_t*)__oe_get_heap_base() + __oe_get_heap_size();
 }
+
+/* Trusted applications have no TCSs whose stacks the host fills */
+oe_result_t oe_get_stack_usage(oe_stack_usage_t* usage, size_t* num_usage)
+{
+    OE_UNUSED(usage);
+    OE_UNUSED(num_usage);
+    return OE_UNSUPPORTED;
+}
@@ -9,6 +9,10 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/thread.h>
+#include "../arena.h"
+#include "../heapprofile.h"
+#include "../malloccache.h"
+#include "../slab.h"
 
 /*
 **==============================================================================
@@ -46,6 +50,34 @@ bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2)
     return thread1 == thread2;
 }
 
+/* Trusted applications are single-threaded */
+oe_result_t oe_thread_create(
+    oe_thread_t* thread,
+    void* (*start_routine)(void*),
+    void* arg)
+{
+    OE_UNUSED(start_routine);
+    OE_UNUSED(arg);
+
+    if (thread)
+        *thread = 0;
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_thread_join(oe_thread_t thread, void** retval)
+{
+    OE_UNUSED(thread);
+    OE_UNUSED(retval);
+    return OE_NOT_FOUND;
+}
+
+oe_result_t oe_thread_detach(oe_thread_t thread)
+{
+    OE_UNUSED(thread);
+    return OE_NOT_FOUND;
+}
+
 /*
 **==============================================================================
 **
@@ -98,6 +130,18 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
     return OE_OK;
 }
 
+oe_result_t oe_mutex_timedlock(oe_mutex_t* mutex, uint64_t deadline)
+{
+    oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
+
+    OE_UNUSED(deadline);
+
+    if (!m)
+        return OE_INVALID_PARAMETER;
+
+    return OE_OK;
+}
+
 oe_result_t oe_mutex_trylock(oe_mutex_t* mutex)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
@@ -197,6 +241,21 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
     return OE_OK;
 }
 
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* condition,
+    oe_mutex_t* mutex,
+    uint64_t deadline)
+{
+    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
+
+    OE_UNUSED(deadline);
+
+    if (!cond || !mutex)
+        return OE_INVALID_PARAMETER;
+
+    return OE_OK;
+}
+
 oe_result_t oe_cond_signal(oe_cond_t* condition)
 {
     oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
@@ -260,6 +319,11 @@ oe_result_t oe_rwlock_init(oe_rwlock_t* read_write_lock)
     return result;
 }
 
+oe_result_t oe_rwlock_init_distributed(oe_rwlock_t* read_write_lock)
+{
+    return oe_rwlock_init(read_write_lock);
+}
+
 oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -270,6 +334,20 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
     return OE_OK;
 }
 
+oe_result_t oe_rwlock_timedrdlock(
+    oe_rwlock_t* read_write_lock,
+    uint64_t deadline)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+
+    OE_UNUSED(deadline);
+
+    if (!rw_lock)
+        return OE_INVALID_PARAMETER;
+
+    return OE_OK;
+}
+
 oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -290,6 +368,20 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
     return OE_OK;
 }
 
+oe_result_t oe_rwlock_timedwrlock(
+    oe_rwlock_t* read_write_lock,
+    uint64_t deadline)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+
+    OE_UNUSED(deadline);
+
+    if (!rw_lock)
+        return OE_INVALID_PARAMETER;
+
+    return OE_OK;
+}
+
 oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -332,6 +424,69 @@ oe_result_t oe_rwlock_unlock(oe_rwlock_t* read_write_lock)
     return OE_OK;
 }
 
+/*
+**==============================================================================
+**
+** oe_futex
+**
+**==============================================================================
+*/
+
+/* Trusted applications are single-threaded: no thread could wake a waiter,
+ * so waits fail rather than return as if woken, which would make callers
+ * spin on a word that cannot change */
+oe_result_t oe_futex_wait(
+    volatile uint32_t* addr,
+    uint32_t val,
+    uint64_t deadline)
+{
+    OE_UNUSED(deadline);
+
+    if (!addr)
+        return OE_INVALID_PARAMETER;
+
+    if (*addr != val)
+        return OE_BUSY;
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_futex_wake(volatile uint32_t* addr, size_t count, size_t* woken)
+{
+    OE_UNUSED(count);
+
+    if (!addr)
+        return OE_INVALID_PARAMETER;
+
+    if (woken)
+        *woken = 0;
+
+    return OE_OK;
+}
+
+oe_result_t oe_futex_requeue(
+    volatile uint32_t* addr,
+    uint32_t val,
+    size_t num_wake,
+    volatile uint32_t* addr2,
+    size_t num_requeue,
+    size_t* count)
+{
+    OE_UNUSED(num_wake);
+    OE_UNUSED(num_requeue);
+
+    if (!addr || !addr2)
+        return OE_INVALID_PARAMETER;
+
+    if (*addr != val)
+        return OE_BUSY;
+
+    if (count)
+        *count = 0;
+
+    return OE_OK;
+}
+
 /*
 **==============================================================================
 **
@@ -469,3 +624,71 @@ void oe_thread_destruct_specific(void)
         oe_spin_unlock(&_lock);
     }
 }
+
+/*
+**==============================================================================
+**
+** oe_get_malloc_cache_slot()
+**
+**     Trusted applications run a single thread, so the malloc cache lives in
+**     a global.
+**
+**==============================================================================
+*/
+
+static void* _malloc_cache;
+
+void** oe_get_malloc_cache_slot(void)
+{
+    return &_malloc_cache;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_thread_arena_slot()
+**
+**     Trusted applications have no hook at the end of their calls to reset
+**     the arena of the thread, so they do not get one.
+**
+**==============================================================================
+*/
+
+void** oe_get_thread_arena_slot(void)
+{
+    return NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_heap_profile_slot()
+**
+**     The heap profiler is enabled by internal ECALLs that trusted
+**     applications do not have, so they never sample.
+**
+**==============================================================================
+*/
+
+uint64_t* oe_get_heap_profile_slot(void)
+{
+    return NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_slab_magazines_slot()
+**
+**     Trusted applications run a single thread, so the slab magazines live
+**     in a global.
+**
+**==============================================================================
+*/
+
+static void* _slab_magazines;
+
+void** oe_get_slab_magazines_slot(void)
+{
+    return &_slab_magazines;
+}
@@ -0,0 +1,484 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/parallel.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
+#include <openenclave/internal/utils.h>
+
+/*
+**==============================================================================
+**
+** Work-stealing scheduler:
+**
+**     Each worker thread owns a deque of work items: ranges of a parallel
+**     loop or tasks of a task group. A worker takes its newest item, and
+**     when it has none steals the oldest item of another deque, which for a
+**     loop is the largest range left. Ranges larger than the grain of their
+**     loop are split in halves as they are run: the upper half is queued
+**     for others to steal and the thread goes on with the lower half.
+**
+**     Threads that are not workers (those making ECALLs) queue their items
+**     on a shared deque, and run items while they wait for their own.
+**
+**     Workers are started with oe_thread_create() when work is posted and
+**     fewer workers than useful are running. A worker without work sleeps
+**     on a condition variable, and exits after OE_PARALLEL_IDLE_TIMEOUT_MS
+**     without work so that the threads of the host pool are given back.
+**
+**     The deques are rings under a spinlock, which orders the items between
+**     the owner and the thieves. Lock-free Chase-Lev deques would need
+**     OE_ATOMIC_MEMORY_BARRIER_* fences on every take and steal, for little
+**     gain with so few items. A thread that runs an item issues a release
+**     barrier before counting it done, and a thread that waits for a loop
+**     or a task group issues an acquire barrier once all its items are
+**     counted, so that it sees everything the items wrote.
+**
+**==============================================================================
+*/
+
+#define DEQUE_CAPACITY 64
+
+/* Deques of the workers, plus the shared deque */
+#define NUM_DEQUES (OE_PARALLEL_MAX_THREADS + 1)
+#define SHARED_DEQUE OE_PARALLEL_MAX_THREADS
+
+/* Pause iterations of a worker without work before it sleeps */
+#define WORKER_SPIN_COUNT 4096
+
+typedef struct _job
+{
+    /* The body of a loop, or the function of a task */
+    oe_parallel_for_body_t body;
+    void (*task)(void*);
+    void* arg;
+    uint64_t grain;
+
+    /* Iterations run (loops) or tasks not finished (task groups) */
+    volatile uint64_t* counter;
+} job_t;
+
+typedef struct _item
+{
+    job_t* job;
+    uint64_t begin;
+    uint64_t end;
+} item_t;
+
+typedef struct _deque
+{
+    oe_spinlock_t lock;
+
+    /* Items are taken by the owner at tail and stolen at head */
+    volatile uint64_t head;
+    volatile uint64_t tail;
+    item_t items[DEQUE_CAPACITY];
+} OE_ALIGNED(64) deque_t;
+
+static deque_t* _deques;
+static oe_once_t _deques_once = OE_ONCE_INIT;
+
+/* Deques owned by a worker (one bit per deque) */
+static volatile uint64_t _deques_used;
+
+/* The deque owned by the calling thread (SHARED_DEQUE if not a worker) */
+static __thread uint64_t _deque = SHARED_DEQUE;
+
+static volatile uint64_t _num_workers;
+static volatile uint64_t _max_threads = OE_PARALLEL_MAX_THREADS;
+
+/* Sleeping workers are woken when the epoch changes */
+static oe_mutex_t _sleep_mutex = OE_MUTEX_INITIALIZER;
+static oe_cond_t _sleep_cond = OE_COND_INITIALIZER;
+static volatile uint64_t _epoch;
+static volatile uint64_t _sleepers;
+
+static void _init_deques(void)
+{
+    const size_t size = NUM_DEQUES * sizeof(deque_t);
+
+    if ((_deques = (deque_t*)oe_memalign(64, size)))
+        memset(_deques, 0, size);
+}
+
+/* Own a free deque (SHARED_DEQUE if all are owned) */
+static uint64_t _claim_deque(void)
+{
+    for (;;)
+    {
+        uint64_t used = oe_atomic_load(&_deques_used);
+        uint64_t deque = 0;
+
+        while (deque < OE_PARALLEL_MAX_THREADS && (used & (1ull << deque)))
+            deque++;
+
+        if (deque == OE_PARALLEL_MAX_THREADS)
+            return SHARED_DEQUE;
+
+        if (oe_atomic_compare_and_swap(
+                &_deques_used, used, used | (1ull << deque)))
+            return deque;
+    }
+}
+
+static void _release_deque(uint64_t deque)
+{
+    for (;;)
+    {
+        uint64_t used = oe_atomic_load(&_deques_used);
+
+        if (oe_atomic_compare_and_swap(
+                &_deques_used, used, used & ~(1ull << deque)))
+            break;
+    }
+}
+
+static bool _push(uint64_t deque, const item_t* item)
+{
+    deque_t* d = &_deques[deque];
+    bool pushed = false;
+
+    oe_spin_lock(&d->lock);
+
+    if (d->tail - d->head < DEQUE_CAPACITY)
+    {
+        d->items[d->tail % DEQUE_CAPACITY] = *item;
+        d->tail++;
+        pushed = true;
+    }
+
+    oe_spin_unlock(&d->lock);
+
+    return pushed;
+}
+
+/* Take the newest item (own deque) or the oldest item (others) */
+static bool _pop(uint64_t deque, bool newest, item_t* item)
+{
+    deque_t* d = &_deques[deque];
+    bool popped = false;
+
+    if (d->head == d->tail)
+        return false;
+
+    oe_spin_lock(&d->lock);
+
+    if (d->head != d->tail)
+    {
+        if (newest)
+            *item = d->items[--d->tail % DEQUE_CAPACITY];
+        else
+            *item = d->items[d->head++ % DEQUE_CAPACITY];
+
+        popped = true;
+    }
+
+    oe_spin_unlock(&d->lock);
+
+    return popped;
+}
+
+/* Wake the sleeping workers to look for the work just queued */
+static void _notify(void)
+{
+    oe_atomic_increment(&_epoch);
+
+    if (oe_atomic_load(&_sleepers))
+    {
+        oe_mutex_lock(&_sleep_mutex);
+        oe_cond_broadcast(&_sleep_cond);
+        oe_mutex_unlock(&_sleep_mutex);
+    }
+}
+
+static void _run(uint64_t deque, item_t* item)
+{
+    job_t* job = item->job;
+    uint64_t begin = item->begin;
+    uint64_t end = item->end;
+
+    if (job->task)
+    {
+        volatile uint64_t* counter = job->counter;
+
+        job->task(job->arg);
+        oe_free(job);
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        oe_atomic_decrement(counter);
+        return;
+    }
+
+    /* Leave the upper halves to other threads */
+    while (end - begin > job->grain)
+    {
+        item_t upper = {job, begin + (end - begin) / 2, end};
+
+        if (!_push(deque, &upper))
+            break;
+
+        _notify();
+        end = upper.begin;
+    }
+
+    job->body(begin, end, job->arg);
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    oe_atomic_add(job->counter, end - begin);
+}
+
+/* Run one item of the own deque, the shared deque or another deque */
+static bool _run_one(uint64_t deque)
+{
+    item_t item;
+
+    if (_pop(deque, true, &item) ||
+        (deque != SHARED_DEQUE && _pop(SHARED_DEQUE, false, &item)))
+    {
+        _run(deque, &item);
+        return true;
+    }
+
+    /* Start with a different victim on each thread */
+    for (uint64_t i = 1; i < NUM_DEQUES; i++)
+    {
+        uint64_t victim = (deque + i) % NUM_DEQUES;
+
+        if (_pop(victim, false, &item))
+        {
+            _run(deque, &item);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Sleep until work is queued after the given epoch. Returns false if none
+ * was queued within the idle timeout */
+static bool _sleep(uint64_t epoch)
+{
+    bool woken = true;
+
+    oe_mutex_lock(&_sleep_mutex);
+    oe_atomic_increment(&_sleepers);
+
+    if (oe_atomic_load(&_epoch) == epoch)
+    {
+        uint64_t deadline =
+            (oe_get_time() + OE_PARALLEL_IDLE_TIMEOUT_MS) * 1000000;
+
+        if (oe_cond_timedwait(&_sleep_cond, &_sleep_mutex, deadline) ==
+                OE_TIMEOUT &&
+            oe_atomic_load(&_epoch) == epoch)
+        {
+            woken = false;
+        }
+    }
+
+    oe_atomic_decrement(&_sleepers);
+    oe_mutex_unlock(&_sleep_mutex);
+
+    return woken;
+}
+
+static void* _worker(void* arg)
+{
+    const uint64_t deque = _claim_deque();
+
+    OE_UNUSED(arg);
+
+    if (deque != SHARED_DEQUE)
+    {
+        _deque = deque;
+
+        for (;;)
+        {
+            uint64_t epoch = oe_atomic_load(&_epoch);
+            size_t spins = 0;
+
+            while (!_run_one(deque) && spins < WORKER_SPIN_COUNT)
+            {
+                OE_CPU_RELAX();
+                spins++;
+            }
+
+            if (spins == WORKER_SPIN_COUNT && !_sleep(epoch))
+                break;
+        }
+
+        /* Only the owner queues items on its deque, so it is empty now that
+         * the worker has found no work */
+        _deque = SHARED_DEQUE;
+        _release_deque(deque);
+    }
+
+    oe_atomic_decrement(&_num_workers);
+
+    return NULL;
+}
+
+/* Start workers until wanted are running (or none can be started) */
+static void _recruit(uint64_t wanted)
+{
+    const uint64_t max_workers = oe_atomic_load(&_max_threads) - 1;
+
+    if (wanted > max_workers)
+        wanted = max_workers;
+
+    for (;;)
+    {
+        uint64_t n = oe_atomic_load(&_num_workers);
+        oe_thread_t thread;
+
+        if (n >= wanted)
+            break;
+
+        if (!oe_atomic_compare_and_swap(&_num_workers, n, n + 1))
+            continue;
+
+        if (oe_thread_create(&thread, _worker, NULL) != OE_OK)
+        {
+            oe_atomic_decrement(&_num_workers);
+            break;
+        }
+
+        oe_thread_detach(thread);
+    }
+}
+
+/*
+**==============================================================================
+**
+** Public functions
+**
+**==============================================================================
+*/
+
+oe_result_t oe_parallel_for(
+    uint64_t begin,
+    uint64_t end,
+    uint64_t grain,
+    oe_parallel_for_body_t body,
+    void* arg)
+{
+    volatile uint64_t done = 0;
+    job_t job;
+    item_t item;
+    uint64_t deque = _deque;
+
+    if (!body || end < begin)
+        return OE_INVALID_PARAMETER;
+
+    if (grain == 0)
+        grain = 1;
+
+    /* Run small loops (and all loops without deques) on this thread */
+    if (end - begin <= grain || oe_atomic_load(&_max_threads) == 1 ||
+        oe_once(&_deques_once, _init_deques) != OE_OK || !_deques)
+    {
+        for (uint64_t i = begin, next; i < end; i = next)
+        {
+            next = end - i > grain ? i + grain : end;
+            body(i, next, arg);
+        }
+
+        return OE_OK;
+    }
+
+    job.body = body;
+    job.task = NULL;
+    job.arg = arg;
+    job.grain = grain;
+    job.counter = &done;
+
+    /* One worker per grain beyond the first: ceil((end - begin) / grain) - 1,
+     * computed without overflowing */
+    _recruit((end - begin - 1) / grain);
+
+    /* Split the loop as this thread runs it, then help the others */
+    item.job = &job;
+    item.begin = begin;
+    item.end = end;
+    _run(deque, &item);
+
+    while (oe_atomic_load(&done) != end - begin)
+    {
+        if (!_run_one(deque))
+            OE_CPU_RELAX();
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    return OE_OK;
+}
+
+oe_result_t oe_parallel_set_max_threads(size_t max_threads)
+{
+    if (max_threads == 0 || max_threads > OE_PARALLEL_MAX_THREADS)
+        return OE_INVALID_PARAMETER;
+
+    oe_atomic_store(&_max_threads, max_threads);
+
+    return OE_OK;
+}
+
+oe_result_t oe_task_group_run(
+    oe_task_group_t* group,
+    void (*func)(void*),
+    void* arg)
+{
+    job_t* job = NULL;
+    item_t item;
+
+    if (!group || !func)
+        return OE_INVALID_PARAMETER;
+
+    oe_atomic_increment(&group->pending);
+
+    if (oe_atomic_load(&_max_threads) > 1 &&
+        oe_once(&_deques_once, _init_deques) == OE_OK && _deques &&
+        (job = (job_t*)oe_calloc(1, sizeof(job_t))))
+    {
+        job->task = func;
+        job->arg = arg;
+        job->counter = &group->pending;
+
+        item.job = job;
+        item.begin = 0;
+        item.end = 1;
+
+        if (_push(_deque, &item))
+        {
+            _recruit(oe_atomic_load(&group->pending));
+            _notify();
+            return OE_OK;
+        }
+
+        oe_free(job);
+    }
+
+    /* Run the task now if it cannot be queued */
+    func(arg);
+    oe_atomic_decrement(&group->pending);
+
+    return OE_OK;
+}
+
+oe_result_t oe_task_group_wait(oe_task_group_t* group)
+{
+    if (!group)
+        return OE_INVALID_PARAMETER;
+
+    while (oe_atomic_load(&group->pending))
+    {
+        if (!_deques || !_run_one(_deque))
+            OE_CPU_RELAX();
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    return OE_OK;
+}
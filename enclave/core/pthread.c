@@ -3,6 +3,8 @@
 
 #include <openenclave/corelibc/errno.h>
 #include <openenclave/corelibc/pthread.h>
+#include <openenclave/corelibc/semaphore.h>
+#include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/defs.h>
 #include <openenclave/internal/thread.h>
@@ -28,11 +30,37 @@ OE_INLINE int _to_errno(oe_result_t result)
             return OE_EPERM;
         case OE_OUT_OF_MEMORY:
             return OE_ENOMEM;
+        case OE_TIMEOUT:
+            return OE_ETIMEDOUT;
+        case OE_OUT_OF_THREADS:
+            return OE_EAGAIN;
+        case OE_NOT_FOUND:
+            return OE_ESRCH;
+        case OE_UNSUPPORTED:
+            return OE_ENOSYS;
         default:
             return OE_EINVAL; /* unreachable */
     }
 }
 
+/* Convert an absolute time into a deadline in nanoseconds since the Epoch */
+static int _to_deadline(const struct oe_timespec* ts, uint64_t* deadline)
+{
+    const uint64_t ns_per_sec = 1000000000;
+
+    if (!ts || ts->tv_sec < 0 || ts->tv_nsec < 0 ||
+        (uint64_t)ts->tv_nsec >= ns_per_sec)
+        return OE_EINVAL;
+
+    /* Times too far in the future to represent never pass */
+    if ((uint64_t)ts->tv_sec >= (OE_UINT64_MAX - 1) / ns_per_sec - 1)
+        *deadline = OE_UINT64_MAX - 1;
+    else
+        *deadline = (uint64_t)ts->tv_sec * ns_per_sec + (uint64_t)ts->tv_nsec;
+
+    return 0;
+}
+
 /*
 **==============================================================================
 **
@@ -61,27 +89,21 @@ int oe_pthread_create(
     void* (*start_routine)(void*),
     void* arg)
 {
-    OE_UNUSED(thread);
+    /* Threads are created with the default attributes */
     OE_UNUSED(attr);
-    OE_UNUSED(start_routine);
-    OE_UNUSED(arg);
-    oe_assert("oe_pthread_create(): panic" == NULL);
-    return -1;
+
+    return _to_errno(
+        oe_thread_create((oe_thread_t*)thread, start_routine, arg));
 }
 
 int oe_pthread_join(oe_pthread_t thread, void** retval)
 {
-    OE_UNUSED(thread);
-    OE_UNUSED(retval);
-    oe_assert("oe_pthread_join(): panic" == NULL);
-    return -1;
+    return _to_errno(oe_thread_join((oe_thread_t)thread, retval));
 }
 
 int oe_pthread_detach(oe_pthread_t thread)
 {
-    OE_UNUSED(thread);
-    oe_assert("oe_pthread_detach(): panic" == NULL);
-    return -1;
+    return _to_errno(oe_thread_detach((oe_thread_t)thread));
 }
 
 /*
@@ -166,6 +188,19 @@ int oe_pthread_mutex_lock(oe_pthread_mutex_t* m)
     return _to_errno(oe_mutex_lock((oe_mutex_t*)m));
 }
 
+int oe_pthread_mutex_timedlock(
+    oe_pthread_mutex_t* m,
+    const struct oe_timespec* ts)
+{
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)))
+        return err;
+
+    return _to_errno(oe_mutex_timedlock((oe_mutex_t*)m, deadline));
+}
+
 int oe_pthread_mutex_trylock(oe_pthread_mutex_t* m)
 {
     return _to_errno(oe_mutex_trylock((oe_mutex_t*)m));
@@ -189,11 +224,55 @@ int oe_pthread_mutex_destroy(oe_pthread_mutex_t* m)
 **==============================================================================
 */
 
+/* The kind of the lock is kept after the process-shared flag */
+#define RWLOCKATTR_KIND 1
+
+int oe_pthread_rwlockattr_init(oe_pthread_rwlockattr_t* attr)
+{
+    if (!attr)
+        return OE_EINVAL;
+
+    attr->__private[0] = 0;
+    attr->__private[RWLOCKATTR_KIND] = OE_PTHREAD_RWLOCK_PREFER_READER_NP;
+    return 0;
+}
+
+int oe_pthread_rwlockattr_setkind_np(oe_pthread_rwlockattr_t* attr, int pref)
+{
+    if (!attr || pref < OE_PTHREAD_RWLOCK_PREFER_READER_NP ||
+        pref > OE_PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP)
+        return OE_EINVAL;
+
+    attr->__private[RWLOCKATTR_KIND] = (uint32_t)pref;
+    return 0;
+}
+
+int oe_pthread_rwlockattr_getkind_np(
+    const oe_pthread_rwlockattr_t* attr,
+    int* pref)
+{
+    if (!attr || !pref)
+        return OE_EINVAL;
+
+    *pref = (int)attr->__private[RWLOCKATTR_KIND];
+    return 0;
+}
+
+int oe_pthread_rwlockattr_destroy(oe_pthread_rwlockattr_t* attr)
+{
+    OE_UNUSED(attr);
+    return 0;
+}
+
 int oe_pthread_rwlock_init(
     oe_pthread_rwlock_t* rwlock,
     const oe_pthread_rwlockattr_t* attr)
 {
-    OE_UNUSED(attr);
+    /* Writer-preferring locks are distributed */
+    if (attr &&
+        attr->__private[RWLOCKATTR_KIND] != OE_PTHREAD_RWLOCK_PREFER_READER_NP)
+        return _to_errno(oe_rwlock_init_distributed((oe_rwlock_t*)rwlock));
+
     return _to_errno(oe_rwlock_init((oe_rwlock_t*)rwlock));
 }
 
@@ -207,6 +286,32 @@ int oe_pthread_rwlock_wrlock(oe_pthread_rwlock_t* rwlock)
     return _to_errno(oe_rwlock_wrlock((oe_rwlock_t*)rwlock));
 }
 
+int oe_pthread_rwlock_timedrdlock(
+    oe_pthread_rwlock_t* rwlock,
+    const struct oe_timespec* ts)
+{
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)))
+        return err;
+
+    return _to_errno(oe_rwlock_timedrdlock((oe_rwlock_t*)rwlock, deadline));
+}
+
+int oe_pthread_rwlock_timedwrlock(
+    oe_pthread_rwlock_t* rwlock,
+    const struct oe_timespec* ts)
+{
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)))
+        return err;
+
+    return _to_errno(oe_rwlock_timedwrlock((oe_rwlock_t*)rwlock, deadline));
+}
+
 int oe_pthread_rwlock_unlock(oe_pthread_rwlock_t* rwlock)
 {
     return _to_errno(oe_rwlock_unlock((oe_rwlock_t*)rwlock));
@@ -243,11 +348,14 @@ int oe_pthread_cond_timedwait(
     oe_pthread_mutex_t* mutex,
     const struct oe_timespec* ts)
 {
-    OE_UNUSED(cond);
-    OE_UNUSED(mutex);
-    OE_UNUSED(ts);
-    oe_assert("oe_pthread_cond_timedwait(): panic" == NULL);
-    return -1;
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)))
+        return err;
+
+    return _to_errno(
+        oe_cond_timedwait((oe_cond_t*)cond, (oe_mutex_t*)mutex, deadline));
 }
 
 int oe_pthread_cond_signal(oe_pthread_cond_t* cond)
@@ -265,6 +373,338 @@ int oe_pthread_cond_destroy(oe_pthread_cond_t* cond)
     return _to_errno(oe_cond_destroy((oe_cond_t*)cond));
 }
 
+/*
+**==============================================================================
+**
+** oe_pthread_barrier_t:
+**
+**     The threads that arrive at the barrier count themselves under its
+**     spinlock and wait on the generation word with oe_futex_wait(). The
+**     last thread to arrive starts a new generation and wakes them all.
+**     Where the futex cannot block, a waiter withdraws and fails with
+**     OE_ENOSYS instead of spinning until the others arrive.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_barrier_impl
+{
+    oe_spinlock_t lock;
+    uint32_t count;
+    uint32_t arrived;
+    volatile uint32_t generation;
+} oe_barrier_impl_t;
+
+OE_STATIC_ASSERT(sizeof(oe_barrier_impl_t) <= sizeof(oe_pthread_barrier_t));
+
+int oe_pthread_barrierattr_init(oe_pthread_barrierattr_t* attr)
+{
+    if (!attr)
+        return OE_EINVAL;
+
+    attr->__private = 0;
+    return 0;
+}
+
+int oe_pthread_barrierattr_destroy(oe_pthread_barrierattr_t* attr)
+{
+    OE_UNUSED(attr);
+    return 0;
+}
+
+int oe_pthread_barrier_init(
+    oe_pthread_barrier_t* barrier,
+    const oe_pthread_barrierattr_t* attr,
+    unsigned int count)
+{
+    oe_barrier_impl_t* b = (oe_barrier_impl_t*)barrier;
+
+    OE_UNUSED(attr);
+
+    if (!b || count == 0)
+        return OE_EINVAL;
+
+    memset(barrier, 0, sizeof(*barrier));
+    b->lock = OE_SPINLOCK_INITIALIZER;
+    b->count = count;
+
+    return 0;
+}
+
+int oe_pthread_barrier_wait(oe_pthread_barrier_t* barrier)
+{
+    oe_barrier_impl_t* b = (oe_barrier_impl_t*)barrier;
+    uint32_t generation;
+
+    if (!b)
+        return OE_EINVAL;
+
+    oe_spin_lock(&b->lock);
+    generation = b->generation;
+
+    if (++b->arrived == b->count)
+    {
+        b->arrived = 0;
+        __atomic_store_n(&b->generation, generation + 1, __ATOMIC_RELEASE);
+        oe_spin_unlock(&b->lock);
+
+        oe_futex_wake(&b->generation, OE_SIZE_MAX, NULL);
+        return OE_PTHREAD_BARRIER_SERIAL_THREAD;
+    }
+
+    oe_spin_unlock(&b->lock);
+
+    while (__atomic_load_n(&b->generation, __ATOMIC_ACQUIRE) == generation)
+    {
+        oe_result_t result =
+            oe_futex_wait(&b->generation, generation, OE_UINT64_MAX);
+
+        /* The futex cannot block (e.g. OE_UNSUPPORTED): withdraw the arrival
+         * unless the barrier completed meanwhile, rather than spin forever */
+        if (result != OE_OK && result != OE_BUSY)
+        {
+            oe_spin_lock(&b->lock);
+
+            if (b->generation == generation)
+            {
+                b->arrived--;
+                oe_spin_unlock(&b->lock);
+                oe_errno = OE_ENOSYS;
+                return OE_ENOSYS;
+            }
+
+            oe_spin_unlock(&b->lock);
+        }
+    }
+
+    return 0;
+}
+
+int oe_pthread_barrier_destroy(oe_pthread_barrier_t* barrier)
+{
+    oe_barrier_impl_t* b = (oe_barrier_impl_t*)barrier;
+    int ret = 0;
+
+    if (!b)
+        return OE_EINVAL;
+
+    oe_spin_lock(&b->lock);
+
+    /* Fail if threads are waiting at the barrier */
+    if (b->arrived)
+        ret = OE_EBUSY;
+
+    oe_spin_unlock(&b->lock);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** oe_sem_t:
+**
+**     A thread that finds the value of the semaphore zero counts itself as a
+**     waiter and waits on the value with oe_futex_wait(). A post increments
+**     the value before it reads the number of waiters, and a waiter counts
+**     itself before oe_futex_wait() re-reads the value, so either the post
+**     sees the waiter and wakes it or the waiter sees the new value.
+**
+**     Unlike the other functions of this file, these return -1 and set
+**     oe_errno on failure, as POSIX specifies.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_sem_impl
+{
+    volatile uint32_t value;
+    volatile uint32_t waiters;
+} oe_sem_impl_t;
+
+OE_STATIC_ASSERT(sizeof(oe_sem_impl_t) <= sizeof(oe_sem_t));
+
+int oe_sem_init(oe_sem_t* sem, int pshared, unsigned int value)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+
+    OE_UNUSED(pshared);
+
+    if (!s || value > OE_SEM_VALUE_MAX)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    memset(sem, 0, sizeof(*sem));
+    s->value = value;
+
+    return 0;
+}
+
+/* Decrement the value unless it is zero */
+static bool _sem_trywait(oe_sem_impl_t* s)
+{
+    uint32_t value = __atomic_load_n(&s->value, __ATOMIC_RELAXED);
+
+    while (value > 0)
+    {
+        if (__atomic_compare_exchange_n(
+                &s->value,
+                &value,
+                value - 1,
+                true,
+                __ATOMIC_ACQUIRE,
+                __ATOMIC_RELAXED))
+            return true;
+    }
+
+    return false;
+}
+
+static int _sem_wait_until(oe_sem_impl_t* s, uint64_t deadline)
+{
+    while (!_sem_trywait(s))
+    {
+        oe_result_t result;
+
+        __atomic_add_fetch(&s->waiters, 1, __ATOMIC_SEQ_CST);
+        result = oe_futex_wait(&s->value, 0, deadline);
+        __atomic_sub_fetch(&s->waiters, 1, __ATOMIC_RELAXED);
+
+        if (result == OE_TIMEOUT)
+        {
+            oe_errno = OE_ETIMEDOUT;
+            return -1;
+        }
+
+        /* OE_BUSY only means that the value changed before the wait */
+        if (result != OE_OK && result != OE_BUSY)
+        {
+            oe_errno = OE_ENOSYS;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int oe_sem_wait(oe_sem_t* sem)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+
+    if (!s)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    return _sem_wait_until(s, OE_UINT64_MAX);
+}
+
+int oe_sem_trywait(oe_sem_t* sem)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+
+    if (!s)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    if (!_sem_trywait(s))
+    {
+        oe_errno = OE_EAGAIN;
+        return -1;
+    }
+
+    return 0;
+}
+
+int oe_sem_timedwait(oe_sem_t* sem, const struct oe_timespec* ts)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+    uint64_t deadline;
+    int err;
+
+    if (!s)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    /* The deadline is not checked if the semaphore can be decremented */
+    if (_sem_trywait(s))
+        return 0;
+
+    if ((err = _to_deadline(ts, &deadline)))
+    {
+        oe_errno = err;
+        return -1;
+    }
+
+    return _sem_wait_until(s, deadline);
+}
+
+int oe_sem_post(oe_sem_t* sem)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+    uint32_t value;
+
+    if (!s)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    value = __atomic_load_n(&s->value, __ATOMIC_RELAXED);
+
+    do
+    {
+        if (value == OE_SEM_VALUE_MAX)
+        {
+            oe_errno = OE_EOVERFLOW;
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(
+        &s->value,
+        &value,
+        value + 1,
+        true,
+        __ATOMIC_SEQ_CST,
+        __ATOMIC_RELAXED));
+
+    if (__atomic_load_n(&s->waiters, __ATOMIC_SEQ_CST))
+        oe_futex_wake(&s->value, 1, NULL);
+
+    return 0;
+}
+
+int oe_sem_getvalue(oe_sem_t* sem, int* value)
+{
+    oe_sem_impl_t* s = (oe_sem_impl_t*)sem;
+
+    if (!s || !value)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    *value = (int)__atomic_load_n(&s->value, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int oe_sem_destroy(oe_sem_t* sem)
+{
+    if (!sem)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
 /*
 **==============================================================================
 **
@@ -0,0 +1,17 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_RUNTIME_ALLOC_H
+#define _OE_RUNTIME_ALLOC_H
+
+#include <openenclave/bits/types.h>
+
+/* Allocate and free the memory of the runtime's own state, which lives as
+ * long as the enclave or as a runtime object such as a slab cache (see
+ * malloc.c) */
+void* oe_runtime_malloc(size_t size);
+void* oe_runtime_calloc(size_t nmemb, size_t size);
+void* oe_runtime_memalign(size_t alignment, size_t size);
+void oe_runtime_free(void* ptr);
+
+#endif /* _OE_RUNTIME_ALLOC_H */
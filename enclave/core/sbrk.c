@@ -3,12 +3,15 @@
 
 #include <openenclave/enclave.h>
 #include <openenclave/internal/globals.h>
+#include <openenclave/internal/malloc.h>
 #include <openenclave/internal/thread.h>
 
+static unsigned char* _heap_next;
+static unsigned char* _heap_peak;
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
 void* oe_sbrk(ptrdiff_t increment)
 {
-    static unsigned char* _heap_next;
-    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
     void* ptr = (void*)-1;
 
     oe_spin_lock(&_lock);
@@ -24,9 +27,22 @@ void* oe_sbrk(ptrdiff_t increment)
         {
             ptr = _heap_next;
             _heap_next += increment;
+
+            if (_heap_next > _heap_peak)
+                _heap_peak = _heap_next;
         }
     }
     oe_spin_unlock(&_lock);
 
     return ptr;
 }
+
+void oe_get_sbrk_stats(uint64_t* sbrk_bytes, uint64_t* peak_sbrk_bytes)
+{
+    const unsigned char* base = (const unsigned char*)__oe_get_heap_base();
+
+    oe_spin_lock(&_lock);
+    *sbrk_bytes = _heap_next ? (uint64_t)(_heap_next - base) : 0;
+    *peak_sbrk_bytes = _heap_peak ? (uint64_t)(_heap_peak - base) : 0;
+    oe_spin_unlock(&_lock);
+}
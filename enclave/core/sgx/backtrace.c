@@ -8,6 +8,8 @@
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/raise.h>
+#include "../heapprofile.h"
+#include "td.h"
 
 #if defined(__INTEL_COMPILER)
 #error "optimized __builtin_return_address() not supported by Intel compiler"
@@ -30,13 +32,19 @@ const void* _check_address(const void* ptr)
  * if any function in the call-stack has been compiled with optimization, or is
  * a special function like global initializer.
  * This new implementation below safely walks up the call-stack, ensuring that
- * each potential-frame is not null and lies within the enclave.
+ * each potential-frame is not null and lies within the stack of the thread.
+ *
+ * Only debug malloc and the heap profiler need backtraces, so the walk is
+ * skipped otherwise.
  */
 int oe_backtrace(void** buffer, int size)
 {
     OE_UNUSED(buffer);
     OE_UNUSED(size);
-#ifdef OE_USE_DEBUG_MALLOC
+#ifndef OE_USE_DEBUG_MALLOC
+    if (!oe_heap_profiler_enabled())
+        return 0;
+#endif
     // Fetch the frame-pointer of the current function.
     // The current function oe_backtrace is not expected to be inlined.
     // The rbp register contains the frame-pointer upon entry to the function.
@@ -60,13 +68,20 @@ int oe_backtrace(void** buffer, int size)
     // just like other general-purpose register and hold some value rather than
     // the frame-pointer. While frame[1] always contains the return address,
     // frame[0] may not always contain the pointer to callee's stack frame.
-    // To be on the safer-side, we always check that the values we access
-    // while traversing the stack always lie within the enclave.
+    // To be on the safer-side, we always check that the frames we access
+    // while traversing the stack lie within the stack of the thread, that
+    // the return addresses lie within the enclave, and that each frame lies
+    // above the previous one so that the walk terminates.
+    const void* stack_base;
+    const void* stack_end;
+    td_get_stack(oe_get_td(), &stack_base, &stack_end);
+
     int n = 0;
     while (n < size)
     {
         // Ensure that the current frame is safe to access.
-        if (!_check_address(frame))
+        if ((const void*)frame < stack_base ||
+            (const void*)(frame + 2) > stack_end)
             break;
 
         // Ensure that the return address is valid.
@@ -75,11 +90,12 @@ int oe_backtrace(void** buffer, int size)
 
         // Store address and move to previous frame.
         buffer[n++] = frame[1];
+
+        if ((void**)*frame <= frame)
+            break;
+
         frame = (void**)*frame;
     }
 
     return n;
-#else
-    return 0;
-#endif
 }
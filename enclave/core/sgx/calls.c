@@ -23,8 +23,10 @@
 #include "../atexit.h"
 #include "asmdefs.h"
 #include "cpuid.h"
+#include "deferred.h"
 #include "init.h"
 #include "report.h"
+#include "switchless.h"
 #include "td.h"
 
 oe_result_t __oe_enclave_status = OE_OK;
@@ -237,10 +239,156 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** ECALL scratch buffers:
+**
+**     Each TCS keeps a scratch buffer in enclave memory that holds the input
+**     and output buffers of the ECALLs it handles, so that the allocator is
+**     not called (and its global lock not taken) on every ECALL. The buffer
+**     starts at a size derived from the heap size and TCS count and grows on
+**     demand up to a limit; larger ECALLs, and ECALLs made while the buffer
+**     is in use (by the switchless ECALL worker running on this TCS), use
+**     the heap.
+**
+**     The buffers are linked together so that the destructor can release
+**     them before checking for leaks. It also detaches them from their TCS,
+**     and ECALLs made after it has run use the heap.
+**
+**==============================================================================
+*/
+
+typedef struct _ecall_scratch
+{
+    struct _ecall_scratch* next;
+
+    /* The thread data of the TCS that owns the buffer */
+    td_t* td;
+
+    uint8_t* buffer;
+    size_t size;
+    bool busy;
+} ecall_scratch_t;
+
+static ecall_scratch_t* _ecall_scratches;
+static oe_spinlock_t _ecall_scratches_lock = OE_SPINLOCK_INITIALIZER;
+
+/* Set once the destructor has released the buffers */
+static bool _ecall_scratches_released;
+
+#define ECALL_SCRATCH_MIN_SIZE OE_PAGE_SIZE
+#define ECALL_SCRATCH_MAX_SIZE (1024 * 1024)
+
+/* Together, the initial buffers take up to 1/64 of the heap, and the
+ * largest buffers up to 1/4 of it */
+#define ECALL_SCRATCH_INITIAL_SHARE 64
+#define ECALL_SCRATCH_LIMIT_SHARE 4
+
+/* Returns the heap size divided among all TCSs and by share, in pages */
+static size_t _ecall_scratch_size(size_t share)
+{
+    uint64_t num_tcs = oe_get_num_tcs();
+    size_t size = __oe_get_heap_size() / ((num_tcs ? num_tcs : 1) * share);
+
+    size = oe_round_down_to_page_size(size);
+
+    if (size < ECALL_SCRATCH_MIN_SIZE)
+        return ECALL_SCRATCH_MIN_SIZE;
+
+    if (size > ECALL_SCRATCH_MAX_SIZE)
+        return ECALL_SCRATCH_MAX_SIZE;
+
+    return size;
+}
+
+static uint8_t* _allocate_ecall_buffer(td_t* td, size_t size)
+{
+    ecall_scratch_t* scratch = (ecall_scratch_t*)td->ecall_scratch;
+
+    if (!scratch)
+    {
+        size_t initial_size = _ecall_scratch_size(ECALL_SCRATCH_INITIAL_SHARE);
+
+        if (_ecall_scratches_released)
+            return oe_malloc(size);
+
+        if (!(scratch = oe_calloc(1, sizeof(ecall_scratch_t))))
+            return oe_malloc(size);
+
+        if (!(scratch->buffer = oe_malloc(initial_size)))
+        {
+            oe_free(scratch);
+            return oe_malloc(size);
+        }
+
+        scratch->td = td;
+        scratch->size = initial_size;
+
+        oe_spin_lock(&_ecall_scratches_lock);
+        scratch->next = _ecall_scratches;
+        _ecall_scratches = scratch;
+        oe_spin_unlock(&_ecall_scratches_lock);
+
+        td->ecall_scratch = scratch;
+    }
+
+    if (scratch->busy || size > _ecall_scratch_size(ECALL_SCRATCH_LIMIT_SHARE))
+        return oe_malloc(size);
+
+    if (size > scratch->size)
+    {
+        size_t new_size = scratch->size;
+        uint8_t* buffer;
+
+        while (new_size < size)
+            new_size *= 2;
+
+        if (!(buffer = oe_malloc(new_size)))
+            return oe_malloc(size);
+
+        oe_free(scratch->buffer);
+        scratch->buffer = buffer;
+        scratch->size = new_size;
+    }
+
+    scratch->busy = true;
+
+    return scratch->buffer;
+}
+
+static void _free_ecall_buffer(td_t* td, uint8_t* buffer)
+{
+    ecall_scratch_t* scratch = (ecall_scratch_t*)td->ecall_scratch;
+
+    if (scratch && buffer == scratch->buffer)
+        scratch->busy = false;
+    else
+        oe_free(buffer);
+}
+
+static void _free_ecall_scratches(void)
+{
+    oe_spin_lock(&_ecall_scratches_lock);
+
+    while (_ecall_scratches)
+    {
+        ecall_scratch_t* next = _ecall_scratches->next;
+
+        _ecall_scratches->td->ecall_scratch = NULL;
+        oe_free(_ecall_scratches->buffer);
+        oe_free(_ecall_scratches);
+        _ecall_scratches = next;
+    }
+
+    _ecall_scratches_released = true;
+    oe_spin_unlock(&_ecall_scratches_lock);
+}
+
 /**
  * This is the preferred way to call enclave functions.
  */
-static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in)
 {
     oe_call_enclave_function_args_t args, *args_ptr;
     oe_result_t result = OE_OK;
@@ -251,6 +399,7 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     size_t buffer_size = 0;
     size_t output_bytes_written = 0;
     ecall_table_t ecall_table;
+    td_t* td = oe_get_td();
 
     // Ensure that args lies outside the enclave.
     if (!oe_is_outside_enclave(
@@ -314,7 +463,7 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
         OE_RAISE(OE_NOT_FOUND);
 
     // Allocate buffers in enclave memory
-    buffer = input_buffer = oe_malloc(buffer_size);
+    buffer = input_buffer = _allocate_ecall_buffer(td, buffer_size);
     if (buffer == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
@@ -352,11 +501,66 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
 
 done:
     if (buffer)
-        oe_free(buffer);
+        _free_ecall_buffer(td, buffer);
 
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _handle_call_enclave_functions()
+**
+**     Handle a batch of calls to enclave functions within a single ECALL.
+**     Each call is validated and handled like the argument of an
+**     OE_ECALL_CALL_ENCLAVE_FUNCTION, and its result is reported in the call
+**     itself so that a failed call does not stop the batch.
+**
+**==============================================================================
+*/
+
+static oe_result_t _handle_call_enclave_functions(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_functions_args_t args;
+    oe_call_enclave_function_args_t* calls;
+    uint64_t calls_size;
+
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_functions_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args = *(oe_call_enclave_functions_args_t*)arg_in;
+    calls = args.calls;
+
+    OE_CHECK(oe_safe_mul_u64(
+        args.num_calls, sizeof(oe_call_enclave_function_args_t), &calls_size));
+
+    if (!calls || !oe_is_outside_enclave(calls, calls_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (uint64_t i = 0; i < args.num_calls; i++)
+    {
+        oe_result_t call_result;
+
+        // Leave the remaining calls unmade if the enclave has crashed.
+        if (oe_get_enclave_status() != OE_OK)
+            break;
+
+        call_result = oe_handle_call_enclave_function((uint64_t)&calls[i]);
+
+        // A successful call sets its own result.
+        if (call_result != OE_OK)
+            calls[i].result = call_result;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -369,7 +573,9 @@ done:
 
 static void _handle_exit(oe_code_t code, uint16_t func, uint64_t arg)
 {
-    oe_exit_enclave(oe_make_call_arg1(code, func, 0, OE_OK), arg);
+    uint16_t flags = oe_hand_over_deferred_ocalls(oe_get_td());
+
+    oe_exit_enclave(oe_make_call_arg1(code, func, flags, OE_OK), arg);
 }
 
 void oe_virtual_exception_dispatcher(
@@ -441,7 +647,12 @@ static void _handle_ecall(
     {
         case OE_ECALL_CALL_ENCLAVE_FUNCTION:
         {
-            arg_out = _handle_call_enclave_function(arg_in);
+            arg_out = oe_handle_call_enclave_function(arg_in);
+            break;
+        }
+        case OE_ECALL_CALL_ENCLAVE_FUNCTIONS:
+        {
+            arg_out = _handle_call_enclave_functions(arg_in);
             break;
         }
         case OE_ECALL_DESTRUCTOR:
@@ -452,6 +663,9 @@ static void _handle_ecall(
             /* Call all finalization functions */
             oe_call_fini_functions();
 
+            /* Release the ECALL scratch buffers of all threads */
+            _free_ecall_scratches();
+
 #if defined(OE_USE_DEBUG_MALLOC)
 
             /* If memory still allocated, print a trace and return an error */
@@ -511,7 +725,8 @@ done:
     td_pop_callsite(td);
 
     /* Perform ERET, giving control back to host */
-    *output_arg1 = oe_make_call_arg1(OE_CODE_ERET, func, 0, result);
+    *output_arg1 = oe_make_call_arg1(
+        OE_CODE_ERET, func, oe_hand_over_deferred_ocalls(td), result);
     *output_arg2 = arg_out;
 }
 
@@ -631,18 +846,24 @@ oe_result_t oe_call_host_function_by_table_id(
     size_t input_buffer_size,
     void* output_buffer,
     size_t output_buffer_size,
-    size_t* output_bytes_written)
+    size_t* output_bytes_written,
+    bool switchless)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_host_function_args_t* args = NULL;
+    bool switchless_args = false;
 
     /* Reject invalid parameters */
     if (!input_buffer || input_buffer_size == 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Switchless calls carry their arguments along with their buffer */
+    if (switchless && (args = oe_get_switchless_ocall_args(input_buffer)))
+        switchless_args = true;
+
     /* Initialize the arguments */
     {
-        if (!(args = oe_host_calloc(1, sizeof(*args))))
+        if (!args && !(args = oe_allocate_ocall_buffer(sizeof(*args))))
         {
             /* Fail if the enclave is crashing. */
             OE_CHECK(__oe_enclave_status);
@@ -655,11 +876,17 @@ oe_result_t oe_call_host_function_by_table_id(
         args->input_buffer_size = input_buffer_size;
         args->output_buffer = output_buffer;
         args->output_buffer_size = output_buffer_size;
+        args->output_bytes_written = 0;
         args->result = OE_UNEXPECTED;
     }
 
-    /* Call the host function with this address */
-    OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST_FUNCTION, (uint64_t)args, NULL));
+    /* Call the host function with this address, unless a host worker
+     * carried out the call switchlessly. A switchless call would overtake
+     * the deferred OCALLs of the thread, which an ordinary OCALL hands over
+     * to the host first. */
+    if (!switchless_args || oe_has_deferred_ocalls(oe_get_td()) ||
+        !oe_post_switchless_ocall(args))
+        OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST_FUNCTION, (uint64_t)args, NULL));
 
     /* Check the result */
     OE_CHECK(args->result);
@@ -669,7 +896,8 @@ oe_result_t oe_call_host_function_by_table_id(
 
 done:
 
-    oe_host_free(args);
+    if (!switchless_args)
+        oe_free_ocall_buffer(args);
 
     return result;
 }
@@ -698,7 +926,35 @@ oe_result_t oe_call_host_function(
         input_buffer_size,
         output_buffer,
         output_buffer_size,
-        output_bytes_written);
+        output_bytes_written,
+        false);
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_host_function()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_host_function_by_table_id(
+        OE_UINT64_MAX,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written,
+        true);
 }
 
 /*
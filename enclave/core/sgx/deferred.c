@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/safecrt.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/utils.h>
+#include "deferred.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Deferred OCALLs:
+**
+**     OCALLs that return nothing to the enclave are appended to the
+**     deferred OCALL queue of the calling TCS instead of exiting the
+**     enclave. The host carries out the queued calls the next time the TCS
+**     exits, before handling the exit itself, so the deferred calls are
+**     ordered with respect to the ordinary OCALLs of the same thread. A full
+**     queue is drained by an OCALL that does nothing else. Switchless
+**     OCALLs are made as ordinary OCALLs while the queue holds calls, so
+**     that they do not overtake them.
+**
+**     The calls still queued when the enclave aborts are lost. Console and
+**     log output is therefore never deferred.
+**
+**     The queue lives in host memory and is only written by the enclave:
+**     the enclave relies on td->deferred_ocall_queue_used and
+**     td->deferred_ocall_queue_calls alone and rewrites the queue header
+**     whenever a call is queued.
+**
+**     td->deferred_ocall_pending is set while a call is being prepared in
+**     the queue. The queue is not handed over to the host while it is set
+**     (an exception may exit the enclave at any point), and the thread
+**     makes its other OCALLs synchronously in the meantime.
+**
+**==============================================================================
+*/
+
+#define HEADER_SIZE sizeof(oe_deferred_ocall_queue_t)
+
+OE_STATIC_ASSERT(HEADER_SIZE % OE_DEFERRED_OCALL_ALIGNMENT == 0);
+OE_STATIC_ASSERT(
+    sizeof(oe_deferred_ocall_t) % OE_DEFERRED_OCALL_ALIGNMENT == 0);
+
+/* Ask the host for the queue of this TCS, draining it if it holds calls */
+static oe_deferred_ocall_queue_t* _get_queue(td_t* td)
+{
+    uint64_t arg_out = 0;
+
+    if (td->deferred_ocall_queue && !td->deferred_ocall_queue_calls)
+        return (oe_deferred_ocall_queue_t*)td->deferred_ocall_queue;
+
+    if (oe_ocall(
+            OE_OCALL_GET_DEFERRED_OCALL_QUEUE,
+            OE_DEFERRED_OCALL_QUEUE_SIZE,
+            &arg_out) != OE_OK ||
+        !arg_out)
+        return NULL;
+
+    if (!oe_is_outside_enclave((void*)arg_out, OE_DEFERRED_OCALL_QUEUE_SIZE))
+        oe_abort();
+
+    /* The exit handed the queued calls over to the host */
+    td->deferred_ocall_queue = (void*)arg_out;
+    td->deferred_ocall_queue_used = HEADER_SIZE;
+    td->deferred_ocall_queue_calls = 0;
+
+    return (oe_deferred_ocall_queue_t*)td->deferred_ocall_queue;
+}
+
+/* The call being prepared (or to be prepared next) in the queue */
+OE_INLINE oe_deferred_ocall_t* _pending_call(td_t* td)
+{
+    return (oe_deferred_ocall_t*)((uint8_t*)td->deferred_ocall_queue +
+                                  td->deferred_ocall_queue_used);
+}
+
+/* Reserve a call with size bytes of arguments, or return null */
+static oe_deferred_ocall_t* _reserve(td_t* td, uint16_t func, size_t size)
+{
+    oe_deferred_ocall_t* call;
+    uint64_t needed;
+
+    if (td->deferred_ocall_pending || !td_initialized(td) || !td->callsites ||
+        oe_get_enclave_status() != OE_OK)
+        return NULL;
+
+    if (size > OE_DEFERRED_OCALL_QUEUE_SIZE - HEADER_SIZE - sizeof(*call))
+        return NULL;
+
+    needed = sizeof(*call) +
+             oe_round_up_to_multiple(size, OE_DEFERRED_OCALL_ALIGNMENT);
+
+    /* Drain the queue if the call does not fit */
+    if (!td->deferred_ocall_queue ||
+        needed > OE_DEFERRED_OCALL_QUEUE_SIZE - td->deferred_ocall_queue_used)
+    {
+        if (!_get_queue(td))
+            return NULL;
+    }
+
+    /* Claim the room before writing into it, in case an exception handler
+     * defers calls of its own in the meantime */
+    td->deferred_ocall_pending = needed;
+
+    if (needed > OE_DEFERRED_OCALL_QUEUE_SIZE - td->deferred_ocall_queue_used)
+    {
+        td->deferred_ocall_pending = 0;
+        return NULL;
+    }
+
+    call = _pending_call(td);
+    call->func = func;
+    call->arg_in = size ? (uint64_t)(call + 1) : 0;
+    call->size = needed;
+    call->reserved = 0;
+
+    return call;
+}
+
+/* Queue the call reserved by _reserve() */
+static void _post(td_t* td)
+{
+    oe_deferred_ocall_queue_t* queue =
+        (oe_deferred_ocall_queue_t*)td->deferred_ocall_queue;
+
+    td->deferred_ocall_queue_used += td->deferred_ocall_pending;
+    td->deferred_ocall_queue_calls++;
+
+    queue->num_calls = td->deferred_ocall_queue_calls;
+    queue->size = td->deferred_ocall_queue_used;
+
+    /* The queue may be handed over from now on */
+    td->deferred_ocall_pending = 0;
+}
+
+/* Returns the arguments of the call being prepared, or null */
+static void* _pending_args(td_t* td)
+{
+    if (!td->deferred_ocall_pending)
+        return NULL;
+
+    return _pending_call(td) + 1;
+}
+
+/*
+**==============================================================================
+**
+** oe_defer_ocall()
+** oe_allocate_deferred_ocall()
+** oe_post_deferred_ocall()
+** oe_cancel_deferred_ocall()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_defer_ocall(uint16_t func, uint64_t arg_in)
+{
+    td_t* td = oe_get_td();
+    oe_deferred_ocall_t* call;
+
+    if (!(call = _reserve(td, func, 0)))
+        return OE_UNSUPPORTED;
+
+    call->arg_in = arg_in;
+    _post(td);
+
+    return OE_OK;
+}
+
+void* oe_allocate_deferred_ocall(uint16_t func, size_t size)
+{
+    oe_deferred_ocall_t* call;
+
+    if (size == 0 || !(call = _reserve(oe_get_td(), func, size)))
+        return NULL;
+
+    return call + 1;
+}
+
+void oe_post_deferred_ocall(void* args)
+{
+    td_t* td = oe_get_td();
+
+    if (args && args == _pending_args(td))
+        _post(td);
+}
+
+void oe_cancel_deferred_ocall(void* args)
+{
+    td_t* td = oe_get_td();
+
+    if (args && args == _pending_args(td))
+        td->deferred_ocall_pending = 0;
+}
+
+/*
+**==============================================================================
+**
+** oe_hand_over_deferred_ocalls()
+**
+**==============================================================================
+*/
+
+uint16_t oe_hand_over_deferred_ocalls(td_t* td)
+{
+    if (!td->deferred_ocall_queue_calls || td->deferred_ocall_pending)
+        return 0;
+
+    /* The host drains the queue before the thread enters the enclave again */
+    td->deferred_ocall_queue_used = HEADER_SIZE;
+    td->deferred_ocall_queue_calls = 0;
+
+    return OE_CALL_FLAG_DEFERRED_OCALLS;
+}
+
+/*
+**==============================================================================
+**
+** oe_allocate_deferred_ocall_buffer()
+** oe_free_deferred_ocall_buffer()
+** oe_deferred_call_host_function()
+**
+**     The marshaling buffer of a deferred EDL OCALL follows its
+**     oe_call_host_function_args_t in the deferred OCALL queue. When the
+**     buffer does not fit into the queue, it is allocated like that of an
+**     ordinary OCALL and the call is made as an ordinary OCALL.
+**
+**==============================================================================
+*/
+
+void* oe_allocate_deferred_ocall_buffer(size_t size)
+{
+    oe_call_host_function_args_t* args = NULL;
+
+    if (size <= OE_DEFERRED_OCALL_QUEUE_SIZE)
+        args = oe_allocate_deferred_ocall(
+            OE_OCALL_CALL_HOST_FUNCTION, sizeof(*args) + size);
+
+    if (args)
+        return args + 1;
+
+    return oe_allocate_ocall_buffer(size);
+}
+
+void oe_free_deferred_ocall_buffer(void* buffer)
+{
+    td_t* td = oe_get_td();
+    uint8_t* queue = (uint8_t*)td->deferred_ocall_queue;
+
+    if (!buffer)
+        return;
+
+    if (queue && (uint8_t*)buffer >= queue &&
+        (uint8_t*)buffer < queue + OE_DEFERRED_OCALL_QUEUE_SIZE)
+    {
+        /* The call was not posted if it is still pending */
+        oe_cancel_deferred_ocall((oe_call_host_function_args_t*)buffer - 1);
+        return;
+    }
+
+    oe_free_ocall_buffer(buffer);
+}
+
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    td_t* td = oe_get_td();
+    oe_call_host_function_args_t* args = _pending_args(td);
+
+    if (!args || input_buffer != args + 1 || !output_bytes_written)
+    {
+        return oe_call_host_function(
+            function_id,
+            input_buffer,
+            input_buffer_size,
+            output_buffer,
+            output_buffer_size,
+            output_bytes_written);
+    }
+
+    args->table_id = OE_UINT64_MAX;
+    args->function_id = function_id;
+    args->input_buffer = input_buffer;
+    args->input_buffer_size = input_buffer_size;
+    args->output_buffer = output_buffer;
+    args->output_buffer_size = output_buffer_size;
+    args->output_bytes_written = 0;
+    args->result = OE_UNEXPECTED;
+
+    oe_post_deferred_ocall(args);
+
+    *output_bytes_written = 0;
+
+    return OE_OK;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_ENCLAVE_CORE_DEFERRED_H
+#define _OE_ENCLAVE_CORE_DEFERRED_H
+
+#include <openenclave/internal/sgxtypes.h>
+
+/* Called as the thread exits the enclave: returns the flags of the exit
+ * (OE_CALL_FLAG_DEFERRED_OCALLS if the host must carry out the calls in the
+ * thread's deferred OCALL queue first) */
+uint16_t oe_hand_over_deferred_ocalls(td_t* td);
+
+/* Whether the thread's deferred OCALL queue holds calls not handed over to
+ * the host yet */
+OE_INLINE bool oe_has_deferred_ocalls(const td_t* td)
+{
+    return td->deferred_ocall_queue_calls != 0;
+}
+
+#endif /* _OE_ENCLAVE_CORE_DEFERRED_H */
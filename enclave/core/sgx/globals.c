@@ -264,3 +264,20 @@ uint64_t oe_get_num_pages(void)
 {
     return __oe_get_enclave_size() / OE_PAGE_SIZE;
 }
+
+uint64_t oe_get_num_tcs(void)
+{
+    return oe_enclave_properties_sgx.header.size_settings.num_tcs;
+}
+
+uint64_t oe_get_num_stack_pages(void)
+{
+    return oe_enclave_properties_sgx.header.size_settings.num_stack_pages;
+}
+
+uint32_t oe_get_lock_spin_count(void)
+{
+    const uint32_t count = oe_enclave_properties_sgx.config.lock_spin_count;
+
+    return count ? count : OE_SGX_DEFAULT_LOCK_SPIN_COUNT;
+}
@@ -0,0 +1,464 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "../hostpool.h"
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/hostpool.h>
+#include <openenclave/internal/thread.h>
+#include "../runtimealloc.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Untrusted memory pool:
+**
+**     oe_host_malloc() and oe_host_free() would otherwise make an OCALL
+**     each. Instead, the enclave asks the host for regions of host memory
+**     with OE_OCALL_GROW_HOST_POOL and allocates blocks from them itself:
+**
+**         (1) Each region is divided into spans of SPAN_SIZE bytes. A span
+**             holds blocks of a single size class (powers of two from 16
+**             bytes to 64KB) and returns to the unused spans once all its
+**             blocks are free.
+**         (2) Each TCS keeps a cache of free blocks per size class, which
+**             only the thread running on that TCS touches. An empty cache
+**             takes a batch of blocks from the spans, a full cache gives a
+**             batch back, both under a single spinlock.
+**         (3) Only when no span has a free block does the pool grow by one
+**             region, with an OCALL.
+**
+**     The host can write the regions at any time, so all the bookkeeping
+**     (the spans and their bitmaps of free blocks) lives in enclave memory
+**     and nothing is ever read from a block. Regions are checked with
+**     oe_is_outside_enclave() when they are added.
+**
+**     Regions are never returned to the host: it frees them when the
+**     enclave is terminated. The pool is enabled with
+**     OE_ENABLE_HOST_MEMORY_POOL().
+**
+**==============================================================================
+*/
+
+#define SPAN_SIZE (64 * 1024)
+#define SPANS_PER_REGION (OE_HOST_POOL_REGION_SIZE / SPAN_SIZE)
+#define MIN_BLOCK_SIZE 16
+#define NUM_CLASSES 13
+#define MAX_BLOCKS_PER_SPAN (SPAN_SIZE / MIN_BLOCK_SIZE)
+#define MAX_CACHED_BLOCKS 16
+#define MAX_CACHED_BYTES_PER_CLASS (128 * 1024)
+#define NO_CLASS OE_UINT32_MAX
+
+OE_STATIC_ASSERT(OE_HOST_POOL_REGION_SIZE % SPAN_SIZE == 0);
+OE_STATIC_ASSERT((MIN_BLOCK_SIZE << (NUM_CLASSES - 1)) == SPAN_SIZE);
+
+/* Overridden by OE_ENABLE_HOST_MEMORY_POOL() */
+__attribute__((weak)) const bool oe_host_memory_pool = false;
+
+typedef struct _span
+{
+    /* Host memory of the span */
+    uint8_t* base;
+
+    /* Size class of the blocks, or NO_CLASS while the span is unused */
+    uint32_t size_class;
+
+    /* Number of set bits in free_map */
+    uint32_t num_free;
+
+    /* A set bit marks a free block */
+    uint64_t free_map[MAX_BLOCKS_PER_SPAN / 64];
+
+    /* Links of the list of spans of the size class that have free blocks,
+     * or of the list of unused spans */
+    struct _span* prev;
+    struct _span* next;
+} Span;
+
+typedef struct _region
+{
+    uint8_t* base;
+    Span spans[SPANS_PER_REGION];
+} Region;
+
+typedef struct _cache
+{
+    uint32_t counts[NUM_CLASSES];
+    void* blocks[NUM_CLASSES][MAX_CACHED_BLOCKS];
+} Cache;
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/* Regions are only ever added, so they are looked up without the lock */
+static Region* _regions[OE_HOST_POOL_MAX_REGIONS];
+static size_t _num_regions;
+
+/* Spans with free blocks, per size class, and spans not in use */
+static Span* _partial[NUM_CLASSES];
+static Span* _unused;
+
+static size_t _class_size(size_t c)
+{
+    return (size_t)MIN_BLOCK_SIZE << c;
+}
+
+/* Smallest class whose blocks can hold size bytes */
+static size_t _size_class(size_t size)
+{
+    if (size <= MIN_BLOCK_SIZE)
+        return 0;
+
+    return (size_t)(64 - __builtin_clzll(size - 1)) - 4;
+}
+
+static size_t _blocks_per_span(size_t c)
+{
+    return SPAN_SIZE / _class_size(c);
+}
+
+/* Blocks of the class that a cache holds at most */
+static size_t _cache_capacity(size_t c)
+{
+    size_t capacity = MAX_CACHED_BYTES_PER_CLASS / _class_size(c);
+
+    if (capacity < 2)
+        return 2;
+
+    return capacity < MAX_CACHED_BLOCKS ? capacity : MAX_CACHED_BLOCKS;
+}
+
+static void _push(Span** list, Span* span)
+{
+    span->prev = NULL;
+    span->next = *list;
+
+    if (*list)
+        (*list)->prev = span;
+
+    *list = span;
+}
+
+static void _remove(Span** list, Span* span)
+{
+    if (span->prev)
+        span->prev->next = span->next;
+    else
+        *list = span->next;
+
+    if (span->next)
+        span->next->prev = span->prev;
+}
+
+/* Returns the span of a block and its index in the span, or null if ptr is
+ * not in the pool. Aborts if ptr is in the pool but is not a block */
+static Span* _find_span(const void* ptr, size_t* index)
+{
+    size_t num_regions = __atomic_load_n(&_num_regions, __ATOMIC_ACQUIRE);
+    const uint8_t* p = (const uint8_t*)ptr;
+
+    for (size_t i = 0; i < num_regions; i++)
+    {
+        Region* region = _regions[i];
+
+        if (p >= region->base && p < region->base + OE_HOST_POOL_REGION_SIZE)
+        {
+            size_t offset = (size_t)(p - region->base);
+            Span* span = &region->spans[offset / SPAN_SIZE];
+            size_t size;
+
+            if (span->size_class == NO_CLASS)
+                oe_abort();
+
+            size = _class_size(span->size_class);
+            offset %= SPAN_SIZE;
+
+            if (offset % size != 0)
+                oe_abort();
+
+            *index = offset / size;
+            return span;
+        }
+    }
+
+    return NULL;
+}
+
+/* Take up to count free blocks of the class (called with the lock held) */
+static size_t _take(size_t c, void** blocks, size_t count)
+{
+    const size_t size = _class_size(c);
+    size_t taken = 0;
+
+    while (taken < count)
+    {
+        Span* span = _partial[c];
+
+        if (!span)
+        {
+            const size_t num_blocks = _blocks_per_span(c);
+
+            if (!(span = _unused))
+                break;
+
+            _remove(&_unused, span);
+
+            span->size_class = (uint32_t)c;
+            span->num_free = (uint32_t)num_blocks;
+
+            for (size_t w = 0; w < OE_COUNTOF(span->free_map); w++)
+            {
+                if (w * 64 >= num_blocks)
+                    span->free_map[w] = 0;
+                else if (num_blocks - w * 64 >= 64)
+                    span->free_map[w] = OE_UINT64_MAX;
+                else
+                    span->free_map[w] = (1ULL << (num_blocks - w * 64)) - 1;
+            }
+
+            _push(&_partial[c], span);
+        }
+
+        for (size_t w = 0; taken < count && span->num_free; w++)
+        {
+            uint64_t bits = span->free_map[w];
+
+            while (bits && taken < count)
+            {
+                size_t index = w * 64 + (size_t)__builtin_ctzll(bits);
+
+                bits &= bits - 1;
+                span->num_free--;
+                blocks[taken++] = span->base + index * size;
+            }
+
+            span->free_map[w] = bits;
+        }
+
+        if (!span->num_free)
+            _remove(&_partial[c], span);
+    }
+
+    return taken;
+}
+
+/* Free a block (called with the lock held) */
+static void _give(Span* span, size_t index)
+{
+    const size_t c = span->size_class;
+    const uint64_t mask = 1ULL << (index % 64);
+
+    /* Double free */
+    if (span->free_map[index / 64] & mask)
+        oe_abort();
+
+    span->free_map[index / 64] |= mask;
+
+    if (span->num_free++ == 0)
+        _push(&_partial[c], span);
+
+    if (span->num_free == _blocks_per_span(c))
+    {
+        _remove(&_partial[c], span);
+        span->size_class = NO_CLASS;
+        _push(&_unused, span);
+    }
+}
+
+/* Give count blocks back (called with the lock held) */
+static void _give_blocks(void** blocks, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t index;
+        Span* span = _find_span(blocks[i], &index);
+
+        if (!span)
+            oe_abort();
+
+        _give(span, index);
+    }
+}
+
+/* Add a region of host memory to the pool. Returns false on failure */
+static bool _grow(void)
+{
+    uint64_t arg_out = 0;
+    Region* region;
+    bool added = false;
+
+    if (__atomic_load_n(&_num_regions, __ATOMIC_RELAXED) >=
+        OE_HOST_POOL_MAX_REGIONS)
+        return false;
+
+    /* The descriptors of the pool live as long as the enclave */
+    if (!(region = (Region*)oe_runtime_calloc(1, sizeof(Region))))
+        return false;
+
+    if (oe_ocall(
+            OE_OCALL_GROW_HOST_POOL, OE_HOST_POOL_REGION_SIZE, &arg_out) !=
+            OE_OK ||
+        !arg_out)
+    {
+        oe_runtime_free(region);
+        return false;
+    }
+
+    if (!oe_is_outside_enclave((void*)arg_out, OE_HOST_POOL_REGION_SIZE) ||
+        arg_out % OE_PAGE_SIZE != 0)
+        oe_abort();
+
+    region->base = (uint8_t*)arg_out;
+
+    for (size_t i = 0; i < SPANS_PER_REGION; i++)
+    {
+        region->spans[i].base = region->base + i * SPAN_SIZE;
+        region->spans[i].size_class = NO_CLASS;
+    }
+
+    oe_spin_lock(&_lock);
+
+    /* Other threads may have grown the pool meanwhile */
+    if (_num_regions < OE_HOST_POOL_MAX_REGIONS)
+    {
+        for (size_t i = 0; i < SPANS_PER_REGION; i++)
+            _push(&_unused, &region->spans[i]);
+
+        _regions[_num_regions] = region;
+        __atomic_store_n(&_num_regions, _num_regions + 1, __ATOMIC_RELEASE);
+        added = true;
+    }
+
+    oe_spin_unlock(&_lock);
+
+    /* The host frees the region when the enclave is terminated */
+    if (!added)
+        oe_runtime_free(region);
+
+    return added;
+}
+
+/* Take up to count blocks of the class, growing the pool if needed */
+static size_t _refill(size_t c, void** blocks, size_t count)
+{
+    for (;;)
+    {
+        size_t taken;
+
+        oe_spin_lock(&_lock);
+        taken = _take(c, blocks, count);
+        oe_spin_unlock(&_lock);
+
+        if (taken || !_grow())
+            return taken;
+    }
+}
+
+static Cache* _get_cache(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return NULL;
+
+    if (!td->host_pool_cache)
+        td->host_pool_cache = oe_runtime_calloc(1, sizeof(Cache));
+
+    return (Cache*)td->host_pool_cache;
+}
+
+/* Give all the blocks of the cache back */
+static void _flush(Cache* cache)
+{
+    oe_spin_lock(&_lock);
+
+    for (size_t c = 0; c < NUM_CLASSES; c++)
+    {
+        _give_blocks(cache->blocks[c], cache->counts[c]);
+        cache->counts[c] = 0;
+    }
+
+    oe_spin_unlock(&_lock);
+}
+
+void* oe_host_pool_alloc(size_t size)
+{
+    Cache* cache;
+    void* block = NULL;
+    size_t c;
+
+    if (!oe_host_memory_pool || size > _class_size(NUM_CLASSES - 1))
+        return NULL;
+
+    c = _size_class(size);
+
+    if (!(cache = _get_cache()))
+    {
+        _refill(c, &block, 1);
+        return block;
+    }
+
+    if (!cache->counts[c])
+    {
+        const size_t batch = _cache_capacity(c) / 2;
+
+        cache->counts[c] = (uint32_t)_refill(c, cache->blocks[c], batch);
+
+        /* The pool is exhausted: release the cached blocks and try again */
+        if (!cache->counts[c])
+        {
+            _flush(cache);
+            cache->counts[c] = (uint32_t)_refill(c, cache->blocks[c], 1);
+
+            if (!cache->counts[c])
+                return NULL;
+        }
+    }
+
+    return cache->blocks[c][--cache->counts[c]];
+}
+
+bool oe_host_pool_free(void* ptr)
+{
+    Cache* cache;
+    Span* span;
+    size_t index;
+    size_t c;
+
+    if (!(span = _find_span(ptr, &index)))
+        return false;
+
+    c = span->size_class;
+
+    if (!(cache = _get_cache()))
+    {
+        oe_spin_lock(&_lock);
+        _give(span, index);
+        oe_spin_unlock(&_lock);
+        return true;
+    }
+
+    /* A full cache gives its most recently freed half back */
+    if (cache->counts[c] == _cache_capacity(c))
+    {
+        const size_t batch = _cache_capacity(c) / 2;
+
+        cache->counts[c] -= (uint32_t)batch;
+
+        oe_spin_lock(&_lock);
+        _give_blocks(&cache->blocks[c][cache->counts[c]], batch);
+        oe_spin_unlock(&_lock);
+    }
+
+    cache->blocks[c][cache->counts[c]++] = ptr;
+    return true;
+}
+
+size_t oe_host_pool_block_size(const void* ptr)
+{
+    size_t index;
+    const Span* span = _find_span(ptr, &index);
+
+    return span ? _class_size(span->size_class) : 0;
+}
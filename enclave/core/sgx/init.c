@@ -9,6 +9,7 @@
 #include <openenclave/internal/jump.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
 #include "asmdefs.h"
 #include "td.h"
 
@@ -47,12 +48,11 @@ static void _initialize_enclave_image()
     _check_memory_boundaries();
 }
 
-static oe_once_t _enclave_initialize_once;
+#define ENCLAVE_NOT_INITIALIZED 0
+#define ENCLAVE_BEING_INITIALIZED 1
+#define ENCLAVE_INITIALIZED 2
 
-static void _initialize_enclave_imp(void)
-{
-    _initialize_enclave_image();
-}
+static uint32_t _enclave_initialize_once;
 
 /*
 **==============================================================================
@@ -67,5 +67,30 @@ static void _initialize_enclave_imp(void)
 */
 void oe_initialize_enclave()
 {
-    oe_once(&_enclave_initialize_once, _initialize_enclave_imp);
+    uint32_t expected = ENCLAVE_NOT_INITIALIZED;
+
+    if (__atomic_load_n(&_enclave_initialize_once, __ATOMIC_ACQUIRE) ==
+        ENCLAVE_INITIALIZED)
+        return;
+
+    /* Not oe_once(), whose waiters sleep on a futex: the relocations that
+     * the enclave needs to exit and wait in the host are not applied yet,
+     * so the other threads can only spin */
+    if (__atomic_compare_exchange_n(
+            &_enclave_initialize_once,
+            &expected,
+            ENCLAVE_BEING_INITIALIZED,
+            false,
+            __ATOMIC_ACQUIRE,
+            __ATOMIC_ACQUIRE))
+    {
+        _initialize_enclave_image();
+        __atomic_store_n(
+            &_enclave_initialize_once, ENCLAVE_INITIALIZED, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (__atomic_load_n(&_enclave_initialize_once, __ATOMIC_ACQUIRE) !=
+           ENCLAVE_INITIALIZED)
+        OE_CPU_RELAX();
 }
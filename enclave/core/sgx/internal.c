@@ -1,7 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/enclave.h>
 #include <openenclave/internal/print.h>
+#include <openenclave/internal/raise.h>
+#include "../heapprofile.h"
 #include "internal_t.h"
 
 int oe_internal_ping_ecall(int value)
@@ -13,3 +16,38 @@ int oe_internal_ping_ecall(int value)
 
     return retval;
 }
+
+oe_result_t oe_get_heap_stats_ecall(void* stats, size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!stats || size != sizeof(oe_heap_stats_t))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_get_heap_stats((oe_heap_stats_t*)stats));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_enable_heap_profiler_ecall(uint64_t sample_interval)
+{
+    return oe_enable_heap_profiler(sample_interval);
+}
+
+oe_result_t oe_get_heap_profile_ecall(
+    void* stacks,
+    size_t size,
+    size_t* num_stacks,
+    uint64_t* sample_interval,
+    uint64_t* dropped)
+{
+    return oe_get_heap_profile(
+        (oe_heap_profile_stack_t*)stacks,
+        size / sizeof(oe_heap_profile_stack_t),
+        num_stacks,
+        sample_interval,
+        dropped);
+}
@@ -0,0 +1,214 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "lockstats.h"
+#include <openenclave/corelibc/string.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/raise.h>
+#include "../runtimealloc.h"
+#include "internal_t.h"
+
+/*
+**==============================================================================
+**
+** Lock contention profiler:
+**
+**     Once enabled by the host, the mutexes, condition variables,
+**     readers-writer locks and spinlocks of the enclave count each of their
+**     operations in an open-addressing hash table keyed by the type and
+**     address of the lock. Entries are claimed with a compare-and-swap on
+**     their key and counted with atomic adds, so the profiler never takes a
+**     lock (it could not profile its own). Operations on locks beyond the
+**     capacity of the table are only counted as dropped.
+**
+**     The time spent parked is measured by the host, which returns it from
+**     the wait OCALLs, since the enclave cannot read a clock by itself.
+**
+**==============================================================================
+*/
+
+#define CACHE_LINE_SIZE 64
+
+typedef struct _lock_entry
+{
+    /* The address of the lock ORed with its type minus one (locks are at
+     * least 4-byte aligned), or zero while the entry is free */
+    uint64_t key;
+    uint64_t caller;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t spins;
+    uint64_t parks;
+    uint64_t wait_ns;
+    uint64_t padding;
+} LockEntry;
+
+OE_STATIC_ASSERT(sizeof(LockEntry) == CACHE_LINE_SIZE);
+
+volatile bool oe_lock_stats_enabled;
+
+/* The table is allocated when the profiler is first enabled, and is never
+ * freed: threads may be recording lock operations until the enclave is gone */
+static LockEntry* volatile _table;
+
+static uint64_t _dropped;
+
+OE_INLINE size_t _hash(uint64_t key)
+{
+    /* Locks are at least 4-byte aligned: hash the upper bits */
+    return (size_t)((key * 0x9e3779b97f4a7c15) >> 54) %
+           OE_LOCK_STATS_MAX_LOCKS;
+}
+
+OE_INLINE void _add(volatile uint64_t* counter, uint64_t n)
+{
+    if (n)
+        oe_atomic_add(counter, n);
+}
+
+void oe_record_lock(
+    oe_lock_type_t type,
+    const volatile void* lock,
+    const void* caller,
+    bool contended,
+    uint64_t spins,
+    uint64_t parks,
+    uint64_t wait_ns)
+{
+    LockEntry* table = _table;
+    const uint64_t key = (uint64_t)lock | (uint64_t)(type - 1);
+    const size_t index = _hash(key);
+
+    if (!table || !oe_lock_stats_enabled)
+        return;
+
+    for (size_t i = 0; i < OE_LOCK_STATS_MAX_LOCKS; i++)
+    {
+        LockEntry* entry = &table[(index + i) % OE_LOCK_STATS_MAX_LOCKS];
+        uint64_t k = oe_atomic_load(&entry->key);
+
+        if (k == 0)
+        {
+            if (oe_atomic_compare_and_swap(&entry->key, 0, key))
+            {
+                entry->caller = (uint64_t)caller;
+                k = key;
+            }
+            else
+            {
+                k = oe_atomic_load(&entry->key);
+            }
+        }
+
+        if (k == key)
+        {
+            oe_atomic_increment(&entry->acquisitions);
+            _add(&entry->contended, contended ? 1 : 0);
+            _add(&entry->spins, spins);
+            _add(&entry->parks, parks);
+            _add(&entry->wait_ns, wait_ns);
+            return;
+        }
+    }
+
+    oe_atomic_increment(&_dropped);
+}
+
+/*
+**==============================================================================
+**
+** Internal ECALLs:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_enable_lock_stats_ecall(bool enable)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const size_t size = OE_LOCK_STATS_MAX_LOCKS * sizeof(LockEntry);
+
+    if (enable && !_table)
+    {
+        LockEntry* table;
+
+        if (!(table = oe_runtime_memalign(CACHE_LINE_SIZE, size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        memset(table, 0, size);
+
+        /* Enabled concurrently by another thread */
+        if (!oe_atomic_compare_and_swap(
+                (volatile uint64_t*)&_table, 0, (uint64_t)table))
+        {
+            oe_runtime_free(table);
+        }
+    }
+    else if (enable)
+    {
+        /* Start a new profile (operations in progress may still be counted
+         * in the previous one, which is acceptable for statistics) */
+        oe_lock_stats_enabled = false;
+        memset(_table, 0, size);
+        _dropped = 0;
+    }
+
+    oe_lock_stats_enabled = enable;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_get_lock_stats_ecall(
+    void* stats,
+    size_t size,
+    size_t* num_stats,
+    uint64_t* dropped)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const uint64_t base = (uint64_t)__oe_get_enclave_base();
+    const size_t max_stats = size / sizeof(oe_lock_stats_t);
+    oe_lock_stats_t* p = (oe_lock_stats_t*)stats;
+    LockEntry* table = _table;
+    size_t n = 0;
+
+    if ((!stats && size) || !num_stats || !dropped)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; table && i < OE_LOCK_STATS_MAX_LOCKS; i++)
+    {
+        const LockEntry* entry = &table[i];
+        const uint64_t key = oe_atomic_load(&entry->key);
+
+        if (key == 0 || entry->acquisitions == 0)
+            continue;
+
+        if (n < max_stats)
+        {
+            p[n].type = (oe_lock_type_t)((key & 3) + 1);
+            p[n].lock = (key & ~(uint64_t)3) - base;
+            p[n].caller = entry->caller ? entry->caller - base : 0;
+            p[n].acquisitions = entry->acquisitions;
+            p[n].contended = entry->contended;
+            p[n].spins = entry->spins;
+            p[n].parks = entry->parks;
+            p[n].wait_ns = entry->wait_ns;
+        }
+
+        n++;
+    }
+
+    *num_stats = n;
+    *dropped = _dropped;
+
+    if (n > max_stats)
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_ENCLAVE_CORE_LOCKSTATS_H
+#define _OE_ENCLAVE_CORE_LOCKSTATS_H
+
+#include <openenclave/bits/lockstats.h>
+#include <openenclave/internal/sgxtypes.h>
+
+/* Whether the lock operations are profiled (see oe_enable_lock_stats_ecall) */
+extern volatile bool oe_lock_stats_enabled;
+
+/* Count an operation on a lock: whether it found the lock held, the pause
+ * iterations it spun, and the number and total time of its waits in the
+ * host. Takes no lock itself */
+void oe_record_lock(
+    oe_lock_type_t type,
+    const volatile void* lock,
+    const void* caller,
+    bool contended,
+    uint64_t spins,
+    uint64_t parks,
+    uint64_t wait_ns);
+
+#endif /* _OE_ENCLAVE_CORE_LOCKSTATS_H */
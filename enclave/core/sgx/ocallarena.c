@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/utils.h>
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** OCALL arena:
+**
+**     Each TCS owns an arena of host memory that OCALL buffers are
+**     bump-allocated from, saving the OE_OCALL_MALLOC and OE_OCALL_FREE
+**     transitions that would otherwise surround every OCALL. The host
+**     allocates the arena when the TCS first asks for it and releases it
+**     when the enclave is terminated. A TCS that the host failed to give an
+**     arena does not ask again: all its buffers come from the host heap.
+**
+**     Allocations are normally released in reverse order (nested OCALLs
+**     release their buffers before returning). Each allocation is preceded
+**     by a header that records the previous allocation, so that a buffer
+**     released out of order is reclaimed once the allocations above it
+**     have been released too.
+**
+**     The headers live in host memory and are not trusted: the enclave only
+**     relies on td->ocall_arena_used and td->ocall_arena_top, which keep
+**     every allocation inside the arena.
+**
+**==============================================================================
+*/
+
+#define OCALL_ARENA_SIZE (64 * 1024)
+
+#define OCALL_ARENA_ALIGNMENT 16
+
+/* Value of td->ocall_arena once the host failed to supply an arena */
+#define NO_OCALL_ARENA ((void*)OE_UINT64_MAX)
+
+typedef struct _header
+{
+    /* Offset of the previous allocation (meaningless for the first one) */
+    uint64_t prev;
+
+    /* Non-zero if the allocation was released out of order */
+    uint64_t freed;
+} header_t;
+
+OE_STATIC_ASSERT(sizeof(header_t) == OCALL_ARENA_ALIGNMENT);
+
+OE_INLINE header_t* _header(td_t* td, uint64_t offset)
+{
+    return (header_t*)((uint8_t*)td->ocall_arena + offset);
+}
+
+/* Ask the host for the arena of this TCS. Returns null on failure */
+static uint8_t* _get_arena(td_t* td)
+{
+    uint64_t arg_out = 0;
+
+    if (td->ocall_arena == NO_OCALL_ARENA)
+        return NULL;
+
+    if (td->ocall_arena)
+        return (uint8_t*)td->ocall_arena;
+
+    if (oe_ocall(OE_OCALL_GET_OCALL_ARENA, OCALL_ARENA_SIZE, &arg_out) !=
+            OE_OK ||
+        !arg_out)
+    {
+        td->ocall_arena = NO_OCALL_ARENA;
+        return NULL;
+    }
+
+    if (!oe_is_outside_enclave((void*)arg_out, OCALL_ARENA_SIZE))
+        oe_abort();
+
+    td->ocall_arena = (void*)arg_out;
+    td->ocall_arena_used = 0;
+    td->ocall_arena_top = 0;
+
+    return (uint8_t*)td->ocall_arena;
+}
+
+static void* _arena_alloc(td_t* td, size_t size)
+{
+    uint64_t offset = td->ocall_arena_used;
+    uint64_t needed;
+    header_t* header;
+
+    if (size > OCALL_ARENA_SIZE - sizeof(header_t))
+        return NULL;
+
+    needed =
+        sizeof(header_t) + oe_round_up_to_multiple(size, OCALL_ARENA_ALIGNMENT);
+
+    if (needed > OCALL_ARENA_SIZE - offset || !_get_arena(td))
+        return NULL;
+
+    header = _header(td, offset);
+    header->prev = td->ocall_arena_top;
+    header->freed = 0;
+
+    td->ocall_arena_top = offset;
+    td->ocall_arena_used = offset + needed;
+
+    return header + 1;
+}
+
+/* Returns true if ptr was allocated from the arena (and releases it) */
+static bool _arena_free(td_t* td, void* ptr)
+{
+    uint8_t* arena = (uint8_t*)td->ocall_arena;
+    uint64_t offset;
+
+    if (!arena || arena == NO_OCALL_ARENA ||
+        (uint8_t*)ptr < arena + sizeof(header_t) ||
+        (uint8_t*)ptr >= arena + OCALL_ARENA_SIZE)
+        return false;
+
+    offset = (uint64_t)((uint8_t*)ptr - arena) - sizeof(header_t);
+
+    /* Ignore pointers that are not live allocations */
+    if (offset % OCALL_ARENA_ALIGNMENT != 0 ||
+        offset >= td->ocall_arena_used)
+        return true;
+
+    /* Defer the release of an allocation that is not the most recent */
+    if (offset != td->ocall_arena_top)
+    {
+        _header(td, offset)->freed = 1;
+        return true;
+    }
+
+    /* Release the most recent allocation and any deferred ones below it */
+    for (;;)
+    {
+        uint64_t prev = _header(td, offset)->prev;
+
+        td->ocall_arena_used = offset;
+
+        if (offset == 0)
+            break;
+
+        /* The header is in host memory: reset the arena if it was changed
+         * into something that would not shrink the arena */
+        if (prev >= offset || prev % OCALL_ARENA_ALIGNMENT != 0)
+        {
+            td->ocall_arena_used = 0;
+            break;
+        }
+
+        td->ocall_arena_top = prev;
+
+        if (!_header(td, prev)->freed)
+            break;
+
+        offset = prev;
+    }
+
+    return true;
+}
+
+/*
+**==============================================================================
+**
+** oe_allocate_ocall_buffer()
+** oe_free_ocall_buffer()
+**
+**     Functions used by oeedger8r for allocating and freeing OCALL buffers.
+**     Buffers that do not fit into the arena of the calling TCS are allocated
+**     from the host heap.
+**
+**==============================================================================
+*/
+
+void* oe_allocate_ocall_buffer(size_t size)
+{
+    void* ptr;
+
+    if ((ptr = _arena_alloc(oe_get_td(), size)))
+        return ptr;
+
+    return oe_host_malloc(size);
+}
+
+void oe_free_ocall_buffer(void* buffer)
+{
+    if (!buffer || _arena_free(oe_get_td(), buffer))
+        return;
+
+    oe_host_free(buffer);
+}
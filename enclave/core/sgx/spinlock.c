@@ -4,6 +4,7 @@
 #ifdef OE_BUILD_ENCLAVE
 #include <openenclave/enclave.h>
 #include <openenclave/internal/thread.h>
+#include "lockstats.h"
 #else
 #include <openenclave/host.h>
 #endif
@@ -34,19 +35,37 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock)
 
 oe_result_t oe_spin_lock(oe_spinlock_t* spinlock)
 {
+    bool contended = false;
+    uint64_t spins = 0;
+
     if (!spinlock)
         return OE_INVALID_PARAMETER;
 
     while (_spin_set_locked((volatile unsigned int*)spinlock) != 0)
     {
+        contended = true;
+
         /* Spin while waiting for spinlock to be released (become 1) */
         while (*spinlock)
         {
             /* Yield to CPU */
             asm volatile("pause");
+            spins++;
         }
     }
 
+#ifdef OE_BUILD_ENCLAVE
+    if (oe_lock_stats_enabled)
+        oe_record_lock(
+            OE_LOCK_TYPE_SPINLOCK,
+            spinlock,
+            __builtin_return_address(0),
+            contended,
+            spins,
+            0,
+            0);
+#endif
+
     return OE_OK;
 }
 
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/sgxtypes.h>
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Stack usage:
+**
+**     The host fills the stack pages of each TCS with OE_SGX_STACK_FILL when
+**     it creates the enclave (and measures them), and nothing clears them
+**     afterwards. The deepest word of a stack that no longer holds the
+**     pattern is thus the deepest point any thread ever reached on it.
+**
+**     The TCSs follow the heap, each laid out as (see host/sgx/create.c):
+**
+**         guard page, stack pages, guard page, TCS page, 2 SSA pages,
+**         guard page, GS segment page, FS segment page
+**
+**     so the stack of a TCS ends one page below it, and the thread data of
+**     the TCS (its GS segment) starts four pages above it.
+**
+**==============================================================================
+*/
+
+#define CONTROL_PAGES 6
+
+#define STACK_FILL (((uint64_t)OE_SGX_STACK_FILL << 32) | OE_SGX_STACK_FILL)
+
+/* Returns the number of bytes between the deepest written word of the stack
+ * and its top. Other threads may be running on the stack meanwhile, so its
+ * words are read through a volatile pointer */
+static uint64_t _peak_bytes(const volatile uint64_t* base, uint64_t size)
+{
+    const uint64_t n = size / sizeof(uint64_t);
+    uint64_t i = 0;
+
+    while (i < n && base[i] == STACK_FILL)
+        i++;
+
+    return (n - i) * sizeof(uint64_t);
+}
+
+oe_result_t oe_get_stack_usage(oe_stack_usage_t* usage, size_t* num_usage)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const uint64_t enclave_base = (uint64_t)__oe_get_enclave_base();
+    const uint64_t num_tcs = oe_get_num_tcs();
+    const uint64_t stack_size = oe_get_num_stack_pages() * OE_PAGE_SIZE;
+    const uint64_t stride =
+        OE_PAGE_SIZE + stack_size + OE_PAGE_SIZE + CONTROL_PAGES * OE_PAGE_SIZE;
+    const uint64_t self = (uint64_t)oe_get_td() - 4 * OE_PAGE_SIZE;
+    uint64_t stack = (uint64_t)__oe_get_heap_end() + OE_PAGE_SIZE;
+    bool found_self = false;
+
+    if (!num_usage || (!usage && *num_usage))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (*num_usage < num_tcs)
+    {
+        *num_usage = num_tcs;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    for (uint64_t i = 0; i < num_tcs; i++, stack += stride)
+    {
+        const uint64_t tcs = stack + stack_size + OE_PAGE_SIZE;
+
+        if (!oe_is_within_enclave((void*)stack, stack_size))
+            OE_RAISE(OE_UNEXPECTED);
+
+        if (tcs == self)
+            found_self = true;
+
+        usage[i].tcs = tcs - enclave_base;
+        usage[i].stack_size = stack_size;
+        usage[i].peak_bytes =
+            _peak_bytes((const volatile uint64_t*)stack, stack_size);
+    }
+
+    /* The layout does not match the enclave */
+    if (!found_self)
+        OE_RAISE(OE_UNEXPECTED);
+
+    *num_usage = num_tcs;
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/fault.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "internal_t.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Trusted copies of the switchless queues:
+**
+**     The host passes the address of each queue once via an initialization
+**     ECALL. The fields that determine where the enclave reads and writes
+**     calls (the ring cells, the calls and their counts) are copied into
+**     enclave memory and validated so that later modifications by the host
+**     cannot redirect enclave accesses. Only the ring indices, the worker
+**     counts and the call states are read from host memory thereafter.
+**
+**==============================================================================
+*/
+
+typedef struct _queue_info
+{
+    oe_switchless_queue_t* queue;
+    oe_switchless_ring_cell_t* cells;
+    uint64_t capacity;
+    uint8_t* calls;
+    uint64_t num_calls;
+    size_t call_size;
+} queue_info_t;
+
+static queue_info_t _ocalls;
+static queue_info_t _ecalls;
+
+/* Number of switchless OCALLs claimed so far by enclave threads */
+static volatile uint64_t _num_claimed_calls;
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+static oe_result_t _init_queue(
+    queue_info_t* info,
+    void* queue_arg,
+    size_t call_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_queue_t queue;
+    size_t cells_size;
+    size_t calls_size;
+    bool locked = false;
+
+    if (!queue_arg || !oe_is_outside_enclave(queue_arg, sizeof(queue)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Copy the queue into enclave memory before validating it */
+    memcpy(&queue, queue_arg, sizeof(queue));
+
+    /* The ring capacity must be a non-zero power of two */
+    if (queue.capacity == 0 || (queue.capacity & (queue.capacity - 1)) != 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_safe_mul_u64(
+        queue.capacity, sizeof(oe_switchless_ring_cell_t), &cells_size));
+    OE_CHECK(oe_safe_mul_u64(queue.num_calls, call_size, &calls_size));
+
+    if (!queue.cells || !oe_is_outside_enclave(queue.cells, cells_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!queue.calls || !oe_is_outside_enclave(queue.calls, calls_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_spin_lock(&_lock);
+    locked = true;
+
+    /* A queue can only be registered once */
+    if (info->queue)
+        OE_RAISE(OE_UNEXPECTED);
+
+    info->cells = queue.cells;
+    info->capacity = queue.capacity;
+    info->calls = (uint8_t*)queue.calls;
+    info->num_calls = queue.num_calls;
+    info->call_size = call_size;
+
+    /* Publish the queue after the fields above are set */
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    info->queue = (oe_switchless_queue_t*)queue_arg;
+
+    result = OE_OK;
+
+done:
+
+    if (locked)
+        oe_spin_unlock(&_lock);
+
+    return result;
+}
+
+oe_result_t oe_init_switchless_ocalls_ecall(void* queue)
+{
+    return _init_queue(&_ocalls, queue, OE_SWITCHLESS_CALL_STRIDE);
+}
+
+oe_result_t oe_init_switchless_ecalls_ecall(void* queue)
+{
+    return _init_queue(&_ecalls, queue, sizeof(oe_switchless_ecall_t));
+}
+
+/*
+**==============================================================================
+**
+** Switchless OCALLs
+**
+**==============================================================================
+*/
+
+/* Returns the switchless call owned by the current thread, claiming one
+ * on first use. Returns null if none is available. */
+static oe_switchless_call_t* _get_call(td_t* td)
+{
+    uint64_t index;
+
+    if (td->switchless_call)
+        return (oe_switchless_call_t*)td->switchless_call;
+
+    if (!_ocalls.queue)
+        return NULL;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    /* Each TCS claims one call for the lifetime of the enclave */
+    index = oe_atomic_increment(&_num_claimed_calls) - 1;
+
+    if (index >= _ocalls.num_calls)
+        return NULL;
+
+    td->switchless_call = _ocalls.calls + index * OE_SWITCHLESS_CALL_STRIDE;
+
+    return (oe_switchless_call_t*)td->switchless_call;
+}
+
+/* Count a switchless OCALL that is made as an ordinary OCALL */
+static void _count_ocall_fallback(void)
+{
+    if (_ocalls.queue)
+        oe_atomic_increment(&_ocalls.queue->fallback_calls);
+}
+
+/*
+**==============================================================================
+**
+** oe_allocate_switchless_ocall_buffer()
+** oe_free_switchless_ocall_buffer()
+**
+**     The marshaling buffer of a switchless OCALL is the buffer of the
+**     calling thread's switchless call when it is large enough and not
+**     already in use (by an outer OCALL on the same thread). Otherwise the
+**     buffer is allocated like that of an ordinary OCALL and the call is
+**     made as an ordinary OCALL.
+**
+**==============================================================================
+*/
+
+void* oe_allocate_switchless_ocall_buffer(size_t size)
+{
+    td_t* td = oe_get_td();
+    oe_switchless_call_t* call;
+
+    if (size <= OE_SWITCHLESS_BUFFER_SIZE && !td->switchless_call_busy &&
+        (call = _get_call(td)))
+    {
+        td->switchless_call_busy = 1;
+        return oe_switchless_call_buffer(call);
+    }
+
+    _count_ocall_fallback();
+
+    return oe_allocate_ocall_buffer(size);
+}
+
+void oe_free_switchless_ocall_buffer(void* buffer)
+{
+    td_t* td = oe_get_td();
+    oe_switchless_call_t* call = (oe_switchless_call_t*)td->switchless_call;
+
+    if (call && buffer == oe_switchless_call_buffer(call))
+    {
+        td->switchless_call_busy = 0;
+        return;
+    }
+
+    oe_free_ocall_buffer(buffer);
+}
+
+/*
+**==============================================================================
+**
+** oe_get_switchless_ocall_args()
+**
+**     Returns the host function arguments of the current thread's switchless
+**     call if buffer is the buffer of that call. Returns null otherwise.
+**
+**==============================================================================
+*/
+
+oe_call_host_function_args_t* oe_get_switchless_ocall_args(const void* buffer)
+{
+    td_t* td = oe_get_td();
+    oe_switchless_call_t* call = (oe_switchless_call_t*)td->switchless_call;
+
+    if (call && td->switchless_call_busy &&
+        buffer == oe_switchless_call_buffer(call))
+        return &call->args;
+
+    return NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_post_switchless_ocall()
+**
+**     Posts the switchless call that owns args onto the ring and waits for a
+**     host worker to carry it out. Returns false, without making the call,
+**     when no host worker is polling the ring, when the ring is full, or when
+**     no worker picks up the call in time. The caller then makes the call as
+**     an ordinary OCALL (which also wakes the sleeping host workers).
+**
+**==============================================================================
+*/
+
+bool oe_post_switchless_ocall(oe_call_host_function_args_t* args)
+{
+    oe_switchless_queue_t* queue = _ocalls.queue;
+    oe_switchless_call_t* call = (oe_switchless_call_t*)(
+        (uint8_t*)args - OE_OFFSETOF(oe_switchless_call_t, args));
+    size_t spins = 0;
+
+    if (!queue || oe_atomic_load(&queue->spinning_workers) == 0)
+        goto fallback;
+
+    oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_POSTED);
+
+    if (!oe_switchless_ring_push(
+            &queue->tail, _ocalls.cells, _ocalls.capacity, call))
+    {
+        oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_IDLE);
+        goto fallback;
+    }
+
+    for (;;)
+    {
+        uint64_t state = oe_atomic_load(&call->state);
+
+        if (state == OE_SWITCHLESS_CALL_STATE_DONE)
+            break;
+
+        /* Reclaim the call if no worker has picked it up in time. The ring
+         * entry is left behind; host workers skip it since it is no longer
+         * in the posted state. */
+        if (state == OE_SWITCHLESS_CALL_STATE_POSTED &&
+            ++spins >= OE_SWITCHLESS_PICKUP_SPIN_COUNT &&
+            oe_atomic_compare_and_swap(
+                &call->state,
+                OE_SWITCHLESS_CALL_STATE_POSTED,
+                OE_SWITCHLESS_CALL_STATE_IDLE))
+        {
+            goto fallback;
+        }
+
+        oe_pause();
+    }
+
+    oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_IDLE);
+
+    return true;
+
+fallback:
+    _count_ocall_fallback();
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** oe_run_switchless_ecall_worker_ecall()
+**
+**     Entry point of an enclave worker: carries out the switchless ECALLs
+**     posted by host callers until the host stops the workers. A worker that
+**     finds no work for OE_SWITCHLESS_WORKER_SPIN_COUNT iterations releases
+**     its core by sleeping in the host until a host caller wakes it.
+**
+**==============================================================================
+*/
+
+static oe_switchless_ecall_t* _get_ecall(void* item)
+{
+    uint8_t* p = (uint8_t*)item;
+    size_t offset;
+
+    /* Only accept calls that lie in the registered call array */
+    if (p < _ecalls.calls)
+        return NULL;
+
+    offset = (size_t)(p - _ecalls.calls);
+
+    if (offset % sizeof(oe_switchless_ecall_t) != 0 ||
+        offset / sizeof(oe_switchless_ecall_t) >= _ecalls.num_calls)
+        return NULL;
+
+    return (oe_switchless_ecall_t*)p;
+}
+
+oe_result_t oe_run_switchless_ecall_worker_ecall(void* context)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_queue_t* queue = _ecalls.queue;
+    size_t spins = 0;
+
+    if (!queue)
+        OE_RAISE(OE_UNEXPECTED);
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    oe_atomic_increment(&queue->spinning_workers);
+
+    while (!oe_atomic_load(&queue->stopping) &&
+           oe_get_enclave_status() == OE_OK)
+    {
+        void* item = NULL;
+
+        if (oe_switchless_ring_pop(
+                &queue->head, _ecalls.cells, _ecalls.capacity, &item))
+        {
+            oe_switchless_ecall_t* call = _get_ecall(item);
+
+            /* Skip stale entries and calls already reclaimed by the host */
+            if (call && oe_atomic_compare_and_swap(
+                            &call->state,
+                            OE_SWITCHLESS_CALL_STATE_POSTED,
+                            OE_SWITCHLESS_CALL_STATE_RUNNING))
+            {
+                call->result =
+                    oe_handle_call_enclave_function((uint64_t)&call->args);
+                oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_DONE);
+            }
+
+            spins = 0;
+        }
+        else if (++spins < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+        {
+            oe_pause();
+        }
+        else
+        {
+            /* Let host callers see that this worker stopped polling */
+            oe_atomic_decrement(&queue->spinning_workers);
+            result = oe_sleep_switchless_ecall_worker_ocall(context);
+            oe_atomic_increment(&queue->spinning_workers);
+            OE_CHECK(result);
+            spins = 0;
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    oe_atomic_decrement(&queue->spinning_workers);
+
+    return result;
+}
@@ -0,0 +1,19 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_ENCLAVE_CORE_SWITCHLESS_H
+#define _OE_ENCLAVE_CORE_SWITCHLESS_H
+
+#include <openenclave/internal/switchless.h>
+
+/* Returns the arguments of the current thread's switchless call if buffer is
+ * the marshaling buffer of that call, otherwise null */
+oe_call_host_function_args_t* oe_get_switchless_ocall_args(const void* buffer);
+
+/* Returns true if a host worker carried out the call that owns args */
+bool oe_post_switchless_ocall(oe_call_host_function_args_t* args);
+
+/* Dispatch an oe_call_enclave_function_args_t to the ecall tables */
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in);
+
+#endif /* _OE_ENCLAVE_CORE_SWITCHLESS_H */
@@ -10,6 +10,10 @@
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/utils.h>
+#include "../arena.h"
+#include "../heapprofile.h"
+#include "../malloccache.h"
+#include "../slab.h"
 #include "asmdefs.h"
 #include "thread.h"
 
@@ -161,6 +165,26 @@ void* td_to_tcs(const td_t* td)
     return (uint8_t*)td - (4 * OE_PAGE_SIZE);
 }
 
+/*
+**==============================================================================
+**
+** td_get_stack()
+**
+**     Compute the range [base, end) of the stack of the TCS of a td_t. The
+**     stack pages end one guard page below the TCS page (see the layout in
+**     stackusage.c).
+**
+**==============================================================================
+*/
+
+void td_get_stack(const td_t* td, const void** base, const void** end)
+{
+    const uint8_t* stack_end = (const uint8_t*)td_to_tcs(td) - OE_PAGE_SIZE;
+
+    *base = stack_end - oe_get_num_stack_pages() * OE_PAGE_SIZE;
+    *end = stack_end;
+}
+
 /*
 **==============================================================================
 **
@@ -302,6 +326,11 @@ void td_clear(td_t* td)
     if (td->depth != 0 || td->callsites != NULL)
         oe_abort();
 
+    /* Release the allocations made from the arena of the thread during the
+     * ECALL */
+    if (td->arena)
+        oe_arena_reset((oe_arena_t*)td->arena);
+
     /* Clear base structure */
     memset(&td->base, 0, sizeof(td->base));
 
@@ -310,3 +339,87 @@ void td_clear(td_t* td)
 
     /* Never clear td_t.initialized nor host registers */
 }
+
+/*
+**==============================================================================
+**
+** oe_get_malloc_cache_slot()
+**
+**     Returns the address of the td_t.malloc_cache field of the calling thread
+**     or null before its td_t is initialized.
+**
+**==============================================================================
+*/
+
+void** oe_get_malloc_cache_slot(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return NULL;
+
+    return &td->malloc_cache;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_thread_arena_slot()
+**
+**     Returns the address of the td_t.arena field of the calling thread or
+**     null before its td_t is initialized.
+**
+**==============================================================================
+*/
+
+void** oe_get_thread_arena_slot(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return NULL;
+
+    return &td->arena;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_heap_profile_slot()
+**
+**     Returns the address of the td_t.heap_profile_countdown field of the
+**     calling thread or null before its td_t is initialized.
+**
+**==============================================================================
+*/
+
+uint64_t* oe_get_heap_profile_slot(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return NULL;
+
+    return &td->heap_profile_countdown;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_slab_magazines_slot()
+**
+**     Returns the address of the td_t.slab_magazines field of the calling
+**     thread or null before its td_t is initialized.
+**
+**==============================================================================
+*/
+
+void** oe_get_slab_magazines_slot(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return NULL;
+
+    return &td->slab_magazines;
+}
@@ -70,6 +70,8 @@ td_t* td_from_tcs(void* tcs);
 
 void* td_to_tcs(const td_t* td);
 
+void td_get_stack(const td_t* td, const void** base, const void** end);
+
 void td_init(td_t* td);
 
 void td_clear(td_t* td);
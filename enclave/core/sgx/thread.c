@@ -3,12 +3,18 @@
 
 #include "thread.h"
 #include <openenclave/bits/safecrt.h>
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/corelibc/string.h>
+#include <openenclave/edger8r/enclave.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
+#include <openenclave/internal/globals.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "lockstats.h"
 #include "td.h"
 
 /*
@@ -19,13 +25,23 @@
 **==============================================================================
 */
 
+/* Count a wait of the calling thread in the host that lasted wait_ns (as
+ * returned by the host) for the lock contention profiler */
+OE_INLINE void _count_park(oe_thread_data_t* self, uint64_t wait_ns)
+{
+    ((td_t*)self)->lock_parks++;
+    ((td_t*)self)->lock_wait_ns += wait_ns;
+}
+
 static int _thread_wait(oe_thread_data_t* self)
 {
     const void* tcs = td_to_tcs((td_t*)self);
+    uint64_t wait_ns = 0;
 
-    if (oe_ocall(OE_OCALL_THREAD_WAIT, (uint64_t)tcs, NULL) != OE_OK)
+    if (oe_ocall(OE_OCALL_THREAD_WAIT, (uint64_t)tcs, &wait_ns) != OE_OK)
         return -1;
 
+    _count_park(self, wait_ns);
     return 0;
 }
 
@@ -43,6 +59,7 @@ static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
 {
     int ret = -1;
     oe_thread_wake_wait_args_t* args = NULL;
+    uint64_t wait_ns = 0;
 
     if (!(args = oe_host_calloc(1, sizeof(oe_thread_wake_wait_args_t))))
         goto done;
@@ -50,9 +67,10 @@ static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
     args->waiter_tcs = td_to_tcs((td_t*)waiter);
     args->self_tcs = td_to_tcs((td_t*)self);
 
-    if (oe_ocall(OE_OCALL_THREAD_WAKE_WAIT, (uint64_t)args, NULL) != OE_OK)
+    if (oe_ocall(OE_OCALL_THREAD_WAKE_WAIT, (uint64_t)args, &wait_ns) != OE_OK)
         goto done;
 
+    _count_park(self, wait_ns);
     ret = 0;
 
 done:
@@ -60,6 +78,157 @@ done:
     return ret;
 }
 
+/* Largest number of threads woken by a single OCALL */
+#define WAKE_BATCH_SIZE 64
+
+typedef struct _wake_batch
+{
+    const void* tcs[WAKE_BATCH_SIZE];
+    size_t count;
+} WakeBatch;
+
+/* Wake the threads of the batch with a single OCALL */
+static int _thread_wake_batch(const WakeBatch* batch)
+{
+    int ret = -1;
+    oe_thread_wake_multiple_args_t* args = NULL;
+    const size_t size = batch->count * sizeof(batch->tcs[0]);
+
+    if (batch->count == 0)
+        return 0;
+
+    if (batch->count == 1 ||
+        !(args = oe_allocate_ocall_buffer(sizeof(*args) + size)))
+    {
+        /* Wake the threads one at a time */
+        for (size_t i = 0; i < batch->count; i++)
+        {
+            const uint64_t tcs = (uint64_t)batch->tcs[i];
+
+            if (oe_ocall(OE_OCALL_THREAD_WAKE, tcs, NULL) != OE_OK)
+                return -1;
+        }
+
+        return 0;
+    }
+
+    args->num_tcs = batch->count;
+    memcpy(args + 1, batch->tcs, size);
+
+    if (oe_ocall(OE_OCALL_THREAD_WAKE_MULTIPLE, (uint64_t)args, NULL) != OE_OK)
+        goto done;
+
+    ret = 0;
+
+done:
+    oe_free_ocall_buffer(args);
+    return ret;
+}
+
+/* Deadline of the waits that do not time out */
+#define NO_DEADLINE OE_UINT64_MAX
+
+/* Wait in the host until woken or until the deadline (in nanoseconds since
+ * the Epoch) passes. Returns OE_TIMEOUT in the latter case */
+static oe_result_t _thread_wait_until(oe_thread_data_t* self, uint64_t deadline)
+{
+    oe_result_t result = OE_FAILURE;
+    oe_thread_wait_timed_args_t* args;
+
+    if (deadline == NO_DEADLINE)
+        return _thread_wait(self) == 0 ? OE_OK : OE_FAILURE;
+
+    if (!(args = oe_allocate_ocall_buffer(sizeof(*args))))
+        return OE_FAILURE;
+
+    args->deadline = deadline;
+    args->wait_ns = 0;
+    args->timed_out = false;
+
+    if (oe_ocall(OE_OCALL_THREAD_WAIT_TIMED, (uint64_t)args, NULL) != OE_OK)
+        goto done;
+
+    _count_park(self, args->wait_ns);
+    result = args->timed_out ? OE_TIMEOUT : OE_OK;
+
+done:
+    oe_free_ocall_buffer(args);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** Lock profiling:
+**
+**     When the lock contention profiler is enabled, each lock operation
+**     snapshots the lock_* counters of the calling thread, which the waits
+**     below add to, and counts their growth against the lock.
+**
+**==============================================================================
+*/
+
+typedef struct _lock_probe
+{
+    /* The return address of the lock operation, or null if not profiled */
+    const void* caller;
+    td_t* td;
+    uint64_t contentions;
+    uint64_t spins;
+    uint64_t parks;
+    uint64_t wait_ns;
+} LockProbe;
+
+OE_INLINE void _probe_start(LockProbe* probe, const void* caller)
+{
+    td_t* td;
+
+    probe->caller = NULL;
+
+    if (!oe_lock_stats_enabled)
+        return;
+
+    td = (td_t*)oe_get_thread_data();
+    probe->caller = caller;
+    probe->td = td;
+    probe->contentions = td->lock_contentions;
+    probe->spins = td->lock_spins;
+    probe->parks = td->lock_parks;
+    probe->wait_ns = td->lock_wait_ns;
+}
+
+/* Count the operation unless it failed (timed out waits are counted) */
+OE_INLINE oe_result_t _probe_end(
+    LockProbe* probe,
+    oe_lock_type_t type,
+    const void* lock,
+    oe_result_t result)
+{
+    if (probe->caller && (result == OE_OK || result == OE_TIMEOUT))
+    {
+        const td_t* td = probe->td;
+        const uint64_t spins = td->lock_spins - probe->spins;
+        const uint64_t parks = td->lock_parks - probe->parks;
+
+        oe_record_lock(
+            type,
+            lock,
+            probe->caller,
+            td->lock_contentions != probe->contentions || spins || parks,
+            spins,
+            parks,
+            td->lock_wait_ns - probe->wait_ns);
+    }
+
+    return result;
+}
+
+/* Note that the calling thread found a lock held */
+OE_INLINE void _count_contention(oe_thread_data_t* self)
+{
+    ((td_t*)self)->lock_contentions++;
+}
+
 /*
 **==============================================================================
 **
@@ -114,11 +283,120 @@ static bool _queue_contains(Queue* queue, oe_thread_data_t* thread)
     return false;
 }
 
+static void _queue_remove(Queue* queue, oe_thread_data_t* thread)
+{
+    oe_thread_data_t* prev = NULL;
+    oe_thread_data_t* p;
+
+    for (p = queue->front; p; prev = p, p = p->next)
+    {
+        if (p == thread)
+        {
+            if (prev)
+                prev->next = p->next;
+            else
+                queue->front = p->next;
+
+            if (queue->back == p)
+                queue->back = prev;
+
+            return;
+        }
+    }
+}
+
+static size_t _queue_length(Queue* queue)
+{
+    oe_thread_data_t* p;
+    size_t n = 0;
+
+    for (p = queue->front; p; p = p->next)
+        n++;
+
+    return n;
+}
+
 static __inline__ bool _queue_empty(Queue* queue)
 {
     return queue->front ? false : true;
 }
 
+/*
+**==============================================================================
+**
+** Adaptive waits:
+**
+**     A thread that finds a mutex locked, or that waits on a condition
+**     variable, first spins with exponential backoff for up to
+**     oe_get_lock_spin_count() pause iterations, and only then exits the
+**     enclave to wait in the host. The wait state of a queued thread tells
+**     the thread that selects it (by unlocking the mutex or by signaling the
+**     condition variable) whether it must be woken by an OCALL:
+**
+**         THREAD_SPINNING - the thread notices by itself that it was selected
+**         THREAD_PARKED - the thread waits in the host (or is about to)
+**
+**     The wait state is only changed under the spinlock of the object the
+**     thread is queued on, so a thread is selected at most once per wait.
+**     Wake-ups are not paired with waits, however: the host remembers a
+**     wake-up that comes before the wait, and a wait can consume a wake-up
+**     meant for an earlier one. This happens when:
+**
+**         - a timed wait gives up (leaving the queue under the spinlock)
+**           just as the thread is selected, and misses the wake-up;
+**         - the last reader of a reader-writer lock wakes a writer that is
+**           parked waiting for the readers (writer_parked), without any
+**           spinlock, after the writer stopped waiting.
+**
+**     Such a stray wake-up makes a later wait of the thread return early.
+**     Every wait loop therefore re-checks its condition, so this only costs
+**     an extra iteration.
+**
+**==============================================================================
+*/
+
+#define THREAD_RUNNING 0
+#define THREAD_SPINNING 1
+#define THREAD_PARKED 2
+
+/* Largest number of pause iterations between two checks of a spinning
+ * thread */
+#define SPIN_BACKOFF_MAX 64
+
+OE_INLINE volatile uint64_t* _wait_state(oe_thread_data_t* thread)
+{
+    return &((td_t*)thread)->wait_state;
+}
+
+/* Pause for the current backoff and double it. Returns false once the
+ * thread has spun for spin_count iterations */
+static bool _spin(uint32_t spin_count, uint32_t* spun, uint32_t* backoff)
+{
+    if (*spun >= spin_count)
+        return false;
+
+    for (uint32_t i = 0; i < *backoff; i++)
+        OE_CPU_RELAX();
+
+    *spun += *backoff;
+    ((td_t*)oe_get_thread_data())->lock_spins += *backoff;
+
+    if (*backoff < SPIN_BACKOFF_MAX)
+        *backoff *= 2;
+
+    return true;
+}
+
+/* Select a queued thread; returns true if it must be woken. The caller holds
+ * the spinlock of the queue */
+static bool _select_waiter(oe_thread_data_t* waiter)
+{
+    const bool parked = *_wait_state(waiter) == THREAD_PARKED;
+
+    *_wait_state(waiter) = THREAD_RUNNING;
+    return parked;
+}
+
 /*
 **==============================================================================
 **
@@ -218,57 +496,126 @@ static int _mutex_lock(oe_mutex_impl_t* m, oe_thread_data_t* self)
     return -1;
 }
 
-oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
+/* Whether the mutex is free for SELF to obtain (read without the spinlock) */
+OE_INLINE bool _mutex_available(oe_mutex_impl_t* m, oe_thread_data_t* self)
 {
-    oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
-    oe_thread_data_t* self = oe_get_thread_data();
+    volatile oe_mutex_impl_t* v = m;
 
-    if (!m)
-        return OE_INVALID_PARAMETER;
+    return v->owner == NULL && v->queue.front == self;
+}
+
+static oe_result_t _mutex_lock_until(oe_mutex_impl_t* m, uint64_t deadline)
+{
+    oe_thread_data_t* self = oe_get_thread_data();
+    const uint32_t spin_count = oe_get_lock_spin_count();
+    uint32_t spun = 0;
+    uint32_t backoff = 1;
 
     /* Loop until SELF obtains mutex */
     for (;;)
     {
+        uint64_t state;
+
         oe_spin_lock(&m->lock);
         {
             /* Attempt to acquire lock */
             if (_mutex_lock(m, self) == 0)
             {
+                *_wait_state(self) = THREAD_RUNNING;
                 oe_spin_unlock(&m->lock);
                 return OE_OK;
             }
 
+            _count_contention(self);
+
             /* If the waiters queue does not contain this thread */
             if (!_queue_contains(&m->queue, self))
             {
                 /* Insert thread at back of waiters queue */
                 _queue_push_back(&m->queue, self);
             }
+
+            /* Spin until the spin count is spent, then wait in the host */
+            state = spun < spin_count ? THREAD_SPINNING : THREAD_PARKED;
+            *_wait_state(self) = state;
         }
         oe_spin_unlock(&m->lock);
 
-        /* Ask host to wait for an event on this thread */
-        _thread_wait(self);
+        if (state == THREAD_SPINNING)
+        {
+            while (!_mutex_available(m, self) &&
+                   _spin(spin_count, &spun, &backoff))
+                ;
+        }
+        else if (_thread_wait_until(self, deadline) == OE_TIMEOUT)
+        {
+            oe_result_t result = OE_TIMEOUT;
+
+            /* The mutex may have been handed over as the wait timed out */
+            oe_spin_lock(&m->lock);
+            {
+                if (_mutex_lock(m, self) == 0)
+                    result = OE_OK;
+                else
+                    _queue_remove(&m->queue, self);
+
+                *_wait_state(self) = THREAD_RUNNING;
+            }
+            oe_spin_unlock(&m->lock);
+
+            return result;
+        }
     }
 
     /* Unreachable! */
 }
 
+oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
+{
+    oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
+    LockProbe probe;
+
+    if (!m)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe, OE_LOCK_TYPE_MUTEX, m, _mutex_lock_until(m, NO_DEADLINE));
+}
+
+oe_result_t oe_mutex_timedlock(oe_mutex_t* mutex, uint64_t deadline)
+{
+    oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
+    LockProbe probe;
+
+    if (!m || deadline == NO_DEADLINE)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe, OE_LOCK_TYPE_MUTEX, m, _mutex_lock_until(m, deadline));
+}
+
 oe_result_t oe_mutex_trylock(oe_mutex_t* mutex)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
     oe_thread_data_t* self = oe_get_thread_data();
+    LockProbe probe;
 
     if (!m)
         return OE_INVALID_PARAMETER;
 
+    _probe_start(&probe, __builtin_return_address(0));
+
     oe_spin_lock(&m->lock);
     {
         /* Attempt to acquire lock */
         if (_mutex_lock(m, self) == 0)
         {
             oe_spin_unlock(&m->lock);
-            return OE_OK;
+            return _probe_end(&probe, OE_LOCK_TYPE_MUTEX, m, OE_OK);
         }
     }
     oe_spin_unlock(&m->lock);
@@ -293,8 +640,10 @@ static int _mutex_unlock(oe_mutex_t* mutex, oe_thread_data_t** waiter)
                 /* Thread no longer has this mutex locked */
                 m->owner = NULL;
 
-                /* Set waiter to the next thread on the queue (maybe none) */
-                *waiter = m->queue.front;
+                /* Set waiter to the next thread on the queue if it must be
+                 * woken (maybe none) */
+                if (m->queue.front && _select_waiter(m->queue.front))
+                    *waiter = m->queue.front;
             }
 
             ret = 0;
@@ -407,21 +756,21 @@ oe_result_t oe_cond_destroy(oe_cond_t* condition)
     return OE_OK;
 }
 
-oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+static oe_result_t _cond_wait_until(
+    oe_cond_impl_t* cond,
+    oe_mutex_t* mutex,
+    uint64_t deadline)
 {
-    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
     oe_thread_data_t* self = oe_get_thread_data();
-
-    if (!cond || !mutex)
-        return OE_INVALID_PARAMETER;
+    const uint32_t spin_count = oe_get_lock_spin_count();
+    uint32_t spun = 0;
+    uint32_t backoff = 1;
+    oe_result_t result = OE_OK;
 
     oe_spin_lock(&cond->lock);
     {
         oe_thread_data_t* waiter = NULL;
 
-        /* Add the self thread to the end of the wait queue */
-        _queue_push_back((Queue*)&cond->queue, self);
-
         /* Unlock this mutex and get the waiter at the front of the queue */
         if (_mutex_unlock(mutex, &waiter) != 0)
         {
@@ -429,46 +778,126 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
             return OE_BUSY;
         }
 
-        for (;;)
+        /* Add the self thread to the end of the wait queue */
+        _queue_push_back((Queue*)&cond->queue, self);
+        *_wait_state(self) = THREAD_SPINNING;
+
+        /* Loop until self is selected (no longer waiting) */
+        while (*_wait_state(self) != THREAD_RUNNING)
         {
+            if (*_wait_state(self) == THREAD_SPINNING && spun < spin_count)
+            {
+                oe_spin_unlock(&cond->lock);
+                {
+                    if (waiter)
+                    {
+                        _thread_wake(waiter);
+                        waiter = NULL;
+                    }
+
+                    while (*_wait_state(self) == THREAD_SPINNING &&
+                           _spin(spin_count, &spun, &backoff))
+                        ;
+                }
+                oe_spin_lock(&cond->lock);
+                continue;
+            }
+
+            *_wait_state(self) = THREAD_PARKED;
+
             oe_spin_unlock(&cond->lock);
             {
-                if (waiter)
+                if (waiter && deadline == NO_DEADLINE)
                 {
                     _thread_wake_wait(waiter, self);
                     waiter = NULL;
                 }
                 else
                 {
-                    _thread_wait(self);
+                    if (waiter)
+                    {
+                        _thread_wake(waiter);
+                        waiter = NULL;
+                    }
+
+                    result = _thread_wait_until(self, deadline);
                 }
             }
             oe_spin_lock(&cond->lock);
 
-            /* If self is no longer in the queue, then it was selected */
-            if (!_queue_contains((Queue*)&cond->queue, self))
-                break;
+            /* Leave the queue unless signaled as the wait timed out */
+            if (result == OE_TIMEOUT && *_wait_state(self) != THREAD_RUNNING)
+            {
+                _queue_remove((Queue*)&cond->queue, self);
+                *_wait_state(self) = THREAD_RUNNING;
+            }
+            else
+            {
+                result = OE_OK;
+            }
         }
     }
     oe_spin_unlock(&cond->lock);
     oe_mutex_lock(mutex);
 
-    return OE_OK;
+    return result;
+}
+
+oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+{
+    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
+    LockProbe probe;
+
+    if (!cond || !mutex)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_COND,
+        cond,
+        _cond_wait_until(cond, mutex, NO_DEADLINE));
+}
+
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* condition,
+    oe_mutex_t* mutex,
+    uint64_t deadline)
+{
+    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
+    LockProbe probe;
+
+    if (!cond || !mutex || deadline == NO_DEADLINE)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_COND,
+        cond,
+        _cond_wait_until(cond, mutex, deadline));
 }
 
 oe_result_t oe_cond_signal(oe_cond_t* condition)
 {
     oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
     oe_thread_data_t* waiter;
+    bool wake = false;
 
     if (!cond)
         return OE_INVALID_PARAMETER;
 
     oe_spin_lock(&cond->lock);
     waiter = _queue_pop_front((Queue*)&cond->queue);
+
+    /* A spinning waiter may run (and reuse its next field) once selected */
+    if (waiter)
+        wake = _select_waiter(waiter);
     oe_spin_unlock(&cond->lock);
 
-    if (!waiter)
+    if (!wake)
         return OE_OK;
 
     _thread_wake(waiter);
@@ -478,30 +907,55 @@ oe_result_t oe_cond_signal(oe_cond_t* condition)
 oe_result_t oe_cond_broadcast(oe_cond_t* condition)
 {
     oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
-    Queue waiters = {NULL, NULL};
+    Queue* queue;
+    WakeBatch batch;
+    size_t remaining;
 
     if (!cond)
         return OE_INVALID_PARAMETER;
 
+    queue = (Queue*)&cond->queue;
+
     oe_spin_lock(&cond->lock);
+
+    /* Wake the threads waiting at the time of the call, a batch per OCALL.
+     * The queue is only read under the spinlock, since a woken thread may
+     * reuse its next field at once */
+    remaining = _queue_length(queue);
+
+    while (remaining > 0)
     {
         oe_thread_data_t* p;
 
-        while ((p = _queue_pop_front((Queue*)&cond->queue)))
-            _queue_push_back(&waiters, p);
-    }
-    oe_spin_unlock(&cond->lock);
+        batch.count = 0;
 
-    oe_thread_data_t* p_next = NULL;
-    for (oe_thread_data_t* p = waiters.front; p; p = p_next)
-    {
-        // p could wake up and immediately use a synchronization
-        // primitive that could modify the next field.
-        // Therefore fetch the next thread before waking up p.
-        p_next = p->next;
-        _thread_wake(p);
+        while (remaining > 0 && batch.count < WAKE_BATCH_SIZE)
+        {
+            /* Waiters that timed out have left the queue */
+            if (!(p = _queue_pop_front(queue)))
+            {
+                remaining = 0;
+                break;
+            }
+
+            remaining--;
+
+            /* Only parked waiters are woken: spinning ones notice by
+             * themselves */
+            if (_select_waiter(p))
+                batch.tcs[batch.count++] = td_to_tcs((td_t*)p);
+        }
+
+        if (batch.count)
+        {
+            oe_spin_unlock(&cond->lock);
+            _thread_wake_batch(&batch);
+            oe_spin_lock(&cond->lock);
+        }
     }
 
+    oe_spin_unlock(&cond->lock);
+
     return OE_OK;
 }
 
@@ -513,6 +967,8 @@ oe_result_t oe_cond_broadcast(oe_cond_t* condition)
 **==============================================================================
 */
 
+typedef struct _reader_slots ReaderSlots;
+
 /* Internal readers-writer lock variable implementation. */
 typedef struct _oe_rwlock_impl
 {
@@ -528,52 +984,444 @@ typedef struct _oe_rwlock_impl
     /* Queue of threads waiting on this variable. */
     Queue queue;
 
+    /* Reader slots of a distributed lock (null for other locks). */
+    ReaderSlots* slots;
+
 } oe_rwlock_impl_t;
 
 OE_STATIC_ASSERT(sizeof(oe_rwlock_impl_t) <= sizeof(oe_rwlock_t));
 
-oe_result_t oe_rwlock_init(oe_rwlock_t* read_write_lock)
+// The current thread must hold the spinlock.
+// _wake_waiters releases ownership of the spinlock.
+static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
 {
-    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
-    oe_result_t result = OE_UNEXPECTED;
+    oe_thread_data_t* p = NULL;
+    WakeBatch batch;
+
+    // Take a snapshot of the number of current waiters.
+    size_t remaining = _queue_length(&rw_lock->queue);
+
+    // Wake the waiters in FIFO order, a batch per OCALL. The queue is only
+    // read under the spinlock, since a woken waiter may immediately queue
+    // itself again. Releasing the lock before each OCALL allows a waiter
+    // that is woken up to immediately acquire the spinlock and
+    // subsequently, the ownership of the rw_lock. However actual
+    // acquisition of the lock will be dependent on OS scheduling of the
+    // threads.
+    do
+    {
+        batch.count = 0;
 
-    if (!rw_lock)
-        return OE_INVALID_PARAMETER;
+        while (remaining > 0 && batch.count < WAKE_BATCH_SIZE &&
+               (p = _queue_pop_front(&rw_lock->queue)))
+        {
+            remaining--;
+            batch.tcs[batch.count++] = td_to_tcs((td_t*)p);
+        }
 
-    memset(rw_lock, 0, sizeof(oe_rwlock_t));
-    rw_lock->lock = OE_SPINLOCK_INITIALIZER;
+        // Waiters that timed out have left the queue.
+        if (!p)
+            remaining = 0;
 
-    result = OE_OK;
+        oe_spin_unlock(&rw_lock->lock);
+        _thread_wake_batch(&batch);
 
-    return result;
+        if (remaining > 0)
+            oe_spin_lock(&rw_lock->lock);
+    } while (remaining > 0);
+
+    return OE_OK;
 }
 
-oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
-{
-    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
-    oe_thread_data_t* self = oe_get_thread_data();
+/*
+**==============================================================================
+**
+** Distributed readers-writer lock:
+**
+**     A lock created with oe_rwlock_init_distributed() counts its readers in
+**     one slot per TCS, each in its own cache line, so readers of different
+**     threads do not write to the same memory. A reader increments its slot
+**     and goes on unless a writer has come, in which case it decrements the
+**     slot again and waits in the queue of the lock until the writer is
+**     done. A writer announces itself in the writer word of the slots, which
+**     keeps new readers out (writer preference), then waits until all the
+**     slots are zero: it spins first, then parks until the last reader wakes
+**     it. Both sides update their word with a locked instruction before
+**     reading the other's, so either the reader sees the writer or the
+**     writer sees the reader.
+**
+**     A thread that already holds the lock for reading may lock it again
+**     while a writer waits, since the writer is waiting for it.
+**
+**     Writers and waiting readers synchronize on the spinlock and queue of
+**     the lock as for other locks; only the fast path of readers is
+**     distributed.
+**
+**==============================================================================
+*/
+
+#define CACHE_LINE_SIZE 64
+
+/* Reader count of a TCS */
+typedef struct _reader_slot
+{
+    volatile uint64_t count;
+    uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} ReaderSlot;
+
+struct _reader_slots
+{
+    /* The thread data of the writer that owns the lock or waits for its
+     * readers to leave, or zero */
+    volatile uint64_t writer;
+
+    /* Non-zero while the writer is parked waiting for the readers */
+    volatile uint64_t writer_parked;
+
+    uint64_t num_slots;
+    uint8_t padding[CACHE_LINE_SIZE - 3 * sizeof(uint64_t)];
+
+    ReaderSlot slots[];
+};
+
+OE_STATIC_ASSERT(sizeof(ReaderSlot) == CACHE_LINE_SIZE);
+OE_STATIC_ASSERT(sizeof(ReaderSlots) == CACHE_LINE_SIZE);
+
+/* Slots handed out to the threads (one per TCS) */
+static volatile uint64_t _num_reader_slots;
+
+/* The reader count of the calling thread */
+static volatile uint64_t* _reader_count(
+    ReaderSlots* slots,
+    oe_thread_data_t* self)
+{
+    td_t* td = (td_t*)self;
+
+    if (!td->rwlock_slot)
+        td->rwlock_slot = oe_atomic_increment(&_num_reader_slots);
+
+    return &slots->slots[(td->rwlock_slot - 1) % slots->num_slots].count;
+}
+
+static bool _has_readers(ReaderSlots* slots)
+{
+    for (uint64_t i = 0; i < slots->num_slots; i++)
+    {
+        if (slots->slots[i].count)
+            return true;
+    }
+
+    return false;
+}
+
+/* Remove a reader, and wake the writer if it is parked waiting for the
+ * readers to leave */
+static void _leave_reader(ReaderSlots* slots, volatile uint64_t* count)
+{
+    if (oe_atomic_decrement(count) == 0 &&
+        oe_atomic_load(&slots->writer_parked))
+    {
+        const uint64_t writer = slots->writer;
+
+        // A late wake-up only makes a later wait return early.
+        if (writer)
+            _thread_wake((oe_thread_data_t*)writer);
+    }
+}
+
+static oe_result_t _drwlock_rdlock_until(
+    oe_rwlock_impl_t* rw_lock,
+    uint64_t deadline)
+{
+    ReaderSlots* slots = rw_lock->slots;
+    oe_thread_data_t* self = oe_get_thread_data();
+    volatile uint64_t* count = _reader_count(slots, self);
+
+    for (;;)
+    {
+        // Announce the reader, then check for a writer.
+        if (oe_atomic_increment(count) > 1 || !oe_atomic_load(&slots->writer))
+            return OE_OK;
+
+        _leave_reader(slots, count);
+        _count_contention(self);
+
+        // Wait for the writer to release the lock.
+        oe_spin_lock(&rw_lock->lock);
+
+        if (slots->writer)
+        {
+            oe_result_t result;
+
+            if (!_queue_contains(&rw_lock->queue, self))
+                _queue_push_back(&rw_lock->queue, self);
+
+            oe_spin_unlock(&rw_lock->lock);
+            result = _thread_wait_until(self, deadline);
+            oe_spin_lock(&rw_lock->lock);
+
+            // Give up if the lock is still held at the deadline.
+            if (result == OE_TIMEOUT && slots->writer)
+            {
+                _queue_remove(&rw_lock->queue, self);
+                oe_spin_unlock(&rw_lock->lock);
+                return OE_TIMEOUT;
+            }
+        }
+
+        _queue_remove(&rw_lock->queue, self);
+        oe_spin_unlock(&rw_lock->lock);
+    }
+}
+
+static oe_result_t _drwlock_tryrdlock(oe_rwlock_impl_t* rw_lock)
+{
+    ReaderSlots* slots = rw_lock->slots;
+    volatile uint64_t* count = _reader_count(slots, oe_get_thread_data());
+
+    if (oe_atomic_increment(count) > 1 || !oe_atomic_load(&slots->writer))
+        return OE_OK;
+
+    _leave_reader(slots, count);
+
+    return OE_BUSY;
+}
+
+static oe_result_t _drwlock_rdunlock(oe_rwlock_impl_t* rw_lock)
+{
+    ReaderSlots* slots = rw_lock->slots;
+    volatile uint64_t* count = _reader_count(slots, oe_get_thread_data());
+
+    if (*count == 0)
+        return OE_NOT_OWNER;
+
+    _leave_reader(slots, count);
+
+    return OE_OK;
+}
+
+/* Wait until no thread holds the lock for reading. The caller has
+ * announced itself in slots->writer, so no new reader comes in */
+static oe_result_t _wait_for_readers(
+    ReaderSlots* slots,
+    oe_thread_data_t* self,
+    uint64_t deadline)
+{
+    const uint32_t spin_count = oe_get_lock_spin_count();
+    uint32_t spun = 0;
+    uint32_t backoff = 1;
+
+    while (_has_readers(slots))
+    {
+        oe_result_t result = OE_OK;
+
+        if (_spin(spin_count, &spun, &backoff))
+            continue;
+
+        // Park until the last reader leaves. A reader that leaves after
+        // the check below sees writer_parked and wakes this thread.
+        oe_atomic_increment(&slots->writer_parked);
+
+        if (_has_readers(slots))
+            result = _thread_wait_until(self, deadline);
+
+        oe_atomic_decrement(&slots->writer_parked);
+
+        if (result == OE_TIMEOUT && _has_readers(slots))
+            return OE_TIMEOUT;
+    }
+
+    return OE_OK;
+}
+
+static oe_result_t _drwlock_wrlock_until(
+    oe_rwlock_impl_t* rw_lock,
+    uint64_t deadline)
+{
+    ReaderSlots* slots = rw_lock->slots;
+    oe_thread_data_t* self = oe_get_thread_data();
+    oe_result_t result;
+
+    oe_spin_lock(&rw_lock->lock);
+
+    // Recursive writer lock.
+    if (slots->writer == (uint64_t)self)
+    {
+        oe_spin_unlock(&rw_lock->lock);
+        return OE_BUSY;
+    }
+
+    // Wait for any other writer to finish, then keep new readers out.
+    while (!oe_atomic_compare_and_swap(&slots->writer, 0, (uint64_t)self))
+    {
+        if (!_queue_contains(&rw_lock->queue, self))
+            _queue_push_back(&rw_lock->queue, self);
+
+        oe_spin_unlock(&rw_lock->lock);
+        result = _thread_wait_until(self, deadline);
+        oe_spin_lock(&rw_lock->lock);
+
+        // Give up if the lock is still held at the deadline.
+        if (result == OE_TIMEOUT && slots->writer)
+        {
+            _queue_remove(&rw_lock->queue, self);
+            oe_spin_unlock(&rw_lock->lock);
+            return OE_TIMEOUT;
+        }
+    }
+
+    // A wait cut short may leave self queued.
+    _queue_remove(&rw_lock->queue, self);
+    oe_spin_unlock(&rw_lock->lock);
+
+    // Wait for the readers inside to leave.
+    if (_wait_for_readers(slots, self, deadline) != OE_OK)
+    {
+        // Let in the readers that backed off.
+        oe_spin_lock(&rw_lock->lock);
+        slots->writer = 0;
+        _wake_waiters(rw_lock);
+        return OE_TIMEOUT;
+    }
+
+    rw_lock->writer = self;
+
+    return OE_OK;
+}
+
+static oe_result_t _drwlock_trywrlock(oe_rwlock_impl_t* rw_lock)
+{
+    ReaderSlots* slots = rw_lock->slots;
+    oe_thread_data_t* self = oe_get_thread_data();
+
+    oe_spin_lock(&rw_lock->lock);
+
+    if (!oe_atomic_compare_and_swap(&slots->writer, 0, (uint64_t)self))
+    {
+        oe_spin_unlock(&rw_lock->lock);
+        return OE_BUSY;
+    }
+
+    if (_has_readers(slots))
+    {
+        // Let in the readers that backed off meanwhile.
+        slots->writer = 0;
+        _wake_waiters(rw_lock);
+        return OE_BUSY;
+    }
+
+    rw_lock->writer = self;
+    oe_spin_unlock(&rw_lock->lock);
+
+    return OE_OK;
+}
+
+static oe_result_t _drwlock_wrunlock(oe_rwlock_impl_t* rw_lock)
+{
+    ReaderSlots* slots = rw_lock->slots;
+
+    oe_spin_lock(&rw_lock->lock);
+
+    // Self must be the owner.
+    if (rw_lock->writer != oe_get_thread_data())
+    {
+        oe_spin_unlock(&rw_lock->lock);
+        return OE_NOT_OWNER;
+    }
+
+    rw_lock->writer = NULL;
+    slots->writer = 0;
+
+    // Wake the waiting readers and writers.
+    return _wake_waiters(rw_lock);
+}
+
+/*
+**==============================================================================
+**
+** oe_rwlock_t functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_rwlock_init(oe_rwlock_t* read_write_lock)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    oe_result_t result = OE_UNEXPECTED;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    memset(rw_lock, 0, sizeof(oe_rwlock_t));
+    rw_lock->lock = OE_SPINLOCK_INITIALIZER;
+
+    result = OE_OK;
+
+    return result;
+}
+
+oe_result_t oe_rwlock_init_distributed(oe_rwlock_t* read_write_lock)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    const uint64_t num_slots = oe_get_num_tcs() ? oe_get_num_tcs() : 1;
+    const size_t size = sizeof(ReaderSlots) + num_slots * sizeof(ReaderSlot);
+    ReaderSlots* slots;
+
+    if (!rw_lock)
+        return OE_INVALID_PARAMETER;
+
+    if (!(slots = (ReaderSlots*)oe_memalign(CACHE_LINE_SIZE, size)))
+        return OE_OUT_OF_MEMORY;
+
+    memset(slots, 0, size);
+    slots->num_slots = num_slots;
+
+    oe_rwlock_init(read_write_lock);
+    rw_lock->slots = slots;
+
+    return OE_OK;
+}
+
+static oe_result_t _rwlock_rdlock_until(
+    oe_rwlock_impl_t* rw_lock,
+    uint64_t deadline)
+{
+    oe_thread_data_t* self = oe_get_thread_data();
+
+    if (rw_lock->slots)
+        return _drwlock_rdlock_until(rw_lock, deadline);
+
     oe_spin_lock(&rw_lock->lock);
 
     // Wait for writer to finish.
     // Multiple readers can concurrently operate.
     while (rw_lock->writer != NULL)
     {
+        oe_result_t result;
+
         // Add self to list of waiters, and go to wait state.
         if (!_queue_contains(&rw_lock->queue, self))
             _queue_push_back(&rw_lock->queue, self);
 
         oe_spin_unlock(&rw_lock->lock);
-        _thread_wait(self);
+        result = _thread_wait_until(self, deadline);
 
         // Upon waking, re-acquire the lock.
         // Just like a condition variable.
         oe_spin_lock(&rw_lock->lock);
+
+        // Give up if the lock is still held at the deadline.
+        if (result == OE_TIMEOUT && rw_lock->writer != NULL)
+        {
+            _queue_remove(&rw_lock->queue, self);
+            oe_spin_unlock(&rw_lock->lock);
+            return OE_TIMEOUT;
+        }
     }
 
+    // A wait cut short may leave self queued.
+    _queue_remove(&rw_lock->queue, self);
+
     // Increment number of readers.
     rw_lock->readers++;
 
@@ -582,13 +1430,47 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
     return OE_OK;
 }
 
-oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
+oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    LockProbe probe;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_RWLOCK,
+        rw_lock,
+        _rwlock_rdlock_until(rw_lock, NO_DEADLINE));
+}
+
+oe_result_t oe_rwlock_timedrdlock(
+    oe_rwlock_t* read_write_lock,
+    uint64_t deadline)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    LockProbe probe;
+
+    if (!rw_lock || deadline == NO_DEADLINE)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_RWLOCK,
+        rw_lock,
+        _rwlock_rdlock_until(rw_lock, deadline));
+}
+
+static oe_result_t _rwlock_tryrdlock(oe_rwlock_impl_t* rw_lock)
+{
+    if (rw_lock->slots)
+        return _drwlock_tryrdlock(rw_lock);
+
     oe_spin_lock(&rw_lock->lock);
 
     oe_result_t result = OE_BUSY;
@@ -605,28 +1487,18 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     return result;
 }
 
-// The current thread must hold the spinlock.
-// _wake_waiters releases ownership of the spinlock.
-static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
+oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
 {
-    oe_thread_data_t* p = NULL;
-    Queue waiters = {NULL, NULL};
-
-    // Take a snapshot of current list of waiters.
-    while ((p = _queue_pop_front(&rw_lock->queue)))
-        _queue_push_back(&waiters, p);
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    LockProbe probe;
 
-    // Release the lock and wake up the waiters. This allows waiter that is
-    // woken up to immediately acquire the spinlock and subsequently, the
-    // ownership of the rw_lock.
-    oe_spin_unlock(&rw_lock->lock);
+    if (!rw_lock)
+        return OE_INVALID_PARAMETER;
 
-    // Wake the waiters in FIFO order. However actual acquisition of the lock
-    // will be dependent on OS scheduling of the threads.
-    while ((p = _queue_pop_front(&waiters)))
-        _thread_wake(p);
+    _probe_start(&probe, __builtin_return_address(0));
 
-    return OE_OK;
+    return _probe_end(
+        &probe, OE_LOCK_TYPE_RWLOCK, rw_lock, _rwlock_tryrdlock(rw_lock));
 }
 
 static oe_result_t _rwlock_rdunlock(oe_rwlock_t* read_write_lock)
@@ -636,6 +1508,9 @@ static oe_result_t _rwlock_rdunlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (rw_lock->slots)
+        return _drwlock_rdunlock(rw_lock);
+
     oe_spin_lock(&rw_lock->lock);
 
     // There must be at least 1 reader and no writers.
@@ -656,13 +1531,14 @@ static oe_result_t _rwlock_rdunlock(oe_rwlock_t* read_write_lock)
     return OE_OK;
 }
 
-oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
+static oe_result_t _rwlock_wrlock_until(
+    oe_rwlock_impl_t* rw_lock,
+    uint64_t deadline)
 {
-    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
     oe_thread_data_t* self = oe_get_thread_data();
 
-    if (!rw_lock)
-        return OE_INVALID_PARAMETER;
+    if (rw_lock->slots)
+        return _drwlock_wrlock_until(rw_lock, deadline);
 
     oe_spin_lock(&rw_lock->lock);
 
@@ -676,33 +1552,82 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
     // Wait for all readers and any other writer to finish.
     while (rw_lock->readers > 0 || rw_lock->writer != NULL)
     {
+        oe_result_t result;
+
         // Add self to list of waiters, and go to wait state.
         if (!_queue_contains(&rw_lock->queue, self))
             _queue_push_back(&rw_lock->queue, self);
 
         oe_spin_unlock(&rw_lock->lock);
 
-        _thread_wait(self);
+        result = _thread_wait_until(self, deadline);
 
         // Upon waking, re-acquire the lock.
         // Just like a condition variable.
         oe_spin_lock(&rw_lock->lock);
+
+        // Give up if the lock is still held at the deadline.
+        if (result == OE_TIMEOUT &&
+            (rw_lock->readers > 0 || rw_lock->writer != NULL))
+        {
+            _queue_remove(&rw_lock->queue, self);
+            oe_spin_unlock(&rw_lock->lock);
+            return OE_TIMEOUT;
+        }
     }
 
+    // A wait cut short may leave self queued.
+    _queue_remove(&rw_lock->queue, self);
+
     rw_lock->writer = self;
     oe_spin_unlock(&rw_lock->lock);
 
     return OE_OK;
 }
 
-oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
+oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
-    oe_thread_data_t* self = oe_get_thread_data();
+    LockProbe probe;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_RWLOCK,
+        rw_lock,
+        _rwlock_wrlock_until(rw_lock, NO_DEADLINE));
+}
+
+oe_result_t oe_rwlock_timedwrlock(
+    oe_rwlock_t* read_write_lock,
+    uint64_t deadline)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    LockProbe probe;
+
+    if (!rw_lock || deadline == NO_DEADLINE)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe,
+        OE_LOCK_TYPE_RWLOCK,
+        rw_lock,
+        _rwlock_wrlock_until(rw_lock, deadline));
+}
+
+static oe_result_t _rwlock_trywrlock(oe_rwlock_impl_t* rw_lock)
+{
+    oe_thread_data_t* self = oe_get_thread_data();
+
+    if (rw_lock->slots)
+        return _drwlock_trywrlock(rw_lock);
+
     oe_result_t result = OE_BUSY;
     oe_spin_lock(&rw_lock->lock);
 
@@ -718,6 +1643,20 @@ oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
     return result;
 }
 
+oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
+{
+    oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    LockProbe probe;
+
+    if (!rw_lock)
+        return OE_INVALID_PARAMETER;
+
+    _probe_start(&probe, __builtin_return_address(0));
+
+    return _probe_end(
+        &probe, OE_LOCK_TYPE_RWLOCK, rw_lock, _rwlock_trywrlock(rw_lock));
+}
+
 static oe_result_t _rwlock_wrunlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -726,6 +1665,9 @@ static oe_result_t _rwlock_wrunlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (rw_lock->slots)
+        return _drwlock_wrunlock(rw_lock);
+
     oe_spin_lock(&rw_lock->lock);
 
     // Self must be the owner.
@@ -759,12 +1701,17 @@ oe_result_t oe_rwlock_destroy(oe_rwlock_t* read_write_lock)
     oe_spin_lock(&rw_lock->lock);
 
     // There must not be any active readers or writers.
-    if (rw_lock->readers != 0 || rw_lock->writer != NULL)
+    if (rw_lock->readers != 0 || rw_lock->writer != NULL ||
+        (rw_lock->slots &&
+         (rw_lock->slots->writer || _has_readers(rw_lock->slots))))
     {
         oe_spin_unlock(&rw_lock->lock);
         return OE_BUSY;
     }
 
+    oe_free(rw_lock->slots);
+    rw_lock->slots = NULL;
+
     oe_spin_unlock(&rw_lock->lock);
 
     return OE_OK;
@@ -789,6 +1736,333 @@ oe_result_t oe_rwlock_unlock(oe_rwlock_t* read_write_lock)
         return _rwlock_rdunlock(read_write_lock);
 }
 
+/*
+**==============================================================================
+**
+** oe_futex:
+**
+**     Threads wait on the address of a 32-bit word, as with the Linux futex.
+**     The waiters are queued in one of FUTEX_BUCKETS buckets, selected by
+**     hashing the address, each with a spinlock and a queue of its own, so
+**     the futex words need no initialization. A waiter is a node on the
+**     stack of the waiting thread. It spins, parks and is selected like the
+**     waiters of the other locks (see Adaptive waits above), under the
+**     spinlock of its bucket.
+**
+**     A requeue moves waiters to another address, possibly in another
+**     bucket, holding the spinlocks of both buckets (taken in address
+**     order). A waiter that locks its bucket checks under the spinlock that
+**     it was not moved in the meantime.
+**
+**==============================================================================
+*/
+
+#define FUTEX_BUCKET_BITS 6
+#define FUTEX_BUCKETS (1 << FUTEX_BUCKET_BITS)
+
+typedef struct _futex_waiter
+{
+    struct _futex_waiter* next;
+    struct _futex_waiter* prev;
+
+    /* The futex word waited on (changed by a requeue) */
+    volatile uint32_t* volatile addr;
+
+    oe_thread_data_t* thread;
+} FutexWaiter;
+
+typedef struct _futex_bucket
+{
+    oe_spinlock_t lock;
+    FutexWaiter* front;
+    FutexWaiter* back;
+    uint8_t padding[CACHE_LINE_SIZE - 3 * sizeof(uint64_t)];
+} FutexBucket;
+
+OE_STATIC_ASSERT(sizeof(FutexBucket) == CACHE_LINE_SIZE);
+
+static FutexBucket _futex_buckets[FUTEX_BUCKETS];
+
+static FutexBucket* _futex_bucket(volatile uint32_t* addr)
+{
+    const uint64_t hash = (uint64_t)addr * 0x9e3779b97f4a7c15;
+
+    return &_futex_buckets[hash >> (64 - FUTEX_BUCKET_BITS)];
+}
+
+static void _futex_push_back(FutexBucket* bucket, FutexWaiter* waiter)
+{
+    waiter->next = NULL;
+    waiter->prev = bucket->back;
+
+    if (bucket->back)
+        bucket->back->next = waiter;
+    else
+        bucket->front = waiter;
+
+    bucket->back = waiter;
+}
+
+static void _futex_remove(FutexBucket* bucket, FutexWaiter* waiter)
+{
+    if (waiter->prev)
+        waiter->prev->next = waiter->next;
+    else
+        bucket->front = waiter->next;
+
+    if (waiter->next)
+        waiter->next->prev = waiter->prev;
+    else
+        bucket->back = waiter->prev;
+}
+
+/* Lock the bucket that a waiter is queued in */
+static FutexBucket* _futex_lock_waiter(FutexWaiter* waiter)
+{
+    for (;;)
+    {
+        FutexBucket* bucket = _futex_bucket(waiter->addr);
+
+        oe_spin_lock(&bucket->lock);
+
+        if (_futex_bucket(waiter->addr) == bucket)
+            return bucket;
+
+        /* Requeued to another bucket */
+        oe_spin_unlock(&bucket->lock);
+    }
+}
+
+static void _futex_lock_pair(FutexBucket* bucket1, FutexBucket* bucket2)
+{
+    if (bucket1 == bucket2)
+    {
+        oe_spin_lock(&bucket1->lock);
+    }
+    else if (bucket1 < bucket2)
+    {
+        oe_spin_lock(&bucket1->lock);
+        oe_spin_lock(&bucket2->lock);
+    }
+    else
+    {
+        oe_spin_lock(&bucket2->lock);
+        oe_spin_lock(&bucket1->lock);
+    }
+}
+
+static void _futex_unlock_pair(FutexBucket* bucket1, FutexBucket* bucket2)
+{
+    if (bucket1 != bucket2)
+        oe_spin_unlock(&bucket2->lock);
+
+    oe_spin_unlock(&bucket1->lock);
+}
+
+/* Select up to count waiters of addr, from the front of the bucket, until
+ * the batch of the parked ones is full. Returns the number selected. The
+ * caller holds the spinlock of the bucket */
+static size_t _futex_select(
+    FutexBucket* bucket,
+    volatile uint32_t* addr,
+    size_t count,
+    WakeBatch* batch)
+{
+    FutexWaiter* p = bucket->front;
+    size_t n = 0;
+
+    while (p && n < count && batch->count < WAKE_BATCH_SIZE)
+    {
+        FutexWaiter* next = p->next;
+
+        if (p->addr == addr)
+        {
+            oe_thread_data_t* thread = p->thread;
+
+            /* The waiter may return (and release its node) once selected */
+            _futex_remove(bucket, p);
+
+            if (_select_waiter(thread))
+                batch->tcs[batch->count++] = td_to_tcs((td_t*)thread);
+
+            n++;
+        }
+
+        p = next;
+    }
+
+    return n;
+}
+
+oe_result_t oe_futex_wait(
+    volatile uint32_t* addr,
+    uint32_t val,
+    uint64_t deadline)
+{
+    oe_thread_data_t* self = oe_get_thread_data();
+    const uint32_t spin_count = oe_get_lock_spin_count();
+    uint32_t spun = 0;
+    uint32_t backoff = 1;
+    FutexWaiter waiter;
+    FutexBucket* bucket;
+    oe_result_t result = OE_OK;
+
+    if (!addr || ((uint64_t)addr & 3))
+        return OE_INVALID_PARAMETER;
+
+    bucket = _futex_bucket(addr);
+    oe_spin_lock(&bucket->lock);
+
+    /* The word is compared under the spinlock that the wakes take, so a
+     * wake that follows a change of the word cannot be missed */
+    if (*addr != val)
+    {
+        oe_spin_unlock(&bucket->lock);
+        return OE_BUSY;
+    }
+
+    waiter.addr = addr;
+    waiter.thread = self;
+    _futex_push_back(bucket, &waiter);
+    *_wait_state(self) = THREAD_SPINNING;
+
+    oe_spin_unlock(&bucket->lock);
+
+    while (*_wait_state(self) == THREAD_SPINNING &&
+           _spin(spin_count, &spun, &backoff))
+        ;
+
+    for (;;)
+    {
+        bucket = _futex_lock_waiter(&waiter);
+
+        /* Selected (possibly just as the wait timed out) */
+        if (*_wait_state(self) == THREAD_RUNNING)
+        {
+            result = OE_OK;
+            break;
+        }
+
+        if (result != OE_OK)
+        {
+            _futex_remove(bucket, &waiter);
+            *_wait_state(self) = THREAD_RUNNING;
+            break;
+        }
+
+        *_wait_state(self) = THREAD_PARKED;
+
+        oe_spin_unlock(&bucket->lock);
+        result = _thread_wait_until(self, deadline);
+    }
+
+    oe_spin_unlock(&bucket->lock);
+
+    return result;
+}
+
+oe_result_t oe_futex_wake(volatile uint32_t* addr, size_t count, size_t* woken)
+{
+    FutexBucket* bucket;
+    WakeBatch batch;
+    size_t n = 0;
+
+    if (!addr || ((uint64_t)addr & 3))
+        return OE_INVALID_PARAMETER;
+
+    bucket = _futex_bucket(addr);
+
+    /* Wake a batch per OCALL */
+    do
+    {
+        batch.count = 0;
+
+        oe_spin_lock(&bucket->lock);
+        n += _futex_select(bucket, addr, count - n, &batch);
+        oe_spin_unlock(&bucket->lock);
+
+        _thread_wake_batch(&batch);
+    } while (batch.count == WAKE_BATCH_SIZE && n < count);
+
+    if (woken)
+        *woken = n;
+
+    return OE_OK;
+}
+
+oe_result_t oe_futex_requeue(
+    volatile uint32_t* addr,
+    uint32_t val,
+    size_t num_wake,
+    volatile uint32_t* addr2,
+    size_t num_requeue,
+    size_t* count)
+{
+    FutexBucket* bucket;
+    FutexBucket* bucket2;
+    FutexWaiter* p;
+    WakeBatch batch;
+    size_t n = 0;
+    size_t moved = 0;
+
+    if (!addr || ((uint64_t)addr & 3) || !addr2 || ((uint64_t)addr2 & 3))
+        return OE_INVALID_PARAMETER;
+
+    bucket = _futex_bucket(addr);
+    bucket2 = _futex_bucket(addr2);
+    batch.count = 0;
+
+    _futex_lock_pair(bucket, bucket2);
+
+    if (*addr != val)
+    {
+        _futex_unlock_pair(bucket, bucket2);
+        return OE_BUSY;
+    }
+
+    /* Wake a batch per OCALL */
+    for (;;)
+    {
+        n += _futex_select(bucket, addr, num_wake - n, &batch);
+
+        if (n == num_wake || batch.count < WAKE_BATCH_SIZE)
+            break;
+
+        _futex_unlock_pair(bucket, bucket2);
+        _thread_wake_batch(&batch);
+        batch.count = 0;
+        _futex_lock_pair(bucket, bucket2);
+    }
+
+    /* Move the next waiters, which stay in their wait state */
+    for (p = bucket->front; p && moved < num_requeue;)
+    {
+        FutexWaiter* next = p->next;
+
+        if (p->addr == addr)
+        {
+            if (bucket2 != bucket)
+            {
+                _futex_remove(bucket, p);
+                _futex_push_back(bucket2, p);
+            }
+
+            p->addr = addr2;
+            moved++;
+        }
+
+        p = next;
+    }
+
+    _futex_unlock_pair(bucket, bucket2);
+    _thread_wake_batch(&batch);
+
+    if (count)
+        *count = n + moved;
+
+    return OE_OK;
+}
+
 /*
 **==============================================================================
 **
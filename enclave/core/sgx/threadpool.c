@@ -0,0 +1,282 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include "internal_t.h"
+
+/*
+**==============================================================================
+**
+** Enclave threads:
+**
+**     The host lends the enclave a pool of threads, each holding a TCS of
+**     its own for the lifetime of the enclave. oe_thread_create() asks the
+**     host to have an idle pool thread run the new thread, which it does by
+**     making oe_run_thread_ecall(). Each run is an outermost ECALL, so the
+**     thread starts with freshly initialized thread-local storage and its
+**     thread-specific data destructors run when it returns.
+**
+**     The host is not trusted with the thread objects: it only passes back
+**     the handles that the enclave gave it, and these are looked up in the
+**     list of threads before being used. Nor is it trusted to report the
+**     start of a thread: a thread that a pool thread started is treated as
+**     created even if the host reported an error.
+**
+**==============================================================================
+*/
+
+#define THREAD_MAGIC 0x4d3c0a0b1e2f7a69
+
+typedef enum _thread_state
+{
+    THREAD_PENDING,
+    THREAD_RUNNING,
+    THREAD_FINISHED,
+} thread_state_t;
+
+typedef struct _thread
+{
+    uint64_t magic;
+    struct _thread* next;
+    void* (*start_routine)(void*);
+    void* arg;
+    void* retval;
+    thread_state_t state;
+
+    /* Whether the thread was detached (it frees itself when it finishes) or
+     * is being joined (the joiner frees it) */
+    bool detached;
+    bool joining;
+} thread_t;
+
+static oe_mutex_t _lock = OE_MUTEX_INITIALIZER;
+
+/* Signaled whenever a thread finishes */
+static oe_cond_t _finished = OE_COND_INITIALIZER;
+
+/* The threads created and not yet joined or freed after being detached */
+static thread_t* _threads;
+
+/* The host pool and the number of its threads not running a thread */
+static void* _pool;
+static size_t _free_slots;
+
+/* Returns the thread of the given handle (null if there is none) */
+static thread_t* _find(uint64_t handle)
+{
+    for (thread_t* p = _threads; p; p = p->next)
+    {
+        if ((uint64_t)p == handle)
+            return p->magic == THREAD_MAGIC ? p : NULL;
+    }
+
+    return NULL;
+}
+
+static void _remove(thread_t* thread)
+{
+    for (thread_t** p = &_threads; *p; p = &(*p)->next)
+    {
+        if (*p == thread)
+        {
+            *p = thread->next;
+            break;
+        }
+    }
+}
+
+static void _free(thread_t* thread)
+{
+    _remove(thread);
+    thread->magic = 0;
+    oe_free(thread);
+}
+
+oe_result_t oe_init_thread_pool_ecall(void* pool, size_t max_threads)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    oe_mutex_lock(&_lock);
+
+    if (!pool || max_threads == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (_pool)
+        OE_RAISE(OE_UNEXPECTED);
+
+    _pool = pool;
+    _free_slots = max_threads;
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&_lock);
+    return result;
+}
+
+oe_result_t oe_run_thread_ecall(void* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    thread_t* thread;
+    void* retval;
+
+    oe_mutex_lock(&_lock);
+    {
+        if (!(thread = _find((uint64_t)handle)) ||
+            thread->state != THREAD_PENDING)
+        {
+            oe_mutex_unlock(&_lock);
+            OE_RAISE(OE_NOT_FOUND);
+        }
+
+        thread->state = THREAD_RUNNING;
+    }
+    oe_mutex_unlock(&_lock);
+
+    retval = thread->start_routine(thread->arg);
+
+    oe_mutex_lock(&_lock);
+    {
+        thread->retval = retval;
+        thread->state = THREAD_FINISHED;
+
+        if (thread->detached)
+            _free(thread);
+
+        _free_slots++;
+        oe_cond_broadcast(&_finished);
+    }
+    oe_mutex_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_thread_create(
+    oe_thread_t* thread_out,
+    void* (*start_routine)(void*),
+    void* arg)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+    thread_t* thread = NULL;
+    void* pool;
+
+    if (thread_out)
+        *thread_out = 0;
+
+    if (!thread_out || !start_routine)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(thread = (thread_t*)oe_calloc(1, sizeof(thread_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    thread->magic = THREAD_MAGIC;
+    thread->start_routine = start_routine;
+    thread->arg = arg;
+    thread->state = THREAD_PENDING;
+
+    /* Reserve a pool thread: the host can then start the thread at once */
+    oe_mutex_lock(&_lock);
+    {
+        if (!(pool = _pool) || _free_slots == 0)
+        {
+            oe_mutex_unlock(&_lock);
+            OE_RAISE_NO_TRACE(pool ? OE_OUT_OF_THREADS : OE_UNSUPPORTED);
+        }
+
+        _free_slots--;
+        thread->next = _threads;
+        _threads = thread;
+    }
+    oe_mutex_unlock(&_lock);
+
+    if ((result = oe_start_thread_ocall(&retval, pool, thread)) != OE_OK ||
+        (result = retval) != OE_OK)
+    {
+        bool started;
+
+        /* A pool thread may have started the thread despite the error: it
+         * then owns the thread object and its slot, and the thread must be
+         * joined or detached as any other */
+        oe_mutex_lock(&_lock);
+
+        if (!(started = thread->state != THREAD_PENDING))
+        {
+            _remove(thread);
+            _free_slots++;
+        }
+
+        oe_mutex_unlock(&_lock);
+
+        if (!started)
+            OE_RAISE(result);
+    }
+
+    *thread_out = (oe_thread_t)thread;
+    thread = NULL;
+    result = OE_OK;
+
+done:
+    oe_free(thread);
+    return result;
+}
+
+oe_result_t oe_thread_join(oe_thread_t handle, void** retval)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    thread_t* thread;
+
+    oe_mutex_lock(&_lock);
+
+    if (!(thread = _find(handle)))
+        OE_RAISE_NO_TRACE(OE_NOT_FOUND);
+
+    if (thread->detached || thread->joining)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    thread->joining = true;
+
+    while (thread->state != THREAD_FINISHED)
+        oe_cond_wait(&_finished, &_lock);
+
+    if (retval)
+        *retval = thread->retval;
+
+    _free(thread);
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&_lock);
+    return result;
+}
+
+oe_result_t oe_thread_detach(oe_thread_t handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    thread_t* thread;
+
+    oe_mutex_lock(&_lock);
+
+    if (!(thread = _find(handle)))
+        OE_RAISE_NO_TRACE(OE_NOT_FOUND);
+
+    if (thread->detached || thread->joining)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (thread->state == THREAD_FINISHED)
+        _free(thread);
+    else
+        thread->detached = true;
+
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&_lock);
+    return result;
+}
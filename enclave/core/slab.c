@@ -0,0 +1,529 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "slab.h"
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "runtimealloc.h"
+
+/*
+**==============================================================================
+**
+** Slab allocator:
+**
+**     A slab cache serves objects of one size in three layers:
+**
+**         (1) Each thread has two magazines per cache, arrays of free
+**             objects: the loaded one, which it allocates from and frees to,
+**             and the previous one. Allocating from an empty magazine swaps
+**             in the previous one if it is full, and freeing to a full one
+**             swaps in the previous one if it is empty, so a thread that
+**             alternates between allocating and freeing stays on its own
+**             magazines without taking any lock.
+**         (2) When both magazines of a thread are empty (or full), the
+**             thread exchanges the previous one with a full (or empty)
+**             magazine of the depot of the cache, under the lock of the
+**             cache. Objects thus move between threads a magazine at a time.
+**         (3) When the depot has no full magazine, objects are taken from
+**             the free list of the cache, which slabs carved from the
+**             enclave heap refill.
+**
+**     Every operation takes constant time, except carving a new slab. The
+**     magazines of a thread are found through a table indexed by cache,
+**     which each cache joins on first use, so the number of caches with
+**     magazines is bounded by OE_SLAB_MAX_CACHES. Each table entry records
+**     the generation of the cache it was set up for, so that the entries of
+**     a destroyed cache are not mistaken for those of a new one.
+**
+**     Slabs, magazines and tables live as long as their cache, or as the
+**     enclave, and are runtime allocations (see malloc.c).
+**
+**==============================================================================
+*/
+
+#define MAGAZINE_SIZE 16
+#define SLAB_SIZE (16 * 1024)
+#define MIN_SLAB_OBJECTS 8
+
+/* Index of a cache that got no entry in the tables of the threads */
+#define NO_MAGAZINES OE_UINT64_MAX
+
+typedef struct _object
+{
+    struct _object* next;
+} Object;
+
+typedef struct _slab
+{
+    struct _slab* next;
+} Slab;
+
+typedef struct _magazine
+{
+    /* Next magazine of the depot */
+    struct _magazine* next;
+
+    /* Next magazine of the cache, to free them all */
+    struct _magazine* next_all;
+
+    uint64_t rounds;
+    void* objects[MAGAZINE_SIZE];
+} Magazine;
+
+/* The magazines of a thread for one cache */
+typedef struct _entry
+{
+    uint64_t generation;
+    Magazine* loaded;
+    Magazine* previous;
+} Entry;
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+static oe_slab_cache_t* _caches[OE_SLAB_MAX_CACHES];
+static uint64_t _generation;
+
+static bool _valid(size_t object_size, size_t alignment)
+{
+    return object_size && object_size <= OE_SLAB_MAX_OBJECT_SIZE &&
+           alignment && !(alignment & (alignment - 1)) &&
+           alignment <= OE_SLAB_MAX_ALIGNMENT;
+}
+
+static size_t _alignment(const oe_slab_cache_t* cache)
+{
+    /* Free objects hold a pointer */
+    return cache->alignment < sizeof(void*) ? sizeof(void*) : cache->alignment;
+}
+
+/* Distance between the objects of a slab */
+static size_t _stride(const oe_slab_cache_t* cache)
+{
+    return oe_round_up_to_multiple(cache->object_size, _alignment(cache));
+}
+
+/* Give the cache an entry in the tables of the threads on first use */
+static bool _register(oe_slab_cache_t* cache)
+{
+    if (__atomic_load_n(&cache->index, __ATOMIC_ACQUIRE))
+        return true;
+
+    if (!_valid(cache->object_size, cache->alignment))
+        return false;
+
+    oe_spin_lock(&_lock);
+
+    if (!cache->index)
+    {
+        uint64_t index = NO_MAGAZINES;
+
+        for (uint64_t i = 0; i < OE_SLAB_MAX_CACHES; i++)
+        {
+            if (!_caches[i])
+            {
+                _caches[i] = cache;
+                index = i + 1;
+                break;
+            }
+        }
+
+        cache->generation = ++_generation;
+        __atomic_store_n(&cache->index, index, __ATOMIC_RELEASE);
+    }
+
+    oe_spin_unlock(&_lock);
+
+    return true;
+}
+
+/* Carve a new slab into a list of free objects */
+static Slab* _new_slab(
+    const oe_slab_cache_t* cache,
+    Object** first,
+    Object** last)
+{
+    const size_t alignment = _alignment(cache);
+    const size_t stride = _stride(cache);
+    const size_t header = oe_round_up_to_multiple(sizeof(Slab), alignment);
+    size_t count = 0;
+    uint8_t* objects;
+    Slab* slab;
+
+    if (header < SLAB_SIZE)
+        count = (SLAB_SIZE - header) / stride;
+
+    if (count < MIN_SLAB_OBJECTS)
+        count = MIN_SLAB_OBJECTS;
+
+    slab = (Slab*)oe_runtime_memalign(alignment, header + count * stride);
+
+    if (!slab)
+        return NULL;
+
+    objects = (uint8_t*)slab + header;
+
+    for (size_t i = 0; i + 1 < count; i++)
+        ((Object*)(objects + i * stride))->next =
+            (Object*)(objects + (i + 1) * stride);
+
+    *first = (Object*)objects;
+    *last = (Object*)(objects + (count - 1) * stride);
+    (*last)->next = NULL;
+
+    return slab;
+}
+
+/* Take up to count objects from the free list of the cache, carving a new
+ * slab if it is empty. Returns the number of objects taken */
+static size_t _take_objects(
+    oe_slab_cache_t* cache,
+    void** objects,
+    size_t count)
+{
+    size_t n = 0;
+    Object* object;
+    Object* last;
+    Slab* slab;
+
+    oe_spin_lock(&cache->lock);
+
+    while (n < count && (object = (Object*)cache->free_objects))
+    {
+        cache->free_objects = object->next;
+        objects[n++] = object;
+    }
+
+    oe_spin_unlock(&cache->lock);
+
+    if (n)
+        return n;
+
+    if (!(slab = _new_slab(cache, &object, &last)))
+        return 0;
+
+    while (n < count && object)
+    {
+        objects[n++] = object;
+        object = object->next;
+    }
+
+    /* The objects not taken join the free list */
+    oe_spin_lock(&cache->lock);
+
+    slab->next = (Slab*)cache->slabs;
+    cache->slabs = slab;
+
+    if (object)
+    {
+        last->next = (Object*)cache->free_objects;
+        cache->free_objects = object;
+    }
+
+    oe_spin_unlock(&cache->lock);
+
+    return n;
+}
+
+static void _put_object(oe_slab_cache_t* cache, void* ptr)
+{
+    Object* object = (Object*)ptr;
+
+    oe_spin_lock(&cache->lock);
+    object->next = (Object*)cache->free_objects;
+    cache->free_objects = object;
+    oe_spin_unlock(&cache->lock);
+}
+
+/* Take a magazine off one list of the depot and put the given magazine on
+ * another. Returns null, leaving the depot as it is, if the first list is
+ * empty */
+static Magazine* _exchange(
+    oe_slab_cache_t* cache,
+    void** take,
+    void** put,
+    Magazine* magazine)
+{
+    Magazine* taken;
+
+    /* Skip the lock when the list looks empty */
+    if (!__atomic_load_n(take, __ATOMIC_RELAXED))
+        return NULL;
+
+    oe_spin_lock(&cache->lock);
+
+    if ((taken = (Magazine*)*take))
+    {
+        *take = taken->next;
+        magazine->next = (Magazine*)*put;
+        *put = magazine;
+    }
+
+    oe_spin_unlock(&cache->lock);
+
+    return taken;
+}
+
+static void _put_magazine(
+    oe_slab_cache_t* cache,
+    void** list,
+    Magazine* magazine)
+{
+    oe_spin_lock(&cache->lock);
+    magazine->next = (Magazine*)*list;
+    *list = magazine;
+    oe_spin_unlock(&cache->lock);
+}
+
+/* Returns an empty magazine of the depot, or a new one */
+static Magazine* _get_empty_magazine(oe_slab_cache_t* cache)
+{
+    Magazine* magazine;
+
+    oe_spin_lock(&cache->lock);
+
+    if ((magazine = (Magazine*)cache->empty_magazines))
+        cache->empty_magazines = magazine->next;
+
+    oe_spin_unlock(&cache->lock);
+
+    if (magazine)
+        return magazine;
+
+    if (!(magazine = (Magazine*)oe_runtime_malloc(sizeof(Magazine))))
+        return NULL;
+
+    magazine->rounds = 0;
+
+    oe_spin_lock(&cache->lock);
+    magazine->next_all = (Magazine*)cache->magazines;
+    cache->magazines = magazine;
+    oe_spin_unlock(&cache->lock);
+
+    return magazine;
+}
+
+/* Returns the magazines of the calling thread for the cache, or null if
+ * the cache or the thread has none */
+static Entry* _get_entry(oe_slab_cache_t* cache)
+{
+    const uint64_t index = cache->index;
+    void** slot;
+    Entry* entries;
+    Entry* entry;
+
+    if (!index || index == NO_MAGAZINES ||
+        !(slot = oe_get_slab_magazines_slot()))
+        return NULL;
+
+    if (!(entries = (Entry*)*slot))
+    {
+        entries = (Entry*)oe_runtime_calloc(OE_SLAB_MAX_CACHES, sizeof(Entry));
+
+        if (!entries)
+            return NULL;
+
+        *slot = entries;
+    }
+
+    entry = &entries[index - 1];
+
+    /* The entry is new or belonged to a cache destroyed since, which freed
+     * its magazines */
+    if (entry->generation != cache->generation)
+    {
+        Magazine* loaded;
+        Magazine* previous;
+
+        if (!(loaded = _get_empty_magazine(cache)))
+            return NULL;
+
+        if (!(previous = _get_empty_magazine(cache)))
+        {
+            _put_magazine(cache, &cache->empty_magazines, loaded);
+            return NULL;
+        }
+
+        entry->loaded = loaded;
+        entry->previous = previous;
+        entry->generation = cache->generation;
+    }
+
+    return entry;
+}
+
+static void _swap(Entry* entry)
+{
+    Magazine* loaded = entry->loaded;
+
+    entry->loaded = entry->previous;
+    entry->previous = loaded;
+}
+
+/*
+**==============================================================================
+**
+** Public functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_slab_cache_init(
+    oe_slab_cache_t* cache,
+    size_t object_size,
+    size_t alignment)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!cache || !_valid(object_size, alignment))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memset(cache, 0, sizeof(oe_slab_cache_t));
+    cache->object_size = object_size;
+    cache->alignment = alignment;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void* oe_slab_alloc(oe_slab_cache_t* cache)
+{
+    Entry* entry;
+    Magazine* loaded;
+    void* object;
+
+    if (!cache || !_register(cache))
+        return NULL;
+
+    if (!(entry = _get_entry(cache)))
+        return _take_objects(cache, &object, 1) ? object : NULL;
+
+    if (!entry->loaded->rounds && entry->previous->rounds)
+        _swap(entry);
+
+    if (!entry->loaded->rounds)
+    {
+        Magazine* full;
+
+        /* Both magazines are empty: trade the previous one for a full
+         * magazine of the depot, or else fill the loaded one from the free
+         * list */
+        if ((full = _exchange(
+                 cache,
+                 &cache->full_magazines,
+                 &cache->empty_magazines,
+                 entry->previous)))
+        {
+            entry->previous = entry->loaded;
+            entry->loaded = full;
+        }
+        else
+        {
+            entry->loaded->rounds = _take_objects(
+                cache, entry->loaded->objects, MAGAZINE_SIZE);
+
+            if (!entry->loaded->rounds)
+                return NULL;
+        }
+    }
+
+    loaded = entry->loaded;
+    return loaded->objects[--loaded->rounds];
+}
+
+void* oe_slab_calloc(oe_slab_cache_t* cache)
+{
+    void* object;
+
+    if ((object = oe_slab_alloc(cache)))
+        memset(object, 0, cache->object_size);
+
+    return object;
+}
+
+void oe_slab_free(oe_slab_cache_t* cache, void* object)
+{
+    Entry* entry;
+
+    if (!cache || !object)
+        return;
+
+    if (!(entry = _get_entry(cache)))
+    {
+        _put_object(cache, object);
+        return;
+    }
+
+    if (entry->loaded->rounds == MAGAZINE_SIZE && !entry->previous->rounds)
+        _swap(entry);
+
+    if (entry->loaded->rounds == MAGAZINE_SIZE)
+    {
+        Magazine* empty;
+
+        /* Both magazines are full: trade the previous one for an empty
+         * magazine of the depot, or a new one */
+        if (!(empty = _exchange(
+                  cache,
+                  &cache->empty_magazines,
+                  &cache->full_magazines,
+                  entry->previous)))
+        {
+            if (!(empty = _get_empty_magazine(cache)))
+            {
+                _put_object(cache, object);
+                return;
+            }
+
+            _put_magazine(cache, &cache->full_magazines, entry->previous);
+        }
+
+        entry->previous = entry->loaded;
+        entry->loaded = empty;
+    }
+
+    entry->loaded->objects[entry->loaded->rounds++] = object;
+}
+
+void oe_slab_cache_destroy(oe_slab_cache_t* cache)
+{
+    Slab* slab;
+    Magazine* magazine;
+
+    if (!cache)
+        return;
+
+    /* The entries of the threads for the cache go stale: it gets a new
+     * generation if it is used again */
+    oe_spin_lock(&_lock);
+
+    if (cache->index && cache->index != NO_MAGAZINES)
+        _caches[cache->index - 1] = NULL;
+
+    cache->index = 0;
+
+    oe_spin_unlock(&_lock);
+
+    for (slab = (Slab*)cache->slabs; slab;)
+    {
+        Slab* next = slab->next;
+        oe_runtime_free(slab);
+        slab = next;
+    }
+
+    for (magazine = (Magazine*)cache->magazines; magazine;)
+    {
+        Magazine* next = magazine->next_all;
+        oe_runtime_free(magazine);
+        magazine = next;
+    }
+
+    cache->free_objects = NULL;
+    cache->slabs = NULL;
+    cache->full_magazines = NULL;
+    cache->empty_magazines = NULL;
+    cache->magazines = NULL;
+}
@@ -0,0 +1,14 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SLAB_H
+#define _OE_SLAB_H
+
+#include <openenclave/bits/slab.h>
+
+/* Returns the address of the slab magazines pointer of the calling thread,
+ * or null if the thread cannot cache objects yet. Implemented by each
+ * platform */
+void** oe_get_slab_magazines_slot(void);
+
+#endif /* _OE_SLAB_H */
@@ -72,6 +72,33 @@ oe_thread oe_thread_self(void);
  */
 int oe_thread_equal(oe_thread thread1, oe_thread thread2);
 
+/**
+ * Creates a new thread.
+ *
+ * This function creates a new thread that starts executing **func** with
+ * **arg** as its only argument. The new thread must eventually be joined
+ * with oe_thread_join().
+ *
+ * @param thread Set to the identifier of the new thread.
+ * @param func The function to be executed by the new thread.
+ * @param arg The argument passed to **func**.
+ *
+ * @returns Returns zero on success.
+ */
+int oe_thread_create(oe_thread* thread, void* (*func)(void*), void* arg);
+
+/**
+ * Waits for a thread to terminate.
+ *
+ * This function blocks until the thread created by oe_thread_create()
+ * terminates.
+ *
+ * @param thread A thread identifier obtained with oe_thread_create().
+ *
+ * @returns Returns zero on success.
+ */
+int oe_thread_join(oe_thread thread);
+
 /**
  * Calls the given function exactly once.
  *
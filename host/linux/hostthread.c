@@ -24,6 +24,16 @@ int oe_thread_equal(oe_thread thread1, oe_thread thread2)
     return pthread_equal(thread1, thread2);
 }
 
+int oe_thread_create(oe_thread* thread, void* (*func)(void*), void* arg)
+{
+    return pthread_create(thread, NULL, func, arg);
+}
+
+int oe_thread_join(oe_thread thread)
+{
+    return pthread_join(thread, NULL);
+}
+
 /*
 **==============================================================================
 **
@@ -9,8 +9,8 @@ oe_result_t oe_create_enclave(
     const char* enclave_path,
     oe_enclave_type_t enclave_type,
     uint32_t flags,
-    const void* config,
-    uint32_t config_size,
+    const oe_enclave_setting_t* settings,
+    uint32_t setting_count,
     const oe_ocall_func_t* ocall_table,
     uint32_t ocall_table_size,
     oe_enclave_t** enclave_out)
@@ -18,8 +18,8 @@ oe_result_t oe_create_enclave(
     OE_UNUSED(enclave_path);
     OE_UNUSED(enclave_type);
     OE_UNUSED(flags);
-    OE_UNUSED(config);
-    OE_UNUSED(config_size);
+    OE_UNUSED(settings);
+    OE_UNUSED(setting_count);
     OE_UNUSED(ocall_table);
     OE_UNUSED(ocall_table_size);
     OE_UNUSED(enclave_out);
@@ -47,8 +47,142 @@ oe_result_t oe_call_enclave_function(
     return OE_UNSUPPORTED;
 }
 
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_enclave_function(
+        enclave,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+oe_result_t oe_call_enclave_functions_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    if (!enclave || (!calls && num_calls))
+        return OE_INVALID_PARAMETER;
+
+    /* Make the calls one at a time */
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        calls[i].output_bytes_written = 0;
+        calls[i].result = oe_call_enclave_function(
+            enclave,
+            calls[i].function_id,
+            calls[i].input_buffer,
+            calls[i].input_buffer_size,
+            calls[i].output_buffer,
+            calls[i].output_buffer_size,
+            &calls[i].output_bytes_written);
+    }
+
+    return OE_OK;
+}
+
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 {
     OE_UNUSED(enclave);
     return OE_UNSUPPORTED;
 }
+
+oe_result_t oe_get_enclave_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_t* stats,
+    size_t* num_stats)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stats);
+    OE_UNUSED(num_stats);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_enable_enclave_lock_stats(oe_enclave_t* enclave, bool enable)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(enable);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_get_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    oe_lock_stats_t* stats,
+    size_t* num_stats)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stats);
+    OE_UNUSED(num_stats);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_dump_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    size_t top_n,
+    FILE* stream)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(top_n);
+    OE_UNUSED(stream);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_heap_stats_t* stats)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stats);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_dump_enclave_heap_stats(oe_enclave_t* enclave, FILE* stream)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stream);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_enable_enclave_heap_profiler(
+    oe_enclave_t* enclave,
+    uint64_t sample_interval)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(sample_interval);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_write_enclave_heap_profile(oe_enclave_t* enclave, FILE* stream)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stream);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_get_enclave_stack_usage(
+    oe_enclave_t* enclave,
+    oe_stack_usage_t* usage,
+    size_t* num_usage)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(usage);
+    OE_UNUSED(num_usage);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_dump_enclave_stack_usage(oe_enclave_t* enclave, FILE* stream)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stream);
+    return OE_UNSUPPORTED;
+}
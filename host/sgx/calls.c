@@ -27,10 +27,13 @@
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/utils.h>
 #include "../hostthread.h"
+#include "../memalign.h"
 #include "../ocalls.h"
 #include "asmdefs.h"
+#include "callstats.h"
 #include "enclave.h"
 #include "ocalls.h"
+#include "switchless.h"
 
 /*
 **==============================================================================
@@ -184,6 +187,7 @@ static oe_result_t _do_eenter(
     uint64_t arg_in,
     oe_code_t* code_out,
     uint16_t* func_out,
+    uint16_t* flags_out,
     uint16_t* result_out,
     uint64_t* arg_out)
 {
@@ -195,13 +199,16 @@ static oe_result_t _do_eenter(
     if (func_out)
         *func_out = 0;
 
+    if (flags_out)
+        *flags_out = 0;
+
     if (result_out)
         *result_out = 0;
 
     if (arg_out)
         *arg_out = 0;
 
-    if (!code_out || !func_out || !result_out || !arg_out)
+    if (!code_out || !func_out || !flags_out || !result_out || !arg_out)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     OE_TRACE_VERBOSE(
@@ -230,6 +237,7 @@ static oe_result_t _do_eenter(
 
         *code_out = oe_get_code_from_call_arg1(arg3);
         *func_out = oe_get_func_from_call_arg1(arg3);
+        *flags_out = oe_get_flags_from_call_arg1(arg3);
         *result_out = oe_get_result_from_call_arg1(arg3);
         *arg_out = arg4;
     }
@@ -283,16 +291,15 @@ done:
 /*
 **==============================================================================
 **
-** _handle_call_host_function()
+** oe_handle_call_host_function()
 **
-** Handle calls from the enclave.
+** Handle calls from the enclave. Also invoked by the host workers that carry
+** out switchless calls.
 **
 **==============================================================================
 */
 
-static oe_result_t _handle_call_host_function(
-    uint64_t arg,
-    oe_enclave_t* enclave)
+oe_result_t oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave)
 {
     oe_call_host_function_args_t* args_ptr = NULL;
     oe_result_t result = OE_OK;
@@ -382,7 +389,12 @@ static const char* oe_ocall_str(oe_func_t ocall)
                                        "SLEEP",
                                        "GET_TIME",
                                        "BACKTRACE_SYMBOLS",
-                                       "LOG"};
+                                       "LOG",
+                                       "GET_OCALL_ARENA",
+                                       "GET_DEFERRED_OCALL_QUEUE",
+                                       "THREAD_WAIT_TIMED",
+                                       "THREAD_WAKE_MULTIPLE",
+                                       "GROW_HOST_POOL"};
 
     OE_STATIC_ASSERT(OE_OCALL_BASE + OE_COUNTOF(func_names) == OE_OCALL_MAX);
 
@@ -403,7 +415,8 @@ static const char* oe_ecall_str(oe_func_t ecall)
                                        "VIRTUAL_EXCEPTION_HANDLER",
                                        "LOG_INIT",
                                        "GET_PUBLIC_KEY_BY_POLICY",
-                                       "GET_PUBLIC_KEY"};
+                                       "GET_PUBLIC_KEY",
+                                       "CALL_ENCLAVE_FUNCTIONS"};
 
     OE_STATIC_ASSERT(OE_ECALL_BASE + OE_COUNTOF(func_names) == OE_ECALL_MAX);
 
@@ -414,6 +427,176 @@ static const char* oe_ecall_str(oe_func_t ecall)
         return "UNKNOWN";
 };
 
+/*
+**==============================================================================
+**
+** _handle_get_ocall_arena()
+**
+**     Return the arena that the given enclave thread allocates OCALL buffers
+**     from, allocating it on first use. The arena lives as long as the
+**     enclave and is released by oe_terminate_enclave().
+**
+**==============================================================================
+*/
+
+static void _handle_get_ocall_arena(
+    oe_enclave_t* enclave,
+    void* tcs,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    ThreadBinding* binding =
+        oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs);
+
+    if (binding)
+    {
+        size_t index = (size_t)(binding - enclave->bindings);
+
+        /* Only the thread bound to this TCS gets here */
+        if (!enclave->ocall_arenas[index])
+            enclave->ocall_arenas[index] = malloc(arg_in);
+
+        if (arg_out)
+            *arg_out = (uint64_t)enclave->ocall_arenas[index];
+    }
+}
+
+/*
+**==============================================================================
+**
+** _handle_grow_host_pool()
+**
+**     Return a new region of host memory for the untrusted memory pool of
+**     the enclave, or null once the enclave has all the regions it may
+**     have. The regions live as long as the enclave and are released by
+**     oe_terminate_enclave().
+**
+**==============================================================================
+*/
+
+static void _handle_grow_host_pool(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    void* region = NULL;
+
+    if (arg_in != OE_HOST_POOL_REGION_SIZE)
+        return;
+
+    oe_mutex_lock(&enclave->lock);
+
+    if (enclave->num_host_pool_regions < OE_HOST_POOL_MAX_REGIONS &&
+        (region = oe_memalign(OE_PAGE_SIZE, OE_HOST_POOL_REGION_SIZE)))
+    {
+        enclave->host_pool_regions[enclave->num_host_pool_regions++] = region;
+    }
+
+    oe_mutex_unlock(&enclave->lock);
+
+    if (arg_out)
+        *arg_out = (uint64_t)region;
+}
+
+/*
+**==============================================================================
+**
+** _handle_get_deferred_ocall_queue()
+**
+**     Return the queue that the given enclave thread appends deferred OCALLs
+**     to, allocating it on first use. Since the queue is drained whenever
+**     the thread exits the enclave, the enclave also makes this OCALL to
+**     drain a full queue. The queue lives as long as the enclave and is
+**     released by oe_terminate_enclave().
+**
+**==============================================================================
+*/
+
+static void _handle_get_deferred_ocall_queue(
+    oe_enclave_t* enclave,
+    void* tcs,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    ThreadBinding* binding =
+        oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs);
+
+    if (binding && arg_in == OE_DEFERRED_OCALL_QUEUE_SIZE)
+    {
+        size_t index = (size_t)(binding - enclave->bindings);
+
+        /* Only the thread bound to this TCS gets here */
+        if (!enclave->deferred_ocall_queues[index])
+            enclave->deferred_ocall_queues[index] = calloc(1, arg_in);
+
+        if (arg_out)
+            *arg_out = (uint64_t)enclave->deferred_ocall_queues[index];
+    }
+}
+
+static oe_result_t _handle_ocall(
+    oe_enclave_t* enclave,
+    void* tcs,
+    uint16_t func,
+    uint64_t arg_in,
+    uint64_t* arg_out);
+
+/*
+**==============================================================================
+**
+** _handle_deferred_ocalls()
+**
+**     Carry out the OCALLs queued by the given enclave thread since it last
+**     exited the enclave, in order. Only the OCALLs that return nothing to
+**     the enclave may be deferred.
+**
+**==============================================================================
+*/
+
+static void _handle_deferred_ocalls(oe_enclave_t* enclave, void* tcs)
+{
+    ThreadBinding* binding =
+        oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs);
+    oe_deferred_ocall_queue_t* queue;
+    uint64_t offset = sizeof(*queue);
+
+    if (!binding)
+        return;
+
+    queue = (oe_deferred_ocall_queue_t*)
+        enclave->deferred_ocall_queues[binding - enclave->bindings];
+
+    if (!queue || queue->size > OE_DEFERRED_OCALL_QUEUE_SIZE)
+        return;
+
+    for (uint64_t i = 0; i < queue->num_calls; i++)
+    {
+        oe_deferred_ocall_t* call =
+            (oe_deferred_ocall_t*)((uint8_t*)queue + offset);
+
+        if (queue->size - offset < sizeof(*call) ||
+            call->size < sizeof(*call) || call->size > queue->size - offset)
+            break;
+
+        switch (call->func)
+        {
+            case OE_OCALL_CALL_HOST_FUNCTION:
+            case OE_OCALL_FREE:
+                _handle_ocall(
+                    enclave, tcs, (uint16_t)call->func, call->arg_in, NULL);
+                break;
+
+            default:
+                break;
+        }
+
+        offset += call->size;
+    }
+
+    queue->num_calls = 0;
+    queue->size = sizeof(*queue);
+}
+
 /*
 **==============================================================================
 **
@@ -432,10 +615,23 @@ static oe_result_t _handle_ocall(
     uint64_t* arg_out)
 {
     oe_result_t result = OE_UNEXPECTED;
+    const uint64_t start = oe_call_stats_ticks();
+    uint64_t table_id = OE_CALL_STATS_RUNTIME_TABLE_ID;
+    uint64_t function_id = func;
 
     if (!enclave || !tcs)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Count EDL OCALLs under the function they call */
+    if (func == OE_OCALL_CALL_HOST_FUNCTION && arg_in)
+    {
+        const oe_call_host_function_args_t* args =
+            (const oe_call_host_function_args_t*)arg_in;
+
+        table_id = args->table_id;
+        function_id = args->function_id;
+    }
+
     if (arg_out)
         *arg_out = 0;
 
@@ -450,7 +646,12 @@ static oe_result_t _handle_ocall(
     switch ((oe_func_t)func)
     {
         case OE_OCALL_CALL_HOST_FUNCTION:
-            _handle_call_host_function(arg_in, enclave);
+            /* The enclave falls back to ordinary OCALLs when no host worker
+             * is polling for switchless calls: wake them up */
+            if (enclave->switchless_manager)
+                oe_wake_switchless_host_workers(enclave->switchless_manager);
+
+            oe_handle_call_host_function(arg_in, enclave);
             break;
 
         case OE_OCALL_MALLOC:
@@ -470,7 +671,7 @@ static oe_result_t _handle_ocall(
             break;
 
         case OE_OCALL_THREAD_WAIT:
-            HandleThreadWait(enclave, arg_in);
+            HandleThreadWait(enclave, arg_in, arg_out);
             break;
 
         case OE_OCALL_THREAD_WAKE:
@@ -478,7 +679,15 @@ static oe_result_t _handle_ocall(
             break;
 
         case OE_OCALL_THREAD_WAKE_WAIT:
-            HandleThreadWakeWait(enclave, arg_in);
+            HandleThreadWakeWait(enclave, arg_in, arg_out);
+            break;
+
+        case OE_OCALL_THREAD_WAIT_TIMED:
+            HandleThreadWaitTimed(enclave, tcs, arg_in);
+            break;
+
+        case OE_OCALL_THREAD_WAKE_MULTIPLE:
+            HandleThreadWakeMultiple(enclave, arg_in);
             break;
 
         case OE_OCALL_GET_QUOTE:
@@ -515,6 +724,18 @@ static oe_result_t _handle_ocall(
             oe_handle_log(enclave, arg_in);
             break;
 
+        case OE_OCALL_GET_OCALL_ARENA:
+            _handle_get_ocall_arena(enclave, tcs, arg_in, arg_out);
+            break;
+
+        case OE_OCALL_GET_DEFERRED_OCALL_QUEUE:
+            _handle_get_deferred_ocall_queue(enclave, tcs, arg_in, arg_out);
+            break;
+
+        case OE_OCALL_GROW_HOST_POOL:
+            _handle_grow_host_pool(enclave, arg_in, arg_out);
+            break;
+
         default:
         {
             /* No function found with the number */
@@ -526,6 +747,17 @@ static oe_result_t _handle_ocall(
 
 done:
 
+    if (enclave && tcs)
+    {
+        oe_record_call(
+            enclave,
+            oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs),
+            OE_CALL_TYPE_OCALL,
+            table_id,
+            function_id,
+            start);
+    }
+
     return result;
 }
 
@@ -582,14 +814,7 @@ int __oe_dispatch_ocall(
              * is what we are trying to do. So loop through the bindings
              * to figure out the correct one for the given tcs.
              */
-            for (size_t i = 0; i < OE_COUNTOF(enclave->bindings); ++i)
-            {
-                if (enclave->bindings[i].tcs == (uint64_t)tcs)
-                {
-                    binding = &enclave->bindings[i];
-                    break;
-                }
-            }
+            binding = oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs);
             /**In SGX-LKL-OE, new memory is allocated for TLS,
              * and the fsbase is updated accordingly in
              * simulation mode. During ocalls, this new fsbase
@@ -614,6 +839,10 @@ int __oe_dispatch_ocall(
             binding = GetThreadBinding();
         }
 
+        /* Carry out the calls deferred until this exit first */
+        if (oe_get_flags_from_call_arg1(arg1) & OE_CALL_FLAG_DEFERRED_OCALLS)
+            _handle_deferred_ocalls(enclave, tcs);
+
         oe_result_t result = _handle_ocall(enclave, tcs, func, arg, &arg_out);
         *arg1_out = oe_make_call_arg1(OE_CODE_ORET, func, 0, result);
         *arg2_out = arg_out;
@@ -644,9 +873,12 @@ int __oe_dispatch_ocall(
 **         - the calling host thread
 **         - an enclave thread context
 **
-**     If such a binding already exists, the binding's count in incremented.
-**     Else, the calling host thread is bound to the first available enclave
-**     thread context.
+**     If the calling thread is already bound to a thread context of this
+**     enclave (a nested call made while handling an OCALL, possibly one of
+**     another enclave that this enclave called), the binding's count is
+**     incremented. Else, the calling host thread is bound to a free
+**     enclave thread context, waiting for one to be released if the enclave
+**     was created with a TCS wait timeout.
 **
 **     Returns the address of the thread control structure (TCS) corresponding
 **     to the enclave thread context.
@@ -656,50 +888,44 @@ int __oe_dispatch_ocall(
 
 static void* _assign_tcs(oe_enclave_t* enclave)
 {
-    void* tcs = NULL;
-    size_t i;
     oe_thread thread = oe_thread_self();
+    ThreadBinding* outer = GetThreadBinding();
+    ThreadBinding* binding;
 
-    oe_mutex_lock(&enclave->lock);
+    /* The bindings of the calling thread are chained from its TSD, through
+     * those of the enclaves whose OCALLs it is handling: reuse the one of
+     * this enclave if any, as a thread cannot hold two of its TCSs */
+    for (binding = outer; binding; binding = binding->outer)
     {
-        /* First attempt to find a busy td_t owned by this thread */
-        for (i = 0; i < enclave->num_bindings; i++)
+        if (binding >= enclave->bindings &&
+            binding < enclave->bindings + enclave->num_bindings &&
+            (binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
+            binding->count++;
 
-            if ((binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
-            {
-                binding->count++;
-                tcs = (void*)binding->tcs;
-                break;
-            }
-        }
+            /* The OCALL being handled restores the TSD on return */
+            if (binding != outer)
+                _set_thread_binding(binding);
 
-        /* If binding not found above, look for an available ThreadBinding */
-        if (!tcs)
-        {
-            for (i = 0; i < enclave->num_bindings; i++)
-            {
-                ThreadBinding* binding = &enclave->bindings[i];
-
-                if (!(binding->flags & _OE_THREAD_BUSY))
-                {
-                    binding->flags |= _OE_THREAD_BUSY;
-                    binding->thread = thread;
-                    binding->count = 1;
-                    tcs = (void*)binding->tcs;
-
-                    /* Set into TSD so asynchronous exceptions can get it */
-                    _set_thread_binding(binding);
-                    assert(GetThreadBinding() == binding);
-                    break;
-                }
-            }
+            return (void*)binding->tcs;
         }
     }
-    oe_mutex_unlock(&enclave->lock);
 
-    return tcs;
+    if (!(binding = oe_acquire_thread_binding(enclave)))
+        return NULL;
+
+    binding->flags |= _OE_THREAD_BUSY;
+    binding->thread = thread;
+    binding->count = 1;
+
+    /* Restored into TSD when the binding is released */
+    binding->outer = outer;
+
+    /* Set into TSD so asynchronous exceptions can get it */
+    _set_thread_binding(binding);
+    assert(GetThreadBinding() == binding);
+
+    return (void*)binding->tcs;
 }
 
 /*
@@ -715,32 +941,48 @@ static void* _assign_tcs(oe_enclave_t* enclave)
 
 static void _release_tcs(oe_enclave_t* enclave, void* tcs)
 {
-    size_t i;
+    ThreadBinding* binding =
+        oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs);
 
-    oe_mutex_lock(&enclave->lock);
+    if (!binding || !(binding->flags & _OE_THREAD_BUSY))
+        return;
+
+    if (--binding->count == 0)
     {
-        for (i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
-
-            if ((binding->flags & _OE_THREAD_BUSY) &&
-                (void*)binding->tcs == tcs)
-            {
-                binding->count--;
-
-                if (binding->count == 0)
-                {
-                    binding->flags &= (~_OE_THREAD_BUSY);
-                    binding->thread = 0;
-                    memset(&binding->event, 0, sizeof(binding->event));
-                    _set_thread_binding(NULL);
-                    assert(GetThreadBinding() == NULL);
-                }
-                break;
-            }
-        }
+        ThreadBinding* outer = binding->outer;
+
+        binding->flags &= (~_OE_THREAD_BUSY);
+        binding->thread = 0;
+        binding->outer = NULL;
+        memset(&binding->event, 0, sizeof(binding->event));
+        _set_thread_binding(outer);
+        assert(GetThreadBinding() == outer);
+
+        oe_release_thread_binding(enclave, binding);
     }
-    oe_mutex_unlock(&enclave->lock);
+}
+
+/*
+**==============================================================================
+**
+** oe_bind_thread()
+** oe_unbind_thread()
+**
+**     Bind the calling thread to a TCS until it unbinds itself, rather than
+**     for the duration of one ECALL. The ECALLs of the thread nest in this
+**     binding, so the TCS stays reserved for the thread between them.
+**
+**==============================================================================
+*/
+
+void* oe_bind_thread(oe_enclave_t* enclave)
+{
+    return _assign_tcs(enclave);
+}
+
+void oe_unbind_thread(oe_enclave_t* enclave, void* tcs)
+{
+    _release_tcs(enclave, tcs);
 }
 
 /*
@@ -764,12 +1006,26 @@ oe_result_t oe_ecall(
     oe_code_t code = OE_CODE_ECALL;
     oe_code_t code_out = 0;
     uint16_t func_out = 0;
+    uint16_t flags_out = 0;
     uint16_t result_out = 0;
     uint64_t arg_out = 0;
+    uint64_t start = 0;
+    uint64_t table_id = OE_CALL_STATS_RUNTIME_TABLE_ID;
+    uint64_t function_id = func;
 
     if (!enclave)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Count EDL ECALLs under the function they call */
+    if (func == OE_ECALL_CALL_ENCLAVE_FUNCTION && arg)
+    {
+        const oe_call_enclave_function_args_t* args =
+            (const oe_call_enclave_function_args_t*)arg;
+
+        table_id = args->table_id;
+        function_id = args->function_id;
+    }
+
     /* Assign a td_t for this operation */
     if (!(tcs = _assign_tcs(enclave)))
         OE_RAISE(OE_OUT_OF_THREADS);
@@ -779,10 +1035,14 @@ oe_result_t oe_ecall(
         "%s 0x%x %s: %s\n",
         enclave->path,
         enclave->addr,
-        func == OE_ECALL_CALL_ENCLAVE_FUNCTION ? "EDL_ECALL" : "OE_ECALL",
+        func == OE_ECALL_CALL_ENCLAVE_FUNCTION ||
+                func == OE_ECALL_CALL_ENCLAVE_FUNCTIONS
+            ? "EDL_ECALL"
+            : "OE_ECALL",
         oe_ecall_str(func));
 
     /* Perform ECALL or ORET */
+    start = oe_call_stats_ticks();
     OE_CHECK(_do_eenter(
         enclave,
         tcs,
@@ -792,9 +1052,22 @@ oe_result_t oe_ecall(
         arg,
         &code_out,
         &func_out,
+        &flags_out,
         &result_out,
         &arg_out));
 
+    /* Carry out the calls deferred until the ERET before releasing the TCS */
+    if (flags_out & OE_CALL_FLAG_DEFERRED_OCALLS)
+        _handle_deferred_ocalls(enclave, tcs);
+
+    oe_record_call(
+        enclave,
+        oe_get_thread_binding_by_tcs(enclave, (uint64_t)tcs),
+        OE_CALL_TYPE_ECALL,
+        table_id,
+        function_id,
+        start);
+
     /* Process OCALLS */
     if (code_out != OE_CODE_ERET)
         OE_RAISE(OE_UNEXPECTED);
@@ -835,10 +1108,12 @@ oe_result_t oe_call_enclave_function_by_table_id(
     size_t input_buffer_size,
     void* output_buffer,
     size_t output_buffer_size,
-    size_t* output_bytes_written)
+    size_t* output_bytes_written,
+    bool switchless)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_enclave_function_args_t args;
+    oe_result_t dispatch_result = OE_UNEXPECTED;
 
     /* Reject invalid parameters */
     if (!enclave)
@@ -856,8 +1131,16 @@ oe_result_t oe_call_enclave_function_by_table_id(
         args.result = OE_UNEXPECTED;
     }
 
-    /* Perform the ECALL */
+    /* Have an enclave worker carry out switchless calls if possible */
+    if (switchless && enclave->switchless_manager &&
+        oe_post_switchless_ecall(
+            enclave->switchless_manager, &args, &dispatch_result))
     {
+        OE_CHECK(dispatch_result);
+    }
+    else
+    {
+        /* Perform the ECALL */
         uint64_t arg_out = 0;
 
         OE_CHECK(oe_ecall(
@@ -906,7 +1189,133 @@ oe_result_t oe_call_enclave_function(
         input_buffer_size,
         output_buffer,
         output_buffer_size,
-        output_bytes_written);
+        output_bytes_written,
+        false);
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_enclave_function()
+**
+** Call the enclave function specified by the given function-id in the default
+** function table using an enclave worker thread if one is available.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_enclave_function_by_table_id(
+        enclave,
+        OE_UINT64_MAX,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written,
+        true);
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions_batch_by_table_id()
+**
+** Call the enclave functions specified by the given table-id and calls within
+** a single ECALL.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_functions_batch_by_table_id(
+    oe_enclave_t* enclave,
+    uint64_t table_id,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_functions_args_t args;
+    oe_call_enclave_function_args_t* call_args = NULL;
+    uint64_t arg_out = 0;
+
+    /* Reject invalid parameters */
+    if (!enclave || (!calls && num_calls))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (num_calls == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    if (!(call_args = (oe_call_enclave_function_args_t*)calloc(
+              num_calls, sizeof(oe_call_enclave_function_args_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Initialize the call_enclave_args structure of each call */
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        call_args[i].table_id = table_id;
+        call_args[i].function_id = calls[i].function_id;
+        call_args[i].input_buffer = calls[i].input_buffer;
+        call_args[i].input_buffer_size = calls[i].input_buffer_size;
+        call_args[i].output_buffer = calls[i].output_buffer;
+        call_args[i].output_buffer_size = calls[i].output_buffer_size;
+        call_args[i].output_bytes_written = 0;
+        call_args[i].result = OE_UNEXPECTED;
+    }
+
+    args.calls = call_args;
+    args.num_calls = num_calls;
+
+    /* Perform the ECALL */
+    OE_CHECK(oe_ecall(
+        enclave, OE_ECALL_CALL_ENCLAVE_FUNCTIONS, (uint64_t)&args, &arg_out));
+    OE_CHECK((oe_result_t)arg_out);
+
+    /* Report the result of each call */
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        calls[i].result = call_args[i].result;
+        calls[i].output_bytes_written =
+            call_args[i].result == OE_OK ? call_args[i].output_bytes_written
+                                         : 0;
+    }
+
+    result = OE_OK;
+
+done:
+    free(call_args);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions_batch()
+**
+** Call the enclave functions specified by the given calls in the default
+** function table within a single ECALL.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_functions_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    return oe_call_enclave_functions_batch_by_table_id(
+        enclave, OE_UINT64_MAX, calls, num_calls);
 }
 
 /*
@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "callstats.h"
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../dupenv.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*
+**==============================================================================
+**
+** Call statistics:
+**
+**     Each binding has its own table of statistics, updated without
+**     synchronization by the host thread bound to it (a binding is used by
+**     one thread at a time). The table is an open-addressing hash table of
+**     the functions called through the binding. Latencies are kept in time
+**     stamp counter ticks and converted into nanoseconds when the tables
+**     are read, using the rate of the counter since the enclave was created.
+**
+**     Reading the statistics while calls are made may miss the calls in
+**     progress, which is acceptable for statistics.
+**
+**==============================================================================
+*/
+
+#define CALL_STATS_TABLE_SIZE 128
+
+struct _oe_call_stats_table
+{
+    /* Latencies are in ticks; an entry is free while its type is zero */
+    oe_call_stats_t entries[CALL_STATS_TABLE_SIZE];
+
+    /* Calls not counted because the table is full */
+    uint64_t dropped;
+};
+
+/* Returns the number of nanoseconds elapsed since some fixed point */
+static uint64_t _now_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint64_t)(
+        (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Returns the index of the most significant bit set in x (x != 0) */
+OE_INLINE uint32_t _log2(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return (uint32_t)index;
+#else
+    return 63 - (uint32_t)__builtin_clzll(x);
+#endif
+}
+
+OE_INLINE size_t _hash(
+    oe_call_type_t type,
+    uint64_t table_id,
+    uint64_t function_id)
+{
+    uint64_t h = (function_id * 0x9e3779b97f4a7c15) ^ (table_id << 8) ^ type;
+
+    return (size_t)(h ^ (h >> 32)) % CALL_STATS_TABLE_SIZE;
+}
+
+void oe_start_call_stats(oe_enclave_t* enclave)
+{
+    enclave->call_stats_start_ticks = oe_call_stats_ticks();
+    enclave->call_stats_start_ns = _now_ns();
+}
+
+void oe_record_call(
+    oe_enclave_t* enclave,
+    ThreadBinding* binding,
+    oe_call_type_t type,
+    uint64_t table_id,
+    uint64_t function_id,
+    uint64_t start)
+{
+    const uint64_t ticks = oe_call_stats_ticks() - start;
+    size_t index;
+    oe_call_stats_table_t* table;
+    size_t slot;
+
+    if (!binding || !enclave->call_stats)
+        return;
+
+    index = (size_t)(binding - enclave->bindings);
+
+    if (!(table = enclave->call_stats[index]))
+    {
+        if (!(table = (oe_call_stats_table_t*)calloc(1, sizeof(*table))))
+            return;
+
+        enclave->call_stats[index] = table;
+    }
+
+    slot = _hash(type, table_id, function_id);
+
+    for (size_t i = 0; i < CALL_STATS_TABLE_SIZE; i++)
+    {
+        oe_call_stats_t* entry = &table->entries[slot];
+
+        if (entry->type == 0)
+        {
+            entry->table_id = table_id;
+            entry->function_id = function_id;
+            entry->min_ns = OE_UINT64_MAX;
+            entry->type = type;
+        }
+
+        if (entry->type == type && entry->table_id == table_id &&
+            entry->function_id == function_id)
+        {
+            uint32_t bucket = ticks ? _log2(ticks) : 0;
+
+            if (bucket >= OE_CALL_STATS_HISTOGRAM_SIZE)
+                bucket = OE_CALL_STATS_HISTOGRAM_SIZE - 1;
+
+            entry->count++;
+            entry->total_ns += ticks;
+
+            if (ticks < entry->min_ns)
+                entry->min_ns = ticks;
+
+            if (ticks > entry->max_ns)
+                entry->max_ns = ticks;
+
+            entry->histogram[bucket]++;
+            return;
+        }
+
+        slot = (slot + 1) % CALL_STATS_TABLE_SIZE;
+    }
+
+    table->dropped++;
+}
+
+/*
+**==============================================================================
+**
+** _collect_call_stats()
+**
+**     Merge the tables of all bindings into a newly allocated array, in
+**     nanoseconds, sorted by decreasing total latency.
+**
+**==============================================================================
+*/
+
+static void _merge(oe_call_stats_t* to, const oe_call_stats_t* from)
+{
+    to->count += from->count;
+    to->total_ns += from->total_ns;
+
+    if (from->min_ns < to->min_ns)
+        to->min_ns = from->min_ns;
+
+    if (from->max_ns > to->max_ns)
+        to->max_ns = from->max_ns;
+
+    for (size_t i = 0; i < OE_CALL_STATS_HISTOGRAM_SIZE; i++)
+        to->histogram[i] += from->histogram[i];
+}
+
+static void _ticks_to_ns(oe_call_stats_t* stats, double ns_per_tick)
+{
+    uint64_t histogram[OE_CALL_STATS_HISTOGRAM_SIZE] = {0};
+    int shift = 0;
+
+    /* shift = floor(log2(ns_per_tick)) */
+    for (double x = ns_per_tick; x >= 2.0 && shift < 64; x /= 2.0)
+        shift++;
+
+    for (double x = ns_per_tick; x < 1.0 && shift > -64; x *= 2.0)
+        shift--;
+
+    stats->total_ns = (uint64_t)((double)stats->total_ns * ns_per_tick);
+    stats->min_ns = (uint64_t)((double)stats->min_ns * ns_per_tick);
+    stats->max_ns = (uint64_t)((double)stats->max_ns * ns_per_tick);
+
+    /* Move each bucket to the one of its lower bound in nanoseconds */
+    for (int i = 0; i < OE_CALL_STATS_HISTOGRAM_SIZE; i++)
+    {
+        int bucket = i + shift;
+
+        if (bucket < 0)
+            bucket = 0;
+        else if (bucket >= OE_CALL_STATS_HISTOGRAM_SIZE)
+            bucket = OE_CALL_STATS_HISTOGRAM_SIZE - 1;
+
+        histogram[bucket] += stats->histogram[i];
+    }
+
+    memcpy(stats->histogram, histogram, sizeof(histogram));
+}
+
+static int _compare_total(const void* a, const void* b)
+{
+    const oe_call_stats_t* x = (const oe_call_stats_t*)a;
+    const oe_call_stats_t* y = (const oe_call_stats_t*)b;
+
+    if (x->total_ns != y->total_ns)
+        return x->total_ns > y->total_ns ? -1 : 1;
+
+    return 0;
+}
+
+static oe_result_t _collect_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_t** stats_out,
+    size_t* num_stats_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_stats_t* stats = NULL;
+    size_t num_stats = 0;
+    size_t capacity = 0;
+    uint64_t elapsed_ticks;
+    double ns_per_tick = 1.0;
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        const oe_call_stats_table_t* table = enclave->call_stats[i];
+
+        if (!table)
+            continue;
+
+        for (size_t j = 0; j < CALL_STATS_TABLE_SIZE; j++)
+        {
+            const oe_call_stats_t* entry = &table->entries[j];
+            size_t k;
+
+            if (entry->type == 0 || entry->count == 0)
+                continue;
+
+            for (k = 0; k < num_stats; k++)
+            {
+                if (stats[k].type == entry->type &&
+                    stats[k].table_id == entry->table_id &&
+                    stats[k].function_id == entry->function_id)
+                    break;
+            }
+
+            if (k == num_stats)
+            {
+                if (num_stats == capacity)
+                {
+                    size_t new_capacity = capacity ? capacity * 2 : 64;
+                    oe_call_stats_t* p = (oe_call_stats_t*)realloc(
+                        stats, new_capacity * sizeof(*stats));
+
+                    if (!p)
+                        OE_RAISE(OE_OUT_OF_MEMORY);
+
+                    stats = p;
+                    capacity = new_capacity;
+                }
+
+                memcpy(&stats[num_stats++], entry, sizeof(*entry));
+                continue;
+            }
+
+            _merge(&stats[k], entry);
+        }
+    }
+
+    /* Measure the rate of the time stamp counter since the enclave was
+     * created */
+    elapsed_ticks = oe_call_stats_ticks() - enclave->call_stats_start_ticks;
+
+    if (elapsed_ticks)
+    {
+        ns_per_tick = (double)(_now_ns() - enclave->call_stats_start_ns) /
+                      (double)elapsed_ticks;
+    }
+
+    if (ns_per_tick <= 0)
+        ns_per_tick = 1.0;
+
+    for (size_t i = 0; i < num_stats; i++)
+        _ticks_to_ns(&stats[i], ns_per_tick);
+
+    if (num_stats)
+        qsort(stats, num_stats, sizeof(*stats), _compare_total);
+
+    *stats_out = stats;
+    *num_stats_out = num_stats;
+    stats = NULL;
+    result = OE_OK;
+
+done:
+    free(stats);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_enclave_call_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_enclave_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_t* stats,
+    size_t* num_stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_stats_t* all = NULL;
+    size_t num_all = 0;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !num_stats ||
+        (!stats && *num_stats))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_collect_call_stats(enclave, &all, &num_all));
+
+    if (*num_stats < num_all)
+    {
+        *num_stats = num_all;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    if (num_all)
+        memcpy(stats, all, num_all * sizeof(*all));
+
+    *num_stats = num_all;
+    result = OE_OK;
+
+done:
+    free(all);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_dump_call_stats()
+**
+**==============================================================================
+*/
+
+static const char* _table_name(uint64_t table_id)
+{
+    switch (table_id)
+    {
+        case OE_UINT64_MAX:
+            return "edl";
+        case OE_INTERNAL_OCALL_FUNCTION_TABLE_ID:
+            return "internal";
+        case OE_SYSCALL_OCALL_FUNCTION_TABLE_ID:
+            return "syscall";
+        case OE_CALL_STATS_RUNTIME_TABLE_ID:
+            return "runtime";
+        default:
+            return "other";
+    }
+}
+
+void oe_dump_call_stats(oe_enclave_t* enclave)
+{
+    char* env = oe_dupenv("OE_CALL_STATS");
+    oe_call_stats_t* stats = NULL;
+    size_t num_stats = 0;
+    uint64_t dropped = 0;
+
+    if (!env || !*env || strcmp(env, "0") == 0)
+        goto done;
+
+    if (_collect_call_stats(enclave, &stats, &num_stats) != OE_OK)
+        goto done;
+
+    fprintf(stderr, "=== call statistics of %s\n", enclave->path);
+    fprintf(
+        stderr,
+        "%-5s %-8s %8s %10s %14s %10s %10s %10s\n",
+        "type",
+        "table",
+        "function",
+        "count",
+        "total(ns)",
+        "avg(ns)",
+        "min(ns)",
+        "max(ns)");
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        const oe_call_stats_t* s = &stats[i];
+
+        fprintf(
+            stderr,
+            "%-5s %-8s %8llu %10llu %14llu %10llu %10llu %10llu\n",
+            s->type == OE_CALL_TYPE_ECALL ? "ECALL" : "OCALL",
+            _table_name(s->table_id),
+            OE_LLU(s->function_id),
+            OE_LLU(s->count),
+            OE_LLU(s->total_ns),
+            OE_LLU(s->total_ns / s->count),
+            OE_LLU(s->min_ns),
+            OE_LLU(s->max_ns));
+    }
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        if (enclave->call_stats[i])
+            dropped += enclave->call_stats[i]->dropped;
+    }
+
+    if (dropped)
+        fprintf(stderr, "(%llu calls not counted)\n", OE_LLU(dropped));
+
+done:
+    free(stats);
+    free(env);
+}
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_CALLSTATS_H
+#define _OE_HOST_CALLSTATS_H
+
+#include <openenclave/host.h>
+#include "enclave.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+/* Calls are timed with the time stamp counter, which is converted into
+ * nanoseconds only when the statistics are read */
+OE_INLINE uint64_t oe_call_stats_ticks(void)
+{
+    return __rdtsc();
+}
+
+/* Start counting the calls of the enclave */
+void oe_start_call_stats(oe_enclave_t* enclave);
+
+/* Count a call that started at the given tick, made by the thread bound to
+ * binding. Only that thread updates the statistics of the binding */
+void oe_record_call(
+    oe_enclave_t* enclave,
+    ThreadBinding* binding,
+    oe_call_type_t type,
+    uint64_t table_id,
+    uint64_t function_id,
+    uint64_t start);
+
+/* Write the statistics to the standard error if OE_CALL_STATS is set */
+void oe_dump_call_stats(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_CALLSTATS_H */
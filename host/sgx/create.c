@@ -48,11 +48,15 @@ static char* get_fullpath(const char* path)
 #include <openenclave/internal/utils.h>
 #include <string.h>
 #include "../memalign.h"
+#include "callstats.h"
 #include "cpuid.h"
 #include "enclave.h"
+#include "envreports.h"
 #include "exception.h"
 #include "internal_u.h"
 #include "sgxload.h"
+#include "switchless.h"
+#include "threadpool.h"
 
 static oe_once_type _enclave_init_once;
 
@@ -131,7 +135,7 @@ static oe_result_t _add_stack_pages(
 {
     const bool extend = true;
     return _add_filled_pages(
-        context, enclave_addr, vaddr, npages, 0xcccccccc, extend);
+        context, enclave_addr, vaddr, npages, OE_SGX_STACK_FILL, extend);
 }
 
 static oe_result_t _add_heap_pages(
@@ -170,9 +174,11 @@ static oe_result_t _add_control_pages(
 
     /* Save the address of new TCS page into enclave object */
     {
-        if (enclave->num_bindings == OE_SGX_MAX_TCS)
+        if (enclave->num_bindings == enclave->max_bindings)
             OE_RAISE_MSG(
-                OE_FAILURE, "OE_SGX_MAX_TCS (%d) hit\n", OE_SGX_MAX_TCS);
+                OE_FAILURE,
+                "more TCSs than bindings (%zu)\n",
+                enclave->max_bindings);
 
         enclave->bindings[enclave->num_bindings++].tcs = enclave_addr + *vaddr;
     }
@@ -310,6 +316,8 @@ static oe_result_t _add_data_pages(
     OE_CHECK(_add_heap_pages(
         context, enclave->addr, vaddr, size_settings->num_heap_pages));
 
+    enclave->stack_size = size_settings->num_stack_pages * OE_PAGE_SIZE;
+
     for (i = 0; i < size_settings->num_tcs; i++)
     {
         /* Add guard page */
@@ -526,6 +534,10 @@ oe_result_t oe_sgx_build_enclave(
     /* Validate the enclave prop_override structure */
     OE_CHECK(oe_sgx_validate_enclave_properties(&props, NULL));
 
+    /* Allocate a thread binding for each TCS */
+    OE_CHECK(oe_allocate_thread_bindings(
+        enclave, props.header.size_settings.num_tcs));
+
     /* Consolidate enclave-debug-flag with create-debug-flag */
     if (props.config.attributes & OE_SGX_FLAGS_DEBUG)
     {
@@ -621,8 +633,8 @@ oe_result_t oe_create_enclave(
     const char* enclave_path,
     oe_enclave_type_t enclave_type,
     uint32_t flags,
-    const void* config,
-    uint32_t config_size,
+    const oe_enclave_setting_t* settings,
+    uint32_t setting_count,
     const oe_ocall_func_t* ocall_table,
     uint32_t ocall_table_size,
     oe_enclave_t** enclave_out)
@@ -630,6 +642,11 @@ oe_result_t oe_create_enclave(
     oe_result_t result = OE_UNEXPECTED;
     oe_enclave_t* enclave = NULL;
     oe_sgx_load_context_t context;
+    size_t num_host_workers = 0;
+    size_t num_enclave_workers = 0;
+    uint32_t tcs_wait_timeout = 0;
+    size_t num_pool_threads = 0;
+    bool pushed = false;
 
     _initialize_enclave_host();
 
@@ -640,9 +657,56 @@ oe_result_t oe_create_enclave(
     if (!enclave_path || !enclave_out ||
         ((enclave_type != OE_ENCLAVE_TYPE_SGX) &&
          (enclave_type != OE_ENCLAVE_TYPE_AUTO)) ||
-        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
+        (flags & OE_ENCLAVE_FLAG_RESERVED) || (!settings && setting_count > 0))
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Check the enclave settings */
+    for (uint32_t i = 0; i < setting_count; i++)
+    {
+        switch (settings[i].setting_type)
+        {
+            case OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS:
+            {
+                const oe_enclave_setting_context_switchless_t* setting =
+                    settings[i].u.context_switchless_setting;
+
+                if (!setting)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                num_host_workers = setting->max_host_workers;
+                num_enclave_workers = setting->max_enclave_workers;
+                break;
+            }
+            case OE_ENCLAVE_SETTING_TCS_WAIT:
+            {
+                const oe_enclave_setting_tcs_wait_t* setting =
+                    settings[i].u.tcs_wait_setting;
+
+                if (!setting)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                tcs_wait_timeout = setting->timeout_ms;
+                break;
+            }
+            case OE_ENCLAVE_SETTING_THREAD_POOL:
+            {
+                const oe_enclave_setting_thread_pool_t* setting =
+                    settings[i].u.thread_pool_setting;
+
+                if (!setting)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                num_pool_threads = setting->max_threads;
+                break;
+            }
+            default:
+                OE_RAISE_MSG(
+                    OE_INVALID_PARAMETER,
+                    "unknown enclave setting: 0x%x",
+                    settings[i].setting_type);
+        }
+    }
+
     /* Allocate and zero-fill the enclave structure */
     if (!(enclave = (oe_enclave_t*)calloc(1, sizeof(oe_enclave_t))))
         OE_RAISE(OE_OUT_OF_MEMORY);
@@ -651,10 +715,30 @@ oe_result_t oe_create_enclave(
     /* Disable simulation mode on windows */
     if (flags & OE_ENCLAVE_FLAG_SIMULATE)
         OE_RAISE(OE_INVALID_PARAMETER);
+#endif
+
+    /* Initialize the context parameter and any driver handles */
+    OE_CHECK(oe_sgx_initialize_load_context(
+        &context, OE_SGX_LOAD_TYPE_CREATE, flags));
+
+    /* Build the enclave */
+    OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
 
-    /* Create Windows events for each TCS binding. Enclaves use
-     * this event when calling into the host to handle waits/wakes
-     * as part of the enclave mutex and condition variable
+    /* The pool threads and the enclave workers each hold a TCS for the
+     * lifetime of the enclave. Leave at least one TCS for ordinary ECALLs. */
+    if (num_pool_threads + num_enclave_workers >= enclave->num_bindings)
+        OE_RAISE_MSG(
+            OE_INVALID_PARAMETER,
+            "%zu pool threads and %zu enclave workers need more than %zu TCS",
+            num_pool_threads,
+            num_enclave_workers,
+            enclave->num_bindings);
+
+#if defined(_WIN32)
+
+    /* Create Windows events for each TCS binding (allocated by the build
+     * above). Enclaves use this event when calling into the host to handle
+     * waits/wakes as part of the enclave mutex and condition variable
      * implementation.
      */
     for (size_t i = 0; i < enclave->num_bindings; i++)
@@ -674,12 +758,11 @@ oe_result_t oe_create_enclave(
 
 #endif
 
-    /* Initialize the context parameter and any driver handles */
-    OE_CHECK(oe_sgx_initialize_load_context(
-        &context, OE_SGX_LOAD_TYPE_CREATE, flags));
+    /* Make the TCSs available to ECALLs */
+    OE_CHECK(oe_initialize_thread_bindings(enclave, tcs_wait_timeout));
 
-    /* Build the enclave */
-    OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
+    /* Count the calls of the enclave from here on */
+    oe_start_call_stats(enclave);
 
     /* Push the new created enclave to the global list. */
     if (oe_push_enclave_instance(enclave) != 0)
@@ -687,6 +770,8 @@ oe_result_t oe_create_enclave(
         OE_RAISE(OE_FAILURE);
     }
 
+    pushed = true;
+
     // Create debugging structures only for debug enclaves.
     if (enclave->debug)
     {
@@ -746,6 +831,19 @@ oe_result_t oe_create_enclave(
             OE_RAISE(OE_FAILURE);
     }
 
+    /* Profile the locks or the heap of the enclave if OE_LOCK_STATS or
+     * OE_HEAP_PROFILE is set */
+    oe_start_env_reports(enclave);
+
+    /* Start the host threads that run the threads started by the enclave */
+    if (num_pool_threads > 0)
+        OE_CHECK(oe_start_thread_pool(enclave, num_pool_threads));
+
+    /* Start the workers for switchless OCALLs and ECALLs */
+    if (num_host_workers > 0 || num_enclave_workers > 0)
+        OE_CHECK(oe_start_switchless_manager(
+            enclave, num_host_workers, num_enclave_workers));
+
     *enclave_out = enclave;
     result = OE_OK;
 
@@ -753,6 +851,38 @@ done:
 
     if (result != OE_OK && enclave)
     {
+        oe_stop_thread_pool(enclave);
+
+        if (enclave->debug_enclave)
+        {
+            oe_debug_notify_enclave_terminated(enclave->debug_enclave);
+            free(enclave->debug_enclave->tcs_array);
+            free(enclave->debug_enclave);
+        }
+
+        /* Unregister and unmap the enclave, as oe_terminate_enclave() does */
+        if (pushed)
+            oe_remove_enclave_instance(enclave);
+
+        if (enclave->addr)
+            oe_sgx_delete_enclave(enclave);
+
+        for (size_t i = 0; i < enclave->num_bindings; i++)
+        {
+            free(enclave->ocall_arenas[i]);
+            free(enclave->deferred_ocall_queues[i]);
+
+#if defined(_WIN32)
+            if (enclave->bindings[i].event.handle)
+                CloseHandle(enclave->bindings[i].event.handle);
+#endif
+        }
+
+        for (size_t i = 0; i < enclave->num_host_pool_regions; i++)
+            oe_memalign_free(enclave->host_pool_regions[i]);
+
+        free(enclave->path);
+        oe_destroy_thread_bindings(enclave);
         free(enclave);
     }
 
@@ -769,9 +899,25 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     if (!enclave || enclave->magic != ENCLAVE_MAGIC)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Enclave workers must leave the enclave before it is destructed */
+    oe_stop_switchless_enclave_workers(enclave);
+
+    /* So must the enclave threads: wait for them to return */
+    oe_stop_thread_pool(enclave);
+
+    /* Write the reports requested by the environment while the enclave
+     * can still be called */
+    oe_write_env_reports(enclave);
+
     /* Call the enclave destructor */
     OE_CHECK(oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL));
 
+    /* The destructor may still make switchless OCALLs: stop workers after */
+    oe_stop_switchless_manager(enclave);
+
+    /* No calls are made from here on */
+    oe_dump_call_stats(enclave);
+
     if (enclave->debug_enclave)
     {
         oe_debug_notify_enclave_terminated(enclave->debug_enclave);
@@ -794,6 +940,18 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
          * Track failures reported by the platform, but do not exit early */
         result = oe_sgx_delete_enclave(enclave);
 
+        /* Release the OCALL arenas and deferred OCALL queues of the enclave
+         * threads */
+        for (size_t i = 0; i < enclave->num_bindings; i++)
+        {
+            free(enclave->ocall_arenas[i]);
+            free(enclave->deferred_ocall_queues[i]);
+        }
+
+        /* Release the regions of the untrusted memory pool */
+        for (size_t i = 0; i < enclave->num_host_pool_regions; i++)
+            oe_memalign_free(enclave->host_pool_regions[i]);
+
 #if defined(_WIN32)
 
         /* Release Windows events created during enclave creation */
@@ -811,6 +969,7 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     /* Release and destroy the mutex object */
     oe_mutex_unlock(&enclave->lock);
     oe_mutex_destroy(&enclave->lock);
+    oe_destroy_thread_bindings(enclave);
 
     /* Clear the contents of the enclave structure */
 
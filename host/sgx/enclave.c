@@ -4,31 +4,467 @@
 #include "enclave.h"
 #include <assert.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/*
+**==============================================================================
+**
+** oe_get_thread_binding_by_tcs()
+**
+**     The TCSs of an enclave are laid out at a fixed distance from each other,
+**     so the binding of a TCS is found by dividing its offset from the first
+**     TCS by that distance. The result is verified against the binding, and
+**     a linear search is used should the layout ever differ.
+**
+**==============================================================================
+*/
+
+ThreadBinding* oe_get_thread_binding_by_tcs(
+    oe_enclave_t* enclave,
+    uint64_t tcs)
+{
+    if (!enclave || enclave->num_bindings == 0)
+        return NULL;
+
+    if (enclave->tcs_stride)
+    {
+        uint64_t first = enclave->bindings[0].tcs;
+        uint64_t index;
+
+        if (tcs < first || (tcs - first) % enclave->tcs_stride != 0)
+            return NULL;
+
+        index = (tcs - first) / enclave->tcs_stride;
+
+        if (index < enclave->num_bindings &&
+            enclave->bindings[index].tcs == tcs)
+            return &enclave->bindings[index];
+
+        return NULL;
+    }
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        if (enclave->bindings[i].tcs == tcs)
+            return &enclave->bindings[i];
+    }
+
+    return NULL;
+}
 
 /* Get the event object from the enclave for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs)
 {
-    EnclaveEvent* event = NULL;
+    ThreadBinding* binding = oe_get_thread_binding_by_tcs(enclave, tcs);
 
-    if (!enclave)
-        return NULL;
+    return binding ? &binding->event : NULL;
+}
+
+/*
+**==============================================================================
+**
+** Free bindings:
+**
+**     The bindings that are not in use form a lock-free stack. The head holds
+**     the index (plus one) of the top binding in its low 32 bits and a tag in
+**     its high 32 bits. The tag changes on every update so that a stale
+**     compare-and-swap fails (the ABA problem). Reusing the most recently
+**     released binding also keeps the TCS and its stack warm in the cache.
+**
+**==============================================================================
+*/
+
+#define _INDEX_MASK 0xffffffffULL
+
+static uint64_t _next_head(uint64_t head, uint64_t index_plus_one)
+{
+    return (((head >> 32) + 1) << 32) | index_plus_one;
+}
+
+static ThreadBinding* _pop_free_binding(oe_enclave_t* enclave)
+{
+    for (;;)
+    {
+        uint64_t head = oe_atomic_load(&enclave->free_bindings);
+        uint64_t index_plus_one = head & _INDEX_MASK;
+        uint64_t next;
+
+        if (index_plus_one == 0)
+            return NULL;
+
+        next = enclave->free_bindings_next[index_plus_one - 1];
+
+        if (oe_atomic_compare_and_swap(
+                &enclave->free_bindings, head, _next_head(head, next)))
+            return &enclave->bindings[index_plus_one - 1];
+    }
+}
+
+static void _push_free_binding(oe_enclave_t* enclave, ThreadBinding* binding)
+{
+    uint64_t index = (uint64_t)(binding - enclave->bindings);
+
+    for (;;)
+    {
+        uint64_t head = oe_atomic_load(&enclave->free_bindings);
+
+        enclave->free_bindings_next[index] = (uint32_t)(head & _INDEX_MASK);
+
+        if (oe_atomic_compare_and_swap(
+                &enclave->free_bindings, head, _next_head(head, index + 1)))
+            return;
+    }
+}
+
+/*
+**==============================================================================
+**
+** Waiting for a free binding:
+**
+**     When the enclave was created with a TCS wait timeout, threads that find
+**     no free binding queue up and are handed bindings as they are released,
+**     in the order in which they started waiting. Each waiter lives on the
+**     stack of its thread and sleeps on its own event.
+**
+**==============================================================================
+*/
+
+struct _oe_binding_waiter
+{
+    oe_binding_waiter_t* next;
+
+    /* The binding handed to this waiter (null until then) */
+    ThreadBinding* volatile binding;
+
+#if defined(__linux__)
+    volatile uint32_t word;
+#elif defined(_WIN32)
+    HANDLE handle;
+#endif
+};
+
+static void _remove_waiter(oe_enclave_t* enclave, oe_binding_waiter_t* waiter)
+{
+    oe_binding_waiter_t** p = &enclave->waiters_head;
+    oe_binding_waiter_t* prev = NULL;
+
+    while (*p && *p != waiter)
+    {
+        prev = *p;
+        p = &(*p)->next;
+    }
+
+    if (*p)
+    {
+        *p = waiter->next;
+
+        if (enclave->waiters_tail == waiter)
+            enclave->waiters_tail = prev;
+    }
+}
+
+static void _wake_waiter(oe_binding_waiter_t* waiter, ThreadBinding* binding)
+{
+    waiter->binding = binding;
+
+#if defined(__linux__)
+    __atomic_store_n(&waiter->word, 1, __ATOMIC_RELEASE);
+    syscall(__NR_futex, &waiter->word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif defined(_WIN32)
+    SetEvent(waiter->handle);
+#endif
+}
+
+/* Sleep until woken or until the timeout (in milliseconds) expires */
+static void _sleep_waiter(oe_binding_waiter_t* waiter, uint32_t timeout)
+{
+#if defined(__linux__)
+
+    struct timespec ts = {timeout / 1000, (timeout % 1000) * 1000000L};
+
+    syscall(
+        __NR_futex,
+        &waiter->word,
+        FUTEX_WAIT_PRIVATE,
+        0,
+        timeout == OE_TCS_WAIT_INFINITE ? NULL : &ts,
+        NULL,
+        0);
+
+#elif defined(_WIN32)
+
+    WaitForSingleObject(
+        waiter->handle, timeout == OE_TCS_WAIT_INFINITE ? INFINITE : timeout);
+
+#endif
+}
+
+/* Returns the number of milliseconds elapsed since some fixed point */
+static uint64_t _now_ms(void)
+{
+#if defined(__linux__)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#elif defined(_WIN32)
+    return GetTickCount64();
+#endif
+}
+
+static ThreadBinding* _wait_for_free_binding(oe_enclave_t* enclave)
+{
+    oe_binding_waiter_t waiter;
+    ThreadBinding* binding = NULL;
+    const uint32_t timeout = enclave->tcs_wait_timeout;
+    const uint64_t start = _now_ms();
+
+    memset(&waiter, 0, sizeof(waiter));
+
+    oe_mutex_lock(&enclave->waiters_lock);
+    {
+        /* Announce the waiter before checking the free list one last time:
+         * a thread releasing a binding after this point sees the waiter */
+        oe_atomic_increment(&enclave->num_waiters);
 
-    oe_mutex_lock(&enclave->lock);
+        /* Only take a free binding if no one is waiting ahead of us */
+        if (!enclave->waiters_head && (binding = _pop_free_binding(enclave)))
+        {
+            oe_atomic_decrement(&enclave->num_waiters);
+            oe_mutex_unlock(&enclave->waiters_lock);
+            return binding;
+        }
+
+#if defined(_WIN32)
+        if (!(waiter.handle = CreateEvent(0, FALSE, FALSE, 0)))
+        {
+            oe_atomic_decrement(&enclave->num_waiters);
+            oe_mutex_unlock(&enclave->waiters_lock);
+            return NULL;
+        }
+#endif
+
+        if (enclave->waiters_tail)
+            enclave->waiters_tail->next = &waiter;
+        else
+            enclave->waiters_head = &waiter;
+
+        enclave->waiters_tail = &waiter;
+    }
+    oe_mutex_unlock(&enclave->waiters_lock);
+
+    while (!waiter.binding)
     {
-        size_t i;
+        uint32_t remaining = OE_TCS_WAIT_INFINITE;
 
-        for (i = 0; i < enclave->num_bindings; i++)
+        if (timeout != OE_TCS_WAIT_INFINITE)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
+            uint64_t elapsed = _now_ms() - start;
 
-            if (binding->tcs == tcs)
+            if (elapsed >= timeout)
             {
-                event = &binding->event;
+                /* Give up, unless a binding was handed over meanwhile */
+                oe_mutex_lock(&enclave->waiters_lock);
+
+                if (!waiter.binding)
+                {
+                    _remove_waiter(enclave, &waiter);
+                    oe_atomic_decrement(&enclave->num_waiters);
+                }
+
+                oe_mutex_unlock(&enclave->waiters_lock);
                 break;
             }
+
+            remaining = (uint32_t)(timeout - elapsed);
         }
+
+        _sleep_waiter(&waiter, remaining);
+    }
+
+    /* The thread that handed over the binding wakes the waiter while holding
+     * the lock: wait for it to finish before the waiter goes out of scope */
+    if (waiter.binding)
+    {
+        oe_mutex_lock(&enclave->waiters_lock);
+        oe_mutex_unlock(&enclave->waiters_lock);
     }
-    oe_mutex_unlock(&enclave->lock);
 
-    return event;
+#if defined(_WIN32)
+    CloseHandle(waiter.handle);
+#endif
+
+    return waiter.binding;
+}
+
+/* Hand free bindings to the threads waiting the longest */
+static void _hand_off_free_bindings(oe_enclave_t* enclave)
+{
+    oe_mutex_lock(&enclave->waiters_lock);
+
+    while (enclave->waiters_head)
+    {
+        oe_binding_waiter_t* waiter = enclave->waiters_head;
+        ThreadBinding* binding = _pop_free_binding(enclave);
+
+        if (!binding)
+            break;
+
+        enclave->waiters_head = waiter->next;
+
+        if (!enclave->waiters_head)
+            enclave->waiters_tail = NULL;
+
+        oe_atomic_decrement(&enclave->num_waiters);
+        _wake_waiter(waiter, binding);
+    }
+
+    oe_mutex_unlock(&enclave->waiters_lock);
+}
+
+/*
+**==============================================================================
+**
+** oe_allocate_thread_bindings()
+** oe_initialize_thread_bindings()
+** oe_acquire_thread_binding()
+** oe_release_thread_binding()
+** oe_destroy_thread_bindings()
+**
+**     The bindings and the per-TCS state kept alongside them are sized from
+**     the number of TCSs in the enclave properties. The bindings are
+**     allocated before the TCS pages are added (which records each TCS in
+**     its binding) and made available to ECALLs once they all have been.
+**
+**==============================================================================
+*/
+
+static void _free_thread_bindings(oe_enclave_t* enclave)
+{
+    if (enclave->call_stats)
+    {
+        for (size_t i = 0; i < enclave->max_bindings; i++)
+            free(enclave->call_stats[i]);
+    }
+
+    free(enclave->bindings);
+    free(enclave->ocall_arenas);
+    free(enclave->deferred_ocall_queues);
+    free(enclave->free_bindings_next);
+    free(enclave->call_stats);
+
+    enclave->bindings = NULL;
+    enclave->ocall_arenas = NULL;
+    enclave->deferred_ocall_queues = NULL;
+    enclave->free_bindings_next = NULL;
+    enclave->call_stats = NULL;
+    enclave->num_bindings = 0;
+    enclave->max_bindings = 0;
+}
+
+oe_result_t oe_allocate_thread_bindings(oe_enclave_t* enclave, size_t num_tcs)
+{
+    if (!enclave || enclave->bindings || num_tcs == 0 ||
+        num_tcs > OE_SGX_MAX_TCS)
+        return OE_INVALID_PARAMETER;
+
+    enclave->bindings = (ThreadBinding*)calloc(num_tcs, sizeof(ThreadBinding));
+    enclave->ocall_arenas = (void**)calloc(num_tcs, sizeof(void*));
+    enclave->deferred_ocall_queues = (void**)calloc(num_tcs, sizeof(void*));
+    enclave->free_bindings_next = (uint32_t*)calloc(num_tcs, sizeof(uint32_t));
+    enclave->call_stats = (oe_call_stats_table_t**)calloc(
+        num_tcs, sizeof(oe_call_stats_table_t*));
+
+    if (!enclave->bindings || !enclave->ocall_arenas ||
+        !enclave->deferred_ocall_queues || !enclave->free_bindings_next ||
+        !enclave->call_stats)
+    {
+        _free_thread_bindings(enclave);
+        return OE_OUT_OF_MEMORY;
+    }
+
+    if (oe_mutex_init(&enclave->waiters_lock))
+    {
+        _free_thread_bindings(enclave);
+        return OE_FAILURE;
+    }
+
+    enclave->max_bindings = num_tcs;
+
+    return OE_OK;
+}
+
+oe_result_t oe_initialize_thread_bindings(
+    oe_enclave_t* enclave,
+    uint32_t tcs_wait_timeout)
+{
+    if (!enclave->bindings)
+        return OE_UNEXPECTED;
+
+    enclave->tcs_wait_timeout = tcs_wait_timeout;
+
+    /* Use the fixed distance between TCSs if all of them follow it */
+    if (enclave->num_bindings > 1 &&
+        enclave->bindings[1].tcs > enclave->bindings[0].tcs)
+    {
+        enclave->tcs_stride =
+            enclave->bindings[1].tcs - enclave->bindings[0].tcs;
+
+        for (size_t i = 2; i < enclave->num_bindings; i++)
+        {
+            if (enclave->bindings[i].tcs - enclave->bindings[i - 1].tcs !=
+                enclave->tcs_stride)
+            {
+                enclave->tcs_stride = 0;
+                break;
+            }
+        }
+    }
+
+    /* Push in reverse so that the first TCS is handed out first */
+    for (size_t i = enclave->num_bindings; i > 0; i--)
+        _push_free_binding(enclave, &enclave->bindings[i - 1]);
+
+    return OE_OK;
+}
+
+ThreadBinding* oe_acquire_thread_binding(oe_enclave_t* enclave)
+{
+    ThreadBinding* binding = NULL;
+
+    /* Do not overtake the threads already waiting for a binding */
+    if (oe_atomic_load(&enclave->num_waiters) == 0)
+        binding = _pop_free_binding(enclave);
+
+    if (!binding && enclave->tcs_wait_timeout)
+        binding = _wait_for_free_binding(enclave);
+
+    return binding;
+}
+
+void oe_release_thread_binding(oe_enclave_t* enclave, ThreadBinding* binding)
+{
+    _push_free_binding(enclave, binding);
+
+    /* The push is a full barrier, so a thread that announced itself as a
+     * waiter either found the binding or is seen waiting here */
+    if (oe_atomic_load(&enclave->num_waiters) != 0)
+        _hand_off_free_bindings(enclave);
+}
+
+void oe_destroy_thread_bindings(oe_enclave_t* enclave)
+{
+    if (!enclave->bindings)
+        return;
+
+    oe_mutex_destroy(&enclave->waiters_lock);
+    _free_thread_bindings(enclave);
 }
@@ -8,6 +8,7 @@
 #include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/debugrt/host.h>
+#include <openenclave/internal/hostpool.h>
 #include <openenclave/internal/load.h>
 #include <openenclave/internal/sgxcreate.h>
 #include <stdbool.h>
@@ -29,6 +30,14 @@ typedef struct _enclave_event
 
 #define ENCLAVE_MAGIC 0x20dc98463a5ad8b8
 
+typedef struct _oe_switchless_manager oe_switchless_manager_t;
+
+typedef struct _oe_binding_waiter oe_binding_waiter_t;
+
+typedef struct _oe_call_stats_table oe_call_stats_table_t;
+
+typedef struct _oe_thread_pool oe_thread_pool_t;
+
 /*
 **==============================================================================
 **
@@ -70,6 +79,10 @@ typedef struct _thread_binding
     /* The host GS and FS values saved before making an ecall */
     void* host_gs;
     void* host_fs;
+
+    /* The binding that the thread had before this one was assigned (a
+     * binding of another enclave when called from an OCALL) */
+    struct _thread_binding* outer;
 } ThreadBinding;
 
 OE_STATIC_ASSERT(OE_OFFSETOF(ThreadBinding, tcs) == ThreadBinding_tcs);
@@ -104,8 +117,9 @@ struct _oe_enclave
     /* Size of enclave in bytes */
     uint64_t size;
 
-    /* Array of thread bindings */
-    ThreadBinding bindings[OE_SGX_MAX_TCS];
+    /* Array of thread bindings (one per TCS, sized from the enclave
+     * properties) */
+    ThreadBinding* bindings;
     size_t num_bindings;
     oe_mutex lock;
 
@@ -124,6 +138,59 @@ struct _oe_enclave
 
     /* Meta-data needed by debugrt  */
     oe_debug_enclave_t* debug_enclave;
+
+    /* Host workers servicing switchless calls (null if none) */
+    oe_switchless_manager_t* switchless_manager;
+
+    /* The number of bindings allocated */
+    size_t max_bindings;
+
+    /* Arenas that the enclave threads allocate OCALL buffers from (indexed
+     * like bindings) */
+    void** ocall_arenas;
+
+    /* Queues of the OCALLs deferred by the enclave threads until they exit
+     * the enclave (indexed like bindings) */
+    void** deferred_ocall_queues;
+
+    /* Lock-free stack of the bindings not in use: the index (plus one) of
+     * the top binding and a tag; the next index (plus one) of each binding */
+    volatile uint64_t free_bindings;
+    uint32_t* free_bindings_next;
+
+    /* Distance between consecutive TCSs (zero if they are irregular) */
+    uint64_t tcs_stride;
+
+    /* Milliseconds that ECALLs wait for a free binding (zero: no waiting) */
+    uint32_t tcs_wait_timeout;
+
+    /* FIFO of the threads waiting for a free binding */
+    oe_mutex waiters_lock;
+    oe_binding_waiter_t* waiters_head;
+    oe_binding_waiter_t* waiters_tail;
+    volatile uint64_t num_waiters;
+
+    /* Statistics of the calls made by the thread of each binding (indexed
+     * like bindings, allocated on first use) */
+    oe_call_stats_table_t** call_stats;
+
+    /* Time stamp counter and monotonic time when counting started, to
+     * convert the counter into nanoseconds */
+    uint64_t call_stats_start_ticks;
+    uint64_t call_stats_start_ns;
+
+    /* Host threads running the threads started by the enclave (null if
+     * none) */
+    oe_thread_pool_t* thread_pool;
+
+    /* Regions of host memory handed to the untrusted memory pool of the
+     * enclave (guarded by lock) */
+    void* host_pool_regions[OE_HOST_POOL_MAX_REGIONS];
+    size_t num_host_pool_regions;
+
+    /* Size of the stack of each TCS in bytes, which ends one page below the
+     * TCS */
+    uint64_t stack_size;
 };
 
 // Static asserts for consistency with
@@ -137,7 +204,7 @@ OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, addr) == 2 * sizeof(void*));
 // The fields up to binding correspond to 'ENCLAVE_HEADER'
 OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, bindings) == 0x28);
 
-OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0x788);
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0x90);
 OE_STATIC_ASSERT(
     OE_OFFSETOF(oe_enclave_t, debug) + 1 ==
     OE_OFFSETOF(oe_enclave_t, simulate));
@@ -146,4 +213,34 @@ OE_STATIC_ASSERT(
 /* Get the event for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs);
 
+/* Get the binding of the given TCS (null if tcs is not a TCS of enclave) */
+ThreadBinding* oe_get_thread_binding_by_tcs(
+    oe_enclave_t* enclave,
+    uint64_t tcs);
+
+/* Allocate the bindings for an enclave with the given number of TCSs */
+oe_result_t oe_allocate_thread_bindings(oe_enclave_t* enclave, size_t num_tcs);
+
+/* Build the free list of bindings once all TCSs have been added */
+oe_result_t oe_initialize_thread_bindings(
+    oe_enclave_t* enclave,
+    uint32_t tcs_wait_timeout);
+
+/* Take a free binding, waiting for one if the enclave was configured to.
+ * Returns null if none is available */
+ThreadBinding* oe_acquire_thread_binding(oe_enclave_t* enclave);
+
+/* Return a binding taken with oe_acquire_thread_binding() */
+void oe_release_thread_binding(oe_enclave_t* enclave, ThreadBinding* binding);
+
+/* Bind the calling thread to a TCS until oe_unbind_thread(); its ECALLs
+ * reuse the binding. Returns the TCS, or null if none is available */
+void* oe_bind_thread(oe_enclave_t* enclave);
+
+/* Release the binding made by oe_bind_thread() */
+void oe_unbind_thread(oe_enclave_t* enclave, void* tcs);
+
+/* Release the bindings allocated by oe_allocate_thread_bindings() */
+void oe_destroy_thread_bindings(oe_enclave_t* enclave);
+
 #endif /* _OE_HOST_ENCLAVE_H */
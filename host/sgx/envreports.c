@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "envreports.h"
+#include <openenclave/internal/heapprofile.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../dupenv.h"
+#include "../fopen.h"
+
+/*
+**==============================================================================
+**
+** Environment reports:
+**
+**     Each of these environment variables makes the host collect statistics
+**     of every enclave it creates and report them when the enclave is
+**     terminated, while it can still be called:
+**
+**         OE_LOCK_STATS=[N]       the N most contended locks (stderr)
+**         OE_HEAP_STATS=1         the heap statistics (stderr)
+**         OE_HEAP_PROFILE=<file>  the sampled heap profile (pprof file)
+**         OE_STACK_USAGE=1        the peak stack usage of each TCS (stderr)
+**
+**     A variable that is unset, empty or "0" requests nothing.
+**
+**==============================================================================
+*/
+
+/* Locks reported at termination when OE_LOCK_STATS is not a number */
+#define DEFAULT_TOP_N 20
+
+/* Sample interval used when OE_HEAP_PROFILE_INTERVAL is not a number */
+#define DEFAULT_INTERVAL (512 * 1024)
+
+typedef struct _env_report
+{
+    /* The variable that requests the report */
+    const char* name;
+
+    /* Called when the enclave is created, or null */
+    void (*start)(oe_enclave_t* enclave, const char* value);
+
+    /* Called before the enclave destructor runs */
+    void (*write)(oe_enclave_t* enclave, const char* value);
+} env_report_t;
+
+static size_t _get_lock_stats_top_n(const char* value)
+{
+    char* end;
+    const unsigned long n = strtoul(value, &end, 10);
+
+    return (*end || n == 0) ? DEFAULT_TOP_N : (size_t)n;
+}
+
+static void _start_lock_stats(oe_enclave_t* enclave, const char* value)
+{
+    OE_UNUSED(value);
+    oe_enable_enclave_lock_stats(enclave, true);
+}
+
+static void _write_lock_stats(oe_enclave_t* enclave, const char* value)
+{
+    oe_dump_enclave_lock_stats(enclave, _get_lock_stats_top_n(value), stderr);
+}
+
+static void _write_heap_stats(oe_enclave_t* enclave, const char* value)
+{
+    OE_UNUSED(value);
+    oe_dump_enclave_heap_stats(enclave, stderr);
+}
+
+static void _start_heap_profiler(oe_enclave_t* enclave, const char* value)
+{
+    char* env = oe_dupenv("OE_HEAP_PROFILE_INTERVAL");
+    uint64_t interval = DEFAULT_INTERVAL;
+
+    OE_UNUSED(value);
+
+    if (env && *env)
+    {
+        char* end;
+        const unsigned long long n = strtoull(env, &end, 10);
+
+        if (!*end && n && n <= OE_HEAP_PROFILE_MAX_INTERVAL)
+            interval = n;
+    }
+
+    oe_enable_enclave_heap_profiler(enclave, interval);
+    free(env);
+}
+
+static void _write_heap_profile(oe_enclave_t* enclave, const char* path)
+{
+    FILE* stream;
+
+    if (oe_fopen(&stream, path, "w") != 0)
+        return;
+
+    oe_write_enclave_heap_profile(enclave, stream);
+    fclose(stream);
+}
+
+static void _write_stack_usage(oe_enclave_t* enclave, const char* value)
+{
+    OE_UNUSED(value);
+    oe_dump_enclave_stack_usage(enclave, stderr);
+}
+
+static const env_report_t _reports[] = {
+    {"OE_LOCK_STATS", _start_lock_stats, _write_lock_stats},
+    {"OE_HEAP_STATS", NULL, _write_heap_stats},
+    {"OE_HEAP_PROFILE", _start_heap_profiler, _write_heap_profile},
+    {"OE_STACK_USAGE", NULL, _write_stack_usage},
+};
+
+/* Calls start() or write() of each report requested by the environment */
+static void _run_reports(oe_enclave_t* enclave, bool start)
+{
+    for (size_t i = 0; i < OE_COUNTOF(_reports); i++)
+    {
+        const env_report_t* report = &_reports[i];
+        char* value;
+
+        if (start && !report->start)
+            continue;
+
+        value = oe_dupenv(report->name);
+
+        if (value && *value && strcmp(value, "0") != 0)
+        {
+            if (start)
+                report->start(enclave, value);
+            else
+                report->write(enclave, value);
+        }
+
+        free(value);
+    }
+}
+
+void oe_start_env_reports(oe_enclave_t* enclave)
+{
+    _run_reports(enclave, true);
+}
+
+void oe_write_env_reports(oe_enclave_t* enclave)
+{
+    _run_reports(enclave, false);
+}
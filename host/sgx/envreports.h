@@ -0,0 +1,18 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_ENVREPORTS_H
+#define _OE_HOST_ENVREPORTS_H
+
+#include <openenclave/host.h>
+#include "enclave.h"
+
+/* Start collecting the statistics requested by the OE_* environment
+ * variables of envreports.c. Called once the enclave is initialized */
+void oe_start_env_reports(oe_enclave_t* enclave);
+
+/* Write the reports requested by the OE_* environment variables of
+ * envreports.c. Called before the enclave destructor runs */
+void oe_write_env_reports(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_ENVREPORTS_H */
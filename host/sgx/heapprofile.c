@@ -0,0 +1,276 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/heapprofile.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enclave.h"
+#include "internal_u.h"
+#include "ocalls.h"
+
+/*
+**==============================================================================
+**
+** Heap profile:
+**
+**     Once enabled, the enclave samples its allocations and aggregates them
+**     by call stack (see enclave/core/heapprofile.c). The host reads the
+**     stacks with an internal ECALL and writes them in the legacy text
+**     format of pprof heap profiles, which pprof scales back up from the
+**     sample interval. Each stack is followed by comments naming its
+**     functions, and the profile ends with the mapping of the enclave image
+**     so that pprof can symbolize it too.
+**
+**==============================================================================
+*/
+
+/* Read the call stacks of the profile */
+static oe_result_t _collect_heap_profile(
+    oe_enclave_t* enclave,
+    oe_heap_profile_stack_t** stacks_out,
+    size_t* num_stacks_out,
+    uint64_t* interval,
+    uint64_t* dropped)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+    const size_t size =
+        OE_HEAP_PROFILE_MAX_STACKS * sizeof(oe_heap_profile_stack_t);
+    oe_heap_profile_stack_t* stacks = NULL;
+    size_t num_stacks = 0;
+
+    if (!(stacks = (oe_heap_profile_stack_t*)malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_get_heap_profile_ecall(
+        enclave, &retval, stacks, size, &num_stacks, interval, dropped));
+    OE_CHECK(retval);
+
+    if (num_stacks > OE_HEAP_PROFILE_MAX_STACKS)
+        OE_RAISE(OE_UNEXPECTED);
+
+    for (size_t i = 0; i < num_stacks; i++)
+    {
+        if (stacks[i].num_frames > OE_HEAP_PROFILE_MAX_FRAMES)
+            OE_RAISE(OE_UNEXPECTED);
+    }
+
+    *stacks_out = stacks;
+    *num_stacks_out = num_stacks;
+    stacks = NULL;
+    result = OE_OK;
+
+done:
+    free(stacks);
+    return result;
+}
+
+static int _compare_addresses(const void* a, const void* b)
+{
+    const uint64_t x = (uint64_t) * (void* const*)a;
+    const uint64_t y = (uint64_t) * (void* const*)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Gather the distinct addresses of the stacks, sorted, and their function
+ * names. The names are null if the enclave image cannot be read */
+static oe_result_t _symbolize(
+    oe_enclave_t* enclave,
+    const oe_heap_profile_stack_t* stacks,
+    size_t num_stacks,
+    void*** addrs_out,
+    size_t* num_addrs_out,
+    char*** names_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    void** addrs = NULL;
+    size_t num_addrs = 0;
+
+    if (!(addrs = (void**)malloc(
+              (num_stacks * OE_HEAP_PROFILE_MAX_FRAMES + 1) * sizeof(void*))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < num_stacks; i++)
+    {
+        for (uint64_t j = 0; j < stacks[i].num_frames; j++)
+            addrs[num_addrs++] = (void*)(stacks[i].frames[j] + enclave->addr);
+    }
+
+    qsort(addrs, num_addrs, sizeof(void*), _compare_addresses);
+
+    if (num_addrs)
+    {
+        size_t n = 1;
+
+        for (size_t i = 1; i < num_addrs; i++)
+        {
+            if (addrs[i] != addrs[n - 1])
+                addrs[n++] = addrs[i];
+        }
+
+        num_addrs = n;
+    }
+
+    *names_out = num_addrs ? oe_get_enclave_backtrace_symbols(
+                                 enclave, addrs, (int)num_addrs)
+                           : NULL;
+    *addrs_out = addrs;
+    *num_addrs_out = num_addrs;
+    addrs = NULL;
+    result = OE_OK;
+
+done:
+    free(addrs);
+    return result;
+}
+
+static void _write_heap_profile(
+    oe_enclave_t* enclave,
+    const oe_heap_profile_stack_t* stacks,
+    size_t num_stacks,
+    uint64_t interval,
+    uint64_t dropped,
+    void** addrs,
+    size_t num_addrs,
+    char** names,
+    FILE* stream)
+{
+    oe_heap_profile_stack_t total = {0};
+
+    for (size_t i = 0; i < num_stacks; i++)
+    {
+        total.in_use_count += stacks[i].in_use_count;
+        total.in_use_bytes += stacks[i].in_use_bytes;
+        total.alloc_count += stacks[i].alloc_count;
+        total.alloc_bytes += stacks[i].alloc_bytes;
+    }
+
+    fprintf(
+        stream,
+        "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+        OE_LLU(total.in_use_count),
+        OE_LLU(total.in_use_bytes),
+        OE_LLU(total.alloc_count),
+        OE_LLU(total.alloc_bytes),
+        OE_LLU(interval));
+
+    for (size_t i = 0; i < num_stacks; i++)
+    {
+        const oe_heap_profile_stack_t* s = &stacks[i];
+
+        fprintf(
+            stream,
+            "%llu: %llu [%llu: %llu] @",
+            OE_LLU(s->in_use_count),
+            OE_LLU(s->in_use_bytes),
+            OE_LLU(s->alloc_count),
+            OE_LLU(s->alloc_bytes));
+
+        for (uint64_t j = 0; j < s->num_frames; j++)
+            fprintf(stream, " %#llx", OE_LLX(s->frames[j] + enclave->addr));
+
+        fprintf(stream, "\n");
+
+        for (uint64_t j = 0; names && j < s->num_frames; j++)
+        {
+            void* addr = (void*)(s->frames[j] + enclave->addr);
+            void** found = (void**)bsearch(
+                &addr, addrs, num_addrs, sizeof(void*), _compare_addresses);
+
+            if (found)
+                fprintf(
+                    stream,
+                    "#\t%#llx\t%s\n",
+                    OE_LLX((uint64_t)addr),
+                    names[found - addrs]);
+        }
+    }
+
+    if (dropped)
+        fprintf(
+            stream,
+            "# %llu samples did not fit in the profile\n",
+            OE_LLU(dropped));
+
+    fprintf(stream, "\nMAPPED_LIBRARIES:\n");
+    fprintf(
+        stream,
+        "%llx-%llx r-xp 00000000 00:00 0 %s\n",
+        OE_LLX(enclave->addr),
+        OE_LLX(enclave->addr + enclave->size),
+        enclave->path);
+}
+
+/*
+**==============================================================================
+**
+** Public functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_enable_enclave_heap_profiler(
+    oe_enclave_t* enclave,
+    uint64_t sample_interval)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC ||
+        sample_interval > OE_HEAP_PROFILE_MAX_INTERVAL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_enable_heap_profiler_ecall(enclave, &retval, sample_interval));
+    OE_CHECK(retval);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_write_enclave_heap_profile(oe_enclave_t* enclave, FILE* stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_heap_profile_stack_t* stacks = NULL;
+    size_t num_stacks = 0;
+    uint64_t interval;
+    uint64_t dropped;
+    void** addrs = NULL;
+    size_t num_addrs = 0;
+    char** names = NULL;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_collect_heap_profile(
+        enclave, &stacks, &num_stacks, &interval, &dropped));
+    OE_CHECK(_symbolize(
+        enclave, stacks, num_stacks, &addrs, &num_addrs, &names));
+
+    _write_heap_profile(
+        enclave,
+        stacks,
+        num_stacks,
+        interval,
+        dropped,
+        addrs,
+        num_addrs,
+        names,
+        stream);
+
+    if (ferror(stream))
+        OE_RAISE(OE_FAILURE);
+
+    result = OE_OK;
+
+done:
+    free(names);
+    free(addrs);
+    free(stacks);
+    return result;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enclave.h"
+#include "internal_u.h"
+
+/*
+**==============================================================================
+**
+** Heap statistics:
+**
+**     The enclave keeps the statistics of its heap (see enclave/core/malloc.c)
+**     and the host reads them with an internal ECALL. The peak break tells
+**     how many heap pages the enclave actually needed, which is what the
+**     NumHeapPages property should be set from.
+**
+**==============================================================================
+*/
+
+static void _write_heap_stats(const oe_heap_stats_t* s, FILE* stream)
+{
+    fprintf(
+        stream,
+        "heap size        %14llu bytes (%llu pages)\n",
+        OE_LLU(s->heap_size),
+        OE_LLU(oe_count_pages(s->heap_size)));
+    fprintf(
+        stream,
+        "break            %14llu bytes (%llu pages)\n",
+        OE_LLU(s->sbrk_bytes),
+        OE_LLU(oe_count_pages(s->sbrk_bytes)));
+    fprintf(
+        stream,
+        "peak break       %14llu bytes (%llu pages, %llu%% of the heap)\n",
+        OE_LLU(s->peak_sbrk_bytes),
+        OE_LLU(oe_count_pages(s->peak_sbrk_bytes)),
+        OE_LLU(
+            s->heap_size ? s->peak_sbrk_bytes * 100 / s->heap_size : 0));
+    fprintf(stream, "in use           %14llu bytes\n", OE_LLU(s->in_use_bytes));
+    fprintf(
+        stream,
+        "free             %14llu bytes in %llu blocks (%llu bytes at the "
+        "top, %llu%% fragmented)\n",
+        OE_LLU(s->free_bytes),
+        OE_LLU(s->free_blocks),
+        OE_LLU(s->top_free_bytes),
+        OE_LLU(s->fragmentation));
+    fprintf(
+        stream,
+        "allocations      %14llu (%llu frees, %llu failures)\n",
+        OE_LLU(s->allocations),
+        OE_LLU(s->frees),
+        OE_LLU(s->failures));
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+    {
+        if (!s->size_classes[i])
+            continue;
+
+        if (i + 1 < OE_HEAP_STATS_NUM_SIZE_CLASSES)
+            fprintf(
+                stream,
+                "  <= %-11llu %14llu\n",
+                OE_LLU((uint64_t)16 << i),
+                OE_LLU(s->size_classes[i]));
+        else
+            fprintf(
+                stream,
+                "   > %-11llu %14llu\n",
+                OE_LLU((uint64_t)8 << i),
+                OE_LLU(s->size_classes[i]));
+    }
+}
+
+/*
+**==============================================================================
+**
+** Public functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_heap_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(
+        oe_get_heap_stats_ecall(enclave, &retval, stats, sizeof(*stats)));
+    OE_CHECK(retval);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_dump_enclave_heap_stats(oe_enclave_t* enclave, FILE* stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_heap_stats_t stats;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_get_enclave_heap_stats(enclave, &stats));
+
+    fprintf(stream, "=== heap of %s\n", enclave->path);
+    _write_heap_stats(&stats, stream);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -28,7 +28,22 @@ static oe_result_t _call_internal_enclave_function(
         input_buffer_size,
         output_buffer,
         output_buffer_size,
-        output_bytes_written);
+        output_bytes_written,
+        false);
+}
+
+// Override oe_call_enclave_functions_batch() with
+// _call_internal_enclave_functions_batch().
+#define oe_call_enclave_functions_batch _call_internal_enclave_functions_batch
+
+/* The batched ecall edge routines will use this function to route ecalls. */
+static oe_result_t _call_internal_enclave_functions_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    return oe_call_enclave_functions_batch_by_table_id(
+        enclave, OE_INTERNAL_ECALL_FUNCTION_TABLE_ID, calls, num_calls);
 }
 
 /* Ignore missing edge-routine prototypes. */
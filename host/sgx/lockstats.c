@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enclave.h"
+#include "internal_u.h"
+
+/*
+**==============================================================================
+**
+** Lock statistics:
+**
+**     The enclave counts the operations on its locks once the profiler is
+**     enabled (see enclave/core/sgx/lockstats.c). The host reads them with
+**     an internal ECALL, sorts them and reports the most contended locks.
+**
+**==============================================================================
+*/
+
+/* Most contended first: longest wait, then most spins, then most often
+ * contended */
+static int _compare_contention(const void* a, const void* b)
+{
+    const oe_lock_stats_t* x = (const oe_lock_stats_t*)a;
+    const oe_lock_stats_t* y = (const oe_lock_stats_t*)b;
+
+    if (x->wait_ns != y->wait_ns)
+        return x->wait_ns < y->wait_ns ? 1 : -1;
+
+    if (x->spins != y->spins)
+        return x->spins < y->spins ? 1 : -1;
+
+    if (x->contended != y->contended)
+        return x->contended < y->contended ? 1 : -1;
+
+    return 0;
+}
+
+/* Read the statistics of all the locks, sorted */
+static oe_result_t _collect_lock_stats(
+    oe_enclave_t* enclave,
+    oe_lock_stats_t** stats_out,
+    size_t* num_stats_out,
+    uint64_t* dropped)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+    const size_t size = OE_LOCK_STATS_MAX_LOCKS * sizeof(oe_lock_stats_t);
+    oe_lock_stats_t* stats = NULL;
+    size_t num_stats = 0;
+
+    if (!(stats = (oe_lock_stats_t*)malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_get_lock_stats_ecall(
+        enclave, &retval, stats, size, &num_stats, dropped));
+    OE_CHECK(retval);
+
+    if (num_stats > OE_LOCK_STATS_MAX_LOCKS)
+        OE_RAISE(OE_UNEXPECTED);
+
+    qsort(stats, num_stats, sizeof(*stats), _compare_contention);
+
+    *stats_out = stats;
+    *num_stats_out = num_stats;
+    stats = NULL;
+    result = OE_OK;
+
+done:
+    free(stats);
+    return result;
+}
+
+static const char* _type_name(oe_lock_type_t type)
+{
+    switch (type)
+    {
+        case OE_LOCK_TYPE_MUTEX:
+            return "mutex";
+        case OE_LOCK_TYPE_COND:
+            return "cond";
+        case OE_LOCK_TYPE_RWLOCK:
+            return "rwlock";
+        case OE_LOCK_TYPE_SPINLOCK:
+            return "spinlock";
+        default:
+            return "other";
+    }
+}
+
+static void _write_lock_stats(
+    const oe_lock_stats_t* stats,
+    size_t num_stats,
+    uint64_t dropped,
+    FILE* stream)
+{
+    fprintf(
+        stream,
+        "%-8s %12s %12s %10s %10s %12s %10s %14s\n",
+        "type",
+        "lock",
+        "caller",
+        "acquired",
+        "contended",
+        "spins",
+        "parks",
+        "wait(ns)");
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        const oe_lock_stats_t* s = &stats[i];
+
+        fprintf(
+            stream,
+            "%-8s %#12llx %#12llx %10llu %10llu %12llu %10llu %14llu\n",
+            _type_name(s->type),
+            OE_LLX(s->lock),
+            OE_LLX(s->caller),
+            OE_LLU(s->acquisitions),
+            OE_LLU(s->contended),
+            OE_LLU(s->spins),
+            OE_LLU(s->parks),
+            OE_LLU(s->wait_ns));
+    }
+
+    if (dropped)
+        fprintf(
+            stream,
+            "(%llu operations on further locks not counted)\n",
+            OE_LLU(dropped));
+}
+
+/*
+**==============================================================================
+**
+** Public functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_enable_enclave_lock_stats(oe_enclave_t* enclave, bool enable)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_enable_lock_stats_ecall(enclave, &retval, enable));
+    OE_CHECK(retval);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_get_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    oe_lock_stats_t* stats,
+    size_t* num_stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_lock_stats_t* all = NULL;
+    size_t num_all = 0;
+    uint64_t dropped;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !num_stats ||
+        (!stats && *num_stats))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_collect_lock_stats(enclave, &all, &num_all, &dropped));
+
+    if (*num_stats < num_all)
+    {
+        *num_stats = num_all;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    if (num_all)
+        memcpy(stats, all, num_all * sizeof(*all));
+
+    *num_stats = num_all;
+    result = OE_OK;
+
+done:
+    free(all);
+    return result;
+}
+
+oe_result_t oe_dump_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    size_t top_n,
+    FILE* stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_lock_stats_t* stats = NULL;
+    size_t num_stats = 0;
+    uint64_t dropped;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_collect_lock_stats(enclave, &stats, &num_stats, &dropped));
+
+    fprintf(
+        stream,
+        "=== %zu most contended of %zu locks of %s\n",
+        top_n < num_stats ? top_n : num_stats,
+        num_stats,
+        enclave->path);
+    _write_lock_stats(
+        stats, top_n < num_stats ? top_n : num_stats, dropped, stream);
+
+    result = OE_OK;
+
+done:
+    free(stats);
+    return result;
+}
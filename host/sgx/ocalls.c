@@ -5,6 +5,7 @@
 #include <stdio.h>
 
 #if defined(__linux__)
+#include <errno.h>
 #include <linux/futex.h>
 #include <stdlib.h>
 #include <sys/syscall.h>
@@ -52,10 +53,36 @@ void HandleFree(uint64_t arg)
     free((void*)arg);
 }
 
-void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
+/* Returns the number of nanoseconds elapsed since some fixed point */
+static uint64_t _now_ns(void)
+{
+#if defined(__linux__)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#elif defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint64_t)(
+        (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#endif
+}
+
+/* Wait for the event of the TCS in arg_in. Sets *arg_out to the time waited
+ * in nanoseconds, which the enclave's lock contention profiler reports */
+void HandleThreadWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
 {
     const uint64_t tcs = arg_in;
     EnclaveEvent* event = GetEnclaveEvent(enclave, tcs);
+    const uint64_t start = _now_ns();
     assert(event);
 
 #if defined(__linux__)
@@ -84,6 +111,9 @@ void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
     WaitForSingleObject(event->handle, INFINITE);
 
 #endif
+
+    if (arg_out)
+        *arg_out = _now_ns() - start;
 }
 
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg_in)
@@ -105,7 +135,10 @@ void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg_in)
 #endif
 }
 
-void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in)
+void HandleThreadWakeWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
 {
     oe_thread_wake_wait_args_t* args = (oe_thread_wake_wait_args_t*)arg_in;
 
@@ -115,16 +148,108 @@ void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in)
 #if defined(__linux__)
 
     HandleThreadWake(enclave, (uint64_t)args->waiter_tcs);
-    HandleThreadWait(enclave, (uint64_t)args->self_tcs);
+    HandleThreadWait(enclave, (uint64_t)args->self_tcs, arg_out);
 
 #elif defined(_WIN32)
 
     HandleThreadWake(enclave, (uint64_t)args->waiter_tcs);
-    HandleThreadWait(enclave, (uint64_t)args->self_tcs);
+    HandleThreadWait(enclave, (uint64_t)args->self_tcs, arg_out);
 
 #endif
 }
 
+/* Wake the threads of all the TCSs in arg_in with a single OCALL */
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in)
+{
+    oe_thread_wake_multiple_args_t* args =
+        (oe_thread_wake_multiple_args_t*)arg_in;
+    const void** tcs;
+
+    if (!args)
+        return;
+
+    tcs = (const void**)(args + 1);
+
+    for (uint64_t i = 0; i < args->num_tcs; i++)
+        HandleThreadWake(enclave, (uint64_t)tcs[i]);
+}
+
+/* Wait for the event of the calling TCS until the deadline of the
+ * oe_thread_wait_timed_args_t in arg_in, and set its results */
+void HandleThreadWaitTimed(oe_enclave_t* enclave, void* tcs, uint64_t arg_in)
+{
+    oe_thread_wait_timed_args_t* args = (oe_thread_wait_timed_args_t*)arg_in;
+    EnclaveEvent* event = GetEnclaveEvent(enclave, (uint64_t)tcs);
+    uint64_t start;
+    uint64_t deadline;
+    bool timed_out = false;
+    assert(event);
+
+    if (!args)
+        return;
+
+    start = _now_ns();
+    deadline = args->deadline;
+
+#if defined(__linux__)
+
+    if (__sync_fetch_and_add(&event->value, (uint32_t)-1) == 0)
+    {
+        struct timespec ts;
+
+        ts.tv_sec = (time_t)(deadline / 1000000000);
+        ts.tv_nsec = (long)(deadline % 1000000000);
+
+        do
+        {
+            /* The wait with a bitset takes an absolute timeout */
+            if (syscall(
+                    __NR_futex,
+                    &event->value,
+                    FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+                    -1,
+                    &ts,
+                    NULL,
+                    FUTEX_BITSET_MATCH_ANY) != 0 &&
+                errno == ETIMEDOUT)
+            {
+                /* Withdraw from the event, unless it was just signaled */
+                if (__sync_bool_compare_and_swap(
+                        &event->value, (uint32_t)-1, 0))
+                    timed_out = true;
+
+                break;
+            }
+        } while (event->value == (uint32_t)-1);
+    }
+
+#elif defined(_WIN32)
+
+    /* Windows file times count 100ns intervals since 1601-01-01 */
+    const uint64_t epoch = 116444736000000000;
+    FILETIME ft;
+    uint64_t now;
+    DWORD msec = 0;
+
+    GetSystemTimePreciseAsFileTime(&ft);
+    now = ((((uint64_t)ft.dwHighDateTime) << 32) | ft.dwLowDateTime) - epoch;
+    now *= 100;
+
+    if (deadline > now)
+    {
+        const uint64_t n = (deadline - now + 999999) / 1000000;
+        msec = n < INFINITE ? (DWORD)n : INFINITE - 1;
+    }
+
+    if (WaitForSingleObject(event->handle, msec) == WAIT_TIMEOUT)
+        timed_out = true;
+
+#endif
+
+    args->wait_ns = _now_ns() - start;
+    args->timed_out = timed_out;
+}
+
 void HandleGetQuote(uint64_t arg_in)
 {
     oe_get_quote_args_t* args = (oe_get_quote_args_t*)arg_in;
@@ -168,7 +293,7 @@ void HandleGetQETargetInfo(uint64_t arg_in)
     args->result = sgx_get_qetarget_info(&args->target_info);
 }
 
-static char** _backtrace_symbols(
+char** oe_get_enclave_backtrace_symbols(
     oe_enclave_t* enclave,
     void* const* buffer,
     int size)
@@ -257,7 +382,8 @@ void oe_handle_backtrace_symbols(oe_enclave_t* enclave, uint64_t arg)
 
     if (args)
     {
-        args->ret = _backtrace_symbols(enclave, args->buffer, args->size);
+        args->ret = oe_get_enclave_backtrace_symbols(
+            enclave, args->buffer, args->size);
     }
 }
 
@@ -10,15 +10,30 @@ void HandleMalloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleRealloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleFree(uint64_t arg);
 
-void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg);
+void HandleThreadWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out);
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg);
-void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in);
+void HandleThreadWakeWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out);
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in);
+void HandleThreadWaitTimed(oe_enclave_t* enclave, void* tcs, uint64_t arg_in);
 
 void HandleGetQuote(uint64_t arg_in);
 void HandleGetQETargetInfo(uint64_t arg_in);
 void HandleGetQuoteRevocationInfo(uint64_t arg_in);
 void HandleGetQuoteEnclaveIdentityInfo(uint64_t arg_in);
 
+/* Returns the names of the enclave functions of the given addresses, as an
+ * array followed by the strings in a single block to free(), or null */
+char** oe_get_enclave_backtrace_symbols(
+    oe_enclave_t* enclave,
+    void* const* buffer,
+    int size);
+
 void oe_handle_backtrace_symbols(oe_enclave_t* enclave, uint64_t arg);
 void oe_handle_log(oe_enclave_t* enclave, uint64_t arg);
 
@@ -0,0 +1,194 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enclave.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+**==============================================================================
+**
+** Stack usage:
+**
+**     The stack pages of each TCS are filled with OE_SGX_STACK_FILL when the
+**     enclave is created (see _add_stack_pages() in create.c). The host can
+**     read the memory of debug and simulated enclaves, so it finds the
+**     deepest word of each stack that no longer holds the pattern without
+**     calling the enclave. Enclaves built for production can report their
+**     own usage with oe_get_stack_usage().
+**
+**==============================================================================
+*/
+
+#define STACK_FILL (((uint64_t)OE_SGX_STACK_FILL << 32) | OE_SGX_STACK_FILL)
+
+/* Read the memory of a debug or simulated enclave. The memory of simulated
+ * enclaves is ordinary memory, while that of debug enclaves is read through
+ * the debug interface of the SGX driver (as debuggers do) */
+static oe_result_t _read_enclave_memory(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    void* buffer,
+    size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (enclave->simulate)
+    {
+        memcpy(buffer, (const void*)addr, size);
+    }
+    else
+    {
+#if defined(_WIN32)
+        SIZE_T n = 0;
+
+        if (!ReadProcessMemory(
+                GetCurrentProcess(), (LPCVOID)addr, buffer, size, &n) ||
+            n != size)
+            OE_RAISE(OE_FAILURE);
+#else
+        int fd;
+        ssize_t n;
+
+        if ((fd = open("/proc/self/mem", O_RDONLY)) < 0)
+            OE_RAISE(OE_FAILURE);
+
+        n = pread(fd, buffer, size, (off_t)addr);
+        close(fd);
+
+        if (n < 0 || (size_t)n != size)
+            OE_RAISE(OE_FAILURE);
+#endif
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Returns the number of bytes between the deepest written word of the stack
+ * and its top */
+static uint64_t _peak_bytes(const uint64_t* stack, uint64_t size)
+{
+    const uint64_t n = size / sizeof(uint64_t);
+    uint64_t i = 0;
+
+    while (i < n && stack[i] == STACK_FILL)
+        i++;
+
+    return (n - i) * sizeof(uint64_t);
+}
+
+/*
+**==============================================================================
+**
+** Public functions:
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_enclave_stack_usage(
+    oe_enclave_t* enclave,
+    oe_stack_usage_t* usage,
+    size_t* num_usage)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t* stack = NULL;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !num_usage ||
+        (!usage && *num_usage))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The memory of production enclaves cannot be read */
+    if (!enclave->debug && !enclave->simulate)
+        OE_RAISE(OE_UNSUPPORTED);
+
+    if (*num_usage < enclave->num_bindings)
+    {
+        *num_usage = enclave->num_bindings;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    if (!(stack = (uint64_t*)malloc(enclave->stack_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        const uint64_t tcs = enclave->bindings[i].tcs;
+        const uint64_t top = tcs - OE_PAGE_SIZE;
+
+        OE_CHECK(_read_enclave_memory(
+            enclave, top - enclave->stack_size, stack, enclave->stack_size));
+
+        usage[i].tcs = tcs - enclave->addr;
+        usage[i].stack_size = enclave->stack_size;
+        usage[i].peak_bytes = _peak_bytes(stack, enclave->stack_size);
+    }
+
+    *num_usage = enclave->num_bindings;
+    result = OE_OK;
+
+done:
+    free(stack);
+    return result;
+}
+
+oe_result_t oe_dump_enclave_stack_usage(oe_enclave_t* enclave, FILE* stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_stack_usage_t* usage = NULL;
+    size_t num_usage = 0;
+    uint64_t peak = 0;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    num_usage = enclave->num_bindings;
+
+    if (!(usage = (oe_stack_usage_t*)calloc(num_usage, sizeof(*usage))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_get_enclave_stack_usage(enclave, usage, &num_usage));
+
+    fprintf(stream, "=== stacks of %s\n", enclave->path);
+    fprintf(stream, "%12s %14s %14s\n", "tcs", "peak(bytes)", "size(bytes)");
+
+    for (size_t i = 0; i < num_usage; i++)
+    {
+        fprintf(
+            stream,
+            "%#12llx %14llu %14llu\n",
+            OE_LLX(usage[i].tcs),
+            OE_LLU(usage[i].peak_bytes),
+            OE_LLU(usage[i].stack_size));
+
+        if (usage[i].peak_bytes > peak)
+            peak = usage[i].peak_bytes;
+    }
+
+    fprintf(
+        stream,
+        "peak             %14llu bytes (%llu of %llu stack pages)\n",
+        OE_LLU(peak),
+        OE_LLU(oe_count_pages(peak)),
+        OE_LLU(oe_count_pages(enclave->stack_size)));
+
+    result = OE_OK;
+
+done:
+    free(usage);
+    return result;
+}
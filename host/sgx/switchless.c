@@ -0,0 +1,611 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/switchless.h>
+#include <openenclave/internal/trace.h>
+#include "../memalign.h"
+#include "enclave.h"
+#include "internal_u.h"
+#include "switchless.h"
+
+OE_INLINE void _cpu_relax(void)
+{
+#if defined(__GNUC__)
+    asm volatile("pause" ::: "memory");
+#elif defined(_MSC_VER)
+    YieldProcessor();
+#endif
+}
+
+static void _yield(void)
+{
+#if defined(__linux__)
+    sched_yield();
+#elif defined(_WIN32)
+    SwitchToThread();
+#endif
+}
+
+static bool _is_queue_empty(oe_switchless_queue_t* queue)
+{
+    return oe_atomic_load(&queue->head) == oe_atomic_load(&queue->tail);
+}
+
+/*
+**==============================================================================
+**
+** Worker events:
+**
+**     Workers that find no work for OE_SWITCHLESS_WORKER_SPIN_COUNT
+**     iterations stop polling and sleep on the event of their kind. Callers
+**     that find no polling worker make the call as an ordinary transition
+**     and wake the sleeping workers.
+**
+**==============================================================================
+*/
+
+static oe_result_t _event_init(oe_switchless_event_t* event, size_t max)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    event->sleepers = 0;
+
+#if defined(__linux__)
+    OE_UNUSED(max);
+    event->word = 0;
+#elif defined(_WIN32)
+    if (!(event->handle = CreateSemaphore(NULL, 0, (LONG)max, NULL)))
+        OE_RAISE_MSG(OE_FAILURE, "CreateSemaphore failed", NULL);
+#endif
+
+    result = OE_OK;
+#if defined(_WIN32)
+done:
+#endif
+    return result;
+}
+
+static void _event_destroy(oe_switchless_event_t* event)
+{
+#if defined(_WIN32)
+    if (event->handle)
+        CloseHandle(event->handle);
+#else
+    OE_UNUSED(event);
+#endif
+}
+
+/* Sleep unless the queue has work or is stopping */
+static void _event_wait(
+    oe_switchless_event_t* event,
+    oe_switchless_queue_t* queue)
+{
+#if defined(__linux__)
+    uint32_t word = event->word;
+#endif
+
+    oe_atomic_increment(&event->sleepers);
+
+    if (_is_queue_empty(queue) && !oe_atomic_load(&queue->stopping))
+    {
+#if defined(__linux__)
+        syscall(
+            __NR_futex, &event->word, FUTEX_WAIT_PRIVATE, word, NULL, NULL, 0);
+#elif defined(_WIN32)
+        WaitForSingleObject(event->handle, INFINITE);
+#endif
+    }
+
+    oe_atomic_decrement(&event->sleepers);
+}
+
+/* Wake the sleepers (or count workers regardless when force is true) */
+static void _event_wake(oe_switchless_event_t* event, size_t count, bool force)
+{
+    if (!force && oe_atomic_load(&event->sleepers) == 0)
+        return;
+
+#if defined(__linux__)
+    OE_UNUSED(count);
+    __sync_fetch_and_add(&event->word, 1);
+    syscall(
+        __NR_futex, &event->word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#elif defined(_WIN32)
+    if (!force)
+        count = (size_t)oe_atomic_load(&event->sleepers);
+
+    ReleaseSemaphore(event->handle, (LONG)count, NULL);
+#endif
+}
+
+/*
+**==============================================================================
+**
+** Host workers (switchless OCALLs):
+**
+**==============================================================================
+*/
+
+static bool _is_valid_call(
+    oe_switchless_queue_t* queue,
+    void* item,
+    size_t stride)
+{
+    const uint8_t* start = (const uint8_t*)queue->calls;
+    const uint8_t* end = start + queue->num_calls * stride;
+    const uint8_t* p = (const uint8_t*)item;
+
+    return p >= start && p < end && ((size_t)(p - start) % stride) == 0;
+}
+
+static void* _host_worker(void* arg)
+{
+    oe_switchless_manager_t* manager = (oe_switchless_manager_t*)arg;
+    oe_switchless_queue_t* queue = manager->ocall_queue;
+    size_t spins = 0;
+
+    oe_atomic_increment(&queue->spinning_workers);
+
+    while (!oe_atomic_load(&queue->stopping))
+    {
+        void* item = NULL;
+
+        if (oe_switchless_ring_pop(
+                &queue->head, queue->cells, queue->capacity, &item))
+        {
+            oe_switchless_call_t* call = (oe_switchless_call_t*)item;
+
+            /* Skip stale entries and calls already reclaimed by the enclave */
+            if (_is_valid_call(queue, item, OE_SWITCHLESS_CALL_STRIDE) &&
+                oe_atomic_compare_and_swap(
+                    &call->state,
+                    OE_SWITCHLESS_CALL_STATE_POSTED,
+                    OE_SWITCHLESS_CALL_STATE_RUNNING))
+            {
+                oe_handle_call_host_function(
+                    (uint64_t)&call->args, manager->enclave);
+                oe_atomic_increment(&queue->switchless_calls);
+                oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_DONE);
+            }
+
+            spins = 0;
+        }
+        else if (++spins < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+        {
+            _cpu_relax();
+        }
+        else
+        {
+            /* Let the enclave see that this worker stopped polling */
+            oe_atomic_decrement(&queue->spinning_workers);
+            _event_wait(&manager->host_workers_event, queue);
+            oe_atomic_increment(&queue->spinning_workers);
+            spins = 0;
+        }
+    }
+
+    oe_atomic_decrement(&queue->spinning_workers);
+
+    return NULL;
+}
+
+void oe_wake_switchless_host_workers(oe_switchless_manager_t* manager)
+{
+    if (manager->ocall_queue)
+        _event_wake(
+            &manager->host_workers_event, manager->num_host_workers, false);
+}
+
+/*
+**==============================================================================
+**
+** Enclave workers (switchless ECALLs):
+**
+**     Each enclave worker is a host thread that enters the enclave through
+**     oe_run_switchless_ecall_worker_ecall() and polls the ecall queue from
+**     inside the enclave. An idle enclave worker releases its core by making
+**     oe_sleep_switchless_ecall_worker_ocall(), which returns once a host
+**     caller wakes the enclave workers or the workers are stopped.
+**
+**==============================================================================
+*/
+
+static void* _enclave_worker(void* arg)
+{
+    oe_switchless_manager_t* manager = (oe_switchless_manager_t*)arg;
+    oe_result_t retval = OE_UNEXPECTED;
+    oe_result_t result;
+
+    result = oe_run_switchless_ecall_worker_ecall(
+        manager->enclave, &retval, manager);
+
+    if (result != OE_OK || retval != OE_OK)
+        OE_TRACE_ERROR(
+            "enclave worker exited: %s, %s",
+            oe_result_str(result),
+            oe_result_str(retval));
+
+    return NULL;
+}
+
+void oe_sleep_switchless_ecall_worker_ocall(void* context)
+{
+    oe_switchless_manager_t* manager = (oe_switchless_manager_t*)context;
+
+    _event_wait(&manager->enclave_workers_event, manager->ecall_queue);
+}
+
+/* Returns the index of an unclaimed ecall, or -1 if there is none */
+static int64_t _claim_ecall(oe_switchless_manager_t* manager)
+{
+    for (uint64_t i = 0; i < manager->ecall_queue->num_calls; i++)
+    {
+        if (manager->ecalls_claimed[i] == 0 &&
+            oe_atomic_compare_and_swap(&manager->ecalls_claimed[i], 0, 1))
+            return (int64_t)i;
+    }
+
+    return -1;
+}
+
+bool oe_post_switchless_ecall(
+    oe_switchless_manager_t* manager,
+    oe_call_enclave_function_args_t* args,
+    oe_result_t* dispatch_result)
+{
+    oe_switchless_queue_t* queue = manager->ecall_queue;
+    oe_switchless_ecall_t* call;
+    int64_t index = -1;
+    size_t spins = 0;
+
+    if (!queue)
+        return false;
+
+    if (oe_atomic_load(&queue->spinning_workers) == 0 ||
+        (index = _claim_ecall(manager)) < 0)
+        goto fallback;
+
+    call = (oe_switchless_ecall_t*)queue->calls + index;
+    call->args = *args;
+    call->result = OE_UNEXPECTED;
+    oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_POSTED);
+
+    if (!oe_switchless_ring_push(
+            &queue->tail, queue->cells, queue->capacity, call))
+        goto reclaim;
+
+    for (;;)
+    {
+        uint64_t state = oe_atomic_load(&call->state);
+
+        if (state == OE_SWITCHLESS_CALL_STATE_DONE)
+            break;
+
+        /* Reclaim the call if no worker has picked it up in time. The ring
+         * entry is left behind; enclave workers skip it since it is no
+         * longer in the posted state. */
+        if (state == OE_SWITCHLESS_CALL_STATE_POSTED &&
+            spins >= OE_SWITCHLESS_PICKUP_SPIN_COUNT &&
+            oe_atomic_compare_and_swap(
+                &call->state,
+                OE_SWITCHLESS_CALL_STATE_POSTED,
+                OE_SWITCHLESS_CALL_STATE_IDLE))
+        {
+            goto release;
+        }
+
+        /* Release the core while a long call is running */
+        if (++spins < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+            _cpu_relax();
+        else
+            _yield();
+    }
+
+    *args = call->args;
+    *dispatch_result = (oe_result_t)call->result;
+    oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_IDLE);
+    oe_atomic_store(&manager->ecalls_claimed[index], 0);
+    oe_atomic_increment(&queue->switchless_calls);
+
+    return true;
+
+reclaim:
+    oe_atomic_store(&call->state, OE_SWITCHLESS_CALL_STATE_IDLE);
+release:
+    oe_atomic_store(&manager->ecalls_claimed[index], 0);
+fallback:
+    oe_atomic_increment(&queue->fallback_calls);
+    _event_wake(
+        &manager->enclave_workers_event, manager->num_enclave_workers, false);
+
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** oe_start_switchless_manager()
+**
+**==============================================================================
+*/
+
+static void _free_queue(oe_switchless_queue_t* queue)
+{
+    if (queue)
+    {
+        oe_memalign_free(queue->calls);
+        oe_memalign_free(queue->cells);
+        oe_memalign_free(queue);
+    }
+}
+
+static void _free_manager(oe_switchless_manager_t* manager)
+{
+    _free_queue(manager->ocall_queue);
+    _free_queue(manager->ecall_queue);
+    _event_destroy(&manager->host_workers_event);
+    _event_destroy(&manager->enclave_workers_event);
+    free((void*)manager->ecalls_claimed);
+    free(manager->host_workers);
+    free(manager->enclave_workers);
+    free(manager);
+}
+
+static oe_result_t _new_queue(
+    size_t num_calls,
+    size_t call_size,
+    oe_switchless_queue_t** queue_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_queue_t* queue = NULL;
+    size_t capacity = 1;
+
+    /* The ring has room for each of the calls plus the stale entries left
+     * behind by calls reclaimed by their callers. */
+    while (capacity < 2 * num_calls)
+        capacity <<= 1;
+
+    if (!(queue = (oe_switchless_queue_t*)oe_memalign(64, sizeof(*queue))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(queue, 0, sizeof(*queue));
+
+    if (!(queue->cells = (oe_switchless_ring_cell_t*)oe_memalign(
+              64, capacity * sizeof(oe_switchless_ring_cell_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        queue->cells[i].sequence = i;
+        queue->cells[i].item = NULL;
+    }
+
+    queue->capacity = capacity;
+
+    if (!(queue->calls = oe_memalign(64, num_calls * call_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(queue->calls, 0, num_calls * call_size);
+    queue->num_calls = num_calls;
+
+    *queue_out = queue;
+    queue = NULL;
+    result = OE_OK;
+
+done:
+    _free_queue(queue);
+    return result;
+}
+
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    size_t num_host_workers,
+    size_t num_enclave_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager = NULL;
+
+    if (!enclave || (num_host_workers == 0 && num_enclave_workers == 0))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (enclave->switchless_manager)
+        OE_RAISE(OE_UNEXPECTED);
+
+    /* Enclave workers occupy their TCS for the lifetime of the enclave.
+     * Leave at least one TCS for ordinary ECALLs. */
+    if (num_enclave_workers >= enclave->num_bindings)
+        OE_RAISE_MSG(
+            OE_INVALID_PARAMETER,
+            "%zu enclave workers need more than %zu TCS",
+            num_enclave_workers,
+            enclave->num_bindings);
+
+    if (!(manager = (oe_switchless_manager_t*)calloc(1, sizeof(*manager))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    manager->enclave = enclave;
+
+    if (num_host_workers)
+    {
+        /* One call per enclave thread */
+        OE_CHECK(_new_queue(
+            enclave->num_bindings,
+            OE_SWITCHLESS_CALL_STRIDE,
+            &manager->ocall_queue));
+
+        if (!(manager->host_workers =
+                  (oe_thread*)calloc(num_host_workers, sizeof(oe_thread))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        OE_CHECK(_event_init(&manager->host_workers_event, num_host_workers));
+
+        OE_CHECK(oe_init_switchless_ocalls_ecall(
+            enclave, &retval, manager->ocall_queue));
+        OE_CHECK(retval);
+    }
+
+    if (num_enclave_workers)
+    {
+        OE_CHECK(_new_queue(
+            OE_SWITCHLESS_MAX_ECALLS,
+            sizeof(oe_switchless_ecall_t),
+            &manager->ecall_queue));
+
+        if (!(manager->ecalls_claimed = (volatile uint64_t*)calloc(
+                  OE_SWITCHLESS_MAX_ECALLS, sizeof(uint64_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        if (!(manager->enclave_workers =
+                  (oe_thread*)calloc(num_enclave_workers, sizeof(oe_thread))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        OE_CHECK(
+            _event_init(&manager->enclave_workers_event, num_enclave_workers));
+
+        OE_CHECK(oe_init_switchless_ecalls_ecall(
+            enclave, &retval, manager->ecall_queue));
+        OE_CHECK(retval);
+    }
+
+    enclave->switchless_manager = manager;
+
+    for (size_t i = 0; i < num_host_workers; i++)
+    {
+        if (oe_thread_create(&manager->host_workers[i], _host_worker, manager))
+            OE_RAISE_MSG(OE_FAILURE, "failed to start host worker %zu", i);
+
+        manager->num_host_workers++;
+    }
+
+    for (size_t i = 0; i < num_enclave_workers; i++)
+    {
+        if (oe_thread_create(
+                &manager->enclave_workers[i], _enclave_worker, manager))
+            OE_RAISE_MSG(OE_FAILURE, "failed to start enclave worker %zu", i);
+
+        manager->num_enclave_workers++;
+    }
+
+    manager = NULL;
+    result = OE_OK;
+
+done:
+
+    if (manager)
+    {
+        if (enclave && enclave->switchless_manager == manager)
+            oe_stop_switchless_manager(enclave);
+        else
+            _free_manager(manager);
+    }
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_switchless_enclave_workers()
+** oe_stop_switchless_manager()
+**
+**==============================================================================
+*/
+
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave)
+{
+    oe_switchless_manager_t* manager = enclave->switchless_manager;
+
+    if (!manager || !manager->ecall_queue)
+        return;
+
+    oe_atomic_store(&manager->ecall_queue->stopping, 1);
+    _event_wake(
+        &manager->enclave_workers_event, manager->num_enclave_workers, true);
+
+    for (size_t i = 0; i < manager->num_enclave_workers; i++)
+        oe_thread_join(manager->enclave_workers[i]);
+
+    manager->num_enclave_workers = 0;
+}
+
+void oe_stop_switchless_manager(oe_enclave_t* enclave)
+{
+    oe_switchless_manager_t* manager = enclave->switchless_manager;
+
+    if (!manager)
+        return;
+
+    oe_stop_switchless_enclave_workers(enclave);
+
+    if (manager->ocall_queue)
+    {
+        oe_atomic_store(&manager->ocall_queue->stopping, 1);
+        _event_wake(
+            &manager->host_workers_event, manager->num_host_workers, true);
+
+        for (size_t i = 0; i < manager->num_host_workers; i++)
+            oe_thread_join(manager->host_workers[i]);
+    }
+
+    enclave->switchless_manager = NULL;
+    _free_manager(manager);
+}
+
+/*
+**==============================================================================
+**
+** oe_get_switchless_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager;
+
+    if (!enclave || !stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memset(stats, 0, sizeof(*stats));
+
+    if ((manager = enclave->switchless_manager))
+    {
+        if (manager->ecall_queue)
+        {
+            stats->switchless_ecalls = manager->ecall_queue->switchless_calls;
+            stats->fallback_ecalls = manager->ecall_queue->fallback_calls;
+        }
+
+        if (manager->ocall_queue)
+        {
+            stats->switchless_ocalls = manager->ocall_queue->switchless_calls;
+            stats->fallback_ocalls = manager->ocall_queue->fallback_calls;
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SWITCHLESS_H
+#define _OE_HOST_SWITCHLESS_H
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/host.h>
+#include <openenclave/internal/switchless.h>
+#include "../hostthread.h"
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** oe_switchless_event_t:
+**
+**     Event that idle workers of one kind sleep on until there is work.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_event
+{
+    /* Number of workers sleeping on the event */
+    volatile uint64_t sleepers;
+
+#if defined(__linux__)
+    volatile uint32_t word;
+#elif defined(_WIN32)
+    HANDLE handle;
+#endif
+} oe_switchless_event_t;
+
+/*
+**==============================================================================
+**
+** oe_switchless_manager_t:
+**
+**     Host-side state of the switchless call machinery of an enclave. The
+**     queues (and the calls and ring cells they refer to) are shared with
+**     the enclave; everything else is private to the host.
+**
+**==============================================================================
+*/
+
+struct _oe_switchless_manager
+{
+    oe_enclave_t* enclave;
+
+    /* Switchless OCALLs: queue and the host workers polling it */
+    oe_switchless_queue_t* ocall_queue;
+    oe_thread* host_workers;
+    size_t num_host_workers;
+    oe_switchless_event_t host_workers_event;
+
+    /* Switchless ECALLs: queue and the host threads that run the enclave
+     * workers polling it */
+    oe_switchless_queue_t* ecall_queue;
+    oe_thread* enclave_workers;
+    size_t num_enclave_workers;
+    oe_switchless_event_t enclave_workers_event;
+
+    /* Claims of the calls of ecall_queue by host callers (host only) */
+    volatile uint64_t* ecalls_claimed;
+};
+
+/* Start the workers and register the queues with the enclave */
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    size_t num_host_workers,
+    size_t num_enclave_workers);
+
+/* Stop the enclave workers so that no thread remains inside the enclave */
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave);
+
+/* Stop all workers and release the switchless manager */
+void oe_stop_switchless_manager(oe_enclave_t* enclave);
+
+/* Wake any host workers that went to sleep for lack of work */
+void oe_wake_switchless_host_workers(oe_switchless_manager_t* manager);
+
+/* Have an enclave worker carry out the call described by args. Returns false,
+ * without making the call, if the call must be made as an ordinary ECALL */
+bool oe_post_switchless_ecall(
+    oe_switchless_manager_t* manager,
+    oe_call_enclave_function_args_t* args,
+    oe_result_t* dispatch_result);
+
+/* Dispatch an oe_call_host_function_args_t to the host function tables */
+oe_result_t oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SWITCHLESS_H */
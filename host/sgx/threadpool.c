@@ -0,0 +1,395 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/trace.h>
+#include "../hostthread.h"
+#include "enclave.h"
+#include "internal_u.h"
+#include "threadpool.h"
+
+/*
+**==============================================================================
+**
+** Thread pool:
+**
+**     The host threads that run the threads started by the enclave with
+**     oe_start_thread_ocall(). Each worker binds itself to a TCS when it
+**     starts and keeps it until the pool is stopped, so that the enclave
+**     can count on a TCS for each thread it starts. An idle worker sleeps
+**     until it is given an enclave thread, which it runs by making
+**     oe_run_thread_ecall().
+**
+**     oe_start_thread_ocall() and oe_start_thread_pool() block on the
+**     condition variable of the pool until a worker becomes idle or ready.
+**
+**==============================================================================
+*/
+
+#define WORKER_STARTING 0
+#define WORKER_READY 1
+#define WORKER_FAILED 2
+
+typedef struct _oe_thread_pool_worker
+{
+    oe_thread_pool_t* pool;
+    oe_thread thread;
+
+    /* WORKER_STARTING until the worker has a TCS (or failed to get one) */
+    volatile uint64_t state;
+
+    /* The enclave thread to run (zero while the worker is idle) */
+    volatile uint64_t job;
+
+#if defined(__linux__)
+    volatile uint32_t word;
+#elif defined(_WIN32)
+    HANDLE event;
+#endif
+} oe_thread_pool_worker_t;
+
+struct _oe_thread_pool
+{
+    oe_enclave_t* enclave;
+    oe_thread_pool_worker_t* workers;
+    size_t num_workers;
+    volatile uint64_t stopping;
+
+    /* Broadcast whenever a worker changes state, finishes running an
+     * enclave thread, or the pool stops */
+#if defined(__linux__)
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+#elif defined(_WIN32)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE changed;
+#endif
+};
+
+static bool _init_pool_lock(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    if (pthread_mutex_init(&pool->lock, NULL))
+        return false;
+
+    if (pthread_cond_init(&pool->changed, NULL))
+    {
+        pthread_mutex_destroy(&pool->lock);
+        return false;
+    }
+#elif defined(_WIN32)
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->changed);
+#endif
+    return true;
+}
+
+static void _destroy_pool_lock(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    pthread_cond_destroy(&pool->changed);
+    pthread_mutex_destroy(&pool->lock);
+#elif defined(_WIN32)
+    DeleteCriticalSection(&pool->lock);
+#endif
+}
+
+static void _lock_pool(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    pthread_mutex_lock(&pool->lock);
+#elif defined(_WIN32)
+    EnterCriticalSection(&pool->lock);
+#endif
+}
+
+static void _unlock_pool(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    pthread_mutex_unlock(&pool->lock);
+#elif defined(_WIN32)
+    LeaveCriticalSection(&pool->lock);
+#endif
+}
+
+/* Wait for a change of the pool, with its lock held */
+static void _wait_pool(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    pthread_cond_wait(&pool->changed, &pool->lock);
+#elif defined(_WIN32)
+    SleepConditionVariableCS(&pool->changed, &pool->lock, INFINITE);
+#endif
+}
+
+static void _broadcast_pool(oe_thread_pool_t* pool)
+{
+#if defined(__linux__)
+    pthread_cond_broadcast(&pool->changed);
+#elif defined(_WIN32)
+    WakeAllConditionVariable(&pool->changed);
+#endif
+}
+
+/* Set a field of a worker and tell the threads waiting on the pool */
+static void _set_worker_field(
+    oe_thread_pool_t* pool,
+    volatile uint64_t* field,
+    uint64_t value)
+{
+    _lock_pool(pool);
+    oe_atomic_store(field, value);
+    _broadcast_pool(pool);
+    _unlock_pool(pool);
+}
+
+/* Sleep until the worker is given an enclave thread or the pool stops */
+static void _worker_wait(oe_thread_pool_worker_t* worker)
+{
+#if defined(__linux__)
+    uint32_t word = worker->word;
+
+    if (!oe_atomic_load(&worker->job) &&
+        !oe_atomic_load(&worker->pool->stopping))
+    {
+        syscall(
+            __NR_futex, &worker->word, FUTEX_WAIT_PRIVATE, word, NULL, NULL, 0);
+    }
+#elif defined(_WIN32)
+    if (!oe_atomic_load(&worker->job) &&
+        !oe_atomic_load(&worker->pool->stopping))
+    {
+        WaitForSingleObject(worker->event, INFINITE);
+    }
+#endif
+}
+
+static void _worker_wake(oe_thread_pool_worker_t* worker)
+{
+#if defined(__linux__)
+    __sync_fetch_and_add(&worker->word, 1);
+    syscall(__NR_futex, &worker->word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif defined(_WIN32)
+    SetEvent(worker->event);
+#endif
+}
+
+static void* _worker(void* arg)
+{
+    oe_thread_pool_worker_t* worker = (oe_thread_pool_worker_t*)arg;
+    oe_thread_pool_t* pool = worker->pool;
+    void* tcs;
+
+    if (!(tcs = oe_bind_thread(pool->enclave)))
+    {
+        _set_worker_field(pool, &worker->state, WORKER_FAILED);
+        return NULL;
+    }
+
+    _set_worker_field(pool, &worker->state, WORKER_READY);
+
+    for (;;)
+    {
+        uint64_t job = oe_atomic_load(&worker->job);
+
+        if (job)
+        {
+            oe_result_t retval = OE_UNEXPECTED;
+            oe_result_t result;
+
+            result = oe_run_thread_ecall(pool->enclave, &retval, (void*)job);
+
+            if (result != OE_OK || retval != OE_OK)
+                OE_TRACE_ERROR(
+                    "enclave thread failed: %s, %s",
+                    oe_result_str(result),
+                    oe_result_str(retval));
+
+            _set_worker_field(pool, &worker->job, 0);
+        }
+        else if (oe_atomic_load(&pool->stopping))
+        {
+            break;
+        }
+        else
+        {
+            _worker_wait(worker);
+        }
+    }
+
+    oe_unbind_thread(pool->enclave, tcs);
+
+    return NULL;
+}
+
+oe_result_t oe_start_thread_ocall(void* context, void* thread)
+{
+    oe_thread_pool_t* pool = (oe_thread_pool_t*)context;
+
+    if (!pool || !thread)
+        return OE_INVALID_PARAMETER;
+
+    /* The enclave starts no more threads than there are workers, but the
+     * worker that ran a finished thread may not have left the enclave yet */
+    _lock_pool(pool);
+
+    while (!oe_atomic_load(&pool->stopping))
+    {
+        for (size_t i = 0; i < pool->num_workers; i++)
+        {
+            oe_thread_pool_worker_t* worker = &pool->workers[i];
+
+            if (oe_atomic_load(&worker->job) == 0)
+            {
+                oe_atomic_store(&worker->job, (uint64_t)thread);
+                _unlock_pool(pool);
+                _worker_wake(worker);
+                return OE_OK;
+            }
+        }
+
+        _wait_pool(pool);
+    }
+
+    _unlock_pool(pool);
+    return OE_UNEXPECTED;
+}
+
+/*
+**==============================================================================
+**
+** oe_start_thread_pool()
+** oe_stop_thread_pool()
+**
+**==============================================================================
+*/
+
+static void _stop_pool(oe_thread_pool_t* pool)
+{
+    _lock_pool(pool);
+    oe_atomic_store(&pool->stopping, 1);
+    _broadcast_pool(pool);
+    _unlock_pool(pool);
+
+    for (size_t i = 0; i < pool->num_workers; i++)
+        _worker_wake(&pool->workers[i]);
+
+    for (size_t i = 0; i < pool->num_workers; i++)
+        oe_thread_join(pool->workers[i].thread);
+
+#if defined(_WIN32)
+    for (size_t i = 0; i < pool->num_workers; i++)
+        CloseHandle(pool->workers[i].event);
+#endif
+
+    _destroy_pool_lock(pool);
+    free(pool->workers);
+    free(pool);
+}
+
+oe_result_t oe_start_thread_pool(oe_enclave_t* enclave, size_t max_threads)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+    oe_thread_pool_t* pool = NULL;
+
+    if (!enclave || max_threads == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (enclave->thread_pool)
+        OE_RAISE(OE_UNEXPECTED);
+
+    if (!(pool = (oe_thread_pool_t*)calloc(1, sizeof(*pool))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (!_init_pool_lock(pool))
+    {
+        free(pool);
+        pool = NULL;
+        OE_RAISE(OE_FAILURE);
+    }
+
+    pool->enclave = enclave;
+
+    if (!(pool->workers = (oe_thread_pool_worker_t*)calloc(
+              max_threads, sizeof(oe_thread_pool_worker_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < max_threads; i++)
+    {
+        oe_thread_pool_worker_t* worker = &pool->workers[i];
+
+        worker->pool = pool;
+
+#if defined(_WIN32)
+        if (!(worker->event = CreateEvent(NULL, FALSE, FALSE, NULL)))
+            OE_RAISE_MSG(OE_FAILURE, "CreateEvent failed", NULL);
+#endif
+
+        if (oe_thread_create(&worker->thread, _worker, worker))
+        {
+#if defined(_WIN32)
+            CloseHandle(worker->event);
+#endif
+            OE_RAISE_MSG(OE_FAILURE, "failed to start pool thread %zu", i);
+        }
+
+        pool->num_workers++;
+    }
+
+    /* Wait until each worker holds its TCS */
+    for (size_t i = 0; i < pool->num_workers; i++)
+    {
+        oe_thread_pool_worker_t* worker = &pool->workers[i];
+        uint64_t state;
+
+        _lock_pool(pool);
+
+        while ((state = oe_atomic_load(&worker->state)) == WORKER_STARTING)
+            _wait_pool(pool);
+
+        _unlock_pool(pool);
+
+        if (state == WORKER_FAILED)
+            OE_RAISE_MSG(
+                OE_OUT_OF_THREADS, "no TCS left for pool thread %zu", i);
+    }
+
+    OE_CHECK(oe_init_thread_pool_ecall(enclave, &retval, pool, max_threads));
+    OE_CHECK(retval);
+
+    enclave->thread_pool = pool;
+    pool = NULL;
+    result = OE_OK;
+
+done:
+
+    if (pool)
+        _stop_pool(pool);
+
+    return result;
+}
+
+void oe_stop_thread_pool(oe_enclave_t* enclave)
+{
+    oe_thread_pool_t* pool = enclave->thread_pool;
+
+    if (!pool)
+        return;
+
+    enclave->thread_pool = NULL;
+    _stop_pool(pool);
+}
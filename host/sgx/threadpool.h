@@ -0,0 +1,17 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_THREADPOOL_H
+#define _OE_HOST_THREADPOOL_H
+
+#include <openenclave/host.h>
+#include "enclave.h"
+
+/* Start the host threads that run the threads started by the enclave. Each
+ * of them holds a TCS of the enclave until the pool is stopped */
+oe_result_t oe_start_thread_pool(oe_enclave_t* enclave, size_t max_threads);
+
+/* Wait for the enclave threads being run to return and stop the pool */
+void oe_stop_thread_pool(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_THREADPOOL_H */
@@ -23,6 +23,100 @@ int oe_thread_equal(oe_thread thread1, oe_thread thread2)
     return thread1 == thread2;
 }
 
+typedef struct _thread_start_args
+{
+    void* (*func)(void*);
+    void* arg;
+} thread_start_args_t;
+
+static DWORD WINAPI _thread_start(LPVOID param)
+{
+    thread_start_args_t args = *(thread_start_args_t*)param;
+
+    free(param);
+    args.func(args.arg);
+    return 0;
+}
+
+/* Handles of the threads created by oe_thread_create(). Each stays open
+ * until oe_thread_join(), which waits on it: a thread identifier may be
+ * reused once its thread has exited and all its handles are closed */
+typedef struct _thread_handle
+{
+    DWORD id;
+    HANDLE handle;
+    struct _thread_handle* next;
+} thread_handle_t;
+
+static thread_handle_t* _thread_handles;
+static SRWLOCK _thread_handles_lock = SRWLOCK_INIT;
+
+int oe_thread_create(oe_thread* thread, void* (*func)(void*), void* arg)
+{
+    thread_start_args_t* args = NULL;
+    thread_handle_t* entry = NULL;
+
+    if (!thread || !func)
+        return -1;
+
+    if (!(args = (thread_start_args_t*)malloc(sizeof(*args))))
+        return -1;
+
+    if (!(entry = (thread_handle_t*)malloc(sizeof(*entry))))
+    {
+        free(args);
+        return -1;
+    }
+
+    args->func = func;
+    args->arg = arg;
+
+    if (!(entry->handle =
+              CreateThread(NULL, 0, _thread_start, args, 0, &entry->id)))
+    {
+        free(entry);
+        free(args);
+        return -1;
+    }
+
+    AcquireSRWLockExclusive(&_thread_handles_lock);
+    entry->next = _thread_handles;
+    _thread_handles = entry;
+    ReleaseSRWLockExclusive(&_thread_handles_lock);
+
+    *thread = entry->id;
+    return 0;
+}
+
+int oe_thread_join(oe_thread thread)
+{
+    thread_handle_t** link;
+    thread_handle_t* entry = NULL;
+
+    AcquireSRWLockExclusive(&_thread_handles_lock);
+
+    for (link = &_thread_handles; *link; link = &(*link)->next)
+    {
+        if ((*link)->id == thread)
+        {
+            entry = *link;
+            *link = entry->next;
+            break;
+        }
+    }
+
+    ReleaseSRWLockExclusive(&_thread_handles_lock);
+
+    /* Not created by oe_thread_create() or already joined */
+    if (!entry)
+        return -1;
+
+    WaitForSingleObject(entry->handle, INFINITE);
+    CloseHandle(entry->handle);
+    free(entry);
+    return 0;
+}
+
 /*
 **==============================================================================
 **
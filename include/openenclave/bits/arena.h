@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file arena.h
+ *
+ * This file defines the arena allocator of enclaves, which serves the
+ * short-lived allocations of a request from one block of memory that is
+ * released all at once.
+ *
+ */
+#ifndef _OE_BITS_ARENA_H
+#define _OE_BITS_ARENA_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Alignment of the allocations of **oe_arena_alloc()**.
+ */
+#define OE_ARENA_ALIGNMENT 16
+
+/**
+ * Size of the arena of each enclave thread returned by
+ * **oe_get_thread_arena()**.
+ */
+#define OE_THREAD_ARENA_SIZE (64 * 1024)
+
+/**
+ * An arena: a block of memory from which allocations are carved in order,
+ * and released all together by **oe_arena_reset()** or
+ * **oe_arena_destroy()**.
+ *
+ * The fields of this structure are private. An arena is not thread safe:
+ * each arena must be used by one thread at a time.
+ */
+typedef struct _oe_arena
+{
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    uint64_t owned;
+} oe_arena_t;
+
+/**
+ * Create an arena from a block of the enclave heap.
+ *
+ * @param arena The arena to initialize.
+ * @param size The number of bytes that can be allocated from the arena.
+ *
+ * @retval OE_OK The arena was created.
+ * @retval OE_INVALID_PARAMETER **arena** is null or **size** is zero.
+ * @retval OE_OUT_OF_MEMORY The block of the arena could not be allocated.
+ */
+oe_result_t oe_arena_create(oe_arena_t* arena, size_t size);
+
+/**
+ * Create an arena from a buffer provided by the caller, such as an array on
+ * the stack. The buffer must outlive the arena.
+ *
+ * @param arena The arena to initialize.
+ * @param buffer The buffer that allocations are carved from.
+ * @param size The size of **buffer** in bytes.
+ *
+ * @retval OE_OK The arena was created.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ */
+oe_result_t oe_arena_create_from_buffer(
+    oe_arena_t* arena,
+    void* buffer,
+    size_t size);
+
+/**
+ * Allocate bytes from an arena.
+ *
+ * The allocation is aligned on **OE_ARENA_ALIGNMENT** bytes. It cannot be
+ * freed by itself: it lasts until the arena is reset or destroyed.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ *
+ * @returns The allocated bytes, or null if the arena does not have **size**
+ * bytes left.
+ */
+void* oe_arena_alloc(oe_arena_t* arena, size_t size);
+
+/**
+ * Allocate bytes with a given alignment from an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param alignment The alignment of the allocation, a power of two.
+ * @param size The number of bytes to allocate.
+ *
+ * @returns The allocated bytes, or null if **alignment** is not a power of
+ * two or the arena does not have **size** bytes left at that alignment.
+ */
+void* oe_arena_memalign(oe_arena_t* arena, size_t alignment, size_t size);
+
+/**
+ * Release all the allocations of an arena, which can then be allocated from
+ * again. This takes constant time.
+ *
+ * @param arena The arena to reset.
+ */
+void oe_arena_reset(oe_arena_t* arena);
+
+/**
+ * Release an arena and the block of the enclave heap it was created from,
+ * if any. This takes constant time.
+ *
+ * @param arena The arena to destroy.
+ */
+void oe_arena_destroy(oe_arena_t* arena);
+
+/**
+ * Get the arena of the calling enclave thread.
+ *
+ * Each thread (TCS) of an SGX enclave has an arena of
+ * **OE_THREAD_ARENA_SIZE** bytes, created the first time this function is
+ * called on the thread. The arena is reset when the outermost ECALL made on
+ * the thread returns, so it serves allocations that last no longer than the
+ * ECALL, such as those needed to handle a request. Code that resets the
+ * arena must make sure none of its callers still uses it.
+ *
+ * @returns The arena of the thread, or null if it could not be created or
+ * the enclave type does not support thread arenas.
+ */
+oe_arena_t* oe_get_thread_arena(void);
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_ARENA_H */
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file arena_resource.h
+ *
+ * This file defines oe::arena_resource, a polymorphic memory resource of
+ * libcxx that allocates from an arena (see arena.h), so that the containers
+ * of std::experimental::pmr can allocate from an arena. Enclaves that use
+ * it must link against oelibcxx.
+ *
+ */
+#ifndef _OE_BITS_ARENA_RESOURCE_H
+#define _OE_BITS_ARENA_RESOURCE_H
+
+#include <openenclave/bits/arena.h>
+#include <experimental/memory_resource>
+
+namespace oe
+{
+/**
+ * A memory resource that allocates from an arena, and from an upstream
+ * resource once the arena is exhausted.
+ *
+ * Deallocating memory of the arena does nothing: it is released when the
+ * arena is reset or destroyed, which must not happen while containers still
+ * use it. Memory of the upstream resource is deallocated to that resource.
+ */
+class arena_resource : public std::experimental::pmr::memory_resource
+{
+  public:
+    /**
+     * Create a resource that allocates from **arena**, then from
+     * **upstream**, which throws std::bad_alloc by default.
+     */
+    explicit arena_resource(
+        oe_arena_t* arena,
+        std::experimental::pmr::memory_resource* upstream =
+            std::experimental::pmr::null_memory_resource())
+        : _arena(arena), _upstream(upstream)
+    {
+    }
+
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+
+    oe_arena_t* arena() const
+    {
+        return _arena;
+    }
+
+    std::experimental::pmr::memory_resource* upstream_resource() const
+    {
+        return _upstream;
+    }
+
+  protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* p = oe_arena_memalign(_arena, alignment, bytes);
+
+        return p ? p : _upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        const uint8_t* q = static_cast<const uint8_t*>(p);
+
+        if (q < _arena->base || q >= _arena->base + _arena->size)
+            _upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::experimental::pmr::memory_resource& other) const
+        noexcept override
+    {
+        return this == &other;
+    }
+
+  private:
+    oe_arena_t* _arena;
+    std::experimental::pmr::memory_resource* _upstream;
+};
+} // namespace oe
+
+#endif /* _OE_BITS_ARENA_RESOURCE_H */
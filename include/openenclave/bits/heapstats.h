@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file heapstats.h
+ *
+ * This file defines the statistics of the heap of an enclave, which help
+ * size the heap (the NumHeapPages enclave property) from its actual use.
+ *
+ */
+#ifndef _OE_BITS_HEAPSTATS_H
+#define _OE_BITS_HEAPSTATS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Number of size classes of the allocation histogram of oe_heap_stats_t.
+ */
+#define OE_HEAP_STATS_NUM_SIZE_CLASSES 24
+
+/**
+ * Statistics of the heap of an enclave, as returned by
+ * **oe_get_heap_stats()** in the enclave and **oe_get_enclave_heap_stats()**
+ * on the host.
+ *
+ * The heap is a fixed region of the enclave, of which the allocator obtains
+ * the pages it needs with oe_sbrk(). The pages beyond the peak break were
+ * never used, so a heap of **peak_sbrk_bytes** (plus a margin) would have
+ * served the same workload.
+ */
+typedef struct _oe_heap_stats
+{
+    /** Size of the heap in bytes (the NumHeapPages property in bytes). */
+    uint64_t heap_size;
+
+    /** Bytes of the heap currently obtained with oe_sbrk(). */
+    uint64_t sbrk_bytes;
+
+    /** Largest value of **sbrk_bytes** since the enclave was created. */
+    uint64_t peak_sbrk_bytes;
+
+    /** Bytes in allocated blocks, including the overhead of the allocator
+     * and the blocks held by the thread caches of the allocator. */
+    uint64_t in_use_bytes;
+
+    /** Bytes in free blocks, including **top_free_bytes**. */
+    uint64_t free_bytes;
+
+    /** Bytes of the free block at the end of the heap, which can be handed
+     * back with oe_sbrk(). */
+    uint64_t top_free_bytes;
+
+    /** Number of free blocks. */
+    uint64_t free_blocks;
+
+    /**
+     * Percentage of the free bytes that lie in free blocks other than the
+     * block at the end of the heap: **(free_bytes - top_free_bytes) * 100 /
+     * free_bytes**, or 0 if no bytes are free.
+     */
+    uint64_t fragmentation;
+
+    /** Number of allocations, including calls to realloc(). */
+    uint64_t allocations;
+
+    /** Number of blocks freed, including blocks resized by realloc(). */
+    uint64_t frees;
+
+    /** Number of allocations that failed. */
+    uint64_t failures;
+
+    /**
+     * Histogram of the allocation sizes: element 0 counts the allocations of
+     * at most 16 bytes, element i the allocations of (8 << i) + 1 up to
+     * 16 << i bytes, and the last element all the larger allocations.
+     */
+    uint64_t size_classes[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+} oe_heap_stats_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_HEAPSTATS_H */
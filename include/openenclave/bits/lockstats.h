@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file lockstats.h
+ *
+ * This file defines the statistics of the lock contention profiler, which
+ * counts how the synchronization primitives of an enclave are contended.
+ *
+ */
+#ifndef _OE_BITS_LOCKSTATS_H
+#define _OE_BITS_LOCKSTATS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Types of the locks profiled by the lock contention profiler.
+ */
+typedef enum _oe_lock_type
+{
+    OE_LOCK_TYPE_MUTEX = 1,
+    OE_LOCK_TYPE_COND = 2,
+    OE_LOCK_TYPE_RWLOCK = 3,
+    OE_LOCK_TYPE_SPINLOCK = 4,
+    __OE_LOCK_TYPE_MAX = OE_ENUM_MAX,
+} oe_lock_type_t;
+
+/**
+ * Largest number of locks that the profiler of an enclave keeps statistics
+ * for. The operations on further locks are not counted.
+ */
+#define OE_LOCK_STATS_MAX_LOCKS 1024
+
+/**
+ * Statistics of one lock of an enclave, as returned by
+ * **oe_get_enclave_lock_stats()**.
+ *
+ * Addresses are offsets from the base of the enclave image, which can be
+ * resolved against the enclave binary (with addr2line for instance).
+ */
+typedef struct _oe_lock_stats
+{
+    /** The type of the lock. */
+    oe_lock_type_t type;
+
+    /** The offset of the lock. */
+    uint64_t lock;
+
+    /** The return address of the first operation on the lock. */
+    uint64_t caller;
+
+    /**
+     * Number of acquisitions (of waits for condition variables), including
+     * timed waits that timed out. For readers-writer locks, read and write
+     * locks are counted together.
+     */
+    uint64_t acquisitions;
+
+    /** Number of acquisitions that found the lock held or had to wait. */
+    uint64_t contended;
+
+    /** Number of pause iterations spun while waiting for the lock. */
+    uint64_t spins;
+
+    /** Number of times a waiting thread was parked in the host. */
+    uint64_t parks;
+
+    /** Total time spent parked in the host, in nanoseconds. */
+    uint64_t wait_ns;
+} oe_lock_stats_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_LOCKSTATS_H */
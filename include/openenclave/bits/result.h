@@ -284,6 +284,11 @@ typedef enum _oe_result
      */
     OE_CRYPTO_ERROR,
 
+    /**
+     * The operation did not complete before its deadline.
+     */
+    OE_TIMEOUT,
+
     __OE_RESULT_MAX = OE_ENUM_MAX,
 } oe_result_t;
 /**< typedef enum _oe_result oe_result_t*/
@@ -25,8 +25,15 @@ typedef struct _oe_sgx_enclave_image_info_t
     uint64_t enclave_size;
 } oe_sgx_enclave_image_info_t;
 
-/* Max number of threads in an enclave supported */
-#define OE_SGX_MAX_TCS 32
+/* Max number of threads in an enclave supported. The host sizes the
+ * per-thread state of an enclave from its actual number of TCSs, so this is
+ * only a sanity limit on the signed enclave properties. */
+#define OE_SGX_MAX_TCS 4096
+
+/* The number of pause iterations a thread spends spinning on a contended
+ * mutex or condition variable before waiting in the host, if the enclave
+ * properties do not set lock_spin_count */
+#define OE_SGX_DEFAULT_LOCK_SPIN_COUNT 2048
 
 // oe_sgx_enclave_properties_t SGX enclave properties derived type
 #define OE_SGX_FLAGS_DEBUG 0x0000000000000002ULL
@@ -38,8 +45,11 @@ typedef struct oe_sgx_enclave_config_t
     uint16_t product_id;
     uint16_t security_version;
 
-    /* Padding to make packed and unpacked size the same */
-    uint32_t padding;
+    /* Number of pause iterations a thread spins on a contended mutex or
+     * condition variable before waiting in the host (0 selects
+     * OE_SGX_DEFAULT_LOCK_SPIN_COUNT). Also makes packed and unpacked size
+     * the same */
+    uint32_t lock_spin_count;
 
     /* (OE_SGX_FLAGS_DEBUG | OE_SGX_FLAGS_MODE64BIT) */
     uint64_t attributes;
@@ -123,7 +133,7 @@ typedef struct _oe_sgx_enclave_properties
         {                                                                 \
             .product_id = PRODUCT_ID,                                     \
             .security_version = SECURITY_VERSION,                         \
-            .padding = 0,                                                 \
+            .lock_spin_count = 0,                                         \
             .attributes = OE_MAKE_ATTRIBUTES(ALLOW_DEBUG)                 \
         },                                                                \
         .image_info =                                                     \
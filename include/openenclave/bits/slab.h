@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file slab.h
+ *
+ * This file defines the slab allocator of enclaves, which serves objects of
+ * one type from per-thread magazines of free objects.
+ *
+ */
+#ifndef _OE_BITS_SLAB_H
+#define _OE_BITS_SLAB_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Maximum number of slab caches whose objects are cached per thread. The
+ * objects of the caches used beyond that number are allocated and freed
+ * under the lock of their cache.
+ */
+#define OE_SLAB_MAX_CACHES 64
+
+/**
+ * Largest object size of a slab cache.
+ */
+#define OE_SLAB_MAX_OBJECT_SIZE (16 * 1024)
+
+/**
+ * Largest object alignment of a slab cache.
+ */
+#define OE_SLAB_MAX_ALIGNMENT 4096
+
+/**
+ * A slab cache: a source of objects of one size and alignment, typically
+ * those of one type.
+ *
+ * Each enclave thread keeps the objects it frees in magazines of its own,
+ * from which it allocates again without taking any lock. Magazines are
+ * exchanged, full or empty, with a depot shared by the threads, and the
+ * objects themselves are carved from slabs of the enclave heap. The memory
+ * of a cache is only returned to the heap by **oe_slab_cache_destroy()**.
+ *
+ * The fields of this structure are private. A cache is thread safe.
+ */
+typedef struct _oe_slab_cache
+{
+    size_t object_size;
+    size_t alignment;
+    uint64_t index;
+    uint64_t generation;
+    volatile uint32_t lock;
+    void* free_objects;
+    void* slabs;
+    void* full_magazines;
+    void* empty_magazines;
+    void* magazines;
+} oe_slab_cache_t;
+
+/**
+ * Static initializer of a slab cache of objects of the given type, for
+ * caches that live as long as the enclave. For example:
+ *
+ *     static oe_slab_cache_t _cache = OE_SLAB_CACHE_INITIALIZER(my_type_t);
+ */
+#define OE_SLAB_CACHE_INITIALIZER(TYPE)                                   \
+    {                                                                     \
+        sizeof(TYPE), __alignof__(TYPE), 0, 0, 0, NULL, NULL, NULL, NULL, \
+            NULL                                                          \
+    }
+
+/**
+ * Initialize a slab cache.
+ *
+ * @param cache The cache to initialize.
+ * @param object_size The size of its objects, at most
+ * **OE_SLAB_MAX_OBJECT_SIZE**.
+ * @param alignment The alignment of its objects, a power of two no larger
+ * than **OE_SLAB_MAX_ALIGNMENT**.
+ *
+ * @retval OE_OK The cache was initialized.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ */
+oe_result_t oe_slab_cache_init(
+    oe_slab_cache_t* cache,
+    size_t object_size,
+    size_t alignment);
+
+/**
+ * Allocate an object from a slab cache.
+ *
+ * The contents of the object are undefined: it may have been freed by
+ * another thread. Allocations from the magazines of the calling thread take
+ * constant time and no lock.
+ *
+ * @param cache The cache to allocate from.
+ *
+ * @returns The object, or null if **cache** is null or invalid or the
+ * enclave heap is exhausted.
+ */
+void* oe_slab_alloc(oe_slab_cache_t* cache);
+
+/**
+ * Allocate a zero-filled object from a slab cache.
+ *
+ * This is **oe_slab_alloc()** followed by the clearing of the whole object.
+ *
+ * @param cache The cache to allocate from.
+ *
+ * @returns The object, or null if **cache** is null or invalid or the
+ * enclave heap is exhausted.
+ */
+void* oe_slab_calloc(oe_slab_cache_t* cache);
+
+/**
+ * Free an object allocated from a slab cache.
+ *
+ * The object is kept by the magazines of the calling thread, whichever
+ * thread allocated it. This takes constant time.
+ *
+ * @param cache The cache the object was allocated from.
+ * @param object The object to free. Nothing is done if it is null.
+ */
+void oe_slab_free(oe_slab_cache_t* cache, void* object);
+
+/**
+ * Release all the objects of a slab cache and return its memory to the
+ * enclave heap.
+ *
+ * No thread may use the cache or its objects meanwhile. The cache can be
+ * allocated from again afterwards.
+ *
+ * @param cache The cache to destroy.
+ */
+void oe_slab_cache_destroy(oe_slab_cache_t* cache);
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_SLAB_H */
@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/**
+ * @file stackusage.h
+ *
+ * This file defines the stack usage of the threads of an enclave, which
+ * helps size the stacks (the NumStackPages enclave property) from their
+ * actual use.
+ *
+ */
+#ifndef _OE_BITS_STACKUSAGE_H
+#define _OE_BITS_STACKUSAGE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * The stack usage of one thread control structure (TCS) of an enclave, as
+ * returned by **oe_get_stack_usage()** in the enclave and
+ * **oe_get_enclave_stack_usage()** on the host.
+ *
+ * The stack pages of each TCS are filled with a known pattern when the
+ * enclave is created. The peak usage is the distance from the top of the
+ * stack to the deepest word that no longer holds the pattern, so it covers
+ * every thread that ran on the TCS since the enclave was created. Stack
+ * memory that was reserved but never written, such as the unused part of
+ * a large local array, is not counted.
+ */
+typedef struct _oe_stack_usage
+{
+    /** Address of the TCS, as an offset from the base of the enclave. */
+    uint64_t tcs;
+
+    /** Size of the stack in bytes (the NumStackPages property in bytes). */
+    uint64_t stack_size;
+
+    /** Most bytes of the stack used since the enclave was created. */
+    uint64_t peak_bytes;
+} oe_stack_usage_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_STACKUSAGE_H */
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_BITS_PTHREAD_BARRIER_H
+#define _OE_BITS_PTHREAD_BARRIER_H
+
+OE_INLINE
+int pthread_barrierattr_init(pthread_barrierattr_t* attr)
+{
+    return oe_pthread_barrierattr_init((oe_pthread_barrierattr_t*)attr);
+}
+
+OE_INLINE
+int pthread_barrierattr_destroy(pthread_barrierattr_t* attr)
+{
+    return oe_pthread_barrierattr_destroy((oe_pthread_barrierattr_t*)attr);
+}
+
+OE_INLINE
+int pthread_barrier_init(
+    pthread_barrier_t* barrier,
+    const pthread_barrierattr_t* attr,
+    unsigned int count)
+{
+    return oe_pthread_barrier_init(
+        (oe_pthread_barrier_t*)barrier,
+        (const oe_pthread_barrierattr_t*)attr,
+        count);
+}
+
+OE_INLINE
+int pthread_barrier_wait(pthread_barrier_t* barrier)
+{
+    return oe_pthread_barrier_wait((oe_pthread_barrier_t*)barrier);
+}
+
+OE_INLINE
+int pthread_barrier_destroy(pthread_barrier_t* barrier)
+{
+    return oe_pthread_barrier_destroy((oe_pthread_barrier_t*)barrier);
+}
+
+#endif /* _OE_BITS_PTHREAD_BARRIER_H */
@@ -19,10 +19,18 @@ typedef oe_pthread_condattr_t pthread_condattr_t;
 typedef oe_pthread_rwlock_t pthread_rwlock_t;
 typedef oe_pthread_rwlockattr_t pthread_rwlockattr_t;
 typedef oe_pthread_spinlock_t pthread_spinlock_t;
+typedef oe_pthread_barrier_t pthread_barrier_t;
+typedef oe_pthread_barrierattr_t pthread_barrierattr_t;
 
 #define PTHREAD_MUTEX_INITIALIZER OE_PTHREAD_MUTEX_INITIALIZER
 #define PTHREAD_RWLOCK_INITIALIZER OE_PTHREAD_RWLOCK_INITIALIZER
 #define PTHREAD_COND_INITIALIZER OE_PTHREAD_COND_INITIALIZER
 #define PTHREAD_ONCE_INIT OE_PTHREAD_ONCE_INIT
+#define PTHREAD_BARRIER_SERIAL_THREAD OE_PTHREAD_BARRIER_SERIAL_THREAD
+
+#define PTHREAD_RWLOCK_PREFER_READER_NP OE_PTHREAD_RWLOCK_PREFER_READER_NP
+#define PTHREAD_RWLOCK_PREFER_WRITER_NP OE_PTHREAD_RWLOCK_PREFER_WRITER_NP
+#define PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP \
+    OE_PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
 
 #endif /* _OE_BITS_PTHREAD_DEF_H */
@@ -41,6 +41,13 @@ int pthread_mutex_trylock(pthread_mutex_t* m)
     return oe_pthread_mutex_trylock((oe_pthread_mutex_t*)m);
 }
 
+OE_INLINE
+int pthread_mutex_timedlock(pthread_mutex_t* m, const struct timespec* ts)
+{
+    return oe_pthread_mutex_timedlock(
+        (oe_pthread_mutex_t*)m, (const struct oe_timespec*)ts);
+}
+
 OE_INLINE
 int pthread_mutex_unlock(pthread_mutex_t* m)
 {
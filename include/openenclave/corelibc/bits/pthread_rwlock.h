@@ -4,6 +4,32 @@
 #ifndef _OE_BITS_PTHREAD_RWLOCK_H
 #define _OE_BITS_PTHREAD_RWLOCK_H
 
+OE_INLINE
+int pthread_rwlockattr_init(pthread_rwlockattr_t* attr)
+{
+    return oe_pthread_rwlockattr_init((oe_pthread_rwlockattr_t*)attr);
+}
+
+OE_INLINE
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t* attr, int pref)
+{
+    return oe_pthread_rwlockattr_setkind_np(
+        (oe_pthread_rwlockattr_t*)attr, pref);
+}
+
+OE_INLINE
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t* attr, int* pref)
+{
+    return oe_pthread_rwlockattr_getkind_np(
+        (const oe_pthread_rwlockattr_t*)attr, pref);
+}
+
+OE_INLINE
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t* attr)
+{
+    return oe_pthread_rwlockattr_destroy((oe_pthread_rwlockattr_t*)attr);
+}
+
 OE_INLINE
 int pthread_rwlock_init(
     pthread_rwlock_t* rwlock,
@@ -25,6 +51,24 @@ int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock)
     return oe_pthread_rwlock_wrlock((oe_pthread_rwlock_t*)rwlock);
 }
 
+OE_INLINE
+int pthread_rwlock_timedrdlock(
+    pthread_rwlock_t* rwlock,
+    const struct timespec* ts)
+{
+    return oe_pthread_rwlock_timedrdlock(
+        (oe_pthread_rwlock_t*)rwlock, (const struct oe_timespec*)ts);
+}
+
+OE_INLINE
+int pthread_rwlock_timedwrlock(
+    pthread_rwlock_t* rwlock,
+    const struct timespec* ts)
+{
+    return oe_pthread_rwlock_timedwrlock(
+        (oe_pthread_rwlock_t*)rwlock, (const struct oe_timespec*)ts);
+}
+
 OE_INLINE
 int pthread_rwlock_unlock(pthread_rwlock_t* rwlock)
 {
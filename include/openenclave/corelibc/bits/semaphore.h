@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_BITS_SEMAPHORE_H
+#define _OE_BITS_SEMAPHORE_H
+
+OE_INLINE
+int sem_init(sem_t* sem, int pshared, unsigned int value)
+{
+    return oe_sem_init((oe_sem_t*)sem, pshared, value);
+}
+
+OE_INLINE
+int sem_wait(sem_t* sem)
+{
+    return oe_sem_wait((oe_sem_t*)sem);
+}
+
+OE_INLINE
+int sem_trywait(sem_t* sem)
+{
+    return oe_sem_trywait((oe_sem_t*)sem);
+}
+
+OE_INLINE
+int sem_timedwait(sem_t* sem, const struct timespec* ts)
+{
+    return oe_sem_timedwait((oe_sem_t*)sem, (const struct oe_timespec*)ts);
+}
+
+OE_INLINE
+int sem_post(sem_t* sem)
+{
+    return oe_sem_post((oe_sem_t*)sem);
+}
+
+OE_INLINE
+int sem_getvalue(sem_t* sem, int* value)
+{
+    return oe_sem_getvalue((oe_sem_t*)sem, value);
+}
+
+OE_INLINE
+int sem_destroy(sem_t* sem)
+{
+    return oe_sem_destroy((oe_sem_t*)sem);
+}
+
+#endif /* _OE_BITS_SEMAPHORE_H */
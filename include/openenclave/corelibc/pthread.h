@@ -24,6 +24,14 @@ OE_EXTERNC_BEGIN
 #define OE_ONCE_INIT 0
 // clang-format on
 
+/* Kinds of readers-writer locks (see oe_pthread_rwlockattr_setkind_np()) */
+#define OE_PTHREAD_RWLOCK_PREFER_READER_NP 0
+#define OE_PTHREAD_RWLOCK_PREFER_WRITER_NP 1
+#define OE_PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP 2
+
+/* Returned by oe_pthread_barrier_wait() to one of the threads */
+#define OE_PTHREAD_BARRIER_SERIAL_THREAD (-1)
+
 typedef uint64_t oe_pthread_t;
 
 typedef uint32_t oe_pthread_once_t;
@@ -67,10 +75,24 @@ typedef struct _oe_pthread_rwlock
     uint64_t __private[5];
 } oe_pthread_rwlock_t;
 
+typedef struct _oe_pthread_barrierattr
+{
+    uint32_t __private;
+} oe_pthread_barrierattr_t;
+
+typedef struct _oe_pthread_barrier
+{
+    uint64_t __private[4];
+} oe_pthread_barrier_t;
+
 oe_pthread_t oe_pthread_self(void);
 
 int oe_pthread_equal(oe_pthread_t thread1, oe_pthread_t thread2);
 
+/* Runs the thread on the host thread pool of the enclave (see
+ * OE_ENCLAVE_SETTING_THREAD_POOL). The attributes are ignored, and the
+ * handle only identifies the thread to oe_pthread_join() and
+ * oe_pthread_detach(): it is not equal to oe_pthread_self() in the thread. */
 int oe_pthread_create(
     oe_pthread_t* thread,
     const oe_pthread_attr_t* attr,
@@ -105,10 +127,27 @@ int oe_pthread_mutex_lock(oe_pthread_mutex_t* m);
 
 int oe_pthread_mutex_trylock(oe_pthread_mutex_t* m);
 
+int oe_pthread_mutex_timedlock(
+    oe_pthread_mutex_t* m,
+    const struct oe_timespec* ts);
+
 int oe_pthread_mutex_unlock(oe_pthread_mutex_t* m);
 
 int oe_pthread_mutex_destroy(oe_pthread_mutex_t* m);
 
+int oe_pthread_rwlockattr_init(oe_pthread_rwlockattr_t* attr);
+
+/* Locks of the writer-preferring kinds are distributed readers-writer locks
+ * (see oe_rwlock_init_distributed()), which scale with the number of readers
+ * but must be destroyed to release their memory */
+int oe_pthread_rwlockattr_setkind_np(oe_pthread_rwlockattr_t* attr, int pref);
+
+int oe_pthread_rwlockattr_getkind_np(
+    const oe_pthread_rwlockattr_t* attr,
+    int* pref);
+
+int oe_pthread_rwlockattr_destroy(oe_pthread_rwlockattr_t* attr);
+
 int oe_pthread_rwlock_init(
     oe_pthread_rwlock_t* rwlock,
     const oe_pthread_rwlockattr_t* attr);
@@ -117,6 +156,14 @@ int oe_pthread_rwlock_rdlock(oe_pthread_rwlock_t* rwlock);
 
 int oe_pthread_rwlock_wrlock(oe_pthread_rwlock_t* rwlock);
 
+int oe_pthread_rwlock_timedrdlock(
+    oe_pthread_rwlock_t* rwlock,
+    const struct oe_timespec* ts);
+
+int oe_pthread_rwlock_timedwrlock(
+    oe_pthread_rwlock_t* rwlock,
+    const struct oe_timespec* ts);
+
 int oe_pthread_rwlock_unlock(oe_pthread_rwlock_t* rwlock);
 
 int oe_pthread_rwlock_destroy(oe_pthread_rwlock_t* rwlock);
@@ -138,6 +185,19 @@ int oe_pthread_cond_broadcast(oe_pthread_cond_t* cond);
 
 int oe_pthread_cond_destroy(oe_pthread_cond_t* cond);
 
+int oe_pthread_barrierattr_init(oe_pthread_barrierattr_t* attr);
+
+int oe_pthread_barrierattr_destroy(oe_pthread_barrierattr_t* attr);
+
+int oe_pthread_barrier_init(
+    oe_pthread_barrier_t* barrier,
+    const oe_pthread_barrierattr_t* attr,
+    unsigned int count);
+
+int oe_pthread_barrier_wait(oe_pthread_barrier_t* barrier);
+
+int oe_pthread_barrier_destroy(oe_pthread_barrier_t* barrier);
+
 int oe_pthread_key_create(
     oe_pthread_key_t* key,
     void (*destructor)(void* value));
@@ -159,6 +219,7 @@ void* oe_pthread_getspecific(oe_pthread_key_t key);
 #if defined(OE_NEED_STDC_NAMES)
 
 #include <openenclave/corelibc/bits/pthread_def.h>
+#include <openenclave/corelibc/bits/pthread_barrier.h>
 #include <openenclave/corelibc/bits/pthread_cond.h>
 #include <openenclave/corelibc/bits/pthread_create.h>
 #include <openenclave/corelibc/bits/pthread_equal.h>
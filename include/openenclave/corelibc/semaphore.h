@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SEMAPHORE_H
+#define _OE_SEMAPHORE_H
+
+#include <openenclave/bits/types.h>
+#include <openenclave/corelibc/time.h>
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** OE names:
+**
+**==============================================================================
+*/
+
+#define OE_SEM_VALUE_MAX 0x7fffffff
+
+typedef struct _oe_sem
+{
+    uint32_t __private[8];
+} oe_sem_t;
+
+int oe_sem_init(oe_sem_t* sem, int pshared, unsigned int value);
+
+int oe_sem_wait(oe_sem_t* sem);
+
+int oe_sem_trywait(oe_sem_t* sem);
+
+int oe_sem_timedwait(oe_sem_t* sem, const struct oe_timespec* ts);
+
+int oe_sem_post(oe_sem_t* sem);
+
+int oe_sem_getvalue(oe_sem_t* sem, int* value);
+
+int oe_sem_destroy(oe_sem_t* sem);
+
+/*
+**==============================================================================
+**
+** Standard-C names:
+**
+**==============================================================================
+*/
+
+#if defined(OE_NEED_STDC_NAMES)
+
+typedef oe_sem_t sem_t;
+
+#define SEM_VALUE_MAX OE_SEM_VALUE_MAX
+
+#include <openenclave/corelibc/bits/semaphore.h>
+
+#endif /* defined(OE_NEED_STDC_NAMES) */
+
+OE_EXTERNC_END
+
+#endif /* _OE_SEMAPHORE_H */
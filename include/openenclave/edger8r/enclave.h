@@ -73,6 +73,59 @@ oe_result_t oe_call_host_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Call the host function whose matching the given function_id using a host
+ * worker thread instead of the calling enclave thread.
+ *
+ * The call is carried out as by **oe_call_host_function** when the
+ * input buffer was not allocated via **oe_allocate_switchless_ocall_buffer**
+ * or when no host worker is available.
+ *
+ * @param function_id The id of the host function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the host function are
+ * written to.
+ * @param output_buffer_size Size of the output buffer.
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ *
+ * @return See **oe_call_host_function**.
+ */
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * Queue a call to the host function matching the given function_id. The
+ * host carries out the call the next time the calling thread exits the
+ * enclave; the call produces no output.
+ *
+ * The call is carried out as by **oe_call_host_function** when the
+ * input buffer was not allocated via **oe_allocate_deferred_ocall_buffer**.
+ *
+ * @param function_id The id of the host function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the host function are
+ * written to (discarded).
+ * @param output_buffer_size Size of the output buffer.
+ * @param output_bytes_written Set to zero when the call is queued.
+ *
+ * @return OE_OK the call was queued or was carried out successfully.
+ * @return See **oe_call_host_function** for the other errors.
+ */
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
 /**
  * Allocate a buffer of given size for doing an ocall.
  *
@@ -92,6 +145,46 @@ void* oe_allocate_ocall_buffer(size_t size);
  */
 void oe_free_ocall_buffer(void* buffer);
 
+/**
+ * Allocate a buffer of given size for doing a switchless ocall.
+ *
+ * The buffer is the marshaling buffer reserved for the calling thread when
+ * it is large enough and not already in use. Otherwise the buffer is
+ * allocated as by **oe_allocate_ocall_buffer**.
+ *
+ * @param size The size in bytes of the buffer.
+ * @returns pointer to the allocated buffer.
+ * @return NULL if allocation failed.
+ */
+void* oe_allocate_switchless_ocall_buffer(size_t size);
+
+/**
+ * Free the buffer allocated for switchless ocalls.
+ *
+ * @param buffer The buffer allocated via oe_allocate_switchless_ocall_buffer.
+ */
+void oe_free_switchless_ocall_buffer(void* buffer);
+
+/**
+ * Allocate a buffer of given size for doing a deferred ocall.
+ *
+ * The buffer is allocated in the deferred call queue of the calling thread
+ * when it fits and no other deferred call is being prepared. Otherwise the
+ * buffer is allocated as by **oe_allocate_ocall_buffer**.
+ *
+ * @param size The size in bytes of the buffer.
+ * @returns pointer to the allocated buffer.
+ * @return NULL if allocation failed.
+ */
+void* oe_allocate_deferred_ocall_buffer(size_t size);
+
+/**
+ * Free the buffer allocated for deferred ocalls.
+ *
+ * @param buffer The buffer allocated via oe_allocate_deferred_ocall_buffer.
+ */
+void oe_free_deferred_ocall_buffer(void* buffer);
+
 /**
  * For hand-written enclaves, that use the older calling mechanism, define empty
  * ecall tables.
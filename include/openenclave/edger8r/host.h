@@ -66,6 +66,83 @@ oe_result_t oe_call_enclave_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Perform a switchless ECALL.
+ *
+ * Call the enclave function that matches the given function-id using an
+ * enclave worker thread instead of the calling thread. The call is made as
+ * by **oe_call_enclave_function** when no enclave worker is available.
+ *
+ * @param function_id The id of the enclave function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the host function are
+ * written to.
+ * @param output_buffer_size Size of the output buffer.
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ *
+ * @return See **oe_call_enclave_function**.
+ */
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * A call made by **oe_call_enclave_functions_batch**.
+ */
+typedef struct _oe_enclave_function_call
+{
+    /** The id of the enclave function that will be called. */
+    uint32_t function_id;
+
+    /** Buffer containing inputs data. */
+    const void* input_buffer;
+
+    /** Size of the input data buffer. */
+    size_t input_buffer_size;
+
+    /** Buffer where the outputs of the enclave function are written to. */
+    void* output_buffer;
+
+    /** Size of the output buffer. */
+    size_t output_buffer_size;
+
+    /** Set to the number of bytes written in the output buffer. */
+    size_t output_bytes_written;
+
+    /** Set to the result of the call (see **oe_call_enclave_function**). */
+    oe_result_t result;
+} oe_enclave_function_call_t;
+
+/**
+ * Perform a batch of ECALLs.
+ *
+ * Call the enclave functions described by the given calls, in order, within
+ * a single entry into the enclave. This saves the cost of entering and
+ * leaving the enclave for all but one of the calls. The calls may be to the
+ * same or to different enclave functions.
+ *
+ * The result of each call is stored in its **result** field: a call that
+ * fails does not prevent the calls after it from being made.
+ *
+ * @param calls The calls to make.
+ * @param num_calls The number of calls.
+ *
+ * @return OE_OK the batch was carried out (see the result of each call).
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_OUT_OF_MEMORY the batch could not be allocated.
+ * @return OE_OUT_OF_THREADS no enclave thread was available.
+ */
+oe_result_t oe_call_enclave_functions_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls);
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_HOST_H
@@ -14,13 +14,17 @@
 #error "enclave.h and host.h must not be included in the same compilation unit."
 #endif
 
+#include "bits/arena.h"
 #include "bits/defs.h"
 #include "bits/exception.h"
 #include "bits/fs.h"
+#include "bits/heapstats.h"
 #include "bits/module.h"
 #include "bits/properties.h"
 #include "bits/report.h"
 #include "bits/result.h"
+#include "bits/slab.h"
+#include "bits/stackusage.h"
 #include "bits/types.h"
 
 /**
@@ -188,6 +192,44 @@ void oe_host_free(void* ptr);
  */
 char* oe_host_strndup(const char* str, size_t n);
 
+/**
+ * Get the statistics of the heap of the enclave.
+ *
+ * This function reports how much of the heap the allocator has used so far
+ * and how it uses it now: its current and peak size, the bytes in use and
+ * free, the fragmentation of the free bytes, and the number and sizes of the
+ * allocations made since the enclave was created.
+ *
+ * @param stats The structure that receives the statistics.
+ *
+ * @retval OE_OK The statistics were returned.
+ * @retval OE_INVALID_PARAMETER **stats** is null.
+ */
+oe_result_t oe_get_heap_stats(oe_heap_stats_t* stats);
+
+/**
+ * Get the peak stack usage of each thread control structure (TCS) of the
+ * enclave.
+ *
+ * The stack pages of each TCS are filled with a known pattern when the
+ * enclave is created, so the deepest word that no longer holds it shows how
+ * much of the stack the threads running on that TCS have used so far (see
+ * oe_stack_usage_t). The largest peak, plus a margin, is what the
+ * NumStackPages property of the enclave can be reduced to.
+ *
+ * @param usage The array that receives the usage of each TCS (may be null
+ * if *num_usage is zero).
+ * @param num_usage On input, the number of elements of **usage**. On
+ * output, the number of TCSs of the enclave.
+ *
+ * @retval OE_OK The usage of every TCS was returned.
+ * @retval OE_BUFFER_TOO_SMALL **usage** is too small: *num_usage was set to
+ * the number of elements needed.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Stack usage is not supported for the enclave type.
+ */
+oe_result_t oe_get_stack_usage(oe_stack_usage_t* usage, size_t* num_usage);
+
 /**
  * Abort execution of the enclave.
  *
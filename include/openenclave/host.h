@@ -21,8 +21,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bits/defs.h"
+#include "bits/heapstats.h"
+#include "bits/lockstats.h"
 #include "bits/report.h"
 #include "bits/result.h"
+#include "bits/stackusage.h"
 #include "bits/types.h"
 
 OE_EXTERNC_BEGIN
@@ -63,6 +66,107 @@ typedef void (*oe_ocall_func_t)(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Types of settings passed into **oe_create_enclave**
+ */
+typedef enum _oe_enclave_setting_type
+{
+    OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS = 0xdc73a628,
+    OE_ENCLAVE_SETTING_TCS_WAIT = 0x5f1b92d4,
+    OE_ENCLAVE_SETTING_THREAD_POOL = 0x2e84c6b1,
+    __OE_ENCLAVE_SETTING_TYPE_MAX = OE_ENUM_MAX,
+} oe_enclave_setting_type_t;
+
+/**
+ * The setting for context-switchless calls.
+ */
+typedef struct _oe_enclave_setting_context_switchless
+{
+    /**
+     * The number of host worker threads that carry out OCALLs marked
+     * with the **transition_using_threads** attribute. Zero disables
+     * switchless OCALLs, in which case such OCALLs are performed as
+     * ordinary OCALLs.
+     */
+    size_t max_host_workers;
+
+    /**
+     * The number of enclave worker threads that carry out ECALLs marked
+     * with the **transition_using_threads** attribute. Each enclave worker
+     * occupies one TCS of the enclave for the lifetime of the enclave, so
+     * this must be less than the TCS count of the enclave. Zero disables
+     * switchless ECALLs, in which case such ECALLs are performed as
+     * ordinary ECALLs.
+     */
+    size_t max_enclave_workers;
+} oe_enclave_setting_context_switchless_t;
+
+/**
+ * Value of **oe_enclave_setting_tcs_wait_t.timeout_ms** to wait without a
+ * time limit.
+ */
+#define OE_TCS_WAIT_INFINITE 0xFFFFFFFFu
+
+/**
+ * The setting for ECALLs made while all the TCSs of the enclave are busy.
+ */
+typedef struct _oe_enclave_setting_tcs_wait
+{
+    /**
+     * The number of milliseconds that such an ECALL waits for a TCS to
+     * become available before failing with OE_OUT_OF_THREADS. Waiting
+     * ECALLs are given TCSs in the order in which they started waiting.
+     * Zero (the default) fails immediately; OE_TCS_WAIT_INFINITE waits
+     * without a time limit.
+     */
+    uint32_t timeout_ms;
+} oe_enclave_setting_tcs_wait_t;
+
+/**
+ * The setting for the host threads that run the threads started in the
+ * enclave with pthread_create().
+ */
+typedef struct _oe_enclave_setting_thread_pool
+{
+    /**
+     * The number of host threads in the pool, which is the maximum number
+     * of enclave threads running at once. Each thread of the pool occupies
+     * one TCS of the enclave for the lifetime of the enclave, so this plus
+     * the number of switchless enclave workers must be less than the TCS
+     * count of the enclave. Zero (the default) disables pthread_create()
+     * in the enclave.
+     *
+     * The enclave threads ignore their attributes. The handle returned by
+     * pthread_create() is only meant for pthread_join() and
+     * pthread_detach(): it does not compare equal to the value of
+     * pthread_self() in the new thread.
+     */
+    size_t max_threads;
+} oe_enclave_setting_thread_pool_t;
+
+/**
+ * The uniform structure type containing a specific type of enclave
+ * setting.
+ */
+typedef struct _oe_enclave_setting
+{
+    /**
+     * The type of the setting in the **u** union
+     */
+    oe_enclave_setting_type_t setting_type;
+
+    /**
+     * The specific setting for the enclave, as indicated by **setting_type**
+     */
+    union {
+        const oe_enclave_setting_context_switchless_t*
+            context_switchless_setting;
+        const oe_enclave_setting_tcs_wait_t* tcs_wait_setting;
+        const oe_enclave_setting_thread_pool_t* thread_pool_setting;
+        /* Add new setting types here */
+    } u;
+} oe_enclave_setting_t;
+
 /**
  * Create an enclave from an enclave image file.
  *
@@ -82,10 +186,10 @@ typedef void (*oe_ocall_func_t)(
  *     - OE_ENCLAVE_FLAG_DEBUG - runs the enclave in debug mode.
  *                               DO NOT SHIP CODE with this flag
  *
- * @param config Additional enclave creation configuration data for the specific
- * enclave type. This parameter is reserved and must be NULL.
+ * @param settings Array of additional settings for the enclave, such as the
+ * number of worker threads for switchless calls. May be NULL.
  *
- * @param config_size The size of the **config** data buffer in bytes.
+ * @param setting_count The number of elements in the **settings** array.
  *
  * @param ocall_table Pointer to table of ocall functions generated by
  * oeedger8r.
@@ -101,8 +205,8 @@ oe_result_t oe_create_enclave(
     const char* path,
     oe_enclave_type_t type,
     uint32_t flags,
-    const void* config,
-    uint32_t config_size,
+    const oe_enclave_setting_t* settings,
+    uint32_t setting_count,
     const oe_ocall_func_t* ocall_table,
     uint32_t ocall_table_size,
     oe_enclave_t** enclave);
@@ -121,6 +225,303 @@ oe_result_t oe_create_enclave(
  */
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave);
 
+/**
+ * Types of the calls counted by **oe_get_enclave_call_stats()**.
+ */
+typedef enum _oe_call_type
+{
+    OE_CALL_TYPE_ECALL = 1,
+    OE_CALL_TYPE_OCALL = 2,
+    __OE_CALL_TYPE_MAX = OE_ENUM_MAX,
+} oe_call_type_t;
+
+/**
+ * Table id of the ECALLs and OCALLs that the runtime makes directly rather
+ * than through an EDL function table (their function ids are internal call
+ * numbers).
+ */
+#define OE_CALL_STATS_RUNTIME_TABLE_ID (OE_UINT64_MAX - 1)
+
+/**
+ * Number of buckets in the latency histogram of **oe_call_stats_t**.
+ */
+#define OE_CALL_STATS_HISTOGRAM_SIZE 32
+
+/**
+ * Statistics of the calls made to one function, as returned by
+ * **oe_get_enclave_call_stats()**.
+ *
+ * ECALL latencies are measured by the calling host thread and include the
+ * OCALLs made during the ECALL. OCALL latencies cover the host function.
+ */
+typedef struct _oe_call_stats
+{
+    /** Whether the function is an ECALL or an OCALL. */
+    oe_call_type_t type;
+
+    /**
+     * The function table: OE_UINT64_MAX for the functions of the enclave's
+     * EDL, 0 and 1 for the internal and system call tables of the runtime,
+     * and OE_CALL_STATS_RUNTIME_TABLE_ID for calls made by the runtime
+     * outside of a table.
+     */
+    uint64_t table_id;
+
+    /** The id of the function within its table. */
+    uint64_t function_id;
+
+    /** Number of calls. */
+    uint64_t count;
+
+    /** Cumulative, minimum and maximum latency of the calls. */
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+
+    /**
+     * Latency histogram: histogram[i] counts the calls that took about
+     * 2^i to 2^(i+1) nanoseconds (the last bucket counts longer calls too).
+     */
+    uint64_t histogram[OE_CALL_STATS_HISTOGRAM_SIZE];
+} oe_call_stats_t;
+
+/**
+ * Get the statistics of the ECALLs and OCALLs made by an enclave.
+ *
+ * The host counts every ECALL and OCALL of every enclave, per function. The
+ * statistics are sorted by decreasing total latency. Calls in progress are
+ * counted once they return.
+ *
+ * If the OE_CALL_STATS environment variable is set to a value other than 0,
+ * the statistics are also written to the standard error when the enclave is
+ * terminated.
+ *
+ * @param enclave The enclave whose calls were counted.
+ * @param stats The array that receives the statistics (may be null if
+ * *num_stats is zero).
+ * @param num_stats On input, the number of elements of **stats**. On
+ * output, the number of functions that were called.
+ *
+ * @retval OE_OK The statistics of all the functions were returned.
+ * @retval OE_BUFFER_TOO_SMALL **stats** is too small: *num_stats was set to
+ * the number of elements needed.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Call statistics are not supported for the enclave
+ * type.
+ */
+oe_result_t oe_get_enclave_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_t* stats,
+    size_t* num_stats);
+
+/**
+ * Start or stop profiling the locks of an enclave.
+ *
+ * While the profiler is enabled, the operations on the mutexes, condition
+ * variables, readers-writer locks and spinlocks of the enclave are counted
+ * per lock, with the time spent waiting for them. Enabling the profiler
+ * discards the statistics collected so far. Profiling slows down every
+ * lock operation somewhat, so it is disabled by default.
+ *
+ * If the OE_LOCK_STATS environment variable is set to a number N other than
+ * 0, the profiler is enabled when the enclave is created and the statistics
+ * of the N most contended locks (20 if N is not a number) are written to
+ * the standard error when the enclave is terminated.
+ *
+ * @param enclave The enclave whose locks to profile.
+ * @param enable Whether to start or stop profiling.
+ *
+ * @retval OE_OK The profiler was started or stopped.
+ * @retval OE_INVALID_PARAMETER **enclave** is invalid.
+ * @retval OE_OUT_OF_MEMORY The enclave could not allocate the statistics.
+ * @retval OE_UNSUPPORTED Lock profiling is not supported for the enclave
+ * type.
+ */
+oe_result_t oe_enable_enclave_lock_stats(oe_enclave_t* enclave, bool enable);
+
+/**
+ * Get the statistics of the locks of an enclave.
+ *
+ * The statistics are those collected since the profiler was last enabled
+ * with **oe_enable_enclave_lock_stats()**, sorted by decreasing time spent
+ * waiting for the lock, then by decreasing number of spins.
+ *
+ * @param enclave The enclave whose locks were profiled.
+ * @param stats The array that receives the statistics (may be null if
+ * *num_stats is zero).
+ * @param num_stats On input, the number of elements of **stats**. On
+ * output, the number of locks profiled.
+ *
+ * @retval OE_OK The statistics of all the locks were returned.
+ * @retval OE_BUFFER_TOO_SMALL **stats** is too small: *num_stats was set to
+ * the number of elements needed.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Lock profiling is not supported for the enclave
+ * type.
+ */
+oe_result_t oe_get_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    oe_lock_stats_t* stats,
+    size_t* num_stats);
+
+/**
+ * Write a report of the most contended locks of an enclave.
+ *
+ * @param enclave The enclave whose locks were profiled.
+ * @param top_n The number of locks to report, as sorted by
+ * **oe_get_enclave_lock_stats()**.
+ * @param stream The stream the report is written to.
+ *
+ * @retval OE_OK The report was written.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Lock profiling is not supported for the enclave
+ * type.
+ */
+oe_result_t oe_dump_enclave_lock_stats(
+    oe_enclave_t* enclave,
+    size_t top_n,
+    FILE* stream);
+
+/**
+ * Get the statistics of the heap of an enclave.
+ *
+ * The statistics report the current and peak use of the heap, its
+ * fragmentation, and the number and sizes of the allocations made by the
+ * enclave since it was created (see oe_heap_stats_t). The peak break is the
+ * number of heap bytes the enclave has needed so far, against which the
+ * NumHeapPages property of the enclave can be sized.
+ *
+ * If the OE_HEAP_STATS environment variable is set to a value other than 0,
+ * the statistics are written to the standard error when the enclave is
+ * terminated.
+ *
+ * @param enclave The enclave whose heap to report.
+ * @param stats The structure that receives the statistics.
+ *
+ * @retval OE_OK The statistics were returned.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Heap statistics are not supported for the enclave
+ * type.
+ */
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_heap_stats_t* stats);
+
+/**
+ * Write a report of the statistics of the heap of an enclave.
+ *
+ * @param enclave The enclave whose heap to report.
+ * @param stream The stream the report is written to.
+ *
+ * @retval OE_OK The report was written.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Heap statistics are not supported for the enclave
+ * type.
+ */
+oe_result_t oe_dump_enclave_heap_stats(oe_enclave_t* enclave, FILE* stream);
+
+/**
+ * Start or stop the sampling heap profiler of an enclave.
+ *
+ * Once started, the enclave records the call stack of about one allocation
+ * per **sample_interval** bytes allocated, chosen at random so that the
+ * samples can be scaled back up to estimate the heap use of each call
+ * stack. Sampling costs little enough to be left on in production for
+ * intervals of hundreds of kilobytes. Starting the profiler discards the
+ * profile collected so far; stopping it keeps the profile, whose sampled
+ * blocks are still followed until they are freed.
+ *
+ * Call stacks are recorded by following frame pointers, so they are only
+ * complete for enclaves built with frame pointers.
+ *
+ * If the OE_HEAP_PROFILE environment variable names a file, the profiler is
+ * started when the enclave is created, with the interval set by
+ * OE_HEAP_PROFILE_INTERVAL (512KB by default), and the profile is written
+ * to that file when the enclave is terminated.
+ *
+ * @param enclave The enclave whose heap to profile.
+ * @param sample_interval The average number of bytes allocated between two
+ * samples, at most 4GB, or zero to stop sampling.
+ *
+ * @retval OE_OK The profiler was started or stopped.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_OUT_OF_MEMORY The enclave could not allocate the profile.
+ * @retval OE_UNSUPPORTED Heap profiling is not supported for the enclave
+ * type.
+ */
+oe_result_t oe_enable_enclave_heap_profiler(
+    oe_enclave_t* enclave,
+    uint64_t sample_interval);
+
+/**
+ * Write the heap profile of an enclave in the pprof heap format.
+ *
+ * The profile lists the sampled allocations and the sampled blocks still in
+ * use by call stack, followed by the names of their functions in comments
+ * and the mapping of the enclave image, so that pprof can report it by
+ * bytes in use or by bytes allocated.
+ *
+ * @param enclave The enclave whose heap was profiled.
+ * @param stream The stream the profile is written to.
+ *
+ * @retval OE_OK The profile was written.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_FAILURE The profile could not be written to the stream.
+ * @retval OE_UNSUPPORTED Heap profiling is not supported for the enclave
+ * type.
+ */
+oe_result_t oe_write_enclave_heap_profile(oe_enclave_t* enclave, FILE* stream);
+
+/**
+ * Get the peak stack usage of each thread control structure (TCS) of an
+ * enclave.
+ *
+ * The stack pages of each TCS are filled with a known pattern when the
+ * enclave is created. This function reads the stacks of the enclave to find
+ * how much of each stack the threads of the enclave have used so far (see
+ * oe_stack_usage_t), without calling the enclave. The largest peak, plus a
+ * margin, is what the NumStackPages property of the enclave can be reduced
+ * to.
+ *
+ * The host can only read the memory of debug and simulated enclaves. Other
+ * enclaves can report their own usage with **oe_get_stack_usage()**.
+ *
+ * If the OE_STACK_USAGE environment variable is set to a value other than 0,
+ * the usage is written to the standard error when the enclave is
+ * terminated.
+ *
+ * @param enclave The enclave whose stacks to read.
+ * @param usage The array that receives the usage of each TCS (may be null
+ * if *num_usage is zero).
+ * @param num_usage On input, the number of elements of **usage**. On
+ * output, the number of TCSs of the enclave.
+ *
+ * @retval OE_OK The usage of every TCS was returned.
+ * @retval OE_BUFFER_TOO_SMALL **usage** is too small: *num_usage was set to
+ * the number of elements needed.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_FAILURE The memory of the enclave could not be read.
+ * @retval OE_UNSUPPORTED The enclave is neither a debug nor a simulated
+ * enclave, or its type does not support stack usage.
+ */
+oe_result_t oe_get_enclave_stack_usage(
+    oe_enclave_t* enclave,
+    oe_stack_usage_t* usage,
+    size_t* num_usage);
+
+/**
+ * Write a report of the stack usage of each TCS of an enclave.
+ *
+ * @param enclave The enclave whose stacks to read.
+ * @param stream The stream the report is written to.
+ *
+ * @retval OE_OK The report was written.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED The stacks of the enclave cannot be read (see
+ * **oe_get_enclave_stack_usage()**).
+ */
+oe_result_t oe_dump_enclave_stack_usage(oe_enclave_t* enclave, FILE* stream);
+
 #if (OE_API_VERSION < 2)
 #error "Only OE_API_VERSION of 2 is supported"
 #else
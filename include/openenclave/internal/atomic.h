@@ -10,8 +10,15 @@
 #if defined(_MSC_VER)
 #pragma intrinsic(_InterlockedIncrement64)
 #pragma intrinsic(_InterlockedDecrement64)
+#pragma intrinsic(_InterlockedCompareExchange64)
+#pragma intrinsic(_InterlockedExchangeAdd64)
 __int64 _InterlockedIncrement64(__int64* lpAddend);
 __int64 _InterlockedDecrement64(__int64* lpAddend);
+__int64 _InterlockedCompareExchange64(
+    __int64 volatile* Destination,
+    __int64 Exchange,
+    __int64 Comparand);
+__int64 _InterlockedExchangeAdd64(__int64 volatile* Addend, __int64 Value);
 #endif
 
 /* Atomically increment **x** and return its new value */
@@ -38,4 +45,60 @@ OE_INLINE uint64_t oe_atomic_decrement(volatile uint64_t* x)
 #endif
 }
 
+/* Atomically add **n** to **x** and return its new value */
+OE_INLINE uint64_t oe_atomic_add(volatile uint64_t* x, uint64_t n)
+{
+#if defined(__GNUC__)
+    return __sync_add_and_fetch(x, n);
+#elif defined(_MSC_VER)
+    return (uint64_t)_InterlockedExchangeAdd64((__int64*)x, (__int64)n) + n;
+#else
+#error "unsupported"
+#endif
+}
+
+/* Atomically set **x** to **new_value** if it equals **old_value** */
+OE_INLINE bool oe_atomic_compare_and_swap(
+    volatile uint64_t* x,
+    uint64_t old_value,
+    uint64_t new_value)
+{
+#if defined(__GNUC__)
+    return __sync_bool_compare_and_swap(x, old_value, new_value);
+#elif defined(_MSC_VER)
+    return _InterlockedCompareExchange64(
+               (__int64*)x, (__int64)new_value, (__int64)old_value) ==
+           (__int64)old_value;
+#else
+#error "unsupported"
+#endif
+}
+
+/* Read **x** with acquire semantics */
+OE_INLINE uint64_t oe_atomic_load(const volatile uint64_t* x)
+{
+#if defined(__GNUC__)
+    return __atomic_load_n(x, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+    uint64_t value = *x;
+    _ReadWriteBarrier();
+    return value;
+#else
+#error "unsupported"
+#endif
+}
+
+/* Write **value** to **x** with release semantics */
+OE_INLINE void oe_atomic_store(volatile uint64_t* x, uint64_t value)
+{
+#if defined(__GNUC__)
+    __atomic_store_n(x, value, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+    _ReadWriteBarrier();
+    *x = value;
+#else
+#error "unsupported"
+#endif
+}
+
 #endif /* _OE_ATOMIC_H */
@@ -30,6 +30,10 @@ typedef void (*oe_ocall_function)(uint64_t arg_in, uint64_t* arg_out);
 **==============================================================================
 */
 
+/* Set by the enclave on exit (OCALL or ERET) when the deferred OCALL queue of
+ * the exiting TCS holds calls for the host to carry out first */
+#define OE_CALL_FLAG_DEFERRED_OCALLS 0x0001
+
 /*
 **==============================================================================
 **
@@ -80,6 +84,7 @@ typedef enum _oe_func
     OE_ECALL_LOG_INIT,
     OE_ECALL_GET_PUBLIC_KEY_BY_POLICY,
     OE_ECALL_GET_PUBLIC_KEY,
+    OE_ECALL_CALL_ENCLAVE_FUNCTIONS,
     /* Caution: always add new ECALL function numbers here */
 
     OE_ECALL_MAX,
@@ -100,6 +105,11 @@ typedef enum _oe_func
     OE_OCALL_GET_TIME,
     OE_OCALL_BACKTRACE_SYMBOLS,
     OE_OCALL_LOG,
+    OE_OCALL_GET_OCALL_ARENA,
+    OE_OCALL_GET_DEFERRED_OCALL_QUEUE,
+    OE_OCALL_THREAD_WAIT_TIMED,
+    OE_OCALL_THREAD_WAKE_MULTIPLE,
+    OE_OCALL_GROW_HOST_POOL,
     /* Caution: always add new OCALL function numbers here */
 
     OE_OCALL_MAX, /* This value is never used */
@@ -213,6 +223,23 @@ typedef struct _oe_call_enclave_function_args
     oe_result_t result;
 } oe_call_enclave_function_args_t;
 
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions_args_t
+**
+**     Argument of OE_ECALL_CALL_ENCLAVE_FUNCTIONS: the enclave handles each
+**     of the calls as it would an OE_ECALL_CALL_ENCLAVE_FUNCTION.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_call_enclave_functions_args
+{
+    oe_call_enclave_function_args_t* calls;
+    uint64_t num_calls;
+} oe_call_enclave_functions_args_t;
+
 /*
 **==============================================================================
 **
@@ -229,7 +256,25 @@ oe_result_t oe_call_enclave_function_by_table_id(
     size_t input_buffer_size,
     void* output_buffer,
     size_t output_buffer_size,
-    size_t* output_bytes_written);
+    size_t* output_bytes_written,
+    bool switchless);
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions_batch_by_table_id()
+**
+**==============================================================================
+*/
+
+/* Defined in <openenclave/edger8r/host.h> as oe_enclave_function_call_t */
+struct _oe_enclave_function_call;
+
+oe_result_t oe_call_enclave_functions_batch_by_table_id(
+    oe_enclave_t* enclave,
+    uint64_t table_id,
+    struct _oe_enclave_function_call* calls,
+    size_t num_calls);
 
 /*
 **==============================================================================
@@ -255,6 +300,48 @@ typedef struct _oe_call_host_function_args
     oe_result_t result;
 } oe_call_host_function_args_t;
 
+/*
+**==============================================================================
+**
+** oe_deferred_ocall_queue_t
+**
+**     Each TCS owns a queue of host memory where the enclave appends the
+**     OCALLs that return nothing to the enclave (freeing host memory,
+**     writing to the console, EDL OCALLs declared transition_deferred).
+**     The host carries out the queued calls, in order, the next time the
+**     TCS exits the enclave (OE_CALL_FLAG_DEFERRED_OCALLS), before handling
+**     the OCALL or returning from the ECALL that caused the exit.
+**
+**     The queue header is followed by the calls. Each call is made as by
+**     oe_ocall(func, arg_in) and is followed by its arguments when it has
+**     any (arg_in then points to them). Calls are aligned on
+**     OE_DEFERRED_OCALL_ALIGNMENT bytes.
+**
+**==============================================================================
+*/
+
+#define OE_DEFERRED_OCALL_QUEUE_SIZE (64 * 1024)
+
+#define OE_DEFERRED_OCALL_ALIGNMENT 16
+
+typedef struct _oe_deferred_ocall
+{
+    uint64_t func;
+    uint64_t arg_in;
+
+    /* Size of the call, including this header and the arguments */
+    uint64_t size;
+    uint64_t reserved;
+} oe_deferred_ocall_t;
+
+typedef struct _oe_deferred_ocall_queue
+{
+    uint64_t num_calls;
+
+    /* Bytes of the queue in use, including this header */
+    uint64_t size;
+} oe_deferred_ocall_queue_t;
+
 /*
 **==============================================================================
 **
@@ -270,7 +357,8 @@ oe_result_t oe_call_host_function_by_table_id(
     size_t input_buffer_size,
     void* output_buffer,
     size_t output_buffer_size,
-    size_t* output_bytes_written);
+    size_t* output_bytes_written,
+    bool switchless);
 
 /*
 **==============================================================================
@@ -475,6 +563,53 @@ oe_result_t oe_ecall(
  */
 oe_result_t oe_ocall(uint16_t func, uint64_t arg_in, uint64_t* arg_out);
 
+/**
+ * Queue an OCALL that returns nothing to the enclave.
+ *
+ * The call is carried out by the host the next time the calling thread
+ * exits the enclave (see oe_deferred_ocall_queue_t).
+ *
+ * @param func The number of the function to be called.
+ * @param arg_in The input argument passed to the function.
+ *
+ * @retval OE_OK The call was queued.
+ * @retval OE_UNSUPPORTED The call cannot be queued: the caller should make
+ * it with oe_ocall() instead.
+ */
+oe_result_t oe_defer_ocall(uint16_t func, uint64_t arg_in);
+
+/**
+ * Allocate the arguments of a deferred OCALL.
+ *
+ * The arguments are allocated in the deferred OCALL queue of the calling
+ * thread and passed to the host function as arg_in. The call is queued by
+ * oe_post_deferred_ocall() or abandoned by oe_cancel_deferred_ocall(); no
+ * other call may be deferred by this thread in between.
+ *
+ * @param func The number of the function to be called.
+ * @param size The size of the arguments in bytes.
+ *
+ * @returns The arguments (in host memory), or NULL if the call cannot be
+ * deferred: the caller should make it with oe_ocall() instead.
+ */
+void* oe_allocate_deferred_ocall(uint16_t func, size_t size);
+
+/**
+ * Queue the deferred OCALL whose arguments were allocated by
+ * oe_allocate_deferred_ocall().
+ *
+ * @param args The arguments returned by oe_allocate_deferred_ocall().
+ */
+void oe_post_deferred_ocall(void* args);
+
+/**
+ * Abandon the deferred OCALL whose arguments were allocated by
+ * oe_allocate_deferred_ocall().
+ *
+ * @param args The arguments returned by oe_allocate_deferred_ocall().
+ */
+void oe_cancel_deferred_ocall(void* args);
+
 /*
 **==============================================================================
 **
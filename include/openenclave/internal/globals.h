@@ -31,6 +31,11 @@ extern oe_enclave_t* oe_enclave;
 uint64_t oe_get_base_heap_page(void);
 uint64_t oe_get_num_heap_pages(void);
 uint64_t oe_get_num_pages(void);
+uint64_t oe_get_num_tcs(void);
+uint64_t oe_get_num_stack_pages(void);
+
+/* Pause iterations spent spinning on a contended lock before waiting */
+uint32_t oe_get_lock_spin_count(void);
 
 OE_EXTERNC_END
 
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_HEAPPROFILE_H
+#define _OE_INTERNAL_HEAPPROFILE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/* Most frames recorded per call stack */
+#define OE_HEAP_PROFILE_MAX_FRAMES 16
+
+/* Most distinct call stacks recorded by the profiler */
+#define OE_HEAP_PROFILE_MAX_STACKS 1024
+
+/* Largest sample interval accepted by the profiler */
+#define OE_HEAP_PROFILE_MAX_INTERVAL (1ULL << 32)
+
+/* The allocations sampled with one call stack, as returned by
+ * oe_get_heap_profile_ecall() */
+typedef struct _oe_heap_profile_stack
+{
+    /* Sampled blocks of this stack that are still allocated, and their
+     * requested bytes */
+    uint64_t in_use_count;
+    uint64_t in_use_bytes;
+
+    /* All the allocations sampled with this stack, and their bytes */
+    uint64_t alloc_count;
+    uint64_t alloc_bytes;
+
+    /* Return addresses, innermost first, as offsets from the enclave base */
+    uint64_t num_frames;
+    uint64_t frames[OE_HEAP_PROFILE_MAX_FRAMES];
+} oe_heap_profile_stack_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_INTERNAL_HEAPPROFILE_H */
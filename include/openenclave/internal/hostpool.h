@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOSTPOOL_H
+#define _OE_HOSTPOOL_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/* Size of each region of host memory that the enclave requests with
+ * OE_OCALL_GROW_HOST_POOL */
+#define OE_HOST_POOL_REGION_SIZE (1024 * 1024)
+
+/* Most regions that the host hands to an enclave */
+#define OE_HOST_POOL_MAX_REGIONS 64
+
+//
+// If true, oe_host_malloc(), oe_host_calloc(), oe_host_realloc() and
+// oe_host_free() serve blocks of up to 64KB from a pool of host memory that
+// the enclave manages itself, rather than making an OCALL each. The pool
+// grows one region of OE_HOST_POOL_REGION_SIZE bytes at a time and is only
+// released when the enclave is terminated.
+//
+// Blocks allocated from the pool must be released with oe_host_free() (or
+// resized with oe_host_realloc()): the host cannot free() them. To use this
+// mechanism in an enclave, define the variable at file scope:
+//
+//     #include <openenclave/internal/hostpool.h>
+//     .
+//     .
+//     .
+//     OE_ENABLE_HOST_MEMORY_POOL();
+//
+extern const bool oe_host_memory_pool;
+
+#define OE_ENABLE_HOST_MEMORY_POOL() \
+    OE_EXPORT_CONST bool oe_host_memory_pool = true
+
+OE_EXTERNC_END
+
+#endif /* _OE_HOSTPOOL_H */
@@ -44,6 +44,10 @@ typedef struct _oe_malloc_stats
  */
 oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats);
 
+/* Get the current and the highest break set with oe_sbrk(), as offsets from
+ * the base of the heap */
+void oe_get_sbrk_stats(uint64_t* sbrk_bytes, uint64_t* peak_sbrk_bytes);
+
 /* Dump the list of all in-use allocations */
 void oe_debug_malloc_dump(void);
 
@@ -65,6 +69,22 @@ size_t oe_debug_malloc_check(void);
 //
 extern bool oe_disable_debug_malloc_check;
 
+//
+// If true, small allocations are served from per-thread caches of free
+// blocks, which spares most calls the global lock of the enclave heap. This
+// trades some memory (up to 64KB of cached blocks per thread) for
+// scalability and is ignored when the enclave is built with debug malloc.
+// To use this mechanism in an enclave, define the variable at file scope:
+//
+//     #include <openenclave/internal/malloc.h>
+//
+//     OE_ENABLE_MALLOC_THREAD_CACHE();
+//
+extern const bool oe_malloc_thread_cache;
+
+#define OE_ENABLE_MALLOC_THREAD_CACHE() \
+    OE_EXPORT_CONST bool oe_malloc_thread_cache = true
+
 OE_EXTERNC_END
 
 #endif /* _OE_MALLOC_H */
@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_PARALLEL_H
+#define _OE_INTERNAL_PARALLEL_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+#ifdef OE_BUILD_ENCLAVE
+OE_EXTERNC_BEGIN
+
+/**
+ * The largest number of threads working on the parallel jobs of an enclave,
+ * including the threads that start the jobs.
+ */
+#define OE_PARALLEL_MAX_THREADS 64
+
+/**
+ * Milliseconds that a worker without work waits for more before exiting.
+ */
+#define OE_PARALLEL_IDLE_TIMEOUT_MS 50
+
+/**
+ * The body of a parallel loop, called for ranges of its iterations.
+ */
+typedef void (*oe_parallel_for_body_t)(uint64_t begin, uint64_t end, void* arg);
+
+/**
+ * Run a loop in parallel.
+ *
+ * This function calls **body** for ranges of at most **grain** iterations
+ * that together cover [**begin**, **end**), and returns once all of them
+ * have returned. The ranges are run by the calling thread and by worker
+ * threads started with oe_thread_create(), which take ranges from each
+ * other when they run out of work. If no worker thread can be started, the
+ * calling thread runs the whole loop.
+ *
+ * @param begin The first iteration of the loop.
+ * @param end The iteration after the last one.
+ * @param grain The largest number of iterations per call of **body** (one
+ *        if zero).
+ * @param body The function that runs a range of iterations.
+ * @param arg The argument passed to **body**.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ *
+ */
+oe_result_t oe_parallel_for(
+    uint64_t begin,
+    uint64_t end,
+    uint64_t grain,
+    oe_parallel_for_body_t body,
+    void* arg);
+
+/**
+ * Set the largest number of threads working on each parallel job.
+ *
+ * @param max_threads The number of threads, including the thread that
+ *        starts the job, between 1 (no parallelism) and
+ *        OE_PARALLEL_MAX_THREADS (the default).
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER **max_threads** is out of range
+ *
+ */
+oe_result_t oe_parallel_set_max_threads(size_t max_threads);
+
+/**
+ * A group of tasks run in parallel, which can be waited for together.
+ */
+typedef struct _oe_task_group
+{
+    /* The number of tasks not finished yet */
+    volatile uint64_t pending;
+} oe_task_group_t;
+
+#define OE_TASK_GROUP_INITIALIZER \
+    {                             \
+        0                         \
+    }
+
+/**
+ * Run a task of a task group.
+ *
+ * This function has **func** called with **arg** by a worker thread, or by
+ * a thread waiting for a task group, and returns at once. If the task
+ * cannot be queued, it is run before this function returns.
+ *
+ * @param group The task group of the task.
+ * @param func The function run by the task.
+ * @param arg The argument passed to **func**.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ *
+ */
+oe_result_t oe_task_group_run(
+    oe_task_group_t* group,
+    void (*func)(void*),
+    void* arg);
+
+/**
+ * Wait for the tasks of a task group.
+ *
+ * This function runs queued tasks, of this group or others, until all the
+ * tasks of the group have finished.
+ *
+ * @param group The task group to wait for.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER **group** is null
+ *
+ */
+oe_result_t oe_task_group_wait(oe_task_group_t* group);
+
+OE_EXTERNC_END
+
+#ifdef __cplusplus
+
+#include <type_traits>
+#include <utility>
+
+namespace oe
+{
+/* Call f(i) for each i of [begin, end), in ranges of at most grain
+ * iterations run in parallel */
+template <typename F>
+void parallel_for(uint64_t begin, uint64_t end, uint64_t grain, const F& f)
+{
+    struct thunk
+    {
+        static void run(uint64_t first, uint64_t last, void* arg)
+        {
+            const F& func = *static_cast<const F*>(arg);
+
+            for (uint64_t i = first; i < last; i++)
+                func(i);
+        }
+    };
+
+    oe_parallel_for(begin, end, grain, thunk::run, const_cast<F*>(&f));
+}
+
+/* Runs callables in parallel; the destructor waits for them */
+class task_group
+{
+  public:
+    task_group()
+    {
+        _group.pending = 0;
+    }
+
+    ~task_group()
+    {
+        wait();
+    }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    template <typename F>
+    void run(F&& f)
+    {
+        typedef typename std::decay<F>::type func_type;
+
+        oe_task_group_run(
+            &_group, _invoke<func_type>, new func_type(std::forward<F>(f)));
+    }
+
+    void wait()
+    {
+        oe_task_group_wait(&_group);
+    }
+
+  private:
+    template <typename F>
+    static void _invoke(void* arg)
+    {
+        F* func = static_cast<F*>(arg);
+
+        (*func)();
+        delete func;
+    }
+
+    oe_task_group_t _group;
+};
+} // namespace oe
+
+#endif /* __cplusplus */
+
+#endif /* OE_BUILD_ENCLAVE */
+
+#endif /* _OE_INTERNAL_PARALLEL_H */
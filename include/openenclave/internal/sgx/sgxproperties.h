@@ -26,7 +26,8 @@ OE_INLINE bool oe_sgx_is_valid_num_stack_pages(uint64_t x)
 
 OE_INLINE bool oe_sgx_is_valid_num_tcs(uint64_t x)
 {
-    return x <= OE_SGX_MAX_TCS;
+    /* An enclave needs a TCS to be initialized */
+    return x >= 1 && x <= OE_SGX_MAX_TCS;
 }
 
 OE_INLINE bool oe_sgx_is_valid_attributes(uint64_t x)
@@ -563,7 +563,14 @@ oe_thread_data_t* oe_get_thread_data(void);
 
 #define TD_MAGIC 0xc90afe906c5d19a3
 
-#define OE_THREAD_LOCAL_SPACE (3840)
+/* The 32-bit word that the host fills the stack pages of each TCS with,
+ * from which the stack usage is measured */
+#define OE_SGX_STACK_FILL 0xcccccccc
+
+/* What remains of the page of td_t for thread-local variables. Every field
+ * added to td_t takes its size from here: applications see the limit (see
+ * CHANGELOG.md) */
+#define OE_THREAD_LOCAL_SPACE (3672)
 
 typedef struct _callsite Callsite;
 
@@ -604,6 +611,70 @@ typedef struct _td
     /* Simulation mode is active if non-zero */
     uint64_t simulate;
 
+    /* Switchless call owned by this thread (host memory) or null */
+    void* switchless_call;
+
+    /* Non-zero while the buffer of switchless_call is allocated */
+    uint64_t switchless_call_busy;
+
+    /* Untrusted arena that OCALL buffers are allocated from (host memory),
+     * or all ones if the host failed to supply it */
+    void* ocall_arena;
+
+    /* Bytes of ocall_arena in use */
+    uint64_t ocall_arena_used;
+
+    /* Offset of the most recent allocation in ocall_arena */
+    uint64_t ocall_arena_top;
+
+    /* Queue of the OCALLs deferred until the next exit (host memory) */
+    void* deferred_ocall_queue;
+
+    /* Bytes of deferred_ocall_queue in use and number of calls queued */
+    uint64_t deferred_ocall_queue_used;
+    uint64_t deferred_ocall_queue_calls;
+
+    /* Size of the deferred OCALL being prepared (zero if none) */
+    uint64_t deferred_ocall_pending;
+
+    /* Scratch buffer for the arguments of ECALLs handled by this thread */
+    void* ecall_scratch;
+
+    /* How this thread waits for a mutex or condition variable (see
+     * enclave/core/sgx/thread.c) */
+    uint64_t wait_state;
+
+    /* Reader slot of this thread in distributed readers-writer locks plus
+     * one, or zero until the thread first takes such a lock */
+    uint64_t rwlock_slot;
+
+    /* Running counts of the lock waits of this thread, attributed to locks
+     * by the lock contention profiler (see enclave/core/sgx/lockstats.h) */
+    uint64_t lock_contentions;
+    uint64_t lock_spins;
+    uint64_t lock_parks;
+    uint64_t lock_wait_ns;
+
+    /* Cache of small free blocks of the thread-caching allocator, or null
+     * until the thread first allocates (see enclave/core/malloccache.c) */
+    void* malloc_cache;
+
+    /* Arena returned by oe_get_thread_arena(), reset when the outermost ECALL
+     * returns, or null until first requested (see enclave/core/arena.c) */
+    void* arena;
+
+    /* Cache of free blocks of the untrusted memory pool, or null until the
+     * thread first allocates from it (see enclave/core/sgx/hostpool.c) */
+    void* host_pool_cache;
+
+    /* Epoch of the heap profile and bytes left before the next sampled
+     * allocation of the thread (see enclave/core/heapprofile.c) */
+    uint64_t heap_profile_countdown;
+
+    /* Magazines of the thread for each slab cache, or null until the thread
+     * first uses one (see enclave/core/slab.c) */
+    void* slab_magazines;
+
     /* Reserved for thread-local variables. */
     uint8_t thread_local_data[OE_THREAD_LOCAL_SPACE];
 } td_t;
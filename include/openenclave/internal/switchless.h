@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_SWITCHLESS_H
+#define _OE_INTERNAL_SWITCHLESS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** Switchless calls:
+**
+**     A switchless call is carried out by a worker thread on the other side
+**     of the enclave boundary instead of by the calling thread:
+**
+**     - Switchless OCALLs are carried out by host worker threads. The
+**       calling enclave thread never leaves the enclave.
+**
+**     - Switchless ECALLs are carried out by enclave worker threads, which
+**       are host threads parked inside the enclave on dedicated TCSs. The
+**       calling host thread never enters the enclave.
+**
+**     The caller posts the call onto a queue that lives in host memory and
+**     spins until a worker reports that the call has completed. All of the
+**     structures below reside in host memory and are shared by the host and
+**     the enclave. The enclave never trusts their contents beyond what it
+**     would trust for an ordinary OCALL or ECALL.
+**
+**     The ring of a queue is a bounded multi-producer/multi-consumer queue of
+**     call pointers (see "Bounded MPMC queue", D. Vyukov).
+**
+**==============================================================================
+*/
+
+/* Size of the marshaling buffer that follows each switchless OCALL */
+#define OE_SWITCHLESS_BUFFER_SIZE (16 * 1024)
+
+/* Number of switchless ECALLs that can be in flight at once */
+#define OE_SWITCHLESS_MAX_ECALLS 64
+
+/* Number of polling iterations before a worker goes to sleep */
+#define OE_SWITCHLESS_WORKER_SPIN_COUNT 8192
+
+/* Number of polling iterations before the caller reclaims a posted call */
+#define OE_SWITCHLESS_PICKUP_SPIN_COUNT 4096
+
+/* States of a switchless call */
+#define OE_SWITCHLESS_CALL_STATE_IDLE 0
+#define OE_SWITCHLESS_CALL_STATE_POSTED 1
+#define OE_SWITCHLESS_CALL_STATE_RUNNING 2
+#define OE_SWITCHLESS_CALL_STATE_DONE 3
+
+typedef struct _oe_switchless_call
+{
+    /* One of OE_SWITCHLESS_CALL_STATE_* */
+    volatile uint64_t state;
+
+    /* Arguments passed to the host function dispatcher */
+    oe_call_host_function_args_t args;
+
+    /* Pad to a multiple of the cache line; the buffer follows immediately */
+    uint8_t padding[56];
+} oe_switchless_call_t;
+
+OE_STATIC_ASSERT(sizeof(oe_switchless_call_t) == 128);
+
+/* Distance in bytes between two consecutive switchless OCALLs */
+#define OE_SWITCHLESS_CALL_STRIDE \
+    (sizeof(oe_switchless_call_t) + OE_SWITCHLESS_BUFFER_SIZE)
+
+/* Returns the marshaling buffer of the given call */
+OE_INLINE uint8_t* oe_switchless_call_buffer(oe_switchless_call_t* call)
+{
+    return (uint8_t*)(call + 1);
+}
+
+typedef struct _oe_switchless_ecall
+{
+    /* One of OE_SWITCHLESS_CALL_STATE_* */
+    volatile uint64_t state;
+
+    /* Result of dispatching the call inside the enclave */
+    volatile uint64_t result;
+
+    /* Arguments passed to the enclave function dispatcher */
+    oe_call_enclave_function_args_t args;
+
+    /* Pad to a multiple of the cache line */
+    uint8_t padding[48];
+} oe_switchless_ecall_t;
+
+OE_STATIC_ASSERT(sizeof(oe_switchless_ecall_t) == 128);
+
+typedef struct _oe_switchless_ring_cell
+{
+    volatile uint64_t sequence;
+    void* volatile item;
+} oe_switchless_ring_cell_t;
+
+typedef struct _oe_switchless_queue
+{
+    /* Next position to be written by the callers (producers) */
+    OE_ALIGNED(64) volatile uint64_t tail;
+
+    /* Next position to be read by the workers (consumers) */
+    OE_ALIGNED(64) volatile uint64_t head;
+
+    /* Number of workers that are awake and polling the ring */
+    OE_ALIGNED(64) volatile uint64_t spinning_workers;
+
+    /* Set by the host when the workers must exit */
+    volatile uint64_t stopping;
+
+    /* Calls carried out by workers and calls that fell back to an ordinary
+     * transition. These are statistics only and are never trusted. */
+    volatile uint64_t switchless_calls;
+    volatile uint64_t fallback_calls;
+
+    /* The ring: capacity is a power of two */
+    oe_switchless_ring_cell_t* cells;
+    uint64_t capacity;
+
+    /* The calls (oe_switchless_call_t or oe_switchless_ecall_t) that may be
+     * posted onto the ring */
+    void* calls;
+    uint64_t num_calls;
+} oe_switchless_queue_t;
+
+/*
+**==============================================================================
+**
+** oe_switchless_ring_push()
+** oe_switchless_ring_pop()
+**
+**     Lock-free push and pop over the ring cells. Both return false when the
+**     ring is full (push) or empty (pop). The capacity and cell array are
+**     passed explicitly so that the enclave can use its own trusted copies.
+**
+**==============================================================================
+*/
+
+OE_INLINE bool oe_switchless_ring_push(
+    volatile uint64_t* tail,
+    oe_switchless_ring_cell_t* cells,
+    uint64_t capacity,
+    void* item)
+{
+    uint64_t pos = *tail;
+
+    for (;;)
+    {
+        oe_switchless_ring_cell_t* cell = &cells[pos & (capacity - 1)];
+        uint64_t seq = oe_atomic_load(&cell->sequence);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+
+        if (diff == 0)
+        {
+            if (oe_atomic_compare_and_swap(tail, pos, pos + 1))
+            {
+                cell->item = item;
+                oe_atomic_store(&cell->sequence, pos + 1);
+                return true;
+            }
+
+            pos = *tail;
+        }
+        else if (diff < 0)
+        {
+            /* The ring is full */
+            return false;
+        }
+        else
+        {
+            pos = *tail;
+        }
+    }
+}
+
+OE_INLINE bool oe_switchless_ring_pop(
+    volatile uint64_t* head,
+    oe_switchless_ring_cell_t* cells,
+    uint64_t capacity,
+    void** item)
+{
+    uint64_t pos = *head;
+
+    for (;;)
+    {
+        oe_switchless_ring_cell_t* cell = &cells[pos & (capacity - 1)];
+        uint64_t seq = oe_atomic_load(&cell->sequence);
+        int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+
+        if (diff == 0)
+        {
+            if (oe_atomic_compare_and_swap(head, pos, pos + 1))
+            {
+                *item = cell->item;
+                oe_atomic_store(&cell->sequence, pos + capacity);
+                return true;
+            }
+
+            pos = *head;
+        }
+        else if (diff < 0)
+        {
+            /* The ring is empty */
+            return false;
+        }
+        else
+        {
+            pos = *head;
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_stats_t:
+**
+**     Counts of the calls requested as switchless, by how they were made.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_stats
+{
+    /* ECALLs carried out by enclave workers */
+    uint64_t switchless_ecalls;
+
+    /* ECALLs made as ordinary ECALLs instead */
+    uint64_t fallback_ecalls;
+
+    /* OCALLs carried out by host workers */
+    uint64_t switchless_ocalls;
+
+    /* OCALLs made as ordinary OCALLs instead */
+    uint64_t fallback_ocalls;
+} oe_switchless_stats_t;
+
+/* Host only: get the switchless call counters of the given enclave */
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* stats);
+
+OE_EXTERNC_END
+
+#endif /* _OE_INTERNAL_SWITCHLESS_H */
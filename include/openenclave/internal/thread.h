@@ -22,6 +22,46 @@ typedef struct _oe_thread_wake_wait_args
     const void* self_tcs;
 } oe_thread_wake_wait_args_t;
 
+/*
+**==============================================================================
+**
+** oe_thread_wake_multiple_args_t
+**
+**     The array of the num_tcs TCSs to wake follows the structure in the
+**     same host buffer.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_wake_multiple_args
+{
+    uint64_t num_tcs;
+} oe_thread_wake_multiple_args_t;
+
+/*
+**==============================================================================
+**
+** oe_thread_wait_timed_args_t
+**
+**     The arguments and results of OE_OCALL_THREAD_WAIT_TIMED. Like it,
+**     OE_OCALL_THREAD_WAIT and OE_OCALL_THREAD_WAKE_WAIT report the time the
+**     thread waited, in nanoseconds, which they return.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_wait_timed_args
+{
+    /* The deadline, in nanoseconds since the Epoch */
+    uint64_t deadline;
+
+    /* The time the thread waited, in nanoseconds */
+    uint64_t wait_ns;
+
+    /* Whether the deadline passed before the thread was woken */
+    bool timed_out;
+} oe_thread_wait_timed_args_t;
+
 #ifdef OE_BUILD_ENCLAVE
 OE_EXTERNC_BEGIN
 
@@ -66,6 +106,65 @@ oe_thread_t oe_thread_self(void);
  */
 bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2);
 
+/**
+ * Start a thread in the enclave.
+ *
+ * This function starts a thread that calls **start_routine** with **arg**.
+ * The thread is run by one of the host threads that the enclave was given
+ * with the OE_ENCLAVE_SETTING_THREAD_POOL setting, each of which holds a
+ * TCS of its own. The thread must be joined with oe_thread_join() or
+ * detached with oe_thread_detach() to release its resources.
+ *
+ * The identifier set into **thread** is not the one that oe_thread_self()
+ * returns within the new thread.
+ *
+ * @param thread Set to the identifier of the new thread.
+ * @param start_routine The function run by the new thread.
+ * @param arg The argument passed to **start_routine**.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_OUT_OF_MEMORY insufficient memory exists to create the thread
+ * @return OE_OUT_OF_THREADS all the threads of the pool are in use
+ * @return OE_UNSUPPORTED the enclave was created without a thread pool
+ *
+ */
+oe_result_t oe_thread_create(
+    oe_thread_t* thread,
+    void* (*start_routine)(void*),
+    void* arg);
+
+/**
+ * Wait for a thread to finish.
+ *
+ * This function waits for a thread started with oe_thread_create() to
+ * finish and releases its resources.
+ *
+ * @param thread The identifier of the thread to wait for.
+ * @param retval If non-null, set to the value returned by the thread.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_NOT_FOUND there is no such thread
+ * @return OE_INVALID_PARAMETER the thread is detached or already joined
+ *
+ */
+oe_result_t oe_thread_join(oe_thread_t thread, void** retval);
+
+/**
+ * Detach a thread.
+ *
+ * This function has the resources of a thread started with
+ * oe_thread_create() released as soon as it finishes, without joining it.
+ *
+ * @param thread The identifier of the thread to detach.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_NOT_FOUND there is no such thread
+ * @return OE_INVALID_PARAMETER the thread is detached or already joined
+ *
+ */
+oe_result_t oe_thread_detach(oe_thread_t thread);
+
 typedef uint32_t oe_once_t;
 
 /**
@@ -236,6 +335,23 @@ oe_result_t oe_mutex_init(oe_mutex_t* mutex);
  */
 oe_result_t oe_mutex_lock(oe_mutex_t* mutex);
 
+/**
+ * Acquire a lock on a mutex, giving up at a deadline.
+ *
+ * This function behaves like oe_mutex_lock() but returns OE_TIMEOUT if the
+ * mutex is still unavailable when the deadline passes.
+ *
+ * @param mutex Acquire a lock on this mutex.
+ * @param deadline The absolute time, in nanoseconds since the Epoch
+ *        (CLOCK_REALTIME), at which to give up.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_TIMEOUT the deadline passed before the mutex was acquired
+ *
+ */
+oe_result_t oe_mutex_timedlock(oe_mutex_t* mutex, uint64_t deadline);
+
 /**
  * Try to acquire a lock on a mutex.
  *
@@ -336,6 +452,29 @@ oe_result_t oe_cond_init(oe_cond_t* cond);
  */
 oe_result_t oe_cond_wait(oe_cond_t* cond, oe_mutex_t* mutex);
 
+/**
+ * Wait on a condition variable until signaled or until a deadline.
+ *
+ * This function behaves like oe_cond_wait() but returns OE_TIMEOUT if the
+ * thread is not signaled before the deadline passes. The mutex is locked
+ * again in either case.
+ *
+ * @param cond Wait on this condition variable.
+ * @param mutex This mutex must be locked by the caller.
+ * @param deadline The absolute time, in nanoseconds since the Epoch
+ *        (CLOCK_REALTIME), at which to give up.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the mutex is not locked by the calling thread.
+ * @return OE_TIMEOUT the deadline passed before the thread was signaled
+ *
+ */
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* cond,
+    oe_mutex_t* mutex,
+    uint64_t deadline);
+
 /**
  * Signal a thread waiting on a condition variable.
  *
@@ -417,6 +556,30 @@ typedef struct _oe_rwlock
  */
 oe_result_t oe_rwlock_init(oe_rwlock_t* rw_lock);
 
+/**
+ * Initialize a distributed readers-writer lock.
+ *
+ * This function initializes a readers-writer lock for data that is read
+ * often and written rarely. Its readers are counted in one slot per TCS,
+ * each in its own cache line, so threads taking the lock for reading do not
+ * contend with each other. A writer waits for the readers inside to leave
+ * while new readers wait for the writer (writer preference), which makes
+ * taking the lock for writing more costly than for a lock initialized with
+ * oe_rwlock_init().
+ *
+ * The lock is used with the other oe_rwlock functions, and the memory of its
+ * slots is released by oe_rwlock_destroy(). On OP-TEE, this function is the
+ * same as oe_rwlock_init().
+ *
+ * @param rw_lock Initialize this readers-writer variable.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_OUT_OF_MEMORY insufficient memory exists for the reader slots
+ *
+ */
+oe_result_t oe_rwlock_init_distributed(oe_rwlock_t* rw_lock);
+
 /**
  * Acquire a read lock on a readers-writer lock.
  *
@@ -446,6 +609,23 @@ oe_result_t oe_rwlock_init(oe_rwlock_t* rw_lock);
  */
 oe_result_t oe_rwlock_rdlock(oe_rwlock_t* rw_lock);
 
+/**
+ * Acquire a read lock on a readers-writer lock, giving up at a deadline.
+ *
+ * This function behaves like oe_rwlock_rdlock() but returns OE_TIMEOUT if
+ * the lock is still locked for writing when the deadline passes.
+ *
+ * @param rw_lock Acquire a read lock on this readers-writer lock.
+ * @param deadline The absolute time, in nanoseconds since the Epoch
+ *        (CLOCK_REALTIME), at which to give up.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_TIMEOUT the deadline passed before the lock was acquired
+ *
+ */
+oe_result_t oe_rwlock_timedrdlock(oe_rwlock_t* rw_lock, uint64_t deadline);
+
 /**
  * Try to acquire a read lock on a readers-writer lock.
  *
@@ -531,6 +711,24 @@ oe_result_t oe_rwlock_unlock(oe_rwlock_t* rw_lock);
  */
 oe_result_t oe_rwlock_wrlock(oe_rwlock_t* rw_lock);
 
+/**
+ * Acquire a write lock on a readers-writer lock, giving up at a deadline.
+ *
+ * This function behaves like oe_rwlock_wrlock() but returns OE_TIMEOUT if
+ * the lock is still locked when the deadline passes.
+ *
+ * @param rw_lock Acquire a write lock on this readers-writer lock.
+ * @param deadline The absolute time, in nanoseconds since the Epoch
+ *        (CLOCK_REALTIME), at which to give up.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY object is already locked for writing by this thread
+ * @return OE_TIMEOUT the deadline passed before the lock was acquired
+ *
+ */
+oe_result_t oe_rwlock_timedwrlock(oe_rwlock_t* rw_lock, uint64_t deadline);
+
 /**
  * Try to acquire a write lock on a readers-writer lock.
  *
@@ -573,6 +771,86 @@ oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* rw_lock);
  */
 oe_result_t oe_rwlock_destroy(oe_rwlock_t* rw_lock);
 
+/**
+ * Wait on a futex word.
+ *
+ * This function atomically checks that the 32-bit word at **addr** still
+ * holds **val** and, if so, puts the calling thread to sleep until
+ * oe_futex_wake() or oe_futex_requeue() wakes it or the deadline passes.
+ * The word is only compared, never written: its meaning is up to the
+ * synchronization object built on it. Any address may be used; no
+ * initialization or destruction is needed.
+ *
+ * As with the Linux futex, the function may return OE_OK without a
+ * matching wake-up, so callers must re-check the word in a loop.
+ *
+ * @param addr The address of the futex word (4-byte aligned).
+ * @param val The value the word is expected to hold.
+ * @param deadline The absolute time, in nanoseconds since the Epoch
+ *        (CLOCK_REALTIME), at which to give up, or OE_UINT64_MAX to wait
+ *        without a deadline.
+ *
+ * @return OE_OK the thread was woken
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the word did not hold **val**
+ * @return OE_TIMEOUT the deadline passed before the thread was woken
+ * @return OE_UNSUPPORTED the platform cannot block (OP-TEE)
+ *
+ */
+oe_result_t oe_futex_wait(
+    volatile uint32_t* addr,
+    uint32_t val,
+    uint64_t deadline);
+
+/**
+ * Wake threads waiting on a futex word.
+ *
+ * This function wakes up to **count** of the threads waiting on **addr**,
+ * in the order in which they started waiting. Pass OE_SIZE_MAX to wake all
+ * of them.
+ *
+ * @param addr The address of the futex word.
+ * @param count The largest number of threads to wake.
+ * @param woken If non-null, set to the number of threads woken.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ *
+ */
+oe_result_t oe_futex_wake(
+    volatile uint32_t* addr,
+    size_t count,
+    size_t* woken);
+
+/**
+ * Wake threads waiting on a futex word and move others to another word.
+ *
+ * This function checks that the word at **addr** still holds **val**, then
+ * wakes up to **num_wake** of the threads waiting on **addr** and moves up
+ * to **num_requeue** of the others to wait on **addr2** instead, without
+ * waking them. A condition variable uses it to move its waiters to the
+ * mutex they will lock rather than wake them all at once.
+ *
+ * @param addr The address of the futex word.
+ * @param val The value the word at **addr** is expected to hold.
+ * @param num_wake The largest number of threads to wake.
+ * @param addr2 The address of the futex word to move threads to.
+ * @param num_requeue The largest number of threads to move.
+ * @param count If non-null, set to the number of threads woken or moved.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the word at **addr** did not hold **val**
+ *
+ */
+oe_result_t oe_futex_requeue(
+    volatile uint32_t* addr,
+    uint32_t val,
+    size_t num_wake,
+    volatile uint32_t* addr2,
+    size_t num_requeue,
+    size_t* count);
+
 typedef uint32_t oe_thread_key_t;
 
 /**
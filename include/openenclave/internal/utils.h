@@ -207,6 +207,12 @@ OE_INLINE uint64_t oe_round_down_to_page_size(uint64_t x)
     return x & ~((uint64_t)OE_PAGE_SIZE - 1);
 }
 
+/* Returns the number of pages needed to hold x bytes */
+OE_INLINE uint64_t oe_count_pages(uint64_t x)
+{
+    return oe_round_up_to_page_size(x) / OE_PAGE_SIZE;
+}
+
 OE_EXTERNC_END
 
 #endif /* _OE_UTILS_H */
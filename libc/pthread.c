@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <openenclave/corelibc/pthread.h>
+#include <openenclave/corelibc/semaphore.h>
 #include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/defs.h>
@@ -9,6 +10,7 @@
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
 #include <pthread.h>
+#include <semaphore.h>
 
 #ifdef pthread_equal
 #undef pthread_equal
@@ -22,6 +24,7 @@
 #undef OE_INLINE
 #define OE_INLINE
 #endif
+#include <openenclave/corelibc/bits/pthread_barrier.h>
 #include <openenclave/corelibc/bits/pthread_cond.h>
 #include <openenclave/corelibc/bits/pthread_equal.h>
 #include <openenclave/corelibc/bits/pthread_key.h>
@@ -29,6 +32,7 @@
 #include <openenclave/corelibc/bits/pthread_once.h>
 #include <openenclave/corelibc/bits/pthread_rwlock.h>
 #include <openenclave/corelibc/bits/pthread_spin.h>
+#include <openenclave/corelibc/bits/semaphore.h>
 #if defined(__UNDEF_OE_NEED_STDC_NAMES)
 #undef OE_NEED_STDC_NAMES
 #undef __UNDEF_OE_NEED_STDC_NAMES
@@ -47,6 +51,10 @@ OE_STATIC_ASSERT(sizeof(pthread_spinlock_t) == sizeof(oe_spinlock_t));
 OE_STATIC_ASSERT(sizeof(pthread_mutex_t) >= sizeof(oe_mutex_t));
 OE_STATIC_ASSERT(sizeof(pthread_cond_t) >= sizeof(oe_cond_t));
 OE_STATIC_ASSERT(sizeof(pthread_rwlock_t) >= sizeof(oe_rwlock_t));
+OE_STATIC_ASSERT(sizeof(pthread_barrier_t) >= sizeof(oe_pthread_barrier_t));
+OE_STATIC_ASSERT(sizeof(sem_t) >= sizeof(oe_sem_t));
+OE_STATIC_ASSERT(
+    PTHREAD_BARRIER_SERIAL_THREAD == OE_PTHREAD_BARRIER_SERIAL_THREAD);
 
 static __thread struct __pthread _pthread_self = {.locale = C_LOCALE};
 
@@ -70,11 +78,13 @@ int pthread_create(
     void* (*start_routine)(void*),
     void* arg)
 {
+    /* Without hooks, threads are run by the host thread pool */
     if (!_pthread_hooks || !_pthread_hooks->create)
-    {
-        oe_assert("pthread_create(): panic" == NULL);
-        return -1;
-    }
+        return oe_pthread_create(
+            (oe_pthread_t*)thread,
+            (const oe_pthread_attr_t*)attr,
+            start_routine,
+            arg);
 
     return _pthread_hooks->create(thread, attr, start_routine, arg);
 }
@@ -82,10 +92,7 @@ int pthread_create(
 int pthread_join(pthread_t thread, void** retval)
 {
     if (!_pthread_hooks || !_pthread_hooks->join)
-    {
-        oe_assert("pthread_join(): panic" == NULL);
-        return -1;
-    }
+        return oe_pthread_join((oe_pthread_t)thread, retval);
 
     return _pthread_hooks->join(thread, retval);
 }
@@ -93,10 +100,7 @@ int pthread_join(pthread_t thread, void** retval)
 int pthread_detach(pthread_t thread)
 {
     if (!_pthread_hooks || !_pthread_hooks->detach)
-    {
-        oe_assert("pthread_detach(): panic" == NULL);
-        return -1;
-    }
+        return oe_pthread_detach((oe_pthread_t)thread);
 
     return _pthread_hooks->detach(thread);
 }
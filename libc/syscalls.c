@@ -125,6 +125,138 @@ done:
     return ret;
 }
 
+/* Operations of SYS_futex (see linux/futex.h) */
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+/* Computes the deadline of a futex wait in nanoseconds since the Epoch,
+ * OE_UINT64_MAX if it has none. A zero deadline is valid: it has passed */
+static oe_result_t _futex_deadline(
+    const struct timespec* timeout,
+    bool absolute,
+    uint64_t* deadline)
+{
+    uint64_t msec = 0;
+    uint64_t nsec;
+
+    if (!timeout)
+    {
+        *deadline = OE_UINT64_MAX;
+        return OE_OK;
+    }
+
+    if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 ||
+        timeout->tv_nsec >= 1000000000L)
+        return OE_INVALID_PARAMETER;
+
+    /* Relative timeouts start now. The enclave only has the realtime clock,
+     * which also serves for the waits on the monotonic clock */
+    if (!absolute && (msec = oe_get_time()) == (uint64_t)-1)
+        return OE_FAILURE;
+
+    nsec = msec * _MSEC_TO_NSEC + (uint64_t)timeout->tv_nsec;
+
+    if ((uint64_t)timeout->tv_sec > (OE_UINT64_MAX - 1 - nsec) / 1000000000UL)
+        *deadline = OE_UINT64_MAX - 1;
+    else
+        *deadline = nsec + (uint64_t)timeout->tv_sec * 1000000000UL;
+
+    return OE_OK;
+}
+
+/* Implement the futex operations that MUSL uses on oe_futex_wait() and
+ * oe_futex_wake(). Returns -errno on failure, as the kernel does */
+static long _syscall_futex(
+    long n,
+    long x1,
+    long x2,
+    long x3,
+    long x4,
+    long x5,
+    long x6)
+{
+    volatile uint32_t* addr = (volatile uint32_t*)x1;
+    const int op = (int)x2 & ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME);
+    const uint32_t val = (uint32_t)x3;
+    size_t count = 0;
+    uint64_t deadline;
+    oe_result_t result;
+
+    OE_UNUSED(n);
+
+    switch (op)
+    {
+        case FUTEX_WAIT:
+        case FUTEX_WAIT_BITSET:
+        {
+            if (op == FUTEX_WAIT_BITSET &&
+                (uint32_t)x6 != FUTEX_BITSET_MATCH_ANY)
+                return -ENOSYS;
+
+            /* FUTEX_WAIT_BITSET takes an absolute timeout */
+            if (_futex_deadline(
+                    (const struct timespec*)x4,
+                    op == FUTEX_WAIT_BITSET,
+                    &deadline) != OE_OK)
+                return -EINVAL;
+
+            result = oe_futex_wait(addr, val, deadline);
+
+            if (result == OE_BUSY)
+                return -EAGAIN;
+
+            if (result == OE_TIMEOUT)
+                return -ETIMEDOUT;
+
+            if (result == OE_UNSUPPORTED)
+                return -ENOSYS;
+
+            return result == OE_OK ? 0 : -EINVAL;
+        }
+        case FUTEX_WAKE:
+        case FUTEX_WAKE_BITSET:
+        {
+            if (op == FUTEX_WAKE_BITSET &&
+                (uint32_t)x6 != FUTEX_BITSET_MATCH_ANY)
+                return -ENOSYS;
+
+            if (oe_futex_wake(addr, (size_t)(uint32_t)x3, &count) != OE_OK)
+                return -EINVAL;
+
+            return (long)count;
+        }
+        case FUTEX_REQUEUE:
+        case FUTEX_CMP_REQUEUE:
+        {
+            /* FUTEX_REQUEUE compares the word with itself */
+            const uint32_t expected =
+                op == FUTEX_CMP_REQUEUE ? (uint32_t)x6 : *addr;
+
+            result = oe_futex_requeue(
+                addr,
+                expected,
+                (size_t)(uint32_t)x3,
+                (volatile uint32_t*)x5,
+                (size_t)(uint32_t)x4,
+                &count);
+
+            if (result == OE_BUSY)
+                return -EAGAIN;
+
+            return result == OE_OK ? (long)count : -EINVAL;
+        }
+        default:
+            return -ENOSYS;
+    }
+}
+
 static void _stat_to_oe_stat(struct stat* stat, struct oe_stat* oe_stat)
 {
     oe_stat->st_dev = stat->st_dev;
@@ -235,6 +367,11 @@ long __syscall(long n, long x1, long x2, long x3, long x4, long x5, long x6)
         /* The hook ignored the syscall so fall through */
     }
 
+    /* The futex is implemented in the enclave (liboesyscall would only
+     * trace it as not handled) */
+    if (n == SYS_futex)
+        return _syscall_futex(n, x1, x2, x3, x4, x5, x6);
+
     /* Let liboesyscall handle select system calls. */
     {
         long ret;
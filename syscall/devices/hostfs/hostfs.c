@@ -106,6 +106,12 @@ static int _hostfs_closedir(oe_fd_t* desc);
 
 static struct oe_dirent* _hostfs_readdir(oe_fd_t* desc);
 
+/* Devices are cloned by each mount, and files and directories are opened
+ * and closed at a high rate by some enclaves */
+static oe_slab_cache_t _device_cache = OE_SLAB_CACHE_INITIALIZER(device_t);
+static oe_slab_cache_t _file_cache = OE_SLAB_CACHE_INITIALIZER(file_t);
+static oe_slab_cache_t _dir_cache = OE_SLAB_CACHE_INITIALIZER(dir_t);
+
 /* Return true if the file system was mounted as read-only. */
 OE_INLINE bool _is_read_only(const device_t* fs)
 {
@@ -278,7 +284,7 @@ static int _hostfs_clone(oe_device_t* device, oe_device_t** new_device)
     if (!fs || !new_device)
         OE_RAISE_ERRNO(OE_EINVAL);
 
-    if (!(new_fs = oe_calloc(1, sizeof(device_t))))
+    if (!(new_fs = oe_slab_alloc(&_device_cache)))
         OE_RAISE_ERRNO(OE_ENOMEM);
 
     *new_fs = *fs;
@@ -299,7 +305,7 @@ static int _hostfs_release(oe_device_t* device)
     if (!fs)
         OE_RAISE_ERRNO(OE_EINVAL);
 
-    oe_free(fs);
+    oe_slab_free(&_device_cache, fs);
     ret = 0;
 
 done:
@@ -328,7 +334,7 @@ static oe_fd_t* _hostfs_open_file(
 
     /* Create new file struct. */
     {
-        if (!(file = oe_calloc(1, sizeof(file_t))))
+        if (!(file = oe_slab_calloc(&_file_cache)))
             OE_RAISE_ERRNO(OE_ENOMEM);
 
         file->base.type = OE_FD_TYPE_FILE;
@@ -356,7 +362,7 @@ static oe_fd_t* _hostfs_open_file(
 done:
 
     if (file)
-        oe_free(file);
+        oe_slab_free(&_file_cache, file);
 
     return ret;
 }
@@ -385,7 +391,7 @@ static oe_fd_t* _hostfs_open_directory(
 
     /* Allocate and initialize the file struct. */
     {
-        if (!(file = oe_calloc(1, sizeof(file_t))))
+        if (!(file = oe_slab_calloc(&_file_cache)))
             OE_RAISE_ERRNO(OE_ENOMEM);
 
         file->base.type = OE_FD_TYPE_FILE;
@@ -402,7 +408,7 @@ static oe_fd_t* _hostfs_open_directory(
 done:
 
     if (file)
-        oe_free(file);
+        oe_slab_free(&_file_cache, file);
 
     if (dir)
         _hostfs_closedir(dir);
@@ -442,7 +448,7 @@ static int _hostfs_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
 
     /* Create and initialize the new file structure. */
     {
-        if (!(new_file = oe_calloc(1, sizeof(file_t))))
+        if (!(new_file = oe_slab_calloc(&_file_cache)))
             OE_RAISE_ERRNO(oe_errno);
 
         new_file->base.type = OE_FD_TYPE_FILE;
@@ -470,7 +476,7 @@ static int _hostfs_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
 done:
 
     if (new_file)
-        oe_free(new_file);
+        oe_slab_free(&_file_cache, new_file);
 
     return ret;
 }
@@ -704,7 +710,7 @@ static int _hostfs_close_file(oe_fd_t* desc)
     if (retval == -1)
         OE_RAISE_ERRNO(oe_errno);
 
-    oe_free(file);
+    oe_slab_free(&_file_cache, file);
 
     ret = retval;
 
@@ -727,7 +733,7 @@ static int _hostfs_close_directory(oe_fd_t* desc)
         OE_RAISE_ERRNO(oe_errno);
 
     /* Release the file object. */
-    oe_free(file);
+    oe_slab_free(&_file_cache, file);
 
     ret = 0;
 
@@ -865,7 +871,7 @@ static oe_fd_t* _hostfs_opendir(oe_device_t* device, const char* name)
     if (_make_host_path(fs, name, host_name) != 0)
         OE_RAISE_ERRNO_MSG(oe_errno, "name=%s", name);
 
-    if (!(dir = oe_calloc(1, sizeof(dir_t))))
+    if (!(dir = oe_slab_calloc(&_dir_cache)))
         OE_RAISE_ERRNO(OE_ENOMEM);
 
     if (oe_syscall_opendir_ocall(&retval, host_name) != OE_OK)
@@ -885,7 +891,7 @@ static oe_fd_t* _hostfs_opendir(oe_device_t* device, const char* name)
 done:
 
     if (dir)
-        oe_free(dir);
+        oe_slab_free(&_dir_cache, dir);
 
     return ret;
 }
@@ -938,7 +944,7 @@ static int _hostfs_closedir(oe_fd_t* desc)
     if (oe_syscall_closedir_ocall(&retval, dir->host_dir) != OE_OK)
         OE_RAISE_ERRNO(OE_EINVAL);
 
-    oe_free(dir);
+    oe_slab_free(&_dir_cache, dir);
 
     ret = retval;
 
@@ -41,11 +41,14 @@ typedef struct _sock
     oe_host_fd_t host_fd;
 } sock_t;
 
+/* Sockets are opened and closed at a high rate by servers */
+static oe_slab_cache_t _sock_cache = OE_SLAB_CACHE_INITIALIZER(sock_t);
+
 static sock_t* _new_sock(void)
 {
     sock_t* sock = NULL;
 
-    if (!(sock = oe_calloc(1, sizeof(sock_t))))
+    if (!(sock = oe_slab_calloc(&_sock_cache)))
         return NULL;
 
     sock->base.type = OE_FD_TYPE_SOCKET;
@@ -56,6 +59,11 @@ static sock_t* _new_sock(void)
     return sock;
 }
 
+static void _free_sock(sock_t* sock)
+{
+    oe_slab_free(&_sock_cache, sock);
+}
+
 static device_t* _cast_device(const oe_device_t* device)
 {
     device_t* p = (device_t*)device;
@@ -119,7 +127,7 @@ static oe_fd_t* _hostsock_device_socket(
 done:
 
     if (new_sock)
-        oe_free(new_sock);
+        _free_sock(new_sock);
 
     return ret;
 }
@@ -179,10 +187,10 @@ static ssize_t _hostsock_device_socketpair(
 done:
 
     if (pair[0])
-        oe_free(pair[0]);
+        _free_sock(pair[0]);
 
     if (pair[1])
-        oe_free(pair[1]);
+        _free_sock(pair[1]);
 
     return ret;
 }
@@ -279,7 +287,7 @@ static oe_fd_t* _hostsock_accept(
 done:
 
     if (new_sock)
-        oe_free(new_sock);
+        _free_sock(new_sock);
 
     return ret;
 }
@@ -556,7 +564,7 @@ static int _hostsock_close(oe_fd_t* sock_)
         OE_RAISE_ERRNO(OE_EINVAL);
 
     if (ret == 0)
-        oe_free(sock);
+        _free_sock(sock);
 
 done:
 
@@ -660,7 +668,7 @@ static int _hostsock_dup(oe_fd_t* sock_, oe_fd_t** new_sock_out)
 done:
 
     if (new_sock)
-        oe_free(new_sock);
+        _free_sock(new_sock);
 
     return ret;
 }
@@ -3,11 +3,40 @@
 
 #include <openenclave/enclave.h>
 
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/internal/syscall/fdtable.h>
 #include <openenclave/internal/syscall/raise.h>
 #include <openenclave/internal/syscall/sys/poll.h>
 #include "syscall_t.h"
 
+/* Most calls poll a few descriptors, whose host descriptors are allocated
+ * from a slab cache. Those of larger calls are allocated from the heap */
+#define MAX_SLAB_FDS 16
+
+typedef struct _host_fds
+{
+    struct oe_host_pollfd fds[MAX_SLAB_FDS];
+} host_fds_t;
+
+static oe_slab_cache_t _host_fds_cache = OE_SLAB_CACHE_INITIALIZER(host_fds_t);
+
+static struct oe_host_pollfd* _new_host_fds(oe_nfds_t nfds)
+{
+    if (nfds > MAX_SLAB_FDS)
+        return oe_calloc(nfds, sizeof(struct oe_host_pollfd));
+
+    /* The host fds are copied to the host: clear the fields not set */
+    return oe_slab_calloc(&_host_fds_cache);
+}
+
+static void _free_host_fds(struct oe_host_pollfd* host_fds, oe_nfds_t nfds)
+{
+    if (nfds > MAX_SLAB_FDS)
+        oe_free(host_fds);
+    else
+        oe_slab_free(&_host_fds_cache, host_fds);
+}
+
 int oe_poll(struct oe_pollfd* fds, oe_nfds_t nfds, int timeout)
 {
     int ret = -1;
@@ -18,7 +47,7 @@ int oe_poll(struct oe_pollfd* fds, oe_nfds_t nfds, int timeout)
     if (!fds || nfds == 0)
         OE_RAISE_ERRNO(OE_EINVAL);
 
-    if (!(host_fds = oe_calloc(nfds, sizeof(struct oe_host_pollfd))))
+    if (!(host_fds = _new_host_fds(nfds)))
         OE_RAISE_ERRNO(OE_ENOMEM);
 
     /* Convert enclave fds to host fds. */
@@ -51,7 +80,7 @@ int oe_poll(struct oe_pollfd* fds, oe_nfds_t nfds, int timeout)
 done:
 
     if (host_fds)
-        oe_free(host_fds);
+        _free_host_fds(host_fds, nfds);
 
     return ret;
 }
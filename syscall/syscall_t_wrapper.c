@@ -18,6 +18,9 @@
 /* Override oe_call_host_function() calls with _call_host_function(). */
 #define oe_call_host_function _call_host_function
 
+/* Override oe_switchless_call_host_function() calls similarly. */
+#define oe_switchless_call_host_function _switchless_call_host_function
+
 /* Use this function below instead of oe_call_host_function(). */
 static oe_result_t _call_host_function(
     size_t function_id,
@@ -34,7 +37,28 @@ static oe_result_t _call_host_function(
         input_buffer_size,
         output_buffer,
         output_buffer_size,
-        output_bytes_written);
+        output_bytes_written,
+        false);
+}
+
+/* Use this function below instead of oe_switchless_call_host_function(). */
+static oe_result_t _switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_host_function_by_table_id(
+        OE_SYSCALL_OCALL_FUNCTION_TABLE_ID,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written,
+        true);
 }
 
 #include "syscall_t.c"
@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_TESTS_ALLOC_STRESS_H
+#define _OE_TESTS_ALLOC_STRESS_H
+
+#include <openenclave/internal/tests.h>
+
+/*
+**==============================================================================
+**
+** Allocator stress harness:
+**
+**     What the allocator tests (malloc_cache, host_pool and slab) have in
+**     common. Their enclaves run rounds of allocations on the threads of the
+**     enclave thread pool with oe_parallel_for(), passing some blocks to the
+**     other threads through an exchange of slots so that they are freed by
+**     a thread other than the one that allocated them. Blocks are filled
+**     with a byte derived from a seed, checked before they are freed. Their
+**     hosts create the enclave with a thread pool of all its TCSs but the
+**     one of the ECALL, which also takes part in the parallel loops.
+**
+**==============================================================================
+*/
+
+#ifdef OE_BUILD_ENCLAVE
+
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/parallel.h>
+
+#define ALLOC_STRESS_NUM_EXCHANGE_SLOTS 64
+
+/* Blocks passed between threads, which free them */
+static void* volatile _alloc_stress_exchange[ALLOC_STRESS_NUM_EXCHANGE_SLOTS];
+
+/* A round of a stress test. The state of the random number generator is
+ * that of the chunk of rounds of the calling thread */
+typedef void (*alloc_stress_round_t)(uint64_t round, uint64_t* state);
+
+/* Linear congruential generator, good enough to pick sizes and slots */
+OE_INLINE uint64_t alloc_stress_random(uint64_t* state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+OE_INLINE uint8_t alloc_stress_fill_byte(uint64_t seed)
+{
+    return (uint8_t)(seed * 31 + 7);
+}
+
+/* Each block starts with its size, followed by a byte derived from it */
+OE_INLINE void alloc_stress_fill_block(uint8_t* block, size_t size)
+{
+    memset(block, alloc_stress_fill_byte(size), size);
+    *(size_t*)block = size;
+}
+
+/* Checks the first size bytes of a block filled by the function above */
+OE_INLINE void alloc_stress_check_block(const uint8_t* block, size_t size)
+{
+    const uint8_t byte = alloc_stress_fill_byte(*(const size_t*)block);
+
+    for (size_t i = sizeof(size_t); i < size; i++)
+        OE_TEST(block[i] == byte);
+}
+
+/* Puts a block in a random slot of the exchange and returns the block the
+ * slot held, possibly one of another thread, or null */
+OE_INLINE void* alloc_stress_exchange(void* block, uint64_t* state)
+{
+    const size_t slot =
+        alloc_stress_random(state) % ALLOC_STRESS_NUM_EXCHANGE_SLOTS;
+
+    return __atomic_exchange_n(
+        &_alloc_stress_exchange[slot], block, __ATOMIC_ACQ_REL);
+}
+
+OE_INLINE void _alloc_stress_run(uint64_t begin, uint64_t end, void* arg)
+{
+    const alloc_stress_round_t round = *(const alloc_stress_round_t*)arg;
+    uint64_t state = begin + 1;
+
+    for (uint64_t i = begin; i < end; i++)
+        round(i, &state);
+}
+
+/* Runs the given number of rounds in parallel, then frees the blocks left
+ * in the exchange with free_block() */
+OE_INLINE void alloc_stress(
+    uint64_t rounds,
+    alloc_stress_round_t round,
+    void (*free_block)(void* block))
+{
+    OE_TEST(oe_parallel_for(0, rounds, 1, _alloc_stress_run, &round) == OE_OK);
+
+    for (size_t i = 0; i < ALLOC_STRESS_NUM_EXCHANGE_SLOTS; i++)
+    {
+        if (_alloc_stress_exchange[i])
+        {
+            free_block(_alloc_stress_exchange[i]);
+            _alloc_stress_exchange[i] = NULL;
+        }
+    }
+}
+
+#else /* OE_BUILD_ENCLAVE */
+
+#include <openenclave/host.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The oe_create_<name>_enclave() function generated for the test */
+typedef oe_result_t (*alloc_stress_create_t)(
+    const char* path,
+    oe_enclave_type_t type,
+    uint32_t flags,
+    const oe_enclave_setting_t* settings,
+    uint32_t setting_count,
+    oe_enclave_t** enclave);
+
+/* Creates the enclave named on the command line, which has num_tcs TCSs */
+OE_INLINE oe_enclave_t* alloc_stress_create_enclave(
+    int argc,
+    const char* argv[],
+    alloc_stress_create_t create,
+    uint32_t num_tcs)
+{
+    oe_enclave_setting_thread_pool_t thread_pool = {num_tcs - 1};
+    oe_enclave_setting_t setting;
+    oe_enclave_t* enclave = NULL;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        exit(1);
+    }
+
+    setting.setting_type = OE_ENCLAVE_SETTING_THREAD_POOL;
+    setting.u.thread_pool_setting = &thread_pool;
+
+    OE_TEST(
+        create(
+            argv[1],
+            OE_ENCLAVE_TYPE_SGX,
+            oe_get_create_flags(),
+            &setting,
+            1,
+            &enclave) == OE_OK);
+
+    return enclave;
+}
+
+#endif /* OE_BUILD_ENCLAVE */
+
+#endif /* _OE_TESTS_ALLOC_STRESS_H */
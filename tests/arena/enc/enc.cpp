@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/arena_resource.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <experimental/string>
+#include <experimental/vector>
+#include <string.h>
+#include "arena_t.h"
+
+#define ARENA_SIZE 4096
+
+static void _test_alloc(void)
+{
+    oe_arena_t arena;
+    uint8_t* p;
+    uint8_t* q;
+
+    OE_TEST(oe_arena_create(NULL, ARENA_SIZE) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_arena_create(&arena, 0) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_arena_create(&arena, ARENA_SIZE) == OE_OK);
+
+    /* Allocations are aligned and carved in order */
+    OE_TEST((p = (uint8_t*)oe_arena_alloc(&arena, 1)) != NULL);
+    OE_TEST((q = (uint8_t*)oe_arena_alloc(&arena, 100)) != NULL);
+    OE_TEST((uintptr_t)p % OE_ARENA_ALIGNMENT == 0);
+    OE_TEST((uintptr_t)q % OE_ARENA_ALIGNMENT == 0);
+    OE_TEST(q == p + OE_ARENA_ALIGNMENT);
+    memset(q, 0xAA, 100);
+
+    OE_TEST((p = (uint8_t*)oe_arena_memalign(&arena, 256, 8)) != NULL);
+    OE_TEST((uintptr_t)p % 256 == 0);
+    OE_TEST(oe_arena_memalign(&arena, 3, 8) == NULL);
+    OE_TEST(oe_arena_memalign(&arena, 0, 8) == NULL);
+
+    /* An exhausted arena fails without changing */
+    OE_TEST(oe_arena_alloc(&arena, ARENA_SIZE) == NULL);
+    OE_TEST(oe_arena_alloc(&arena, SIZE_MAX) == NULL);
+    OE_TEST(oe_arena_alloc(&arena, 8) == p + 16);
+
+    /* Reset releases everything at once */
+    oe_arena_reset(&arena);
+    OE_TEST((q = (uint8_t*)oe_arena_alloc(&arena, ARENA_SIZE)) != NULL);
+    OE_TEST(oe_arena_alloc(&arena, 1) == NULL);
+    memset(q, 0x55, ARENA_SIZE);
+
+    oe_arena_destroy(&arena);
+    OE_TEST(oe_arena_alloc(&arena, 1) == NULL);
+}
+
+static void _test_buffer(void)
+{
+    /* Not aligned on OE_ARENA_ALIGNMENT */
+    static uint8_t buffer[1025];
+    oe_arena_t arena;
+    uint8_t* p;
+
+    OE_TEST(
+        oe_arena_create_from_buffer(&arena, NULL, 1) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_arena_create_from_buffer(&arena, buffer + 1, 1024) == OE_OK);
+
+    OE_TEST((p = (uint8_t*)oe_arena_alloc(&arena, 16)) != NULL);
+    OE_TEST((uintptr_t)p % OE_ARENA_ALIGNMENT == 0);
+    OE_TEST(p >= buffer + 1 && p + 16 <= buffer + 1025);
+
+    while (oe_arena_alloc(&arena, 16))
+        ;
+
+    OE_TEST(arena.used <= arena.size);
+
+    /* The buffer is not freed */
+    oe_arena_destroy(&arena);
+}
+
+static void _test_resource(void)
+{
+    namespace pmr = std::experimental::pmr;
+    oe_arena_t arena;
+
+    OE_TEST(oe_arena_create(&arena, ARENA_SIZE) == OE_OK);
+
+    /* Containers allocate from the arena */
+    {
+        oe::arena_resource resource(&arena);
+        pmr::vector<int> v(&resource);
+
+        for (int i = 0; i < 100; i++)
+            v.push_back(i);
+
+        OE_TEST(
+            (uint8_t*)v.data() >= arena.base &&
+            (uint8_t*)v.data() < arena.base + arena.size);
+
+        for (int i = 0; i < 100; i++)
+            OE_TEST(v[(size_t)i] == i);
+
+        /* Without an upstream resource, exhausting the arena throws */
+        bool thrown = false;
+
+        try
+        {
+            v.reserve(ARENA_SIZE);
+        }
+        catch (std::bad_alloc&)
+        {
+            thrown = true;
+        }
+
+        OE_TEST(thrown);
+    }
+
+    /* With an upstream resource, allocations spill over to it */
+    oe_arena_reset(&arena);
+    {
+        oe::arena_resource resource(&arena, pmr::new_delete_resource());
+        pmr::string s(&resource);
+
+        s.assign(2 * ARENA_SIZE, 'x');
+        OE_TEST(s.size() == 2 * ARENA_SIZE);
+        OE_TEST(
+            (uint8_t*)s.data() < arena.base ||
+            (uint8_t*)s.data() >= arena.base + arena.size);
+    }
+
+    oe_arena_destroy(&arena);
+}
+
+static void _test_thread_arena(void)
+{
+    oe_arena_t* arena = oe_get_thread_arena();
+
+    OE_TEST(arena != NULL);
+    OE_TEST(oe_get_thread_arena() == arena);
+    OE_TEST(arena->size == OE_THREAD_ARENA_SIZE);
+    OE_TEST(oe_arena_alloc(arena, OE_THREAD_ARENA_SIZE / 2) != NULL);
+}
+
+int enc_test_arena(void)
+{
+    _test_alloc();
+    _test_buffer();
+    _test_resource();
+    _test_thread_arena();
+
+    return 0;
+}
+
+int enc_use_thread_arena(uint64_t* used_on_entry, uint64_t* arena)
+{
+    oe_arena_t* thread_arena = oe_get_thread_arena();
+
+    OE_TEST(thread_arena != NULL);
+
+    *used_on_entry = thread_arena->used;
+    *arena = (uint64_t)thread_arena;
+
+    OE_TEST(oe_arena_alloc(thread_arena, 100) != NULL);
+
+    return 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    1);   /* TCSCount */
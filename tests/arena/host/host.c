@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include "arena_u.h"
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    const uint32_t flags = oe_get_create_flags();
+    int return_value = -1;
+    uint64_t used_on_entry;
+    uint64_t first_arena;
+    uint64_t arena;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_arena_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    result = enc_test_arena(enclave, &return_value);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    /* The enclave has one TCS, so both ECALLs get the same thread arena,
+     * which the first one leaves in use */
+    result = enc_use_thread_arena(
+        enclave, &return_value, &used_on_entry, &first_arena);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+    OE_TEST(first_arena != 0);
+
+    /* The arena was reset when the previous ECALL returned */
+    result =
+        enc_use_thread_arena(enclave, &return_value, &used_on_entry, &arena);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+    OE_TEST(arena == first_arena);
+    OE_TEST(used_on_entry == 0);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_TESTS_BENCH_H
+#define _OE_TESTS_BENCH_H
+
+#include <openenclave/host.h>
+#include <openenclave/internal/types.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef OE_BENCH_VERSION
+#define OE_BENCH_VERSION "unknown"
+#endif
+
+/*
+**==============================================================================
+**
+** Benchmark harness:
+**
+**     What the oebench_* hosts have in common: their common options, the
+**     timing of a benchmark on host threads, and the output of the results
+**     in CSV or JSON. A result is a list of named fields, filled in by each
+**     benchmark with columns of its own; every result of a run has the same
+**     fields.
+**
+**==============================================================================
+*/
+
+struct bench_options
+{
+    uint64_t iterations;
+    size_t max_threads;
+    bool json = false;
+    const char* output = NULL;
+};
+
+struct bench_field
+{
+    const char* name;
+    std::string value;
+
+    /* Whether the value is a string (quoted in JSON) */
+    bool quoted;
+};
+
+typedef std::vector<bench_field> bench_result;
+
+inline bench_field bench_string(const char* name, const std::string& value)
+{
+    return {name, value, true};
+}
+
+inline bench_field bench_uint(const char* name, uint64_t value)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%llu", OE_LLU(value));
+    return {name, buf, false};
+}
+
+inline bench_field bench_double(const char* name, double value, int precision)
+{
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "%.*f", precision, value);
+    return {name, buf, false};
+}
+
+inline uint64_t bench_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/* Parse argv[*i] if it is an option common to the benchmarks, moving *i to
+ * its value. Returns false if it is not one */
+inline bool bench_parse_option(
+    int argc,
+    const char* argv[],
+    int* i,
+    bench_options* opts)
+{
+    const char* arg = argv[*i];
+
+    if (strcmp(arg, "--iterations") == 0 && *i + 1 < argc)
+        opts->iterations = strtoull(argv[++*i], NULL, 10);
+    else if (strcmp(arg, "--threads") == 0 && *i + 1 < argc)
+        opts->max_threads = strtoul(argv[++*i], NULL, 10);
+    else if (strcmp(arg, "--output") == 0 && *i + 1 < argc)
+        opts->output = argv[++*i];
+    else if (strcmp(arg, "--json") == 0)
+        opts->json = true;
+    else
+        return false;
+
+    return true;
+}
+
+/* The powers of two below max_threads, then max_threads */
+inline std::vector<size_t> bench_thread_counts(size_t max_threads)
+{
+    std::vector<size_t> threads;
+
+    for (size_t n = 1; n < max_threads; n *= 2)
+        threads.push_back(n);
+
+    threads.push_back(max_threads);
+    return threads;
+}
+
+/* Run body(n) on the given number of threads at once, the calling thread
+ * included: first with n = warmup, then timed with n = iterations. Returns
+ * the wall-clock time of the timed run */
+inline uint64_t bench_run(
+    size_t threads,
+    uint64_t warmup,
+    uint64_t iterations,
+    const std::function<void(uint64_t)>& body)
+{
+    uint64_t total_ns = 0;
+
+    for (int timed = 0; timed < 2; timed++)
+    {
+        const uint64_t n = timed ? iterations : warmup;
+        std::vector<std::thread> workers;
+        const uint64_t start = bench_now_ns();
+
+        for (size_t i = 1; i < threads; i++)
+            workers.push_back(std::thread(body, n));
+
+        body(n);
+
+        for (auto& worker : workers)
+            worker.join();
+
+        total_ns = bench_now_ns() - start;
+    }
+
+    return total_ns;
+}
+
+inline const char* bench_mode(uint32_t flags)
+{
+    return (flags & OE_ENCLAVE_FLAG_SIMULATE) ? "simulation" : "hardware";
+}
+
+inline void bench_write_results(
+    FILE* os,
+    bool json,
+    const char* mode,
+    const std::vector<bench_result>& results)
+{
+    if (json)
+    {
+        fprintf(os, "{\n");
+        fprintf(os, "  \"version\": \"%s\",\n", OE_BENCH_VERSION);
+        fprintf(os, "  \"mode\": \"%s\",\n", mode);
+        fprintf(os, "  \"results\": [\n");
+    }
+    else
+    {
+        fprintf(os, "version,mode");
+
+        if (!results.empty())
+        {
+            for (const bench_field& field : results[0])
+                fprintf(os, ",%s", field.name);
+        }
+
+        fprintf(os, "\n");
+    }
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const bench_result& result = results[i];
+
+        if (json)
+        {
+            fprintf(os, "    {");
+
+            for (size_t j = 0; j < result.size(); j++)
+            {
+                const bench_field& field = result[j];
+                const char* quote = field.quoted ? "\"" : "";
+
+                fprintf(
+                    os,
+                    "%s\"%s\": %s%s%s",
+                    j ? ", " : "",
+                    field.name,
+                    quote,
+                    field.value.c_str(),
+                    quote);
+            }
+
+            fprintf(os, "}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        else
+        {
+            fprintf(os, "%s,%s", OE_BENCH_VERSION, mode);
+
+            for (const bench_field& field : result)
+                fprintf(os, ",%s", field.value.c_str());
+
+            fprintf(os, "\n");
+        }
+    }
+
+    if (json)
+    {
+        fprintf(os, "  ]\n");
+        fprintf(os, "}\n");
+    }
+}
+
+/* Write the results to the output of the options, the standard output by
+ * default. Returns the exit status of the benchmark */
+inline int bench_output_results(
+    const char* arg0,
+    const bench_options& opts,
+    const char* mode,
+    const std::vector<bench_result>& results)
+{
+    FILE* os = stdout;
+
+    if (opts.output && !(os = fopen(opts.output, "w")))
+    {
+        fprintf(stderr, "%s: cannot open %s\n", arg0, opts.output);
+        return 1;
+    }
+
+    bench_write_results(os, opts.json, mode, results);
+
+    if (os != stdout)
+        fclose(os);
+
+    return 0;
+}
+
+#endif /* _OE_TESTS_BENCH_H */
@@ -151,6 +151,29 @@ void enc_test(test_args* args)
     }
 }
 
+void enc_invert(const unsigned char* in, unsigned char* out, size_t size)
+{
+    /* The output buffer is cleared on entry */
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(out[i] == 0);
+
+    for (size_t i = 0; i < size; i++)
+        out[i] = (unsigned char)~in[i];
+}
+
+static uint64_t _total;
+
+/* Returns the sum of the values passed so far */
+uint64_t enc_accumulate(uint64_t value)
+{
+    return _total += value;
+}
+
+uint64_t enc_get_total()
+{
+    return _total;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/error.h>
@@ -59,6 +60,155 @@ void TestECall(oe_enclave_t* enclave)
     prev = args.thread_data.last_sp;
 }
 
+void TestBufferSizes(oe_enclave_t* enclave)
+{
+    /* Buffers that fit the thread's scratch buffer, that make it grow, and
+     * that are too large to be kept in it; then small ones again */
+    const size_t sizes[] = {1, 4096, 64 * 1024, 1024 * 1024, 100, 8};
+
+    for (size_t i = 0; i < OE_COUNTOF(sizes); i++)
+    {
+        unsigned char* in = (unsigned char*)malloc(sizes[i]);
+        unsigned char* out = (unsigned char*)malloc(sizes[i]);
+
+        OE_TEST(in && out);
+
+        for (size_t j = 0; j < sizes[i]; j++)
+            in[j] = (unsigned char)(i + j);
+
+        OE_TEST(enc_invert(enclave, in, out, sizes[i]) == OE_OK);
+
+        for (size_t j = 0; j < sizes[i]; j++)
+            OE_TEST(out[j] == (unsigned char)~in[j]);
+
+        free(in);
+        free(out);
+    }
+}
+
+void TestBatch(oe_enclave_t* enclave)
+{
+    const size_t count = 1000;
+    uint64_t values[count];
+    uint64_t totals[count];
+    oe_result_t results[count];
+    uint64_t total = 0;
+
+    OE_TEST(enc_get_total(enclave, &total) == OE_OK);
+
+    /* The calls of a batch are made in order */
+    for (size_t i = 0; i < count; i++)
+        values[i] = i + 1;
+
+    OE_TEST(
+        enc_accumulate_batch(enclave, count, results, totals, values) ==
+        OE_OK);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        total += values[i];
+        OE_TEST(results[i] == OE_OK);
+        OE_TEST(totals[i] == total);
+    }
+
+    /* An empty batch does not enter the enclave */
+    OE_TEST(enc_accumulate_batch(enclave, 0, NULL, NULL, NULL) == OE_OK);
+
+    /* A batch can call different functions, and a failed call does not
+     * prevent the calls after it */
+    {
+        /* Marshalling structs padded to the marshalling buffer alignment */
+        union slot {
+            enc_accumulate_args_t accumulate;
+            enc_get_total_args_t get_total;
+            uint8_t bytes[4 * OE_EDGER8R_BUFFER_ALIGNMENT];
+        };
+        static slot slots[3];
+        const uint32_t function_ids[] = {ecall_fcn_id_enc_accumulate,
+                                         0xFFFF,
+                                         ecall_fcn_id_enc_get_total};
+        oe_enclave_function_call_t calls[3];
+
+        OE_STATIC_ASSERT(sizeof(slot) % OE_EDGER8R_BUFFER_ALIGNMENT == 0);
+
+        memset(slots, 0, sizeof(slots));
+        memset(calls, 0, sizeof(calls));
+
+        slots[0].accumulate.value = 5;
+
+        for (size_t i = 0; i < OE_COUNTOF(calls); i++)
+        {
+            calls[i].function_id = function_ids[i];
+            calls[i].input_buffer = &slots[i];
+            calls[i].input_buffer_size = sizeof(slot);
+            calls[i].output_buffer = &slots[i];
+            calls[i].output_buffer_size = sizeof(slot);
+        }
+
+        OE_TEST(
+            oe_call_enclave_functions_batch(
+                enclave, calls, OE_COUNTOF(calls)) == OE_OK);
+
+        OE_TEST(calls[0].result == OE_OK);
+        OE_TEST(slots[0].accumulate._retval == total + 5);
+        OE_TEST(calls[1].result == OE_NOT_FOUND);
+        OE_TEST(calls[2].result == OE_OK);
+        OE_TEST(slots[2].get_total._retval == total + 5);
+    }
+}
+
+void TestCallStats(oe_enclave_t* enclave, size_t count)
+{
+    oe_call_stats_t* stats = NULL;
+    size_t num_stats = 0;
+    bool found = false;
+
+    OE_TEST(
+        oe_get_enclave_call_stats(NULL, NULL, &num_stats) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_get_enclave_call_stats(enclave, NULL, NULL) ==
+        OE_INVALID_PARAMETER);
+
+    /* Ask for the number of functions called so far */
+    OE_TEST(
+        oe_get_enclave_call_stats(enclave, NULL, &num_stats) ==
+        OE_BUFFER_TOO_SMALL);
+    OE_TEST(num_stats > 0);
+
+    stats = (oe_call_stats_t*)calloc(num_stats, sizeof(*stats));
+    OE_TEST(stats != NULL);
+    OE_TEST(oe_get_enclave_call_stats(enclave, stats, &num_stats) == OE_OK);
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        uint64_t histogram_count = 0;
+
+        OE_TEST(stats[i].count > 0);
+        OE_TEST(stats[i].min_ns <= stats[i].max_ns);
+
+        /* The statistics are sorted by total time */
+        if (i > 0)
+            OE_TEST(stats[i - 1].total_ns >= stats[i].total_ns);
+
+        for (size_t j = 0; j < OE_CALL_STATS_HISTOGRAM_SIZE; j++)
+            histogram_count += stats[i].histogram[j];
+
+        OE_TEST(histogram_count == stats[i].count);
+
+        if (stats[i].type == OE_CALL_TYPE_ECALL &&
+            stats[i].table_id == OE_UINT64_MAX &&
+            stats[i].function_id == ecall_fcn_id_enc_test)
+        {
+            OE_TEST(stats[i].count == count);
+            found = true;
+        }
+    }
+
+    OE_TEST(found);
+    free(stats);
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -87,6 +237,15 @@ int main(int argc, const char* argv[])
         TestECall(enclave);
     }
 
+    printf("=== TestBufferSizes()\n");
+    TestBufferSizes(enclave);
+
+    printf("=== TestBatch()\n");
+    TestBatch(enclave);
+
+    printf("=== TestCallStats()\n");
+    TestCallStats(enclave, N);
+
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
     {
         oe_put_err("oe_terminate_enclave(): result=%u", result);
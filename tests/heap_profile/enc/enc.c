@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include "heap_profile_t.h"
+
+#define MAX_KEPT_BLOCKS 1024
+
+static void* _kept[MAX_KEPT_BLOCKS];
+static size_t _num_kept;
+
+/* The host looks for this function in the profile */
+static OE_NEVER_INLINE void* heap_profile_allocate_block(size_t size)
+{
+    void* block = oe_malloc(size);
+
+    OE_TEST(block != NULL);
+    memset(block, 0xAA, size);
+    return block;
+}
+
+int enc_allocate_blocks(size_t count, size_t size)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        void* block = heap_profile_allocate_block(size);
+
+        if (i % 2 == 0 && _num_kept < MAX_KEPT_BLOCKS)
+            _kept[_num_kept++] = block;
+        else
+            oe_free(block);
+    }
+
+    return 0;
+}
+
+void enc_free_blocks(void)
+{
+    for (size_t i = 0; i < _num_kept; i++)
+        oe_free(_kept[i]);
+
+    _num_kept = 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    2);   /* TCSCount */
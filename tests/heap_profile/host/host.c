@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/heapprofile.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "heap_profile_u.h"
+
+#define NUM_BLOCKS 200
+#define BLOCK_SIZE 100
+
+typedef struct _totals
+{
+    unsigned long long in_use_count;
+    unsigned long long in_use_bytes;
+    unsigned long long alloc_count;
+    unsigned long long alloc_bytes;
+    unsigned long long interval;
+} totals_t;
+
+/* Write the profile of the enclave and return it as a string */
+static char* _write_profile(oe_enclave_t* enclave)
+{
+    FILE* stream;
+    char* profile;
+    long size;
+
+    OE_TEST((stream = tmpfile()) != NULL);
+    OE_TEST(oe_write_enclave_heap_profile(enclave, stream) == OE_OK);
+
+    OE_TEST(fseek(stream, 0, SEEK_END) == 0);
+    OE_TEST((size = ftell(stream)) > 0);
+    OE_TEST(fseek(stream, 0, SEEK_SET) == 0);
+
+    OE_TEST((profile = (char*)malloc((size_t)size + 1)) != NULL);
+    OE_TEST(fread(profile, 1, (size_t)size, stream) == (size_t)size);
+    profile[size] = '\0';
+
+    fclose(stream);
+    return profile;
+}
+
+static totals_t _get_totals(oe_enclave_t* enclave)
+{
+    char* profile = _write_profile(enclave);
+    totals_t t;
+
+    OE_TEST(
+        sscanf(
+            profile,
+            "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu",
+            &t.in_use_count,
+            &t.in_use_bytes,
+            &t.alloc_count,
+            &t.alloc_bytes,
+            &t.interval) == 5);
+
+    /* The mapping of the enclave follows the stacks */
+    OE_TEST(strstr(profile, "\nMAPPED_LIBRARIES:\n") != NULL);
+
+/* Call stacks are only walked reliably in debug builds */
+#ifdef OE_USE_DEBUG_MALLOC
+    if (t.alloc_count)
+        OE_TEST(strstr(profile, "\theap_profile_allocate_block\n") != NULL);
+#endif
+
+    free(profile);
+    return t;
+}
+
+static void _allocate_blocks(oe_enclave_t* enclave)
+{
+    int return_value = -1;
+
+    OE_TEST(
+        enc_allocate_blocks(enclave, &return_value, NUM_BLOCKS, BLOCK_SIZE) ==
+        OE_OK);
+    OE_TEST(return_value == 0);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    const uint32_t flags = oe_get_create_flags();
+    totals_t before;
+    totals_t after;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_heap_profile_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(
+        oe_enable_enclave_heap_profiler(
+            enclave, OE_HEAP_PROFILE_MAX_INTERVAL + 1) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_write_enclave_heap_profile(enclave, NULL) == OE_INVALID_PARAMETER);
+
+    /* Nothing is sampled before the profiler is started */
+    _allocate_blocks(enclave);
+    before = _get_totals(enclave);
+    OE_TEST(before.alloc_count == 0);
+    OE_TEST(before.in_use_count == 0);
+
+    /* Sample every allocation: half the blocks are still in use */
+    OE_TEST(oe_enable_enclave_heap_profiler(enclave, 1) == OE_OK);
+    _allocate_blocks(enclave);
+
+    before = _get_totals(enclave);
+    OE_TEST(before.interval == 1);
+    OE_TEST(before.alloc_count >= NUM_BLOCKS);
+    OE_TEST(before.alloc_bytes >= NUM_BLOCKS * BLOCK_SIZE);
+    OE_TEST(before.in_use_count >= NUM_BLOCKS / 2);
+    OE_TEST(before.in_use_bytes >= NUM_BLOCKS / 2 * BLOCK_SIZE);
+
+    /* Freeing the blocks is accounted for */
+    OE_TEST(enc_free_blocks(enclave) == OE_OK);
+
+    after = _get_totals(enclave);
+    OE_TEST(after.alloc_count >= before.alloc_count);
+    OE_TEST(after.in_use_count <= before.in_use_count - NUM_BLOCKS / 2);
+    OE_TEST(
+        after.in_use_bytes <=
+        before.in_use_bytes - NUM_BLOCKS / 2 * BLOCK_SIZE);
+
+    /* Stopping the profiler keeps the profile but samples no more */
+    OE_TEST(oe_enable_enclave_heap_profiler(enclave, 0) == OE_OK);
+    before = _get_totals(enclave);
+    _allocate_blocks(enclave);
+    after = _get_totals(enclave);
+    OE_TEST(after.interval == 1);
+    OE_TEST(after.alloc_count == before.alloc_count);
+    OE_TEST(after.alloc_bytes == before.alloc_bytes);
+    OE_TEST(enc_free_blocks(enclave) == OE_OK);
+
+    /* Restarting the profiler discards the profile. The largest interval
+     * makes sampling the ECALL buffers of the enclave very unlikely */
+    OE_TEST(
+        oe_enable_enclave_heap_profiler(
+            enclave, OE_HEAP_PROFILE_MAX_INTERVAL) == OE_OK);
+    after = _get_totals(enclave);
+    OE_TEST(after.interval == OE_HEAP_PROFILE_MAX_INTERVAL);
+    OE_TEST(after.alloc_count == 0);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
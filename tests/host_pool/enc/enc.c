@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/hostpool.h>
+#include "../../alloc_stress/alloc_stress.h"
+#include "host_pool_t.h"
+
+OE_ENABLE_HOST_MEMORY_POOL();
+
+#define NUM_BLOCKS 128
+
+/* Largest block served by the pool */
+#define MAX_POOL_SIZE (64 * 1024)
+
+static void* _new_block(size_t size)
+{
+    uint8_t* block = (uint8_t*)oe_host_malloc(size);
+
+    OE_TEST(block != NULL);
+    OE_TEST(oe_is_outside_enclave(block, size));
+    alloc_stress_fill_block(block, size);
+    return block;
+}
+
+static void _delete_block(void* block)
+{
+    alloc_stress_check_block((uint8_t*)block, *(size_t*)block);
+    oe_host_free(block);
+}
+
+static void _test_sizes(void)
+{
+    void* blocks[NUM_BLOCKS];
+
+    OE_TEST(oe_host_memory_pool);
+
+    /* Sizes around every size class and past the largest one */
+    for (size_t size = 16; size <= 4 * MAX_POOL_SIZE; size *= 2)
+    {
+        _delete_block(_new_block(size - 1));
+        _delete_block(_new_block(size));
+        _delete_block(_new_block(size + 1));
+    }
+
+    /* Live blocks do not overlap */
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        blocks[i] = _new_block(sizeof(size_t) + i * 13);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        _delete_block(blocks[i]);
+
+    OE_TEST((blocks[0] = oe_host_malloc(0)) != NULL);
+    oe_host_free(blocks[0]);
+    oe_host_free(NULL);
+}
+
+static void _test_calloc(void)
+{
+    void* blocks[NUM_BLOCKS];
+
+    /* Freed blocks are dirty: oe_host_calloc() must clear them */
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        blocks[i] = _new_block(100);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        _delete_block(blocks[i]);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        uint8_t* block = (uint8_t*)oe_host_calloc(4, 25);
+
+        OE_TEST(block != NULL);
+
+        for (size_t j = 0; j < 100; j++)
+            OE_TEST(block[j] == 0);
+
+        blocks[i] = block;
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        oe_host_free(blocks[i]);
+
+    OE_TEST(oe_host_calloc(OE_SIZE_MAX, 2) == NULL);
+}
+
+static void _test_realloc(void)
+{
+    uint8_t* p;
+    uint8_t* q;
+
+    OE_TEST((p = (uint8_t*)oe_host_realloc(NULL, 24)) != NULL);
+    alloc_stress_fill_block(p, 24);
+
+    /* Shrinking and growing within the block keep it in place */
+    OE_TEST(oe_host_realloc(p, 8) == p);
+    OE_TEST((q = (uint8_t*)oe_host_realloc(p, 32)) == p);
+    alloc_stress_check_block(q, 24);
+
+    /* Growing past the block moves it to a larger one */
+    OE_TEST((q = (uint8_t*)oe_host_realloc(p, 1000)) != NULL);
+    OE_TEST(oe_is_outside_enclave(q, 1000));
+    alloc_stress_check_block(q, 24);
+    alloc_stress_fill_block(q, 1000);
+
+    /* Growing past the largest block moves it out of the pool */
+    OE_TEST((p = (uint8_t*)oe_host_realloc(q, 2 * MAX_POOL_SIZE)) != NULL);
+    OE_TEST(oe_is_outside_enclave(p, 2 * MAX_POOL_SIZE));
+    alloc_stress_check_block(p, 1000);
+    alloc_stress_fill_block(p, 2 * MAX_POOL_SIZE);
+
+    /* And back into it */
+    OE_TEST((q = (uint8_t*)oe_host_malloc(2000)) != NULL);
+    memcpy(q, p, 2000);
+    oe_host_free(p);
+    alloc_stress_check_block(q, 2000);
+
+    /* Resizing to zero frees the block */
+    OE_TEST(oe_host_realloc(q, 0) == NULL);
+}
+
+int enc_test_host_pool(void)
+{
+    _test_sizes();
+    _test_calloc();
+    _test_realloc();
+
+    return 0;
+}
+
+static size_t _random_size(uint64_t* state)
+{
+    return sizeof(size_t) + alloc_stress_random(state) % 4096;
+}
+
+/* Allocates, resizes, exchanges and frees blocks of random sizes */
+static void _stress(uint64_t round, uint64_t* state)
+{
+    void* blocks[NUM_BLOCKS];
+
+    OE_UNUSED(round);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        size_t size = _random_size(state);
+
+        /* Some blocks exceed the largest size of the pool */
+        if (i % 32 == 0)
+            size *= 32;
+
+        blocks[i] = _new_block(size);
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i += 2)
+    {
+        size_t old_size = *(size_t*)blocks[i];
+        size_t size = _random_size(state);
+        uint8_t* block;
+
+        block = (uint8_t*)oe_host_realloc(blocks[i], size);
+        OE_TEST(block != NULL);
+        alloc_stress_check_block(block, old_size < size ? old_size : size);
+        alloc_stress_fill_block(block, size);
+        blocks[i] = block;
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i += 4)
+        blocks[i] = alloc_stress_exchange(blocks[i], state);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        if (blocks[i])
+            _delete_block(blocks[i]);
+    }
+}
+
+int enc_test_host_pool_threads(uint64_t rounds)
+{
+    alloc_stress(rounds, _stress, _delete_block);
+    return 0;
+}
+
+int enc_allocate_host_blocks(size_t count, size_t size)
+{
+    for (size_t i = 0; i < count; i++)
+        _delete_block(_new_block(size));
+
+    return 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,                  /* ProductID */
+    1,                  /* SecurityVersion */
+    true,               /* AllowDebug */
+    1024,               /* HeapPageCount */
+    64,                 /* StackPageCount */
+    HOST_POOL_NUM_TCS); /* TCSCount */
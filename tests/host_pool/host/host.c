@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/hostpool.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../alloc_stress/alloc_stress.h"
+#include "host_pool_u.h"
+
+#define ROUNDS 100
+#define NUM_BLOCKS 1000
+
+/* Larger than the largest block served by the pool */
+#define LARGE_BLOCK_SIZE (128 * 1024)
+
+/* Number of times the enclave made the given runtime OCALL */
+static uint64_t _count_ocalls(oe_enclave_t* enclave, oe_func_t func)
+{
+    oe_call_stats_t* stats;
+    size_t num_stats = 0;
+    uint64_t count = 0;
+
+    OE_TEST(
+        oe_get_enclave_call_stats(enclave, NULL, &num_stats) ==
+        OE_BUFFER_TOO_SMALL);
+    OE_TEST((stats = calloc(num_stats, sizeof(*stats))) != NULL);
+    OE_TEST(oe_get_enclave_call_stats(enclave, stats, &num_stats) == OE_OK);
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        if (stats[i].type == OE_CALL_TYPE_OCALL &&
+            stats[i].table_id == OE_CALL_STATS_RUNTIME_TABLE_ID &&
+            stats[i].function_id == (uint64_t)func)
+            count = stats[i].count;
+    }
+
+    free(stats);
+    return count;
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = alloc_stress_create_enclave(
+        argc, argv, oe_create_host_pool_enclave, HOST_POOL_NUM_TCS);
+    int return_value = -1;
+
+    result = enc_test_host_pool(enclave, &return_value);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    result = enc_test_host_pool_threads(enclave, &return_value, ROUNDS);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    /* Blocks served by the pool cost no OCALL */
+    {
+        const uint64_t mallocs = _count_ocalls(enclave, OE_OCALL_MALLOC);
+        const uint64_t frees = _count_ocalls(enclave, OE_OCALL_FREE);
+        uint64_t grows;
+
+        result = enc_allocate_host_blocks(
+            enclave, &return_value, NUM_BLOCKS, 1024);
+        OE_TEST(result == OE_OK);
+        OE_TEST(return_value == 0);
+
+        OE_TEST(_count_ocalls(enclave, OE_OCALL_MALLOC) == mallocs);
+        OE_TEST(_count_ocalls(enclave, OE_OCALL_FREE) == frees);
+
+        grows = _count_ocalls(enclave, OE_OCALL_GROW_HOST_POOL);
+        OE_TEST(grows > 0);
+        OE_TEST(grows <= OE_HOST_POOL_MAX_REGIONS);
+
+        /* Larger blocks still come from the host heap */
+        result = enc_allocate_host_blocks(
+            enclave, &return_value, NUM_BLOCKS, LARGE_BLOCK_SIZE);
+        OE_TEST(result == OE_OK);
+        OE_TEST(return_value == 0);
+
+        OE_TEST(
+            _count_ocalls(enclave, OE_OCALL_MALLOC) == mallocs + NUM_BLOCKS);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/internal/malloc.h>
+#include "../../alloc_stress/alloc_stress.h"
+#include "malloc_cache_t.h"
+
+OE_ENABLE_MALLOC_THREAD_CACHE();
+
+#define NUM_BLOCKS 128
+
+/* Larger than the largest size class of the cache */
+#define MAX_SIZE 1536
+
+static size_t _random_size(uint64_t* state)
+{
+    return sizeof(size_t) + alloc_stress_random(state) % MAX_SIZE;
+}
+
+static void* _new_block(size_t size)
+{
+    uint8_t* block = (uint8_t*)oe_malloc(size);
+
+    OE_TEST(block != NULL);
+    alloc_stress_fill_block(block, size);
+    return block;
+}
+
+static void _delete_block(void* block)
+{
+    alloc_stress_check_block((uint8_t*)block, *(size_t*)block);
+    oe_free(block);
+}
+
+static void _test_single_thread(void)
+{
+    void* blocks[NUM_BLOCKS];
+    void* p;
+
+    OE_TEST(oe_malloc_thread_cache);
+
+    /* Every size up to past the largest class */
+    for (size_t size = sizeof(size_t); size <= MAX_SIZE; size++)
+        _delete_block(_new_block(size));
+
+    /* Cached blocks are dirty: calloc() must clear them */
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        blocks[i] = _new_block(100);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        _delete_block(blocks[i]);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        uint8_t* block = (uint8_t*)oe_calloc(4, 25);
+
+        OE_TEST(block != NULL);
+
+        for (size_t j = 0; j < 100; j++)
+            OE_TEST(block[j] == 0);
+
+        blocks[i] = block;
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        oe_free(blocks[i]);
+
+    /* Aligned blocks may be cached too once freed */
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        OE_TEST(oe_posix_memalign(&blocks[i], 64, 40) == 0);
+        OE_TEST(((uintptr_t)blocks[i] % 64) == 0);
+        alloc_stress_fill_block((uint8_t*)blocks[i], 40);
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        _delete_block(blocks[i]);
+
+    OE_TEST((p = oe_malloc(0)) != NULL);
+    oe_free(p);
+    oe_free(NULL);
+
+    OE_TEST((p = oe_realloc(NULL, 48)) != NULL);
+    oe_free(p);
+}
+
+/* Allocates, resizes, exchanges and frees blocks of random sizes */
+static void _stress(uint64_t round, uint64_t* state)
+{
+    void* blocks[NUM_BLOCKS];
+    uint8_t* zeroed;
+    size_t size;
+
+    OE_UNUSED(round);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        blocks[i] = _new_block(_random_size(state));
+
+    for (size_t i = 0; i < NUM_BLOCKS; i += 2)
+    {
+        size_t old_size = *(size_t*)blocks[i];
+        uint8_t* block;
+
+        size = _random_size(state);
+        block = (uint8_t*)oe_realloc(blocks[i], size);
+        OE_TEST(block != NULL);
+        alloc_stress_check_block(block, old_size < size ? old_size : size);
+        alloc_stress_fill_block(block, size);
+        blocks[i] = block;
+    }
+
+    for (size_t i = 0; i < NUM_BLOCKS; i += 4)
+        blocks[i] = alloc_stress_exchange(blocks[i], state);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        if (blocks[i])
+            _delete_block(blocks[i]);
+    }
+
+    size = _random_size(state);
+    OE_TEST((zeroed = (uint8_t*)oe_calloc(1, size)) != NULL);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(zeroed[i] == 0);
+
+    oe_free(zeroed);
+}
+
+int enc_test_malloc_cache(uint64_t rounds)
+{
+    _test_single_thread();
+    alloc_stress(rounds, _stress, _delete_block);
+
+    return 0;
+}
+
+/* Allocations of (2048, 4096] bytes are counted in this size class */
+#define HEAP_STATS_CLASS 8
+#define HEAP_STATS_SIZE 3000
+
+int enc_test_heap_stats(void)
+{
+    oe_heap_stats_t before;
+    oe_heap_stats_t after;
+    void* blocks[NUM_BLOCKS];
+    uint64_t sum = 0;
+
+    OE_TEST(oe_get_heap_stats(NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_get_heap_stats(&before) == OE_OK);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        blocks[i] = _new_block(HEAP_STATS_SIZE);
+
+    OE_TEST(oe_get_heap_stats(&after) == OE_OK);
+    OE_TEST(after.allocations == before.allocations + NUM_BLOCKS);
+    OE_TEST(
+        after.size_classes[HEAP_STATS_CLASS] ==
+        before.size_classes[HEAP_STATS_CLASS] + NUM_BLOCKS);
+    OE_TEST(
+        after.in_use_bytes >=
+        before.in_use_bytes + NUM_BLOCKS * HEAP_STATS_SIZE);
+
+    for (size_t i = 0; i < NUM_BLOCKS; i++)
+        _delete_block(blocks[i]);
+
+    OE_TEST(oe_malloc(after.heap_size) == NULL);
+
+    OE_TEST(oe_get_heap_stats(&after) == OE_OK);
+    OE_TEST(after.frees == before.frees + NUM_BLOCKS);
+    OE_TEST(after.failures == before.failures + 1);
+    OE_TEST(after.sbrk_bytes <= after.peak_sbrk_bytes);
+    OE_TEST(after.peak_sbrk_bytes <= after.heap_size);
+    OE_TEST(after.top_free_bytes <= after.free_bytes);
+    OE_TEST(after.fragmentation <= 100);
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+        sum += after.size_classes[i];
+
+    OE_TEST(sum == after.allocations);
+
+    return 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,                       /* ProductID */
+    1,                       /* SecurityVersion */
+    true,                    /* AllowDebug */
+    MALLOC_CACHE_HEAP_PAGES, /* HeapPageCount */
+    64,                      /* StackPageCount */
+    MALLOC_CACHE_NUM_TCS);   /* TCSCount */
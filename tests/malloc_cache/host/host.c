@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include "../../alloc_stress/alloc_stress.h"
+#include "malloc_cache_u.h"
+
+#define ROUNDS 200
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = alloc_stress_create_enclave(
+        argc, argv, oe_create_malloc_cache_enclave, MALLOC_CACHE_NUM_TCS);
+    int return_value = -1;
+
+    result = enc_test_malloc_cache(enclave, &return_value, ROUNDS);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    result = enc_test_heap_stats(enclave, &return_value);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    /* The host reads the same statistics */
+    {
+        oe_heap_stats_t stats;
+
+        result = oe_get_enclave_heap_stats(NULL, &stats);
+        OE_TEST(result == OE_INVALID_PARAMETER);
+        result = oe_get_enclave_heap_stats(enclave, NULL);
+        OE_TEST(result == OE_INVALID_PARAMETER);
+        OE_TEST(oe_get_enclave_heap_stats(enclave, &stats) == OE_OK);
+
+        OE_TEST(stats.heap_size == MALLOC_CACHE_HEAP_PAGES * OE_PAGE_SIZE);
+        OE_TEST(stats.peak_sbrk_bytes > 0);
+        OE_TEST(stats.peak_sbrk_bytes <= stats.heap_size);
+        OE_TEST(stats.allocations >= stats.frees);
+        OE_TEST(stats.failures >= 1);
+
+        OE_TEST(oe_dump_enclave_heap_stats(enclave, stdout) == OE_OK);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
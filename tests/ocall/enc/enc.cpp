@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/corelibc/string.h>
 #include <openenclave/edger8r/enclave.h>
 #include <openenclave/enclave.h>
@@ -96,6 +97,103 @@ void enc_test_reentrancy()
     OE_TEST(OE_OK == result);
 }
 
+static void _test_fill_buffer(size_t size, unsigned char value)
+{
+    unsigned char* buffer = (unsigned char*)oe_malloc(size);
+
+    OE_TEST(buffer != NULL);
+    OE_TEST(host_fill_buffer(buffer, size, value) == OE_OK);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(buffer[i] == value);
+
+    oe_free(buffer);
+}
+
+void enc_test_ocall_buffers()
+{
+    /* Buffers are host memory, whether or not they fit into the arena */
+    const size_t sizes[] = {0, 1, 100, 4096, 256 * 1024};
+    void* buffers[OE_COUNTOF(sizes)];
+
+    for (size_t i = 0; i < OE_COUNTOF(sizes); i++)
+    {
+        buffers[i] = oe_allocate_ocall_buffer(sizes[i]);
+        OE_TEST(buffers[i] != NULL);
+        OE_TEST(oe_is_outside_enclave(buffers[i], sizes[i]));
+        memset(buffers[i], 0xAA, sizes[i]);
+    }
+
+    for (size_t i = 0; i < OE_COUNTOF(sizes); i++)
+    {
+        for (size_t j = i + 1; j < OE_COUNTOF(sizes); j++)
+            OE_TEST(buffers[i] != buffers[j]);
+    }
+
+    /* Release the buffers out of order */
+    oe_free_ocall_buffer(buffers[0]);
+    oe_free_ocall_buffer(buffers[2]);
+    oe_free_ocall_buffer(buffers[4]);
+    oe_free_ocall_buffer(buffers[3]);
+    oe_free_ocall_buffer(buffers[1]);
+
+    /* All of the space released is available again */
+    {
+        void* buffer = oe_allocate_ocall_buffer(sizes[1]);
+        OE_TEST(buffer == buffers[0]);
+        oe_free_ocall_buffer(buffer);
+    }
+
+    /* OCALLs whose buffers do and do not fit into the arena */
+    _test_fill_buffer(16, 0x11);
+    _test_fill_buffer(256 * 1024, 0x22);
+    _test_fill_buffer(16, 0x33);
+}
+
+void enc_test_deferred_ocalls(uint64_t count)
+{
+    unsigned char data[256];
+
+    for (uint64_t seq = 0; seq < count; seq++)
+    {
+        /* Vary the size so that the queue fills up and is drained */
+        size_t size = (size_t)(seq % sizeof(data));
+
+        memset(data, (unsigned char)seq, size);
+        OE_TEST(host_record_deferred(data, size, seq) == OE_OK);
+
+        /* Ordinary OCALLs are made once the deferred ones are carried out */
+        if (seq % 1000 == 0)
+        {
+            uint64_t records = 0;
+            OE_TEST(host_get_deferred_records(&records) == OE_OK);
+            OE_TEST(records == seq + 1);
+        }
+    }
+
+    /* A call too large for the queue is made right away, after the others */
+    {
+        const size_t size = 128 * 1024;
+        unsigned char* large = (unsigned char*)oe_malloc(size);
+        uint64_t records = 0;
+
+        OE_TEST(large != NULL);
+        memset(large, (unsigned char)count, size);
+        OE_TEST(host_record_deferred(large, size, count) == OE_OK);
+        oe_free(large);
+
+        OE_TEST(host_get_deferred_records(&records) == OE_OK);
+        OE_TEST(records == count + 1);
+    }
+
+    /* Leave calls in the queue for the host to carry out on return */
+    for (uint64_t seq = count + 1; seq < count + 10; seq++)
+    {
+        memset(data, (unsigned char)seq, sizeof(data));
+        OE_TEST(host_record_deferred(data, sizeof(data), seq) == OE_OK);
+    }
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
@@ -22,6 +22,29 @@ void host_func2(const unsigned char*)
     g_func2_ok = true;
 }
 
+void host_fill_buffer(unsigned char* buffer, size_t size, unsigned char value)
+{
+    memset(buffer, value, size);
+}
+
+static uint64_t g_deferred_records = 0;
+
+void host_record_deferred(const unsigned char* data, size_t size, uint64_t seq)
+{
+    /* Deferred calls are carried out in order */
+    OE_TEST(seq == g_deferred_records);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(data[i] == (unsigned char)seq);
+
+    g_deferred_records++;
+}
+
+uint64_t host_get_deferred_records()
+{
+    return g_deferred_records;
+}
+
 static oe_enclave_t* g_enclave = NULL;
 static bool g_reentrancy_tested = false;
 void host_test_reentrancy()
@@ -107,6 +130,23 @@ int main(int argc, const char* argv[])
         OE_TEST(MY_OCALL_SEED * MY_OCALL_MULTIPLIER == ret_val);
     }
 
+    /* Call enc_test_ocall_buffers */
+    {
+        result = enc_test_ocall_buffers(enclave);
+        OE_TEST(OE_OK == result);
+    }
+
+    /* Call enc_test_deferred_ocalls */
+    {
+        const uint64_t count = 5000;
+        result = enc_test_deferred_ocalls(enclave, count);
+        OE_TEST(OE_OK == result);
+
+        /* The calls still queued were carried out on return (the enclave
+         * makes count + 10 calls) */
+        OE_TEST(g_deferred_records == count + 10);
+    }
+
     /* Call enc_test_reentrancy */
     {
         g_enclave = enclave;
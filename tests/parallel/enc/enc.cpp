@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <mbedtls/gcm.h>
+#include <mbedtls/sha256.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/parallel.h>
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include <vector>
+#include "parallel_t.h"
+
+#define SHA256_SIZE 32
+#define GCM_IV_SIZE 12
+#define GCM_TAG_SIZE 16
+
+static size_t _num_buffers;
+static size_t _buffer_size;
+static std::vector<unsigned char> _input;
+
+/* The results of the benchmarks, and those computed by one thread */
+static std::vector<unsigned char> _output;
+static std::vector<unsigned char> _tags;
+static std::vector<unsigned char> _expected[PARALLEL_NUM_BENCHMARKS];
+static std::vector<unsigned char> _expected_tags;
+
+static const unsigned char _key[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static void _sha256(size_t i)
+{
+    OE_TEST(
+        mbedtls_sha256_ret(
+            &_input[i * _buffer_size],
+            _buffer_size,
+            &_output[i * SHA256_SIZE],
+            0) == 0);
+}
+
+/* Each buffer is encrypted with its own IV */
+static void _aes_gcm(size_t i)
+{
+    mbedtls_gcm_context gcm;
+    unsigned char iv[GCM_IV_SIZE] = {0};
+
+    memcpy(iv, &i, sizeof(i));
+    mbedtls_gcm_init(&gcm);
+    OE_TEST(mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, _key, 256) == 0);
+    OE_TEST(
+        mbedtls_gcm_crypt_and_tag(
+            &gcm,
+            MBEDTLS_GCM_ENCRYPT,
+            _buffer_size,
+            iv,
+            sizeof(iv),
+            NULL,
+            0,
+            &_input[i * _buffer_size],
+            &_output[i * _buffer_size],
+            GCM_TAG_SIZE,
+            &_tags[i * GCM_TAG_SIZE]) == 0);
+    mbedtls_gcm_free(&gcm);
+}
+
+static void _run(int benchmark)
+{
+    memset(_output.data(), 0, _output.size());
+
+    switch (benchmark)
+    {
+        case PARALLEL_SHA256:
+            oe::parallel_for(
+                0, _num_buffers, 1, [](uint64_t i) { _sha256(i); });
+            break;
+        case PARALLEL_SHA256_TASKS:
+        {
+            oe::task_group group;
+
+            for (size_t i = 0; i < _num_buffers; i++)
+                group.run([i] { _sha256(i); });
+
+            group.wait();
+            break;
+        }
+        case PARALLEL_AES_GCM:
+            oe::parallel_for(
+                0, _num_buffers, 1, [](uint64_t i) { _aes_gcm(i); });
+            break;
+    }
+}
+
+int enc_setup(size_t num_buffers, size_t buffer_size)
+{
+    if (num_buffers == 0 || buffer_size < SHA256_SIZE)
+        return -1;
+
+    _num_buffers = num_buffers;
+    _buffer_size = buffer_size;
+    _input.resize(num_buffers * buffer_size);
+    _output.resize(num_buffers * buffer_size);
+    _tags.resize(num_buffers * GCM_TAG_SIZE);
+
+    for (size_t i = 0; i < _input.size(); i++)
+        _input[i] = (unsigned char)(i * 31 + i / 4096);
+
+    /* The results of one thread are those to match */
+    OE_TEST(oe_parallel_set_max_threads(1) == OE_OK);
+
+    for (int benchmark = 0; benchmark < PARALLEL_NUM_BENCHMARKS; benchmark++)
+    {
+        _run(benchmark);
+        _expected[benchmark] = _output;
+    }
+
+    _expected_tags = _tags;
+
+    return 0;
+}
+
+int enc_run(int benchmark, size_t threads, uint64_t iterations)
+{
+    if (benchmark < 0 || benchmark >= PARALLEL_NUM_BENCHMARKS ||
+        oe_parallel_set_max_threads(threads) != OE_OK)
+        return -1;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        _run(benchmark);
+
+        if (_output != _expected[benchmark] ||
+            (benchmark == PARALLEL_AES_GCM && _tags != _expected_tags))
+            return -1;
+    }
+
+    return 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,                 /* ProductID */
+    1,                 /* SecurityVersion */
+    true,              /* AllowDebug */
+    8192,              /* HeapPageCount */
+    64,                /* StackPageCount */
+    PARALLEL_NUM_TCS); /* TCSCount */
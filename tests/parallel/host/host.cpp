@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include "../../bench/bench.h"
+#include "parallel_u.h"
+
+/*
+**==============================================================================
+**
+** oebench_parallel:
+**
+**     Measures how CPU-bound work inside one ECALL scales with the number of
+**     threads working on it: each benchmark hashes (SHA-256) or encrypts
+**     (AES-256-GCM) a set of buffers with oe_parallel_for or a task group,
+**     with 1, 2, 4... threads started on the host thread pool of the
+**     enclave. The enclave checks each result against that of one thread.
+**
+**==============================================================================
+*/
+
+static const char* _benchmarks[PARALLEL_NUM_BENCHMARKS] = {
+    "sha256",
+    "sha256_tasks",
+    "aes_gcm",
+};
+
+struct options : bench_options
+{
+    size_t num_buffers = 64;
+    size_t buffer_size = 65536;
+};
+
+static std::vector<bench_result> _results;
+
+static void _run_benchmarks(oe_enclave_t* enclave, const options& opts)
+{
+    const double bytes = (double)(opts.num_buffers * opts.buffer_size);
+    int ret = -1;
+
+    OE_TEST(
+        enc_setup(enclave, &ret, opts.num_buffers, opts.buffer_size) ==
+        OE_OK);
+    OE_TEST(ret == 0);
+
+    for (int b = 0; b < PARALLEL_NUM_BENCHMARKS; b++)
+    {
+        uint64_t one_thread_ns = 0;
+
+        for (size_t n : bench_thread_counts(opts.max_threads))
+        {
+            /* The ECALL spreads the work over the threads itself; the warm-up
+             * starts the workers */
+            const uint64_t total_ns =
+                bench_run(1, 1, opts.iterations, [&](uint64_t count) {
+                    OE_TEST(enc_run(enclave, &ret, b, n, count) == OE_OK);
+                    OE_TEST(ret == 0);
+                });
+
+            if (n == 1)
+                one_thread_ns = total_ns;
+
+            _results.push_back(
+                {bench_string("benchmark", _benchmarks[b]),
+                 bench_uint("threads", n),
+                 bench_uint("buffers", opts.num_buffers),
+                 bench_uint("buffer_size", opts.buffer_size),
+                 bench_uint("iterations", opts.iterations),
+                 bench_uint("total_ns", total_ns),
+                 bench_double(
+                     "mb_per_sec",
+                     total_ns ? bytes * (double)opts.iterations * 1e3 /
+                                    (double)total_ns
+                              : 0.0,
+                     1),
+                 bench_double(
+                     "speedup",
+                     total_ns ? (double)one_thread_ns / (double)total_ns : 0.0,
+                     2)});
+        }
+    }
+}
+
+static void _usage(const char* arg0)
+{
+    fprintf(
+        stderr,
+        "Usage: %s ENCLAVE [--iterations N] [--threads N] [--buffers N] "
+        "[--buffer-size N] [--json] [--output FILE] [--quick]\n",
+        arg0);
+    exit(1);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    options opts;
+
+    opts.iterations = 10;
+    opts.max_threads = PARALLEL_NUM_TCS;
+
+    if (argc < 2)
+        _usage(argv[0]);
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (bench_parse_option(argc, argv, &i, &opts))
+            continue;
+
+        if (strcmp(argv[i], "--buffers") == 0 && i + 1 < argc)
+            opts.num_buffers = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc)
+            opts.buffer_size = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            opts.iterations = 1;
+            opts.num_buffers = 16;
+            opts.buffer_size = 4096;
+        }
+        else
+            _usage(argv[0]);
+    }
+
+    if (opts.iterations == 0 || opts.max_threads == 0 ||
+        opts.max_threads > PARALLEL_NUM_TCS || opts.num_buffers == 0 ||
+        opts.buffer_size < 32)
+    {
+        fprintf(
+            stderr,
+            "%s: iterations and buffers must be positive, buffers at least "
+            "32 bytes and threads between 1 and %d\n",
+            argv[0],
+            PARALLEL_NUM_TCS);
+        return 1;
+    }
+
+    /* The pool leaves one TCS for the ECALLs of the benchmark, which also
+     * takes part in the work */
+    oe_enclave_setting_thread_pool_t thread_pool = {PARALLEL_NUM_TCS - 1};
+    oe_enclave_setting_t setting;
+
+    setting.setting_type = OE_ENCLAVE_SETTING_THREAD_POOL;
+    setting.u.thread_pool_setting = &thread_pool;
+
+    const uint32_t flags = oe_get_create_flags();
+
+    if ((result = oe_create_parallel_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, &setting, 1, &enclave)) !=
+        OE_OK)
+    {
+        oe_put_err("oe_create_parallel_enclave(): result=%u", result);
+    }
+
+    _run_benchmarks(enclave, opts);
+
+    if ((result = oe_terminate_enclave(enclave)) != OE_OK)
+    {
+        oe_put_err("oe_terminate_enclave(): result=%u", result);
+    }
+
+    return bench_output_results(argv[0], opts, bench_mode(flags), _results);
+}
@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "../../alloc_stress/alloc_stress.h"
+#include "slab_t.h"
+
+#define NUM_OBJECTS 100
+
+/* More caches than get magazines */
+#define NUM_CACHES (OE_SLAB_MAX_CACHES + 8)
+
+typedef struct _object
+{
+    uint64_t id;
+    uint8_t bytes[100];
+} OE_ALIGNED(64) object_t;
+
+static oe_slab_cache_t _cache = OE_SLAB_CACHE_INITIALIZER(object_t);
+
+static object_t* _new_object(uint64_t id)
+{
+    object_t* object = (object_t*)oe_slab_alloc(&_cache);
+
+    OE_TEST(object != NULL);
+    OE_TEST((uintptr_t)object % 64 == 0);
+
+    object->id = id;
+    memset(object->bytes, alloc_stress_fill_byte(id), sizeof(object->bytes));
+    return object;
+}
+
+static void _delete_object(void* arg)
+{
+    object_t* object = (object_t*)arg;
+
+    for (size_t i = 0; i < sizeof(object->bytes); i++)
+        OE_TEST(object->bytes[i] == alloc_stress_fill_byte(object->id));
+
+    oe_slab_free(&_cache, object);
+}
+
+static void _test_init(void)
+{
+    oe_slab_cache_t cache;
+
+    OE_TEST(oe_slab_cache_init(NULL, 8, 8) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_slab_cache_init(&cache, 0, 8) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_slab_cache_init(&cache, OE_SLAB_MAX_OBJECT_SIZE + 1, 8) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(oe_slab_cache_init(&cache, 8, 0) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_slab_cache_init(&cache, 8, 24) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_slab_cache_init(&cache, 8, OE_SLAB_MAX_ALIGNMENT * 2) ==
+        OE_INVALID_PARAMETER);
+
+    OE_TEST(oe_slab_alloc(NULL) == NULL);
+    OE_TEST(oe_slab_calloc(NULL) == NULL);
+    oe_slab_free(&_cache, NULL);
+    oe_slab_free(NULL, NULL);
+}
+
+static void _test_single_thread(void)
+{
+    object_t* objects[NUM_OBJECTS];
+    object_t* object;
+
+    for (uint64_t i = 0; i < NUM_OBJECTS; i++)
+    {
+        objects[i] = _new_object(i);
+
+        for (uint64_t j = 0; j < i; j++)
+            OE_TEST(objects[j] != objects[i]);
+    }
+
+    for (size_t i = 0; i < NUM_OBJECTS; i++)
+        _delete_object(objects[i]);
+
+    /* The magazines of the thread return the last object freed first */
+    object = _new_object(0);
+    _delete_object(object);
+    OE_TEST(_new_object(1) == object);
+    _delete_object(object);
+
+    /* The objects of oe_slab_calloc() are cleared, even once used */
+    OE_TEST(oe_slab_calloc(&_cache) == object);
+
+    for (size_t i = 0; i < sizeof(object_t); i++)
+        OE_TEST(((const uint8_t*)object)[i] == 0);
+
+    oe_slab_free(&_cache, object);
+}
+
+/* Caches past OE_SLAB_MAX_CACHES work without magazines, and destroyed
+ * caches can be used again */
+static void _test_many_caches(void)
+{
+    static oe_slab_cache_t caches[NUM_CACHES];
+    void* objects[NUM_CACHES];
+
+    for (int round = 0; round < 2; round++)
+    {
+        for (size_t i = 0; i < NUM_CACHES; i++)
+        {
+            const size_t size = 8 * (i + 1);
+
+            if (round == 0)
+                OE_TEST(oe_slab_cache_init(&caches[i], size, 8) == OE_OK);
+
+            OE_TEST((objects[i] = oe_slab_alloc(&caches[i])) != NULL);
+            OE_TEST((uintptr_t)objects[i] % 8 == 0);
+            memset(objects[i], (int)i, size);
+        }
+
+        for (size_t i = 0; i < NUM_CACHES; i++)
+        {
+            const uint8_t* bytes = (const uint8_t*)objects[i];
+
+            for (size_t j = 0; j < 8 * (i + 1); j++)
+                OE_TEST(bytes[j] == (uint8_t)i);
+
+            oe_slab_free(&caches[i], objects[i]);
+        }
+
+        for (size_t i = 0; i < NUM_CACHES; i++)
+            oe_slab_cache_destroy(&caches[i]);
+    }
+}
+
+/* Allocates, exchanges and frees objects */
+static void _stress(uint64_t round, uint64_t* state)
+{
+    object_t* objects[NUM_OBJECTS];
+
+    for (size_t i = 0; i < NUM_OBJECTS; i++)
+        objects[i] = _new_object(round * NUM_OBJECTS + i);
+
+    for (size_t i = 0; i < NUM_OBJECTS; i += 4)
+        objects[i] = (object_t*)alloc_stress_exchange(objects[i], state);
+
+    for (size_t i = 0; i < NUM_OBJECTS; i++)
+    {
+        if (objects[i])
+            _delete_object(objects[i]);
+    }
+}
+
+int enc_test_slab(uint64_t rounds)
+{
+    _test_init();
+    _test_single_thread();
+    _test_many_caches();
+
+    alloc_stress(rounds, _stress, _delete_object);
+
+    /* The cache is empty again once destroyed */
+    oe_slab_cache_destroy(&_cache);
+    _test_single_thread();
+    oe_slab_cache_destroy(&_cache);
+
+    return 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,             /* ProductID */
+    1,             /* SecurityVersion */
+    true,          /* AllowDebug */
+    1024,          /* HeapPageCount */
+    64,            /* StackPageCount */
+    SLAB_NUM_TCS); /* TCSCount */
@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include "../../alloc_stress/alloc_stress.h"
+#include "slab_u.h"
+
+#define ROUNDS 200
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = alloc_stress_create_enclave(
+        argc, argv, oe_create_slab_enclave, SLAB_NUM_TCS);
+    int return_value = -1;
+
+    result = enc_test_slab(enclave, &return_value, ROUNDS);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == 0);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
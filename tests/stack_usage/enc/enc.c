@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include "stack_usage_t.h"
+
+#define MAX_USE (128 * 1024)
+
+/* Write every byte so that none of the buffer keeps the stack pattern */
+static OE_NEVER_INLINE void _use_stack(size_t size)
+{
+    uint8_t buffer[MAX_USE];
+    volatile uint8_t* p = buffer + MAX_USE - size;
+
+    for (size_t i = 0; i < size; i++)
+        p[i] = (uint8_t)i;
+}
+
+void enc_use_stack(size_t size)
+{
+    OE_TEST(size <= MAX_USE);
+    _use_stack(size);
+}
+
+uint64_t enc_get_peak_stack_usage(void)
+{
+    oe_stack_usage_t usage[STACK_USAGE_NUM_TCS];
+    size_t num_usage = 0;
+    uint64_t peak = 0;
+
+    OE_TEST(oe_get_stack_usage(NULL, NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_get_stack_usage(NULL, &num_usage) == OE_BUFFER_TOO_SMALL);
+    OE_TEST(num_usage == STACK_USAGE_NUM_TCS);
+
+    if (oe_get_stack_usage(usage, &num_usage) != OE_OK)
+        return 0;
+
+    for (size_t i = 0; i < num_usage; i++)
+    {
+        OE_TEST(
+            usage[i].stack_size == STACK_USAGE_NUM_STACK_PAGES * OE_PAGE_SIZE);
+        OE_TEST(usage[i].peak_bytes <= usage[i].stack_size);
+
+        if (usage[i].peak_bytes > peak)
+            peak = usage[i].peak_bytes;
+    }
+
+    return peak;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,                           /* ProductID */
+    1,                           /* SecurityVersion */
+    true,                        /* AllowDebug */
+    1024,                        /* HeapPageCount */
+    STACK_USAGE_NUM_STACK_PAGES, /* StackPageCount */
+    STACK_USAGE_NUM_TCS);        /* TCSCount */
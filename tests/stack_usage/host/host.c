@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "stack_usage_u.h"
+
+#define STACK_SIZE (STACK_USAGE_NUM_STACK_PAGES * OE_PAGE_SIZE)
+
+/* Bytes of stack written by enc_use_stack() */
+#define USE_SIZE (96 * 1024)
+
+/* Largest peak usage of the stacks of the enclave as read by the host */
+static uint64_t _get_peak(oe_enclave_t* enclave)
+{
+    oe_stack_usage_t usage[STACK_USAGE_NUM_TCS];
+    size_t num_usage = 0;
+    uint64_t peak = 0;
+
+    OE_TEST(
+        oe_get_enclave_stack_usage(enclave, NULL, &num_usage) ==
+        OE_BUFFER_TOO_SMALL);
+    OE_TEST(num_usage == STACK_USAGE_NUM_TCS);
+    OE_TEST(oe_get_enclave_stack_usage(enclave, usage, &num_usage) == OE_OK);
+
+    for (size_t i = 0; i < num_usage; i++)
+    {
+        OE_TEST(usage[i].stack_size == STACK_SIZE);
+        OE_TEST(usage[i].peak_bytes <= STACK_SIZE);
+
+        /* Each TCS lies in its own pages */
+        OE_TEST(usage[i].tcs % OE_PAGE_SIZE == 0);
+        OE_TEST(i == 0 || usage[i].tcs != usage[i - 1].tcs);
+
+        if (usage[i].peak_bytes > peak)
+            peak = usage[i].peak_bytes;
+    }
+
+    return peak;
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    const uint32_t flags = oe_get_create_flags();
+    const bool readable =
+        (flags & (OE_ENCLAVE_FLAG_DEBUG | OE_ENCLAVE_FLAG_SIMULATE)) != 0;
+    uint64_t enclave_peak = 0;
+    size_t num_usage = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_stack_usage_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(
+        oe_get_enclave_stack_usage(NULL, NULL, &num_usage) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_get_enclave_stack_usage(enclave, NULL, NULL) ==
+        OE_INVALID_PARAMETER);
+
+    OE_TEST(enc_use_stack(enclave, USE_SIZE) == OE_OK);
+
+    /* The enclave sees the stack it used */
+    OE_TEST(enc_get_peak_stack_usage(enclave, &enclave_peak) == OE_OK);
+    OE_TEST(enclave_peak >= USE_SIZE);
+    OE_TEST(enclave_peak < STACK_SIZE);
+
+    if (readable)
+    {
+        /* So does the host, and the peak never decreases */
+        OE_TEST(_get_peak(enclave) >= enclave_peak);
+        OE_TEST(oe_dump_enclave_stack_usage(enclave, stdout) == OE_OK);
+    }
+    else
+    {
+        OE_TEST(
+            oe_get_enclave_stack_usage(enclave, NULL, &num_usage) ==
+            OE_UNSUPPORTED);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include "switchless_t.h"
+
+int enc_echo_switchless(char* in, char out[100], int repeats)
+{
+    for (int i = 0; i < repeats; i++)
+    {
+        int return_val = -1;
+
+        if (host_echo_switchless(&return_val, in, out) != OE_OK ||
+            return_val != 0)
+            return -1;
+
+        if (oe_strcmp(in, out) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+int enc_echo_large_switchless(size_t size)
+{
+    int ret = -1;
+    int return_val = -1;
+    uint8_t* in = (uint8_t*)oe_malloc(size);
+    uint8_t* out = (uint8_t*)oe_calloc(1, size);
+
+    if (!in || !out)
+        goto done;
+
+    for (size_t i = 0; i < size; i++)
+        in[i] = (uint8_t)i;
+
+    if (host_echo_large_switchless(&return_val, in, out, size) != OE_OK ||
+        return_val != 0)
+        goto done;
+
+    if (memcmp(in, out, size) != 0)
+        goto done;
+
+    ret = 0;
+
+done:
+    oe_free(in);
+    oe_free(out);
+    return ret;
+}
+
+int enc_echo_nested_switchless(char* in)
+{
+    int ret = -1;
+    char out[100];
+    int return_val = -1;
+    void* outer = oe_allocate_switchless_ocall_buffer(64);
+    void* inner = oe_allocate_switchless_ocall_buffer(64);
+
+    /* The second buffer cannot be the thread's switchless buffer */
+    if (!outer || !inner || outer == inner)
+        goto done;
+
+    /* The OCALL falls back to an ordinary OCALL while the buffer is busy */
+    if (host_echo_switchless(&return_val, in, out) != OE_OK ||
+        return_val != 0 || oe_strcmp(in, out) != 0)
+        goto done;
+
+    oe_free_switchless_ocall_buffer(inner);
+    oe_free_switchless_ocall_buffer(outer);
+    inner = outer = NULL;
+
+    /* The switchless buffer is available again afterwards */
+    if (host_echo_switchless(&return_val, in, out) != OE_OK ||
+        return_val != 0 || oe_strcmp(in, out) != 0)
+        goto done;
+
+    ret = 0;
+
+done:
+    if (inner)
+        oe_free_switchless_ocall_buffer(inner);
+    if (outer)
+        oe_free_switchless_ocall_buffer(outer);
+    return ret;
+}
+
+int enc_add_switchless(int a, int b)
+{
+    return a + b;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    1024, /* StackPageCount */
+    4);   /* TCSCount */
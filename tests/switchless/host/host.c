@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/switchless.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "switchless_u.h"
+
+#define NUM_HOST_WORKERS 2
+#define NUM_ENCLAVE_WORKERS 1
+#define NUM_TCS 4
+#define NUM_REPEATS 10000
+
+static oe_enclave_t* _enclave;
+
+int host_echo_switchless(char* in, char* out)
+{
+    strcpy(out, in);
+    return 0;
+}
+
+int host_echo_large_switchless(const void* in, void* out, size_t size)
+{
+    memcpy(out, in, size);
+    return 0;
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    int return_val;
+    char out[100];
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    /* Bad settings are rejected */
+    {
+        oe_enclave_setting_t setting;
+
+        setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+        setting.u.context_switchless_setting = NULL;
+
+        OE_TEST(
+            oe_create_switchless_enclave(
+                argv[1], OE_ENCLAVE_TYPE_SGX, flags, &setting, 1, &_enclave) ==
+            OE_INVALID_PARAMETER);
+
+        OE_TEST(
+            oe_create_switchless_enclave(
+                argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 1, &_enclave) ==
+            OE_INVALID_PARAMETER);
+    }
+
+    /* Enclave workers must leave at least one TCS for ordinary ECALLs */
+    {
+        oe_enclave_setting_context_switchless_t switchless_setting = {
+            0, NUM_TCS};
+        oe_enclave_setting_t setting;
+
+        setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+        setting.u.context_switchless_setting = &switchless_setting;
+
+        OE_TEST(
+            oe_create_switchless_enclave(
+                argv[1], OE_ENCLAVE_TYPE_SGX, flags, &setting, 1, &_enclave) ==
+            OE_INVALID_PARAMETER);
+    }
+
+    /* Without host workers, switchless OCALLs are ordinary OCALLs */
+    {
+        OE_TEST(
+            oe_create_switchless_enclave(
+                argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &_enclave) ==
+            OE_OK);
+
+        OE_TEST(
+            enc_echo_switchless(
+                _enclave, &return_val, "Hello World", out, 10) == OE_OK);
+        OE_TEST(return_val == 0);
+        OE_TEST(strcmp(out, "Hello World") == 0);
+
+        /* Without enclave workers, switchless ECALLs are ordinary ECALLs */
+        OE_TEST(enc_add_switchless(_enclave, &return_val, 1, 2) == OE_OK);
+        OE_TEST(return_val == 3);
+
+        OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+    }
+
+    /* With host workers */
+    {
+        oe_enclave_setting_context_switchless_t switchless_setting = {
+            NUM_HOST_WORKERS, NUM_ENCLAVE_WORKERS};
+        oe_enclave_setting_t setting;
+        oe_switchless_stats_t stats;
+
+        setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+        setting.u.context_switchless_setting = &switchless_setting;
+
+        if ((result = oe_create_switchless_enclave(
+                 argv[1],
+                 OE_ENCLAVE_TYPE_SGX,
+                 flags,
+                 &setting,
+                 1,
+                 &_enclave)) != OE_OK)
+            oe_put_err("oe_create_enclave(): result=%u", result);
+
+        result = enc_echo_switchless(
+            _enclave, &return_val, "Hello World", out, NUM_REPEATS);
+
+        if (result != OE_OK)
+            oe_put_err("oe_call_enclave() failed: result=%u", result);
+
+        OE_TEST(return_val == 0);
+        OE_TEST(strcmp(out, "Hello World") == 0);
+
+        /* Requests larger than the switchless buffer fall back */
+        OE_TEST(
+            enc_echo_large_switchless(_enclave, &return_val, 64 * 1024) ==
+            OE_OK);
+        OE_TEST(return_val == 0);
+
+        OE_TEST(
+            enc_echo_large_switchless(_enclave, &return_val, 1024) == OE_OK);
+        OE_TEST(return_val == 0);
+
+        /* Switchless OCALLs while the thread's switchless buffer is busy */
+        OE_TEST(
+            enc_echo_nested_switchless(_enclave, &return_val, "Nested") ==
+            OE_OK);
+        OE_TEST(return_val == 0);
+
+        /* Switchless ECALLs; those that no worker picks up in time are made
+         * as ordinary ECALLs, so only the total is deterministic */
+        for (int i = 0; i < NUM_REPEATS; i++)
+        {
+            OE_TEST(enc_add_switchless(_enclave, &return_val, i, 1) == OE_OK);
+            OE_TEST(return_val == i + 1);
+        }
+
+        OE_TEST(oe_get_switchless_stats(_enclave, &stats) == OE_OK);
+        OE_TEST(
+            stats.switchless_ecalls + stats.fallback_ecalls == NUM_REPEATS);
+        OE_TEST(
+            stats.switchless_ocalls + stats.fallback_ocalls >= NUM_REPEATS);
+
+        result = oe_terminate_enclave(_enclave);
+        OE_TEST(result == OE_OK);
+    }
+
+    printf("=== passed all tests (switchless)\n");
+
+    return 0;
+}
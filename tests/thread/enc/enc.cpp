@@ -9,10 +9,13 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
 #include <openenclave/internal/types.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <atomic>
+#include <vector>
 #include "thread_t.h"
 
 static oe_mutex_t mutex1 = OE_MUTEX_INITIALIZER;
@@ -82,6 +85,253 @@ void enc_test_mutex_counts(size_t* count1, size_t* count2)
     OE_TEST(oe_mutex_unlock(&mutex2) == 0);
 }
 
+static oe_mutex_t contention_mutex = OE_MUTEX_INITIALIZER;
+static size_t contention_count = 0;
+
+void enc_test_mutex_contention(size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+    {
+        OE_TEST(oe_mutex_lock(&contention_mutex) == 0);
+        contention_count++;
+        OE_TEST(oe_mutex_unlock(&contention_mutex) == 0);
+    }
+}
+
+size_t enc_mutex_contention_count()
+{
+    size_t count;
+
+    OE_TEST(oe_mutex_lock(&contention_mutex) == 0);
+    count = contention_count;
+    OE_TEST(oe_mutex_unlock(&contention_mutex) == 0);
+
+    return count;
+}
+
+/* The timed waits give up msec milliseconds from now */
+#ifdef _PTHREAD_ENC_
+#define TIMED_OUT ETIMEDOUT
+
+static struct timespec _deadline(uint64_t msec)
+{
+    const uint64_t t = oe_get_time() + msec;
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(t / 1000);
+    ts.tv_nsec = (long)(t % 1000) * 1000000;
+    return ts;
+}
+
+static int _mutex_timedlock(oe_mutex_t* m, uint64_t msec)
+{
+    struct timespec ts = _deadline(msec);
+    return pthread_mutex_timedlock(m, &ts);
+}
+
+static int _cond_timedwait(oe_cond_t* c, oe_mutex_t* m, uint64_t msec)
+{
+    struct timespec ts = _deadline(msec);
+    return pthread_cond_timedwait(c, m, &ts);
+}
+
+static int _rwlock_timedrdlock(oe_rwlock_t* rw, uint64_t msec)
+{
+    struct timespec ts = _deadline(msec);
+    return pthread_rwlock_timedrdlock(rw, &ts);
+}
+#else
+#define TIMED_OUT OE_TIMEOUT
+
+static uint64_t _deadline(uint64_t msec)
+{
+    return (oe_get_time() + msec) * 1000000;
+}
+
+static int _mutex_timedlock(oe_mutex_t* m, uint64_t msec)
+{
+    return oe_mutex_timedlock(m, _deadline(msec));
+}
+
+static int _cond_timedwait(oe_cond_t* c, oe_mutex_t* m, uint64_t msec)
+{
+    return oe_cond_timedwait(c, m, _deadline(msec));
+}
+
+static int _rwlock_timedrdlock(oe_rwlock_t* rw, uint64_t msec)
+{
+    return oe_rwlock_timedrdlock(rw, _deadline(msec));
+}
+#endif
+
+static oe_mutex_t timed_mutex = OE_MUTEX_INITIALIZER;
+static oe_cond_t timed_cond = OE_COND_INITIALIZER;
+static oe_rwlock_t timed_rwlock = OE_RWLOCK_INITIALIZER;
+
+void enc_hold_timed_mutex(size_t microseconds)
+{
+    OE_TEST(oe_mutex_lock(&timed_mutex) == 0);
+    host_usleep(microseconds);
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == 0);
+}
+
+/* Called while another thread holds timed_mutex */
+void enc_test_mutex_timedlock()
+{
+    const uint64_t start = oe_get_time();
+
+    OE_TEST(_mutex_timedlock(&timed_mutex, 50) == TIMED_OUT);
+    OE_TEST(oe_get_time() >= start + 50);
+
+    /* Obtained once the other thread releases it */
+    OE_TEST(_mutex_timedlock(&timed_mutex, 60000) == 0);
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == 0);
+}
+
+void enc_test_timed_waits()
+{
+    uint64_t start = oe_get_time();
+
+    /* Nobody signals the condition variable: the wait times out, and
+     * returns with the mutex locked again */
+    OE_TEST(oe_mutex_lock(&timed_mutex) == 0);
+    OE_TEST(_cond_timedwait(&timed_cond, &timed_mutex, 50) == TIMED_OUT);
+    OE_TEST(oe_get_time() >= start + 50);
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == 0);
+
+    /* A reader waits for the writer, which is this thread */
+    start = oe_get_time();
+    OE_TEST(oe_rwlock_wrlock(&timed_rwlock) == 0);
+    OE_TEST(_rwlock_timedrdlock(&timed_rwlock, 50) == TIMED_OUT);
+    OE_TEST(oe_get_time() >= start + 50);
+    OE_TEST(oe_rwlock_unlock(&timed_rwlock) == 0);
+
+    OE_TEST(_rwlock_timedrdlock(&timed_rwlock, 50) == 0);
+    OE_TEST(oe_rwlock_unlock(&timed_rwlock) == 0);
+}
+
+/* Threads started in the enclave, run by the host thread pool */
+#ifdef _PTHREAD_ENC_
+#define OUT_OF_THREADS EAGAIN
+
+static int _thread_create(oe_thread_t* t, void* (*func)(void*), void* arg)
+{
+    return pthread_create(t, NULL, func, arg);
+}
+
+static int _thread_join(oe_thread_t t, void** retval)
+{
+    return pthread_join(t, retval);
+}
+
+static int _thread_detach(oe_thread_t t)
+{
+    return pthread_detach(t);
+}
+#else
+#define OUT_OF_THREADS OE_OUT_OF_THREADS
+
+static int _thread_create(oe_thread_t* t, void* (*func)(void*), void* arg)
+{
+    return oe_thread_create(t, func, arg);
+}
+
+static int _thread_join(oe_thread_t t, void** retval)
+{
+    return oe_thread_join(t, retval);
+}
+
+static int _thread_detach(oe_thread_t t)
+{
+    return oe_thread_detach(t);
+}
+#endif
+
+static oe_mutex_t started_mutex = OE_MUTEX_INITIALIZER;
+static oe_cond_t started_cond = OE_COND_INITIALIZER;
+static size_t started_count = 0;
+static bool started_release = false;
+static __thread size_t started_tls = 42;
+
+/* Returns twice its argument once the threads are released */
+static void* _started_thread(void* arg)
+{
+    /* Each thread gets fresh thread-local storage */
+    OE_TEST(started_tls == 42);
+    started_tls = (size_t)arg;
+
+    OE_TEST(oe_mutex_lock(&started_mutex) == 0);
+    started_count++;
+    oe_cond_broadcast(&started_cond);
+
+    while (!started_release)
+        oe_cond_wait(&started_cond, &started_mutex);
+
+    OE_TEST(oe_mutex_unlock(&started_mutex) == 0);
+
+    return (void*)(2 * started_tls);
+}
+
+void enc_test_thread_create(size_t max_threads)
+{
+    std::vector<oe_thread_t> threads(max_threads);
+    oe_thread_t extra;
+    void* retval = NULL;
+
+    /* Run all the threads of the pool at once */
+    started_count = 0;
+    started_release = false;
+
+    for (size_t i = 0; i < max_threads; i++)
+        OE_TEST(_thread_create(&threads[i], _started_thread, (void*)i) == 0);
+
+    OE_TEST(oe_mutex_lock(&started_mutex) == 0);
+
+    while (started_count < max_threads)
+        oe_cond_wait(&started_cond, &started_mutex);
+
+    OE_TEST(oe_mutex_unlock(&started_mutex) == 0);
+
+    /* No thread of the pool is left */
+    OE_TEST(_thread_create(&extra, _started_thread, NULL) == OUT_OF_THREADS);
+
+    OE_TEST(oe_mutex_lock(&started_mutex) == 0);
+    started_release = true;
+    oe_cond_broadcast(&started_cond);
+    OE_TEST(oe_mutex_unlock(&started_mutex) == 0);
+
+    for (size_t i = 0; i < max_threads; i++)
+    {
+        OE_TEST(_thread_join(threads[i], &retval) == 0);
+        OE_TEST(retval == (void*)(2 * i));
+    }
+
+    /* The threads of the pool are reused, with fresh thread-local storage
+     * each time. A detached thread releases its thread when it finishes. */
+    for (size_t i = 0; i < max_threads; i++)
+    {
+        OE_TEST(_thread_create(&extra, _started_thread, (void*)i) == 0);
+
+        if (i % 2)
+        {
+            OE_TEST(_thread_detach(extra) == 0);
+        }
+        else
+        {
+            OE_TEST(_thread_join(extra, &retval) == 0);
+            OE_TEST(retval == (void*)(2 * i));
+        }
+    }
+
+    /* Wait for the detached threads to start */
+    OE_TEST(oe_mutex_lock(&started_mutex) == 0);
+
+    while (started_count < 2 * max_threads)
+        oe_cond_wait(&started_cond, &started_mutex);
+
+    OE_TEST(oe_mutex_unlock(&started_mutex) == 0);
+}
+
 static oe_cond_t cond = OE_COND_INITIALIZER;
 static oe_mutex_t cond_mutex = OE_MUTEX_INITIALIZER;
 
@@ -307,4 +557,4 @@ OE_SET_ENCLAVE_SGX(
     true, /* AllowDebug */
     128,  /* HeapPageCount */
     16,   /* StackPageCount */
-    16);  /* TCSCount */
+    64);  /* TCSCount */
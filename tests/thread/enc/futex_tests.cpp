@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifdef _PTHREAD_ENC_
+#include "thread.h"
+#endif
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <atomic>
+#include "thread_t.h"
+
+static pthread_barrier_t barrier;
+static std::atomic<size_t> barrier_arrivals(0);
+static std::atomic<size_t> barrier_serial_count(0);
+static sem_t sem;
+
+void enc_test_futex()
+{
+    uint64_t start = oe_get_time();
+    struct timespec ts;
+    int value = -1;
+
+#ifndef _PTHREAD_ENC_
+    volatile uint32_t word = 1;
+    volatile uint32_t word2 = 0;
+    size_t count = 1;
+
+    /* The word does not hold the value */
+    OE_TEST(oe_futex_wait(&word, 0, OE_UINT64_MAX) == OE_BUSY);
+    OE_TEST(oe_futex_requeue(&word, 0, 1, &word2, 1, NULL) == OE_BUSY);
+
+    /* Nobody wakes the thread */
+    OE_TEST(oe_futex_wait(&word, 1, (start + 50) * 1000000) == OE_TIMEOUT);
+    OE_TEST(oe_get_time() >= start + 50);
+
+    OE_TEST(oe_futex_wake(&word, OE_SIZE_MAX, &count) == OE_OK);
+    OE_TEST(count == 0);
+    OE_TEST(oe_futex_requeue(&word, 1, 1, &word2, 1, &count) == OE_OK);
+    OE_TEST(count == 0);
+
+    start = oe_get_time();
+#endif
+
+    OE_TEST(sem_init(&sem, 0, 1) == 0);
+    OE_TEST(sem_trywait(&sem) == 0);
+    OE_TEST(sem_trywait(&sem) == -1 && errno == EAGAIN);
+
+    /* Nobody posts the semaphore */
+    ts.tv_sec = (time_t)((start + 50) / 1000);
+    ts.tv_nsec = (long)((start + 50) % 1000) * 1000000;
+    OE_TEST(sem_timedwait(&sem, &ts) == -1 && errno == ETIMEDOUT);
+    OE_TEST(oe_get_time() >= start + 50);
+
+    OE_TEST(sem_post(&sem) == 0);
+    OE_TEST(sem_getvalue(&sem, &value) == 0 && value == 1);
+    OE_TEST(sem_destroy(&sem) == 0);
+}
+
+void enc_init_barrier_and_sem(size_t num_threads)
+{
+    barrier_arrivals = 0;
+    barrier_serial_count = 0;
+
+    OE_TEST(pthread_barrier_init(&barrier, NULL, (unsigned)num_threads) == 0);
+    OE_TEST(sem_init(&sem, 0, 0) == 0);
+}
+
+void enc_barrier_rounds(size_t num_threads, size_t rounds)
+{
+    for (size_t i = 0; i < rounds; i++)
+    {
+        barrier_arrivals++;
+
+        int r = pthread_barrier_wait(&barrier);
+        OE_TEST(r == 0 || r == PTHREAD_BARRIER_SERIAL_THREAD);
+
+        if (r == PTHREAD_BARRIER_SERIAL_THREAD)
+            barrier_serial_count++;
+
+        /* All the threads arrived at this round before any left it */
+        OE_TEST(barrier_arrivals >= (i + 1) * num_threads);
+    }
+}
+
+void enc_sem_post_n(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(sem_post(&sem) == 0);
+}
+
+void enc_sem_wait_n(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(sem_wait(&sem) == 0);
+}
+
+void enc_barrier_and_sem_results(size_t* serial_count, int* sem_value)
+{
+    *serial_count = barrier_serial_count;
+    OE_TEST(sem_getvalue(&sem, sem_value) == 0);
+
+    OE_TEST(pthread_barrier_destroy(&barrier) == 0);
+    OE_TEST(sem_destroy(&sem) == 0);
+}
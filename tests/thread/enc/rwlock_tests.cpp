@@ -7,6 +7,7 @@
 
 #include <openenclave/enclave.h>
 #include <openenclave/internal/print.h>
+#include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
 #include <openenclave/internal/types.h>
 #include <stdio.h>
@@ -23,6 +24,7 @@ static size_t g_writers = 0;
 static size_t g_max_readers = 0;
 static size_t g_max_writers = 0;
 static bool g_readers_and_writers = false;
+static bool g_distributed = false;
 
 class ScopedSpinLock
 {
@@ -72,8 +74,9 @@ void enc_reader_thread_impl()
             g_max_readers = std::max(g_max_readers, g_readers);
 
             // Allow all reader threads to be simultaneously active
-            // at least once.
-            while (g_max_readers < NUM_READER_THREADS)
+            // at least once. Distributed locks prefer writers, so readers
+            // inside may not wait for readers kept out by a writer.
+            while (!g_distributed && g_max_readers < NUM_READER_THREADS)
             {
                 lock.Unlock();
                 host_usleep(sleep_utime);
@@ -89,6 +92,13 @@ void enc_reader_thread_impl()
         // Multiple readers should be allowed.
         host_usleep(sleep_utime);
 
+        // A reader may lock a distributed lock again while a writer waits.
+        if (g_distributed)
+        {
+            oe_rwlock_rdlock(&rw_lock);
+            oe_rwlock_unlock(&rw_lock);
+        }
+
         {
             // Update test data.
             ScopedSpinLock lock(&rw_args_lock);
@@ -150,6 +160,19 @@ void enc_writer_thread_impl()
     oe_host_printf("%llu: Writer Exiting\n", OE_LLU(oe_thread_self()));
 }
 
+void enc_rw_use_distributed()
+{
+    OE_TEST(oe_rwlock_destroy(&rw_lock) == 0);
+    OE_TEST(oe_rwlock_init_distributed(&rw_lock) == 0);
+
+    g_readers = 0;
+    g_writers = 0;
+    g_max_readers = 0;
+    g_max_writers = 0;
+    g_readers_and_writers = false;
+    g_distributed = true;
+}
+
 void enc_rw_results(
     size_t* readers,
     size_t* writers,
@@ -45,5 +45,21 @@ typedef pthread_rwlock_t oe_rwlock_t;
 #define oe_rwlock_rdlock pthread_rwlock_rdlock
 #define oe_rwlock_wrlock pthread_rwlock_wrlock
 #define oe_rwlock_unlock pthread_rwlock_unlock
+#define oe_rwlock_destroy pthread_rwlock_destroy
+
+/* Writer-preferring locks are distributed */
+static __inline int oe_rwlock_init_distributed(pthread_rwlock_t* rw_lock)
+{
+    pthread_rwlockattr_t attr;
+    int ret;
+
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(
+        &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    ret = pthread_rwlock_init(rw_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    return ret;
+}
 
 #endif /* _OE_INCLUDE_THREAD_H */
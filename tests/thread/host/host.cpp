@@ -4,6 +4,7 @@
 #include <openenclave/host.h>
 #include <openenclave/internal/error.h>
 #include <openenclave/internal/tests.h>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <chrono>
@@ -47,6 +48,158 @@ void test_mutex(oe_enclave_t* enclave)
     OE_TEST(count2 == NUM_THREADS);
 }
 
+// Short critical sections under heavy contention, which waiters mostly
+// spin for instead of waiting in the host
+void test_mutex_contention(oe_enclave_t* enclave)
+{
+    const size_t iterations = 10000;
+    std::thread threads[NUM_THREADS];
+    size_t count = 0;
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i] = std::thread([enclave, iterations]() {
+            OE_TEST(enc_test_mutex_contention(enclave, iterations) == OE_OK);
+        });
+    }
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    OE_TEST(enc_mutex_contention_count(enclave, &count) == OE_OK);
+    OE_TEST(count == NUM_THREADS * iterations);
+}
+
+// The lock profiler counts the operations on each lock while it is enabled
+void test_lock_stats(oe_enclave_t* enclave)
+{
+    const size_t iterations = 1000;
+    std::thread threads[NUM_THREADS];
+    std::vector<oe_lock_stats_t> stats;
+    size_t num_stats = 0;
+    uint64_t mutex_acquisitions = 0;
+    uint64_t spinlock_acquisitions = 0;
+
+    OE_TEST(oe_enable_enclave_lock_stats(enclave, true) == OE_OK);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i] = std::thread([enclave, iterations]() {
+            OE_TEST(enc_test_mutex_contention(enclave, iterations) == OE_OK);
+        });
+    }
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    OE_TEST(oe_enable_enclave_lock_stats(enclave, false) == OE_OK);
+
+    OE_TEST(
+        oe_get_enclave_lock_stats(enclave, NULL, &num_stats) ==
+        OE_BUFFER_TOO_SMALL);
+    OE_TEST(num_stats > 0);
+
+    stats.resize(num_stats);
+    OE_TEST(
+        oe_get_enclave_lock_stats(enclave, stats.data(), &num_stats) ==
+        OE_OK);
+    OE_TEST(num_stats == stats.size());
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        const oe_lock_stats_t& s = stats[i];
+
+        OE_TEST(s.acquisitions > 0);
+        OE_TEST(s.contended <= s.acquisitions);
+        OE_TEST(s.wait_ns == 0 || s.parks > 0);
+
+        // Sorted by decreasing wait
+        OE_TEST(i == 0 || stats[i - 1].wait_ns >= s.wait_ns);
+
+        if (s.type == OE_LOCK_TYPE_MUTEX)
+            mutex_acquisitions = std::max(mutex_acquisitions, s.acquisitions);
+        else if (s.type == OE_LOCK_TYPE_SPINLOCK)
+            spinlock_acquisitions =
+                std::max(spinlock_acquisitions, s.acquisitions);
+    }
+
+    // The contention mutex, and the spinlock that guards it
+    OE_TEST(mutex_acquisitions >= NUM_THREADS * iterations);
+    OE_TEST(spinlock_acquisitions >= NUM_THREADS * iterations);
+
+    OE_TEST(oe_dump_enclave_lock_stats(enclave, 5, stdout) == OE_OK);
+
+    // Nothing is counted once the profiler is disabled
+    OE_TEST(enc_test_mutex_contention(enclave, iterations) == OE_OK);
+    OE_TEST(
+        oe_get_enclave_lock_stats(enclave, stats.data(), &num_stats) ==
+        OE_OK);
+    OE_TEST(num_stats == stats.size());
+
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        if (stats[i].type == OE_LOCK_TYPE_MUTEX)
+            OE_TEST(stats[i].acquisitions <= mutex_acquisitions);
+    }
+}
+
+void test_timed_waits(oe_enclave_t* enclave)
+{
+    OE_TEST(enc_test_timed_waits(enclave) == OE_OK);
+
+    // Hold the mutex for half a second while another thread tries to lock it
+    std::thread holder([enclave]() {
+        OE_TEST(enc_hold_timed_mutex(enclave, 500000) == OE_OK);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    OE_TEST(enc_test_mutex_timedlock(enclave) == OE_OK);
+
+    holder.join();
+}
+
+// The threads meet at a barrier for a number of rounds, then half of them
+// post a semaphore that the other half waits on
+void test_barrier_and_semaphore(oe_enclave_t* enclave)
+{
+    const size_t rounds = 1000;
+    const size_t posts = 10000;
+    std::thread threads[NUM_THREADS];
+    size_t serial_count = 0;
+    int sem_value = -1;
+
+    OE_TEST(enc_test_futex(enclave) == OE_OK);
+    OE_TEST(enc_init_barrier_and_sem(enclave, NUM_THREADS) == OE_OK);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i] = std::thread([enclave, rounds, posts, i]() {
+            OE_TEST(
+                enc_barrier_rounds(enclave, NUM_THREADS, rounds) == OE_OK);
+
+            if (i % 2)
+                OE_TEST(enc_sem_post_n(enclave, posts) == OE_OK);
+            else
+                OE_TEST(enc_sem_wait_n(enclave, posts) == OE_OK);
+        });
+    }
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        threads[i].join();
+    }
+
+    OE_TEST(
+        enc_barrier_and_sem_results(enclave, &serial_count, &sem_value) ==
+        OE_OK);
+    OE_TEST(serial_count == rounds);
+    OE_TEST(sem_value == 0);
+}
+
 void* waiter_thread(oe_enclave_t* enclave)
 {
     oe_result_t result = enc_wait(enclave, NUM_THREADS);
@@ -211,6 +364,8 @@ void test_thread_locking_patterns(oe_enclave_t* enclave)
 
 void test_readers_writer_lock(oe_enclave_t* enclave);
 
+void test_distributed_readers_writer_lock(oe_enclave_t* enclave);
+
 // test_tcs_exhaustion
 static std::atomic<size_t> g_tcs_out_thread_count(0);
 
@@ -281,6 +436,124 @@ void test_tcs_exhaustion(oe_enclave_t* enclave)
     OE_TEST(tcs_used_thread_count <= enclave->num_bindings);
 }
 
+static oe_enclave_t* create_tcs_wait_enclave(
+    const char* path,
+    uint32_t timeout_ms)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_setting_tcs_wait_t tcs_wait_setting = {timeout_ms};
+    oe_enclave_setting_t setting;
+
+    setting.setting_type = OE_ENCLAVE_SETTING_TCS_WAIT;
+    setting.u.tcs_wait_setting = &tcs_wait_setting;
+
+    OE_TEST(
+        oe_create_thread_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            oe_get_create_flags(),
+            &setting,
+            1,
+            &enclave) == OE_OK);
+
+    return enclave;
+}
+
+// with an infinite TCS wait, ecalls made while all the TCSes are busy wait
+// for one to become free instead of failing with OE_OUT_OF_THREADS
+void test_tcs_wait(const char* path)
+{
+    oe_enclave_t* enclave = create_tcs_wait_enclave(path, OE_TCS_WAIT_INFINITE);
+    std::vector<std::thread> threads;
+    const size_t num_threads = enclave->num_bindings * 4;
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        threads.push_back(std::thread(test_mutex_thread, enclave));
+    }
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        threads[i].join();
+    }
+
+    size_t count1 = 0;
+    size_t count2 = 0;
+    OE_TEST(enc_test_mutex_counts(enclave, &count1, &count2) == OE_OK);
+
+    OE_TEST(count1 == num_threads);
+    OE_TEST(count2 == num_threads);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+}
+
+// with a finite TCS wait, an ecall fails with OE_OUT_OF_THREADS once the
+// timeout expires. The threads holding the TCSes only return after that.
+void test_tcs_wait_timeout(const char* path)
+{
+    oe_enclave_t* enclave = create_tcs_wait_enclave(path, 100);
+    std::vector<std::thread> threads;
+    const size_t test_tcs_req_count = enclave->num_bindings + 1;
+
+    g_tcs_out_thread_count = 0;
+
+    for (size_t i = 0; i < test_tcs_req_count; i++)
+    {
+        threads.push_back(std::thread(tcs_thread, enclave, test_tcs_req_count));
+    }
+
+    for (size_t i = 0; i < test_tcs_req_count; i++)
+    {
+        threads[i].join();
+    }
+
+    size_t tcs_used_thread_count = 0;
+    OE_TEST(
+        enc_tcs_used_thread_count(enclave, &tcs_used_thread_count) == OE_OK);
+
+    OE_TEST(g_tcs_out_thread_count == 1);
+    OE_TEST(tcs_used_thread_count == enclave->num_bindings);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+}
+
+// threads started in the enclave are run by the host thread pool, and
+// fail to start once all the threads of the pool are busy
+void test_thread_create(const char* path)
+{
+    const size_t max_threads = 4;
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_setting_thread_pool_t thread_pool_setting = {max_threads};
+    oe_enclave_setting_t setting;
+
+    setting.setting_type = OE_ENCLAVE_SETTING_THREAD_POOL;
+    setting.u.thread_pool_setting = &thread_pool_setting;
+
+    OE_TEST(
+        oe_create_thread_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            oe_get_create_flags(),
+            &setting,
+            1,
+            &enclave) == OE_OK);
+
+    OE_TEST(enc_test_thread_create(enclave, max_threads) == OE_OK);
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    // The pool must leave a TCS for ordinary ECALLs
+    thread_pool_setting.max_threads = 64;
+
+    OE_TEST(
+        oe_create_thread_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            oe_get_create_flags(),
+            &setting,
+            1,
+            &enclave) == OE_INVALID_PARAMETER);
+}
+
 size_t host_tcs_out_thread_count()
 {
     return g_tcs_out_thread_count;
@@ -306,8 +579,18 @@ int main(int argc, const char* argv[])
         oe_put_err("oe_create_thread_enclave(): result=%u", result);
     }
 
+    // The enclave is signed with more TCSs than the former limit of 32, and
+    // gets a thread binding for each of them
+    OE_TEST(enclave->num_bindings == 64);
+
     test_mutex(enclave);
 
+    test_mutex_contention(enclave);
+
+    test_lock_stats(enclave);
+
+    test_timed_waits(enclave);
+
     test_cond(enclave);
 
     test_cond_broadcast(enclave);
@@ -318,6 +601,10 @@ int main(int argc, const char* argv[])
 
     test_readers_writer_lock(enclave);
 
+    test_distributed_readers_writer_lock(enclave);
+
+    test_barrier_and_semaphore(enclave);
+
     test_tcs_exhaustion(enclave);
 
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
@@ -325,6 +612,12 @@ int main(int argc, const char* argv[])
         oe_put_err("oe_terminate_enclave(): result=%u", result);
     }
 
+    test_tcs_wait(argv[1]);
+
+    test_tcs_wait_timeout(argv[1]);
+
+    test_thread_create(argv[1]);
+
     printf("=== passed all tests (%s)\n", argv[0]);
 
     return 0;
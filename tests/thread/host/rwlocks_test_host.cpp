@@ -32,17 +32,11 @@ void* writer_thread(oe_enclave_t* enclave)
     return NULL;
 }
 
-// Launch multiple reader and writer threads and OE_TEST invariants.
-void test_readers_writer_lock(oe_enclave_t* enclave)
+// Launch multiple reader and writer threads.
+static void _run_readers_and_writers(oe_enclave_t* enclave)
 {
     std::thread threads[NUM_RW_TEST_THREADS];
 
-    size_t readers = 0;
-    size_t writers = 0;
-    size_t max_readers = 0;
-    size_t max_writers = 0;
-    bool readers_and_writers = false;
-
     for (size_t i = 0; i < NUM_RW_TEST_THREADS; i++)
     {
         if (i & 1)
@@ -59,6 +53,18 @@ void test_readers_writer_lock(oe_enclave_t* enclave)
     {
         threads[i].join();
     }
+}
+
+// Launch multiple reader and writer threads and OE_TEST invariants.
+void test_readers_writer_lock(oe_enclave_t* enclave)
+{
+    size_t readers = 0;
+    size_t writers = 0;
+    size_t max_readers = 0;
+    size_t max_writers = 0;
+    bool readers_and_writers = false;
+
+    _run_readers_and_writers(enclave);
 
     OE_TEST(
         enc_rw_results(
@@ -83,3 +89,38 @@ void test_readers_writer_lock(oe_enclave_t* enclave)
     // simultaneously active at least once.
     OE_TEST(max_readers == NUM_READER_THREADS);
 }
+
+// The same with a distributed lock, which prefers writers.
+void test_distributed_readers_writer_lock(oe_enclave_t* enclave)
+{
+    size_t readers = 0;
+    size_t writers = 0;
+    size_t max_readers = 0;
+    size_t max_writers = 0;
+    bool readers_and_writers = false;
+
+    OE_TEST(enc_rw_use_distributed(enclave) == OE_OK);
+
+    _run_readers_and_writers(enclave);
+
+    OE_TEST(
+        enc_rw_results(
+            enclave,
+            &readers,
+            &writers,
+            &max_readers,
+            &max_writers,
+            &readers_and_writers) == OE_OK);
+
+    // All the readers and writers have released the lock.
+    OE_TEST(readers == 0 && writers == 0);
+
+    // There can be at most 1 writer thread active.
+    OE_TEST(max_writers == 1);
+
+    // There can be at most NUM_THREADS/2 reader threads active.
+    OE_TEST(max_readers >= 1 && max_readers <= NUM_READER_THREADS);
+
+    // Readers and writer threads should never be simultaneously active.
+    OE_TEST(readers_and_writers == false);
+}
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include "transitions_t.h"
+
+void enc_empty(void)
+{
+}
+
+void enc_buffer_in(const unsigned char* buffer, size_t size)
+{
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+}
+
+void enc_buffer_in_out(unsigned char* buffer, size_t size)
+{
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+}
+
+void enc_call_host(uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+        OE_TEST(host_empty() == OE_OK);
+}
+
+int enc_call_host_buffer(size_t size, uint64_t iterations)
+{
+    unsigned char* buffer = NULL;
+
+    if (size && !(buffer = (unsigned char*)malloc(size)))
+        return -1;
+
+    if (buffer)
+        memset(buffer, 0xAA, size);
+
+    for (uint64_t i = 0; i < iterations; i++)
+        OE_TEST(host_buffer_in(buffer, size) == OE_OK);
+
+    free(buffer);
+    return 0;
+}
+
+void enc_call_host_nested(uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+        OE_TEST(host_call_enclave() == OE_OK);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,                    /* ProductID */
+    1,                    /* SecurityVersion */
+    true,                 /* AllowDebug */
+    1024,                 /* HeapPageCount */
+    16,                   /* StackPageCount */
+    TRANSITIONS_NUM_TCS); /* TCSCount */
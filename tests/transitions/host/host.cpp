@@ -0,0 +1,204 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include "../../bench/bench.h"
+#include "transitions_u.h"
+
+/*
+**==============================================================================
+**
+** oebench_transitions:
+**
+**     Measures the cost of the transitions between the host and the enclave:
+**     the latency of ECALLs, of OCALLs, of ECALLs nested in OCALLs, and how
+**     it varies with the size of the marshaled buffers and with the number of
+**     threads calling concurrently. The results are written in CSV or JSON so
+**     that they can be compared between releases.
+**
+**     OCALL latencies are measured by timing an ECALL that makes the OCALLs
+**     in a loop, so they include a share of one ECALL.
+**
+**==============================================================================
+*/
+
+static oe_enclave_t* _enclave;
+
+static std::vector<bench_result> _results;
+
+void host_empty()
+{
+}
+
+void host_buffer_in(const unsigned char* buffer, size_t size)
+{
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+}
+
+void host_call_enclave()
+{
+    OE_TEST(enc_empty(_enclave) == OE_OK);
+}
+
+/* Run body(iterations) on each of the threads, after a warm-up, and record
+ * the wall-clock time */
+static void _run(
+    const char* benchmark,
+    size_t threads,
+    size_t size,
+    uint64_t iterations,
+    const std::function<void(uint64_t)>& body)
+{
+    const uint64_t warmup = iterations / 10 ? iterations / 10 : 1;
+    const uint64_t total_ns = bench_run(threads, warmup, iterations, body);
+    const double calls = (double)(iterations * threads);
+
+    _results.push_back(
+        {bench_string("benchmark", benchmark),
+         bench_uint("threads", threads),
+         bench_uint("size", size),
+         bench_uint("iterations", iterations),
+         bench_uint("total_ns", total_ns),
+         bench_double("ns_per_call", (double)total_ns / (double)iterations, 1),
+         bench_double(
+             "calls_per_sec",
+             total_ns ? calls * 1e9 / (double)total_ns : 0.0,
+             0)});
+}
+
+/* Keep the amount of data copied by a benchmark about the same for all
+ * buffer sizes */
+static uint64_t _iterations_for_size(uint64_t iterations, size_t size)
+{
+    const size_t page_size = 4096;
+    uint64_t n = iterations;
+
+    if (size > page_size)
+        n = iterations * page_size / size;
+
+    return n ? n : 1;
+}
+
+static void _run_benchmarks(const bench_options& opts)
+{
+    const uint64_t iterations = opts.iterations;
+    std::vector<size_t> sizes = {0};
+    std::vector<unsigned char> buffer(TRANSITIONS_MAX_BUFFER_SIZE);
+
+    for (size_t size = 16; size <= TRANSITIONS_MAX_BUFFER_SIZE; size *= 4)
+        sizes.push_back(size);
+
+    _run("ecall", 1, 0, iterations, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            OE_TEST(enc_empty(_enclave) == OE_OK);
+    });
+
+    _run("ocall", 1, 0, iterations, [](uint64_t n) {
+        OE_TEST(enc_call_host(_enclave, n) == OE_OK);
+    });
+
+    _run("ecall_ocall_ecall", 1, 0, iterations, [](uint64_t n) {
+        OE_TEST(enc_call_host_nested(_enclave, n) == OE_OK);
+    });
+
+    for (size_t size : sizes)
+    {
+        const uint64_t n = _iterations_for_size(iterations, size);
+        unsigned char* data = buffer.data();
+
+        _run("ecall_in", 1, size, n, [data, size](uint64_t count) {
+            for (uint64_t i = 0; i < count; i++)
+                OE_TEST(enc_buffer_in(_enclave, data, size) == OE_OK);
+        });
+
+        _run("ecall_in_out", 1, size, n, [data, size](uint64_t count) {
+            for (uint64_t i = 0; i < count; i++)
+                OE_TEST(enc_buffer_in_out(_enclave, data, size) == OE_OK);
+        });
+
+        _run("ocall_in", 1, size, n, [size](uint64_t count) {
+            int ret = -1;
+            OE_TEST(
+                enc_call_host_buffer(_enclave, &ret, size, count) == OE_OK);
+            OE_TEST(ret == 0);
+        });
+    }
+
+    /* The iterations are those of each thread */
+    for (size_t n : bench_thread_counts(opts.max_threads))
+    {
+        _run("ecall_threads", n, 0, iterations, [](uint64_t count) {
+            for (uint64_t i = 0; i < count; i++)
+                OE_TEST(enc_empty(_enclave) == OE_OK);
+        });
+
+        _run("ocall_threads", n, 0, iterations, [](uint64_t count) {
+            OE_TEST(enc_call_host(_enclave, count) == OE_OK);
+        });
+    }
+}
+
+static void _usage(const char* arg0)
+{
+    fprintf(
+        stderr,
+        "Usage: %s ENCLAVE [--iterations N] [--threads N] [--json] "
+        "[--output FILE] [--quick]\n",
+        arg0);
+    exit(1);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    bench_options opts;
+
+    opts.iterations = 100000;
+    opts.max_threads = TRANSITIONS_NUM_TCS;
+
+    if (argc < 2)
+        _usage(argv[0]);
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (bench_parse_option(argc, argv, &i, &opts))
+            continue;
+
+        if (strcmp(argv[i], "--quick") == 0)
+            opts.iterations = 100;
+        else
+            _usage(argv[0]);
+    }
+
+    if (opts.iterations == 0 || opts.max_threads == 0 ||
+        opts.max_threads > TRANSITIONS_NUM_TCS)
+    {
+        fprintf(
+            stderr,
+            "%s: iterations must be positive and threads between 1 and %d\n",
+            argv[0],
+            TRANSITIONS_NUM_TCS);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    if ((result = oe_create_transitions_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &_enclave)) !=
+        OE_OK)
+    {
+        oe_put_err("oe_create_transitions_enclave(): result=%u", result);
+    }
+
+    _run_benchmarks(opts);
+
+    if ((result = oe_terminate_enclave(_enclave)) != OE_OK)
+    {
+        oe_put_err("oe_terminate_enclave(): result=%u", result);
+    }
+
+    return bench_output_results(argv[0], opts, bench_mode(flags), _results);
+}
@@ -230,6 +230,33 @@ let oe_gen_wrapper_prototype (fd : func_decl) (is_ecall : bool) =
   in
   sprintf "oe_result_t %s(%s)" fd.fname plist_str
 
+(** Check whether a batched host wrapper is generated for the given
+    ECALL: all of its parameters must be passed by value. *)
+let is_batchable_ecall (tf : trusted_func) =
+  List.for_all
+    (fun (ptype, (decl : declarator)) ->
+      match ptype with PTVal _ -> decl.array_dims = [] | PTPtr _ -> false )
+    tf.tf_fdecl.plist
+
+(** Generate the prototype of the batched host wrapper of a given ECALL.
+    Each parameter becomes an array holding its value for every call. *)
+let oe_gen_batch_wrapper_prototype (fd : func_decl) =
+  let args =
+    [ ["oe_enclave_t* enclave"; "size_t _count"; "oe_result_t* _results"]
+    ; ( match fd.rtype with
+      | Void -> []
+      | _ -> [get_tystr fd.rtype ^ "* _retvals"] )
+    ; List.map
+        (fun (ptype, decl) ->
+          sprintf "const %s* %s"
+            (get_tystr (get_param_atype ptype))
+            decl.identifier )
+        fd.plist ]
+    |> List.flatten
+  in
+  sprintf "oe_result_t %s_batch(\n    %s)" fd.fname
+    (String.concat ",\n    " args)
+
 (** Emit [struct], [union], or [enum]. *)
 let emit_composite_type =
   let emit_struct (s : struct_def) =
@@ -441,11 +468,6 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
       if f.tf_is_priv then
         failwithf
           "Function '%s': 'private' specifier is not supported by oeedger8r"
-          f.tf_fdecl.fname ;
-      if f.tf_is_switchless then
-        failwithf
-          "Function '%s': switchless ecalls and ocalls are not yet supported \
-           by Open Enclave SDK."
           f.tf_fdecl.fname )
     tfs ;
   List.iter
@@ -464,11 +486,28 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
           "Warning: Function '%s': Reentrant ocalls are not supported by Open \
            Enclave. Allow list ignored.\n"
           f.uf_fdecl.fname ;
-      if f.uf_is_switchless then
-        failwithf
-          "Function '%s': switchless ecalls and ocalls are not yet supported \
-           by Open Enclave SDK."
-          f.uf_fdecl.fname )
+      (* Deferred ocalls are queued and carried out later: nothing can be
+         returned to the enclave. *)
+      if f.uf_is_deferred then (
+        if f.uf_is_switchless then
+          failwithf
+            "Function '%s': 'transition_deferred' cannot be combined with \
+             'transition_using_threads'."
+            f.uf_fdecl.fname ;
+        if f.uf_propagate_errno then
+          failwithf
+            "Function '%s': 'transition_deferred' cannot be combined with \
+             'propagate_errno'."
+            f.uf_fdecl.fname ;
+        if f.uf_fdecl.rtype <> Void then
+          failwithf
+            "Function '%s': a 'transition_deferred' function must return void."
+            f.uf_fdecl.fname ;
+        if List.exists is_out_or_inout_ptr f.uf_fdecl.plist then
+          failwithf
+            "Function '%s': a 'transition_deferred' function cannot have out \
+             or in-out parameters."
+            f.uf_fdecl.fname ) )
     ufs ;
   (* Map warning functions over trusted and untrusted function
      declarations *)
@@ -950,6 +989,11 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
   (* Generate host ECALL wrapper function. *)
   let oe_gen_host_ecall_wrapper (tf : trusted_func) =
     let fd = tf.tf_fdecl in
+    (* Switchless ECALLs are handed to an enclave worker thread. *)
+    let call_function =
+      if tf.tf_is_switchless then "oe_switchless_call_enclave_function"
+      else "oe_call_enclave_function"
+    in
     [ oe_gen_wrapper_prototype fd true
     ; "{"
     ; "    oe_result_t _result = OE_FAILURE;"
@@ -976,7 +1020,7 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "    " ^ String.concat "\n    " (oe_prepare_input_buffer fd "malloc")
     ; ""
     ; "    /* Call enclave function. */"
-    ; "    if ((_result = oe_call_enclave_function("
+    ; sprintf "    if ((_result = %s(" call_function
     ; "             "
       ^ String.concat ",\n             "
           [ "enclave"
@@ -999,9 +1043,114 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "}"
     ; "" ]
   in
+  (* Generate the batched host ECALL wrapper function: it makes [_count]
+     calls within a single enclave entry. The marshalling struct of each
+     call is both its input and its output buffer, and all of them share a
+     single allocation. *)
+  let oe_gen_host_ecall_batch_wrapper (tf : trusted_func) =
+    let fd = tf.tf_fdecl in
+    let params = List.map (fun (_, decl) -> decl.identifier) fd.plist in
+    [ oe_gen_batch_wrapper_prototype fd
+    ; "{"
+    ; "    oe_result_t _result = OE_FAILURE;"
+    ; ""
+    ; "    /* Marshalling buffer and calls. */"
+    ; "    size_t _slot_size = 0;"
+    ; "    uint8_t* _buffer = NULL;"
+    ; "    oe_enclave_function_call_t* _calls = NULL;"
+    ; ""
+    ; "    if (_count == 0)"
+    ; "    {"
+    ; "        _result = OE_OK;"
+    ; "        goto done;"
+    ; "    }"
+    ; ""
+    ; sprintf "    if (%s)"
+        (String.concat " || "
+           (List.map (fun p -> "!" ^ p) ("_results" :: params)))
+    ; "    {"
+    ; "        _result = OE_INVALID_PARAMETER;"
+    ; "        goto done;"
+    ; "    }"
+    ; ""
+    ; "    /* Allocate marshalling buffer. */"
+    ; sprintf "    OE_ADD_SIZE(_slot_size, sizeof(%s_args_t));" fd.fname
+    ; "    _buffer = (uint8_t*)calloc(_count, _slot_size);"
+    ; "    _calls = (oe_enclave_function_call_t*)calloc(_count, sizeof(*_calls));"
+    ; "    if (_buffer == NULL || _calls == NULL)"
+    ; "    {"
+    ; "        _result = OE_OUT_OF_MEMORY;"
+    ; "        goto done;"
+    ; "    }"
+    ; ""
+    ; "    /* Fill marshalling structs. */"
+    ; "    for (size_t _i = 0; _i < _count; _i++)"
+    ; "    {"
+    ; sprintf "        %s_args_t* _pargs = (%s_args_t*)(_buffer + _i * _slot_size);"
+        fd.fname fd.fname
+    ; String.concat ""
+        (List.map (fun p -> sprintf "        _pargs->%s = %s[_i];\n" p p) params)
+      ^ sprintf "        _calls[_i].function_id = %s;" (get_function_id fd)
+    ; "        _calls[_i].input_buffer = _pargs;"
+    ; "        _calls[_i].input_buffer_size = _slot_size;"
+    ; "        _calls[_i].output_buffer = _pargs;"
+    ; "        _calls[_i].output_buffer_size = _slot_size;"
+    ; "    }"
+    ; ""
+    ; "    /* Call enclave functions. */"
+    ; "    if ((_result = oe_call_enclave_functions_batch("
+    ; "             enclave, _calls, _count)) != OE_OK)"
+    ; "        goto done;"
+    ; ""
+    ; "    /* Unmarshal results and return values. */"
+    ; "    for (size_t _i = 0; _i < _count; _i++)"
+    ; "    {"
+    ; "        _results[_i] = _calls[_i].result;"
+    ; ""
+    ; "        /* Currently exactly _slot_size bytes must be written. */"
+    ; "        if (_results[_i] == OE_OK &&"
+    ; "            _calls[_i].output_bytes_written != _slot_size)"
+    ; "            _results[_i] = OE_FAILURE;"
+    ; ( if fd.rtype <> Void then
+        String.concat "\n"
+          [ ""
+          ; "        if (_results[_i] == OE_OK && _retvals)"
+          ; sprintf "            _retvals[_i] = ((%s_args_t*)(_buffer + _i * \
+                     _slot_size))->_retval;"
+              fd.fname ]
+      else "        /* No return value. */" )
+    ; "    }"
+    ; ""
+    ; "    _result = OE_OK;"
+    ; ""
+    ; "done:"
+    ; "    free(_buffer);"
+    ; "    free(_calls);"
+    ; "    return _result;"
+    ; "}"
+    ; "" ]
+  in
   (* Generate enclave OCALL wrapper function. *)
   let oe_gen_enclave_ocall_wrapper (uf : untrusted_func) =
     let fd = uf.uf_fdecl in
+    (* Switchless OCALLs marshal into the calling thread's switchless
+       buffer and are carried out by host worker threads. *)
+    let allocate_buffer_function, call_function, free_buffer_function =
+      if uf.uf_is_switchless then
+        ( "oe_allocate_switchless_ocall_buffer"
+        , "oe_switchless_call_host_function"
+        , "oe_free_switchless_ocall_buffer" )
+      else if uf.uf_is_deferred then
+        (* Deferred OCALLs marshal into the calling thread's deferred OCALL
+           queue and are carried out when the thread next exits. *)
+        ( "oe_allocate_deferred_ocall_buffer"
+        , "oe_deferred_call_host_function"
+        , "oe_free_deferred_ocall_buffer" )
+      else
+        ( "oe_allocate_ocall_buffer"
+        , "oe_call_host_function"
+        , "oe_free_ocall_buffer" )
+    in
     [ oe_gen_wrapper_prototype fd false
     ; "{"
     ; "    oe_result_t _result = OE_FAILURE;"
@@ -1033,10 +1182,10 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; ""
     ; "    "
       ^ String.concat "\n    "
-          (oe_prepare_input_buffer fd "oe_allocate_ocall_buffer")
+          (oe_prepare_input_buffer fd allocate_buffer_function)
     ; ""
     ; "    /* Call host function. */"
-    ; "    if ((_result = oe_call_host_function("
+    ; sprintf "    if ((_result = %s(" call_function
     ; "             "
       ^ String.concat ",\n             "
           [ get_function_id fd
@@ -1047,7 +1196,12 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
           ; "&_output_bytes_written)) != OE_OK)" ]
     ; "        goto done;"
     ; ""
-    ; "    " ^ String.concat "\n    " (oe_process_output_buffer fd)
+    ; ( if uf.uf_is_deferred then
+        String.concat "\n"
+          [ "    /* The call may not have been made yet: there are no outputs. */"
+          ; "    OE_UNUSED(_pargs_out);"
+          ; "    OE_UNUSED(_output_buffer_offset);" ]
+      else "    " ^ String.concat "\n    " (oe_process_output_buffer fd) )
     ; ""
     ; "    /* Retrieve propagated errno from OCALL. */"
     ; ( if uf.uf_propagate_errno then "    errno = _pargs_out->_ocall_errno;\n"
@@ -1057,7 +1211,7 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; ""
     ; "done:"
     ; "    if (_buffer)"
-    ; "        oe_free_ocall_buffer(_buffer);"
+    ; sprintf "        %s(_buffer);" free_buffer_function
     ; "    return _result;"
     ; "}"
     ; "" ]
@@ -1206,6 +1360,11 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
         List.map (fun f -> oe_gen_wrapper_prototype f.tf_fdecl true ^ ";") tfs
       else ["/* There were no ecalls. */"]
     in
+    let oe_gen_tfunc_batch_wrapper_prototypes =
+      match List.filter is_batchable_ecall tfs with
+      | [] -> ["/* There were no ecalls with only value parameters. */"]
+      | l -> List.map (fun f -> oe_gen_batch_wrapper_prototype f.tf_fdecl ^ ";") l
+    in
     let oe_gen_ufunc_prototypes =
       if ufs <> [] then
         List.map (fun f -> oe_gen_prototype f.uf_fdecl ^ ";") ufs
@@ -1225,13 +1384,16 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "    const char* path,"
     ; "    oe_enclave_type_t type,"
     ; "    uint32_t flags,"
-    ; "    const void* config,"
-    ; "    uint32_t config_size,"
+    ; "    const oe_enclave_setting_t* settings,"
+    ; "    uint32_t setting_count,"
     ; "    oe_enclave_t** enclave);"
     ; ""
     ; "/**** ECALL prototypes. ****/"
     ; String.concat "\n\n" oe_gen_tfunc_wrapper_prototypes
     ; ""
+    ; "/**** Batched ECALL prototypes. ****/"
+    ; String.concat "\n\n" oe_gen_tfunc_batch_wrapper_prototypes
+    ; ""
     ; "/**** OCALL prototypes. ****/"
     ; String.concat "\n\n" oe_gen_ufunc_prototypes
     ; ""
@@ -1245,6 +1407,11 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
       if tfs <> [] then flatten_map oe_gen_host_ecall_wrapper tfs
       else ["/* There were no ecalls. */"]
     in
+    let oe_gen_host_ecall_batch_wrappers =
+      match List.filter is_batchable_ecall tfs with
+      | [] -> ["/* There were no ecalls with only value parameters. */"]
+      | l -> flatten_map oe_gen_host_ecall_batch_wrapper l
+    in
     let oe_gen_ocall_functions =
       if ufs <> [] then flatten_map oe_gen_ocall_function ufs
       else ["/* There were no ocalls. */"]
@@ -1273,6 +1440,9 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "/**** ECALL function wrappers. ****/"
     ; ""
     ; String.concat "\n" oe_gen_host_ecall_wrappers
+    ; "/**** Batched ECALL function wrappers. ****/"
+    ; ""
+    ; String.concat "\n" oe_gen_host_ecall_batch_wrappers
     ; "/**** OCALL functions. ****/"
     ; ""
     ; String.concat "\n" oe_gen_ocall_functions
@@ -1284,16 +1454,16 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "    const char* path,"
     ; "    oe_enclave_type_t type,"
     ; "    uint32_t flags,"
-    ; "    const void* config,"
-    ; "    uint32_t config_size,"
+    ; "    const oe_enclave_setting_t* settings,"
+    ; "    uint32_t setting_count,"
     ; "    oe_enclave_t** enclave)"
     ; "{"
     ; "    return oe_create_enclave("
     ; "               path,"
     ; "               type,"
     ; "               flags,"
-    ; "               config,"
-    ; "               config_size,"
+    ; "               settings,"
+    ; "               setting_count,"
     ; sprintf "               __%s_ocall_function_table," ec.enclave_name
     ; sprintf "               %d," (List.length ufs)
     ; "               enclave);"
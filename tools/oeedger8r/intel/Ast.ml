@@ -180,6 +180,7 @@ type untrusted_func = {
   uf_allow_list : string list; (* allow list, see above comment *)
   uf_propagate_errno : bool; (* whether this function changes errno *)
   uf_is_switchless    : bool;
+  uf_is_deferred      : bool; (* queued until the enclave thread exits *)
 }
 
 type enclave_func =
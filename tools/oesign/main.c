@@ -120,6 +120,7 @@ typedef struct _config_file_options
     uint64_t num_tcs;
     uint16_t product_id;
     uint16_t security_version;
+    uint64_t lock_spin_count;
 } ConfigFileOptions;
 
 #define CONFIG_FILE_OPTIONS_INITIALIZER                                 \
@@ -127,6 +128,7 @@ typedef struct _config_file_options
         .debug = false, .num_heap_pages = OE_UINT64_MAX,                \
         .num_stack_pages = OE_UINT64_MAX, .num_tcs = OE_UINT64_MAX,     \
         .product_id = OE_UINT16_MAX, .security_version = OE_UINT16_MAX, \
+        .lock_spin_count = OE_UINT64_MAX,                               \
     }
 
 /* Check whether the .conf file is missing required options */
@@ -281,6 +283,18 @@ static int _load_config_file(const char* path, ConfigFileOptions* options)
 
             options->security_version = n;
         }
+        else if (strcmp(str_ptr(&lhs), "LockSpinCount") == 0)
+        {
+            uint64_t n;
+
+            if (str_u64(&rhs, &n) != 0 || n > OE_UINT32_MAX)
+            {
+                Err("%s(%zu): bad value for 'LockSpinCount'", path, line);
+                goto done;
+            }
+
+            options->lock_spin_count = n;
+        }
         else
         {
             Err("%s(%zu): unknown setting: %s", path, line, str_ptr(&rhs));
@@ -453,6 +467,11 @@ void _merge_config_file_options(
     /* If NumTCS option is present */
     if (options->num_tcs != OE_UINT64_MAX)
         properties->header.size_settings.num_tcs = options->num_tcs;
+
+    /* If LockSpinCount option is present */
+    if (options->lock_spin_count != OE_UINT64_MAX)
+        properties->config.lock_spin_count =
+            (uint32_t)options->lock_spin_count;
 }
 
 static const char _usage_gen[] =
@@ -492,6 +511,9 @@ static const char _usage_sign[] =
     "        NumStackPages - the number of stack pages for this enclave\n"
     "        NumTCS - the number of thread control structures for this "
     "enclave\n"
+    "        LockSpinCount - (optional) the number of pause iterations a "
+    "thread\n"
+    "            spins on a contended mutex before waiting in the host\n"
     "\n"
     "    The configuration file contains simple NAME=VALUE entries. For "
     "example:\n"
@@ -528,6 +550,8 @@ int oesign(const char* enclave, const char* conffile, const char* keyfile)
     oe_sgx_enclave_properties_t props;
     oe_sgx_load_context_t context;
 
+    memset(&enc, 0, sizeof(enc));
+
     /* Load the configuration file */
     if (_load_config_file(conffile, &options) != 0)
     {
@@ -628,6 +652,8 @@ done:
     if (pem_data)
         free(pem_data);
 
+    oe_destroy_thread_bindings(&enc);
+
     oe_sgx_cleanup_load_context(&context);
 
     return ret;
@@ -190,6 +190,8 @@ void dump_enclave_properties(const oe_sgx_enclave_properties_t* props)
 
     printf("num_tcs=%llu\n", OE_LLU(props->header.size_settings.num_tcs));
 
+    printf("lock_spin_count=%u\n", props->config.lock_spin_count);
+
     sigstruct = (const sgx_sigstruct_t*)props->sigstruct;
 
     printf("mrenclave=");